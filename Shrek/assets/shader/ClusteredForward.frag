@@ -0,0 +1,86 @@
+#version 450
+
+// forward shading with the point lights LightCull.comp binned into the fragment's cluster, so the cost goes
+// with how many lights are around rather than how many there are. the bindings in set 1 are the ones of
+// LightCull.comp minus the stats, in the order ClusteredLighting::GetShadingBuffers hands them out. set 2 is
+// the material, its albedo is streamed and every fragment writes the mip it sampled into the feedback
+
+layout(location = 0) in vec3 fragPosition; // world space
+layout(location = 1) in vec3 fragNormal;
+layout(location = 2) in vec3 fragAlbedo;
+layout(location = 3) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+struct PointLight
+{
+    vec3  Position; // view space
+    float Radius;
+    vec3  Color;
+    float Intensity;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Params
+{
+    mat4  View;
+    vec4  Projection; // x and y scale of the projection, near, far
+    vec4  Screen;     // render extent, slice scale and bias
+    uvec4 Grid;       // clusters along x, y and z, lights a cluster has room for
+    uint  LightCount;
+} params;
+
+layout(std430, set = 1, binding = 1) readonly buffer Lights { PointLight lights[]; };
+layout(std430, set = 1, binding = 2) readonly buffer Counts { uint counts[]; };
+layout(std430, set = 1, binding = 3) readonly buffer Indices { uint indices[]; };
+
+layout(set = 2, binding = 0) uniform sampler2D albedoTexture;
+layout(std430, set = 2, binding = 1) buffer Feedback { uint Mips[]; } feedback;
+
+// the texture's feedback slot and the finest mip its image holds, no slot for the fallback
+layout(push_constant) uniform Material
+{
+    uint TextureId;
+    uint ResidentMip;
+} material;
+
+const uint noFeedback = 0xffffffffu;
+
+const vec3 ambient = vec3(0.03);
+
+uint clusterIndex(float depth)
+{
+    uvec2 tile  = min(uvec2(gl_FragCoord.xy / params.Screen.xy * vec2(params.Grid.xy)), params.Grid.xy - 1);
+    uint  slice = uint(clamp(log(depth) * params.Screen.z + params.Screen.w, 0.0, float(params.Grid.z - 1)));
+    return tile.x + params.Grid.x * (tile.y + params.Grid.y * slice);
+}
+
+void main()
+{
+    vec3 albedo = fragAlbedo * texture(albedoTexture, fragTexCoord).rgb;
+    if (material.TextureId != noFeedback)
+        atomicMin(feedback.Mips[material.TextureId], uint(max(textureQueryLod(albedoTexture, fragTexCoord).y, 0.0)) + material.ResidentMip);
+
+    vec3 position = (params.View * vec4(fragPosition, 1.0)).xyz;
+    vec3 normal   = normalize(mat3(params.View) * fragNormal);
+
+    uint cluster = clusterIndex(-position.z);
+    uint count   = counts[cluster];
+    uint base    = cluster * params.Grid.w;
+
+    vec3 color = albedo * ambient;
+    for (uint idx = 0; idx < count; ++idx)
+    {
+        PointLight light = lights[indices[base + idx]];
+
+        vec3  toLight  = light.Position - position;
+        float distance = length(toLight);
+
+        // inverse square that goes to exactly 0 at the radius, so the cut off the binning makes doesn't show
+        float window      = clamp(1.0 - pow(distance / light.Radius, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (distance * distance + 1.0);
+
+        color += albedo * light.Color * light.Intensity * attenuation * max(dot(normal, toLight / max(distance, 1e-4)), 0.0);
+    }
+
+    outColor = vec4(color, 1.0);
+}
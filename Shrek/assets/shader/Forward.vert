@@ -0,0 +1,39 @@
+#version 450
+
+// the scene's forward pass, SceneRenderer draws every batch of the render queue as an indirect draw per cull
+// phase. the phase's instances hold the queue positions of what survived the culling, the transforms are laid
+// out by queue position. the camera and the transforms are allocations of the frame's uniform ring
+
+// the streams come in the formats the mesh optimizer quantizes to, the normal is snorm8 with w unused and the
+// texcoord is half floats
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragPosition; // world space
+layout(location = 1) out vec3 fragNormal;
+layout(location = 2) out vec3 fragAlbedo;
+layout(location = 3) out vec2 fragTexCoord;
+
+layout(set = 0, binding = 0) uniform Camera
+{
+    mat4 ViewProjection;
+} camera;
+
+layout(std430, set = 0, binding = 1) readonly buffer Objects { mat4 transforms[]; };
+layout(std430, set = 0, binding = 2) readonly buffer Instances { uint instances[]; };
+
+// what the material's albedo texture is tinted with
+const vec3 albedo = vec3(0.8);
+
+void main()
+{
+    mat4 world    = transforms[instances[gl_InstanceIndex]];
+    vec4 position = world * vec4(inPosition, 1.0);
+
+    fragPosition = position.xyz;
+    fragNormal   = mat3(world) * inNormal.xyz;
+    fragAlbedo   = albedo;
+    fragTexCoord = inTexCoord;
+    gl_Position  = camera.ViewProjection * position;
+}
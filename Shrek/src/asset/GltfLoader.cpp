@@ -0,0 +1,547 @@
+#include "pch.h"
+#include "GltfLoader.h"
+
+#include "MeshOptimizer.h"
+#include "base/Json.h"
+#include "platform/Log.h"
+#include "platform/MappedFile.h"
+
+#include <cstring>
+
+namespace shrek::asset {
+
+namespace {
+
+constexpr uint32_t glbMagic     = 0x46546C67; // "glTF"
+constexpr uint32_t glbVersion   = 2;
+constexpr uint32_t chunkJson    = 0x4E4F534A; // "JSON"
+constexpr uint32_t chunkBin     = 0x004E4942; // "BIN\0"
+constexpr size_t   headerSize   = 12;
+constexpr size_t   chunkHeader  = 8;
+constexpr uint32_t modeTriangle = 4;
+
+enum ComponentType : uint32_t
+{
+    ComponentType_Byte          = 5120,
+    ComponentType_UnsignedByte  = 5121,
+    ComponentType_Short         = 5122,
+    ComponentType_UnsignedShort = 5123,
+    ComponentType_UnsignedInt   = 5125,
+    ComponentType_Float         = 5126,
+};
+
+// an accessor that was checked against the BIN chunk, Data points into the mapped file
+struct Accessor
+{
+    const std::byte* Data{nullptr};
+    uint32_t         Count{0};
+    uint32_t         ComponentType{0};
+    uint32_t         Components{0};
+    uint32_t         ElementSize{0};
+    uint32_t         Stride{0};
+    bool             Normalized{false};
+    base::JsonValue  Json;
+};
+
+uint32_t readU32(const std::byte* data) SRK_NOEXCEPT
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t componentSize(uint32_t componentType) SRK_NOEXCEPT
+{
+    switch (componentType)
+    {
+        case ComponentType_Byte:
+        case ComponentType_UnsignedByte:
+            return 1;
+        case ComponentType_Short:
+        case ComponentType_UnsignedShort:
+            return 2;
+        case ComponentType_UnsignedInt:
+        case ComponentType_Float:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+uint32_t componentCount(std::string_view type) SRK_NOEXCEPT
+{
+    if (type == "SCALAR")
+        return 1;
+    if (type == "VEC2")
+        return 2;
+    if (type == "VEC3")
+        return 3;
+    if (type == "VEC4")
+        return 4;
+    return 0; // matrices are never vertex data we care about
+}
+
+// packs strided elements tightly into dst
+void copyElements(std::byte* dst, const Accessor& accessor) SRK_NOEXCEPT
+{
+    if (accessor.Stride == accessor.ElementSize)
+    {
+        std::memcpy(dst, accessor.Data, static_cast<size_t>(accessor.ElementSize) * accessor.Count);
+        return;
+    }
+
+    for (uint32_t idx{}; idx < accessor.Count; ++idx)
+        std::memcpy(dst + static_cast<size_t>(idx) * accessor.ElementSize, accessor.Data + static_cast<size_t>(idx) * accessor.Stride, accessor.ElementSize);
+}
+
+uint32_t readIndex(const Accessor& accessor, uint32_t idx) SRK_NOEXCEPT
+{
+    const std::byte* src = accessor.Data + static_cast<size_t>(idx) * accessor.Stride;
+    switch (accessor.ComponentType)
+    {
+        case ComponentType_UnsignedByte:
+            return static_cast<uint32_t>(*src);
+        case ComponentType_UnsignedShort:
+        {
+            uint16_t index;
+            std::memcpy(&index, src, sizeof(index));
+            return index;
+        }
+        default:
+            return readU32(src);
+    }
+}
+
+VkFormat vertexFormat(const Accessor& accessor) SRK_NOEXCEPT
+{
+    static constexpr VkFormat floats[]  = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+    static constexpr VkFormat unorm8[]  = {VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM};
+    static constexpr VkFormat snorm8[]  = {VK_FORMAT_R8_SNORM, VK_FORMAT_R8G8_SNORM, VK_FORMAT_R8G8B8_SNORM, VK_FORMAT_R8G8B8A8_SNORM};
+    static constexpr VkFormat unorm16[] = {VK_FORMAT_R16_UNORM, VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16A16_UNORM};
+    static constexpr VkFormat snorm16[] = {VK_FORMAT_R16_SNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R16G16B16_SNORM, VK_FORMAT_R16G16B16A16_SNORM};
+
+    const uint32_t idx = accessor.Components - 1;
+    if (accessor.ComponentType == ComponentType_Float)
+        return floats[idx];
+    if (!accessor.Normalized)
+        return VK_FORMAT_UNDEFINED;
+
+    switch (accessor.ComponentType)
+    {
+        case ComponentType_UnsignedByte:
+            return unorm8[idx];
+        case ComponentType_Byte:
+            return snorm8[idx];
+        case ComponentType_UnsignedShort:
+            return unorm16[idx];
+        case ComponentType_Short:
+            return snorm16[idx];
+        default:
+            return VK_FORMAT_UNDEFINED;
+    }
+}
+
+class GlbParser
+{
+public:
+    GlbParser(render::StagingBuffer& staging, const MeshOptimizeSettings* optimize) SRK_NOEXCEPT :
+        m_Staging(staging),
+        m_Optimize(optimize)
+    {
+    }
+
+    LoadResult Parse(const MappedFile& file, std::vector<render::Mesh>& meshes) SRK_NOEXCEPT
+    {
+        LoadResult result = ReadChunks(file);
+        if (result != LoadResult::Success)
+            return result;
+
+        if (!m_Document.Parse(m_Json))
+            return LoadResult::InvalidJson;
+
+        base::JsonValue root = m_Document.Root();
+
+        // only the glb's own BIN chunk is supported, external .bin/data uris would need more copies
+        base::JsonValue buffers = root["buffers"];
+        for (base::JsonValue buffer = buffers.First(); buffer.IsValid(); buffer = buffer.Next())
+        {
+            if (buffer["uri"].IsValid())
+                return LoadResult::Unsupported;
+        }
+
+        // cache the array elements so lookups by index stay O(1)
+        collect(root["accessors"], m_Accessors);
+        collect(root["bufferViews"], m_BufferViews);
+
+        for (base::JsonValue mesh = root["meshes"].First(); mesh.IsValid(); mesh = mesh.Next())
+        {
+            render::Mesh& out = meshes.emplace_back();
+            out.Name          = std::string(mesh["name"].AsString());
+
+            for (base::JsonValue primitive = mesh["primitives"].First(); primitive.IsValid(); primitive = primitive.Next())
+            {
+                result = ReadPrimitive(primitive, out.Primitives.emplace_back());
+                if (result != LoadResult::Success)
+                    return result;
+
+                out.Bounds = math::Merge(out.Bounds, out.Primitives.back().Bounds);
+            }
+        }
+
+        return LoadResult::Success;
+    }
+
+private:
+    static void collect(base::JsonValue array, std::vector<base::JsonValue>& out) SRK_NOEXCEPT
+    {
+        out.clear();
+        out.reserve(array.Size());
+        for (base::JsonValue element = array.First(); element.IsValid(); element = element.Next())
+            out.push_back(element);
+    }
+
+    LoadResult ReadChunks(const MappedFile& file) SRK_NOEXCEPT
+    {
+        const std::byte* data = file.Data();
+        const size_t     size = file.Size();
+
+        if (size < headerSize + chunkHeader || readU32(data) != glbMagic || readU32(data + 4) != glbVersion)
+            return LoadResult::InvalidContainer;
+
+        const size_t length = std::min<size_t>(readU32(data + 8), size);
+
+        size_t offset = headerSize;
+        while (offset + chunkHeader <= length)
+        {
+            const uint32_t chunkLength = readU32(data + offset);
+            const uint32_t chunkType   = readU32(data + offset + 4);
+            const size_t   begin       = offset + chunkHeader;
+
+            if (begin + chunkLength > length)
+                return LoadResult::InvalidContainer;
+
+            if (chunkType == chunkJson && m_Json.empty())
+                m_Json = std::string_view(reinterpret_cast<const char*>(data + begin), chunkLength);
+            else if (chunkType == chunkBin && m_Bin == nullptr)
+            {
+                m_Bin       = data + begin;
+                m_BinLength = chunkLength;
+            }
+
+            // chunks are 4 byte aligned
+            offset = begin + ((chunkLength + 3u) & ~3u);
+        }
+
+        if (m_Json.empty())
+            return LoadResult::InvalidContainer;
+
+        // the json chunk may be padded with spaces, trailing nulls are tolerated as well
+        while (!m_Json.empty() && (m_Json.back() == '\0' || m_Json.back() == ' '))
+            m_Json.remove_suffix(1);
+
+        return LoadResult::Success;
+    }
+
+    LoadResult ReadAccessor(uint32_t idx, Accessor& accessor) SRK_NOEXCEPT
+    {
+        if (idx >= m_Accessors.size())
+            return LoadResult::InvalidAccessor;
+
+        base::JsonValue json = m_Accessors[idx];
+        if (json["sparse"].IsValid())
+            return LoadResult::Unsupported;
+
+        accessor.Json          = json;
+        accessor.Count         = json["count"].AsUint();
+        accessor.ComponentType = json["componentType"].AsUint();
+        accessor.Components    = componentCount(json["type"].AsString());
+        accessor.Normalized    = json["normalized"].AsBool();
+
+        const uint32_t size = componentSize(accessor.ComponentType);
+        if (size == 0 || accessor.Components == 0 || accessor.Count == 0)
+            return LoadResult::InvalidAccessor;
+
+        accessor.ElementSize = size * accessor.Components;
+
+        const uint32_t viewIdx = json["bufferView"].AsUint(~0u);
+        if (viewIdx >= m_BufferViews.size() || m_Bin == nullptr)
+            return LoadResult::InvalidAccessor;
+
+        base::JsonValue view = m_BufferViews[viewIdx];
+        if (view["buffer"].AsUint() != 0)
+            return LoadResult::Unsupported;
+
+        const uint64_t viewOffset = view["byteOffset"].AsUint();
+        const uint64_t viewLength = view["byteLength"].AsUint();
+        const uint64_t offset     = json["byteOffset"].AsUint();
+        accessor.Stride           = view["byteStride"].AsUint(accessor.ElementSize);
+
+        // everything is checked in 64 bit so a hostile file can't wrap the arithmetic
+        const uint64_t last = offset + static_cast<uint64_t>(accessor.Stride) * (accessor.Count - 1) + accessor.ElementSize;
+        if (viewOffset + viewLength > m_BinLength || last > viewLength || accessor.Stride < accessor.ElementSize || offset % size != 0)
+            return LoadResult::InvalidAccessor;
+
+        accessor.Data = m_Bin + viewOffset + offset;
+        return LoadResult::Success;
+    }
+
+    // the only copy, from the mapping into staging, packing interleaved data on the way
+    LoadResult StreamVertices(const Accessor& accessor, render::MeshStream& stream) SRK_NOEXCEPT
+    {
+        stream.Format = vertexFormat(accessor);
+        stream.Stride = accessor.ElementSize;
+        if (stream.Format == VK_FORMAT_UNDEFINED)
+            return LoadResult::Unsupported;
+
+        stream.Data = m_Staging.Allocate(static_cast<VkDeviceSize>(accessor.ElementSize) * accessor.Count);
+        if (!stream.Data.IsValid())
+            return LoadResult::OutOfStaging;
+
+        copyElements(stream.Data.Data, accessor);
+        return LoadResult::Success;
+    }
+
+    // optimizing needs the data on the cpu first, it still gets written to staging only once at the end
+    LoadResult DecodeVertices(const Accessor& accessor, MeshData::Stream& stream) SRK_NOEXCEPT
+    {
+        stream.Format = vertexFormat(accessor);
+        stream.Stride = accessor.ElementSize;
+        if (stream.Format == VK_FORMAT_UNDEFINED)
+            return LoadResult::Unsupported;
+
+        stream.Data.resize(static_cast<size_t>(accessor.ElementSize) * accessor.Count);
+        copyElements(stream.Data.data(), accessor);
+        return LoadResult::Success;
+    }
+
+    LoadResult DecodeIndices(const Accessor& accessor, uint32_t vertexCount, std::vector<uint32_t>& indices) SRK_NOEXCEPT
+    {
+        if (accessor.Components != 1 || componentSize(accessor.ComponentType) == 0 || accessor.ComponentType == ComponentType_Byte ||
+            accessor.ComponentType == ComponentType_Short || accessor.ComponentType == ComponentType_Float)
+            return LoadResult::InvalidAccessor;
+
+        indices.resize(accessor.Count);
+        for (uint32_t idx{}; idx < accessor.Count; ++idx)
+        {
+            indices[idx] = readIndex(accessor, idx);
+            if (indices[idx] >= vertexCount)
+                return LoadResult::InvalidAccessor;
+        }
+
+        return LoadResult::Success;
+    }
+
+    LoadResult StreamIndices(const Accessor& accessor, render::MeshPrimitive& primitive) SRK_NOEXCEPT
+    {
+        if (accessor.Components != 1)
+            return LoadResult::InvalidAccessor;
+
+        // 8 bit indices are not core vulkan, they get widened while copying
+        const bool     wide      = accessor.ComponentType == ComponentType_UnsignedInt;
+        const uint32_t indexSize = wide ? 4 : 2;
+
+        if (accessor.ComponentType != ComponentType_UnsignedByte && accessor.ComponentType != ComponentType_UnsignedShort && !wide)
+            return LoadResult::InvalidAccessor;
+
+        primitive.IndexType  = wide ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+        primitive.IndexCount = accessor.Count;
+        primitive.Indices    = m_Staging.Allocate(static_cast<VkDeviceSize>(indexSize) * accessor.Count, indexSize);
+        if (!primitive.Indices.IsValid())
+            return LoadResult::OutOfStaging;
+
+        std::byte* dst = primitive.Indices.Data;
+        if (accessor.ComponentType == ComponentType_UnsignedByte)
+        {
+            for (uint32_t idx{}; idx < accessor.Count; ++idx)
+            {
+                const uint16_t index = static_cast<uint16_t>(accessor.Data[idx * accessor.Stride]);
+                std::memcpy(dst + idx * sizeof(uint16_t), &index, sizeof(uint16_t));
+            }
+        }
+        else if (accessor.Stride == indexSize)
+        {
+            std::memcpy(dst, accessor.Data, primitive.Indices.Size);
+        }
+        else
+        {
+            for (uint32_t idx{}; idx < accessor.Count; ++idx)
+                std::memcpy(dst + idx * indexSize, accessor.Data + idx * accessor.Stride, indexSize);
+        }
+
+        // indices are checked here, while they are hot in cache, instead of trusting the file
+        for (uint32_t idx{}; idx < accessor.Count; ++idx)
+        {
+            uint32_t index{};
+            if (wide)
+                std::memcpy(&index, dst + idx * 4, 4);
+            else
+            {
+                uint16_t narrow;
+                std::memcpy(&narrow, dst + idx * 2, 2);
+                index = narrow;
+            }
+
+            if (index >= primitive.VertexCount)
+                return LoadResult::InvalidAccessor;
+        }
+
+        return LoadResult::Success;
+    }
+
+    LoadResult ReadPrimitive(base::JsonValue json, render::MeshPrimitive& primitive) SRK_NOEXCEPT
+    {
+        if (json["mode"].AsUint(modeTriangle) != modeTriangle)
+            return LoadResult::Unsupported;
+
+        static constexpr std::pair<std::string_view, render::VertexStream> semantics[] = {
+            {"POSITION", render::VertexStream_Position},
+            {"NORMAL", render::VertexStream_Normal},
+            {"TANGENT", render::VertexStream_Tangent},
+            {"TEXCOORD_0", render::VertexStream_TexCoord0}};
+
+        base::JsonValue attributes = json["attributes"];
+        if (!attributes["POSITION"].IsValid())
+            return LoadResult::InvalidAccessor;
+
+        m_MeshData = MeshData{};
+
+        for (const auto& [name, stream] : semantics)
+        {
+            base::JsonValue attribute = attributes[name];
+            if (!attribute.IsValid())
+                continue;
+
+            Accessor   accessor;
+            LoadResult result = ReadAccessor(attribute.AsUint(~0u), accessor);
+            if (result != LoadResult::Success)
+                return result;
+
+            // every attribute has to describe the same vertices
+            if (primitive.VertexCount != 0 && accessor.Count != primitive.VertexCount)
+                return LoadResult::InvalidAccessor;
+            primitive.VertexCount = accessor.Count;
+
+            if (stream == render::VertexStream_Position)
+            {
+                if (accessor.ComponentType != ComponentType_Float || accessor.Components != 3)
+                    return LoadResult::InvalidAccessor;
+
+                // min/max are required on positions by the spec
+                base::JsonValue min = accessor.Json["min"];
+                base::JsonValue max = accessor.Json["max"];
+                for (uint32_t axis{}; axis < 3; ++axis)
+                {
+                    primitive.Bounds.Min[axis] = static_cast<float>(min[axis].AsNumber());
+                    primitive.Bounds.Max[axis] = static_cast<float>(max[axis].AsNumber());
+                }
+            }
+
+            result = m_Optimize ? DecodeVertices(accessor, m_MeshData.Streams[stream]) : StreamVertices(accessor, primitive.Streams[stream]);
+            if (result != LoadResult::Success)
+                return result;
+        }
+
+        primitive.Material = static_cast<int32_t>(json["material"].AsNumber(-1.0));
+
+        base::JsonValue indices = json["indices"];
+        if (m_Optimize)
+            return OptimizePrimitive(indices, primitive);
+
+        if (!indices.IsValid())
+        {
+            // non indexed primitives are drawn as they are
+            primitive.IndexCount = 0;
+            return LoadResult::Success;
+        }
+
+        Accessor   accessor;
+        LoadResult result = ReadAccessor(indices.AsUint(~0u), accessor);
+        if (result != LoadResult::Success)
+            return result;
+
+        return StreamIndices(accessor, primitive);
+    }
+
+    LoadResult OptimizePrimitive(base::JsonValue indices, render::MeshPrimitive& primitive) SRK_NOEXCEPT
+    {
+        m_MeshData.VertexCount = primitive.VertexCount;
+        if (indices.IsValid())
+        {
+            Accessor   accessor;
+            LoadResult result = ReadAccessor(indices.AsUint(~0u), accessor);
+            if (result == LoadResult::Success)
+                result = DecodeIndices(accessor, primitive.VertexCount, m_MeshData.Indices);
+            if (result != LoadResult::Success)
+                return result;
+        }
+
+        OptimizeMesh(m_MeshData, *m_Optimize);
+        return WriteMesh(m_MeshData, m_Staging, primitive) ? LoadResult::Success : LoadResult::OutOfStaging;
+    }
+
+private:
+    render::StagingBuffer&       m_Staging;
+    const MeshOptimizeSettings*  m_Optimize;
+    MeshData                     m_MeshData;
+    base::JsonDocument           m_Document;
+    std::string_view             m_Json;
+    const std::byte*             m_Bin{nullptr};
+    uint64_t                     m_BinLength{0};
+    std::vector<base::JsonValue> m_Accessors;
+    std::vector<base::JsonValue> m_BufferViews;
+};
+
+} // namespace
+
+std::string_view ToString(LoadResult result) SRK_NOEXCEPT
+{
+#define TO_STRING(X)    \
+    case LoadResult::X: \
+        return #X
+    switch (result)
+    {
+        TO_STRING(Success);
+        TO_STRING(FileNotFound);
+        TO_STRING(InvalidContainer);
+        TO_STRING(InvalidJson);
+        TO_STRING(InvalidAccessor);
+        TO_STRING(Unsupported);
+        TO_STRING(OutOfStaging);
+        default:
+            return "UNKNOWN";
+    }
+#undef TO_STRING
+}
+
+LoadResult LoadGlb(const std::string& path, render::StagingBuffer& staging, std::vector<render::Mesh>& meshes, const MeshOptimizeSettings* optimize) SRK_NOEXCEPT
+{
+    MappedFile file(path);
+    if (!file.IsValid())
+        return LoadResult::FileNotFound;
+
+    GlbParser    parser(staging, optimize);
+    const size_t firstMesh = meshes.size();
+    LoadResult   result    = parser.Parse(file, meshes);
+
+    if (result != LoadResult::Success)
+    {
+        // staging space that was already handed out stays used until the next Reset
+        meshes.resize(firstMesh);
+        SRK_CORE_ERROR("Unable to load {}: {}", path, ToString(result));
+    }
+
+    return result;
+}
+
+void LoadGlbs(const std::vector<std::string>& paths, render::StagingBuffer& staging, base::JobSystem& jobs, std::vector<GlbLoad>& results, const MeshOptimizeSettings* optimize) SRK_NOEXCEPT
+{
+    results.clear();
+    results.resize(paths.size());
+
+    jobs.ParallelFor(static_cast<uint32_t>(paths.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t idx = begin; idx < end; ++idx)
+            results[idx].Result = LoadGlb(paths[idx], staging, results[idx].Meshes, optimize);
+    });
+}
+
+} // namespace shrek::asset
@@ -0,0 +1,44 @@
+#pragma once
+#include "defs.h"
+#include "MeshOptimizer.h"
+#include "base/JobSystem.h"
+#include "render/Mesh.h"
+#include "render/StagingBuffer.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace shrek::asset {
+
+enum class LoadResult
+{
+    Success,
+    FileNotFound,
+    InvalidContainer, // not a glb or the chunks are broken
+    InvalidJson,
+    InvalidAccessor, // an accessor points outside of its buffer view or has the wrong type
+    Unsupported,     // valid gltf that we don't handle (sparse accessors, external buffers, non triangle lists)
+    OutOfStaging
+};
+
+std::string_view ToString(LoadResult result) SRK_NOEXCEPT;
+
+struct GlbLoad
+{
+    LoadResult                Result{LoadResult::Success};
+    std::vector<render::Mesh> Meshes;
+};
+
+/*
+ *  Loads every mesh of a binary gltf file.
+ *  The file is memory mapped and accessors are validated against the mapped BIN chunk, vertex and index
+ *  data is then copied once, straight from the mapping into the staging buffer.
+ *  With optimize set every primitive goes through OptimizeMesh on the way, which needs a cpu copy first.
+ */
+LoadResult LoadGlb(const std::string& path, render::StagingBuffer& staging, std::vector<render::Mesh>& meshes, const MeshOptimizeSettings* optimize = nullptr) SRK_NOEXCEPT;
+
+// one job per file, results line up with paths
+void LoadGlbs(const std::vector<std::string>& paths, render::StagingBuffer& staging, base::JobSystem& jobs, std::vector<GlbLoad>& results, const MeshOptimizeSettings* optimize = nullptr) SRK_NOEXCEPT;
+
+} // namespace shrek::asset
@@ -0,0 +1,767 @@
+#include "pch.h"
+#include "ImageFile.h"
+
+#include "platform/Log.h"
+#include "platform/MappedFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+namespace shrek::asset {
+
+namespace {
+
+constexpr std::array<uint8_t, 8> pngSignature{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+constexpr uint32_t               pngColorRgb   = 2;
+constexpr uint32_t               pngColorRgba  = 6;
+constexpr size_t                 maxStoredSize = 65535; // largest deflate stored block
+constexpr uint32_t               adlerModulo   = 65521;
+constexpr size_t                 adlerRun      = 5552; // bytes that can be summed before b overflows 32 bits
+
+constexpr std::array<uint32_t, 256> crcTable = []() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t idx{}; idx < 256; ++idx)
+    {
+        uint32_t crc = idx;
+        for (uint32_t bit{}; bit < 8; ++bit)
+            crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+        table[idx] = crc;
+    }
+    return table;
+}();
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) SRK_NOEXCEPT
+{
+    crc = ~crc;
+    for (size_t idx{}; idx < size; ++idx)
+        crc = crcTable[(crc ^ data[idx]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t value) SRK_NOEXCEPT
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// length, type and data, the crc covers the type and data
+void putChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) SRK_NOEXCEPT
+{
+    putU32(out, static_cast<uint32_t>(size));
+    const size_t typeBegin = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    putU32(out, crc32(out.data() + typeBegin, size + 4));
+}
+
+// zlib header, stored deflate blocks and the adler32 of the raw data
+std::vector<uint8_t> storeZlib(const std::vector<uint8_t>& raw) SRK_NOEXCEPT
+{
+    const size_t blockCount = std::max<size_t>(1, (raw.size() + maxStoredSize - 1) / maxStoredSize);
+
+    std::vector<uint8_t> out;
+    out.reserve(raw.size() + blockCount * 5 + 6);
+    out.push_back(0x78); // deflate with a 32K window
+    out.push_back(0x01); // no preset dictionary, checksum of the two bytes is a multiple of 31
+
+    uint32_t a = 1;
+    uint32_t b = 0;
+    size_t   offset{0};
+    for (size_t block{}; block < blockCount; ++block)
+    {
+        const uint16_t size = static_cast<uint16_t>(std::min(maxStoredSize, raw.size() - offset));
+        out.push_back(block + 1 == blockCount ? 1 : 0);
+        out.push_back(static_cast<uint8_t>(size));
+        out.push_back(static_cast<uint8_t>(size >> 8));
+        out.push_back(static_cast<uint8_t>(~size));
+        out.push_back(static_cast<uint8_t>(~size >> 8));
+        out.insert(out.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+        // the modulo can wait for adlerRun bytes before b could overflow
+        for (size_t begin = offset; begin < offset + size; begin += adlerRun)
+        {
+            const size_t end = std::min(begin + adlerRun, offset + size);
+            for (size_t idx = begin; idx < end; ++idx)
+            {
+                a += raw[idx];
+                b += a;
+            }
+            a %= adlerModulo;
+            b %= adlerModulo;
+        }
+        offset += size;
+    }
+
+    putU32(out, (b << 16) | a);
+    return out;
+}
+
+bool writeFile(const std::string& path, const uint8_t* data, size_t size) SRK_NOEXCEPT
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        SRK_CORE_ERROR("{} could not be opened for writing", path);
+        return false;
+    }
+
+    const bool written = std::fwrite(data, 1, size, file) == size;
+    const bool closed  = std::fclose(file) == 0;
+    if (!written || !closed)
+        SRK_CORE_ERROR("{} could not be written", path);
+
+    return written && closed;
+}
+
+uint32_t readBigEndian(const uint8_t* data) SRK_NOEXCEPT
+{
+    return (uint32_t{data[0]} << 24) | (uint32_t{data[1]} << 16) | (uint32_t{data[2]} << 8) | uint32_t{data[3]};
+}
+
+/*
+ *  Canonical huffman decoding after zlib's puff, small and slow enough for reading goldens.
+ *  Counts holds how many codes there are of each length, Symbols the symbols ordered by code.
+ */
+struct Huffman
+{
+    std::array<uint16_t, 16>  Counts{};
+    std::array<uint16_t, 288> Symbols{};
+};
+
+// false when the lengths over subscribe the code space
+bool buildHuffman(Huffman& huffman, const uint8_t* lengths, uint32_t count) SRK_NOEXCEPT
+{
+    huffman.Counts.fill(0);
+    for (uint32_t symbol{}; symbol < count; ++symbol)
+        ++huffman.Counts[lengths[symbol]];
+
+    int32_t left = 1;
+    for (uint32_t length = 1; length < 16; ++length)
+    {
+        left = left * 2 - huffman.Counts[length];
+        if (left < 0)
+            return false;
+    }
+
+    std::array<uint16_t, 16> offsets{};
+    for (uint32_t length = 1; length < 15; ++length)
+        offsets[length + 1] = offsets[length] + huffman.Counts[length];
+
+    for (uint32_t symbol{}; symbol < count; ++symbol)
+    {
+        if (lengths[symbol] != 0)
+            huffman.Symbols[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+    }
+    return true;
+}
+
+class Inflater
+{
+public:
+    Inflater(const uint8_t* data, size_t size, std::vector<uint8_t>& out) SRK_NOEXCEPT :
+        m_Data(data),
+        m_Size(size),
+        m_Position(0),
+        m_Bits(0),
+        m_BitCount(0),
+        m_Failed(false),
+        m_Out(out)
+    {
+    }
+
+    bool Run() SRK_NOEXCEPT
+    {
+        bool last{false};
+        while (!last && !m_Failed)
+        {
+            last = Bits(1) == 1;
+            switch (Bits(2))
+            {
+                case 0:
+                    Stored();
+                    break;
+                case 1:
+                    Fixed();
+                    break;
+                case 2:
+                    Dynamic();
+                    break;
+                default:
+                    m_Failed = true;
+                    break;
+            }
+        }
+        return !m_Failed;
+    }
+
+private:
+    uint32_t Bits(uint32_t count) SRK_NOEXCEPT
+    {
+        while (m_BitCount < count)
+        {
+            if (m_Position == m_Size)
+            {
+                m_Failed = true;
+                return 0;
+            }
+            m_Bits |= uint32_t{m_Data[m_Position++]} << m_BitCount;
+            m_BitCount += 8;
+        }
+
+        const uint32_t value = m_Bits & ((1u << count) - 1);
+        m_Bits >>= count;
+        m_BitCount -= count;
+        return value;
+    }
+
+    uint32_t Decode(const Huffman& huffman) SRK_NOEXCEPT
+    {
+        int32_t code{0};
+        int32_t first{0};
+        int32_t index{0};
+        for (uint32_t length = 1; length < 16 && !m_Failed; ++length)
+        {
+            code |= static_cast<int32_t>(Bits(1));
+            const int32_t count = huffman.Counts[length];
+            if (code - count < first)
+                return huffman.Symbols[index + (code - first)];
+
+            index += count;
+            first  = (first + count) << 1;
+            code <<= 1;
+        }
+
+        m_Failed = true;
+        return 0;
+    }
+
+    void Stored() SRK_NOEXCEPT
+    {
+        // stored blocks start on a byte boundary
+        m_Bits     = 0;
+        m_BitCount = 0;
+        if (m_Size - m_Position < 4)
+        {
+            m_Failed = true;
+            return;
+        }
+
+        const uint32_t size       = m_Data[m_Position] | (uint32_t{m_Data[m_Position + 1]} << 8);
+        const uint32_t complement = m_Data[m_Position + 2] | (uint32_t{m_Data[m_Position + 3]} << 8);
+        m_Position += 4;
+        if (size != (~complement & 0xFFFF) || m_Size - m_Position < size)
+        {
+            m_Failed = true;
+            return;
+        }
+
+        m_Out.insert(m_Out.end(), m_Data + m_Position, m_Data + m_Position + size);
+        m_Position += size;
+    }
+
+    void Codes(const Huffman& lengths, const Huffman& distances) SRK_NOEXCEPT
+    {
+        static constexpr std::array<uint16_t, 29> lengthBase{3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static constexpr std::array<uint8_t, 29>  lengthExtra{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static constexpr std::array<uint16_t, 30> distanceBase{1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static constexpr std::array<uint8_t, 30>  distanceExtra{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        while (!m_Failed)
+        {
+            uint32_t symbol = Decode(lengths);
+            if (symbol < 256)
+            {
+                m_Out.push_back(static_cast<uint8_t>(symbol));
+                continue;
+            }
+            if (symbol == 256)
+                return;
+
+            symbol -= 257;
+            if (symbol >= lengthBase.size())
+            {
+                m_Failed = true;
+                return;
+            }
+            const uint32_t length = lengthBase[symbol] + Bits(lengthExtra[symbol]);
+
+            symbol = Decode(distances);
+            if (symbol >= distanceBase.size())
+            {
+                m_Failed = true;
+                return;
+            }
+            const uint32_t distance = distanceBase[symbol] + Bits(distanceExtra[symbol]);
+            if (distance > m_Out.size())
+            {
+                m_Failed = true;
+                return;
+            }
+
+            // byte by byte since the copy may overlap what it is writing
+            const size_t from = m_Out.size() - distance;
+            for (uint32_t idx{}; idx < length; ++idx)
+                m_Out.push_back(m_Out[from + idx]);
+        }
+    }
+
+    void Fixed() SRK_NOEXCEPT
+    {
+        std::array<uint8_t, 288> lengths{};
+        std::fill(lengths.begin(), lengths.begin() + 144, uint8_t{8});
+        std::fill(lengths.begin() + 144, lengths.begin() + 256, uint8_t{9});
+        std::fill(lengths.begin() + 256, lengths.begin() + 280, uint8_t{7});
+        std::fill(lengths.begin() + 280, lengths.end(), uint8_t{8});
+
+        std::array<uint8_t, 30> distanceLengths{};
+        distanceLengths.fill(5);
+
+        Huffman lengthCode, distanceCode;
+        buildHuffman(lengthCode, lengths.data(), 288);
+        buildHuffman(distanceCode, distanceLengths.data(), 30);
+        Codes(lengthCode, distanceCode);
+    }
+
+    void Dynamic() SRK_NOEXCEPT
+    {
+        static constexpr std::array<uint8_t, 19> order{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        const uint32_t lengthCount   = Bits(5) + 257;
+        const uint32_t distanceCount = Bits(5) + 1;
+        const uint32_t codeCount     = Bits(4) + 4;
+        if (m_Failed || lengthCount > 286 || distanceCount > 30)
+        {
+            m_Failed = true;
+            return;
+        }
+
+        std::array<uint8_t, 320> lengths{};
+        for (uint32_t idx{}; idx < codeCount; ++idx)
+            lengths[order[idx]] = static_cast<uint8_t>(Bits(3));
+
+        Huffman code;
+        if (!buildHuffman(code, lengths.data(), 19))
+        {
+            m_Failed = true;
+            return;
+        }
+
+        // the literal/length and distance lengths are one run length encoded list
+        lengths.fill(0);
+        uint32_t index{0};
+        while (index < lengthCount + distanceCount && !m_Failed)
+        {
+            const uint32_t symbol = Decode(code);
+            if (symbol < 16)
+            {
+                lengths[index++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+
+            uint8_t  repeated{0};
+            uint32_t count{0};
+            if (symbol == 16)
+            {
+                if (index == 0)
+                {
+                    m_Failed = true;
+                    return;
+                }
+                repeated = lengths[index - 1];
+                count    = 3 + Bits(2);
+            }
+            else
+            {
+                count = symbol == 17 ? 3 + Bits(3) : 11 + Bits(7);
+            }
+
+            if (index + count > lengthCount + distanceCount)
+            {
+                m_Failed = true;
+                return;
+            }
+            std::fill(lengths.begin() + index, lengths.begin() + index + count, repeated);
+            index += count;
+        }
+
+        Huffman lengthCode, distanceCode;
+        if (m_Failed || lengths[256] == 0 || !buildHuffman(lengthCode, lengths.data(), lengthCount) ||
+            !buildHuffman(distanceCode, lengths.data() + lengthCount, distanceCount))
+        {
+            m_Failed = true;
+            return;
+        }
+        Codes(lengthCode, distanceCode);
+    }
+
+private:
+    const uint8_t*        m_Data;
+    size_t                m_Size;
+    size_t                m_Position;
+    uint32_t              m_Bits;
+    uint32_t              m_BitCount;
+    bool                  m_Failed;
+    std::vector<uint8_t>& m_Out;
+};
+
+uint8_t paeth(int32_t left, int32_t up, int32_t upLeft) SRK_NOEXCEPT
+{
+    const int32_t estimate = left + up - upLeft;
+    const int32_t toLeft   = std::abs(estimate - left);
+    const int32_t toUp     = std::abs(estimate - up);
+    const int32_t toCorner = std::abs(estimate - upLeft);
+    if (toLeft <= toUp && toLeft <= toCorner)
+        return static_cast<uint8_t>(left);
+    return static_cast<uint8_t>(toUp <= toCorner ? up : upLeft);
+}
+
+// integer bt.601 limited range, the usual fixed point approximation
+uint8_t lumaOf(uint32_t r, uint32_t g, uint32_t b) SRK_NOEXCEPT
+{
+    return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+uint8_t blueDifferenceOf(int32_t r, int32_t g, int32_t b) SRK_NOEXCEPT
+{
+    return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+uint8_t redDifferenceOf(int32_t r, int32_t g, int32_t b) SRK_NOEXCEPT
+{
+    return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+} // namespace
+
+bool ReadPng(const std::string& path, Image& image) SRK_NOEXCEPT
+{
+    MappedFile file(path);
+    if (!file.IsValid())
+        return false;
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(file.Data());
+    const size_t   size = file.Size();
+    if (size < pngSignature.size() || std::memcmp(data, pngSignature.data(), pngSignature.size()) != 0)
+    {
+        SRK_CORE_ERROR("{} is not a png", path);
+        return false;
+    }
+
+    uint32_t             width{0};
+    uint32_t             height{0};
+    uint32_t             channels{0};
+    std::vector<uint8_t> compressed;
+    for (size_t offset = pngSignature.size(); offset + 12 <= size;)
+    {
+        const uint32_t length = readBigEndian(data + offset);
+        const uint8_t* type   = data + offset + 4;
+        const uint8_t* chunk  = data + offset + 8;
+        if (length > size - offset - 12)
+            break;
+
+        if (std::memcmp(type, "IHDR", 4) == 0 && length == 13)
+        {
+            width  = readBigEndian(chunk);
+            height = readBigEndian(chunk + 4);
+            if (chunk[8] != 8 || (chunk[9] != pngColorRgb && chunk[9] != pngColorRgba) || chunk[12] != 0)
+            {
+                SRK_CORE_ERROR("{} has to be an 8 bit rgb or rgba png without interlacing", path);
+                return false;
+            }
+            channels = chunk[9] == pngColorRgba ? 4 : 3;
+        }
+        else if (std::memcmp(type, "IDAT", 4) == 0)
+        {
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        }
+        else if (std::memcmp(type, "IEND", 4) == 0)
+        {
+            break;
+        }
+
+        offset += 12 + size_t{length};
+    }
+
+    // zlib header: deflate and no preset dictionary
+    if (channels == 0 || width == 0 || height == 0 || compressed.size() < 2 || (compressed[0] & 0x0F) != 8 || (compressed[1] & 0x20) != 0)
+    {
+        SRK_CORE_ERROR("{} is missing its header or image data", path);
+        return false;
+    }
+
+    const size_t         stride = size_t{width} * channels;
+    std::vector<uint8_t> raw;
+    raw.reserve((stride + 1) * height);
+    Inflater inflater(compressed.data() + 2, compressed.size() - 2, raw);
+    if (!inflater.Run() || raw.size() < (stride + 1) * height)
+    {
+        SRK_CORE_ERROR("{} has corrupt image data", path);
+        return false;
+    }
+
+    // filters work on the bytes of the pixel to the left, the one above and the one above left
+    for (uint32_t y{}; y < height; ++y)
+    {
+        uint8_t*       row      = raw.data() + (stride + 1) * y + 1;
+        const uint8_t* previous = y > 0 ? row - (stride + 1) : nullptr;
+        const uint8_t  filter   = row[-1];
+        for (size_t x{}; x < stride; ++x)
+        {
+            const int32_t left   = x >= channels ? row[x - channels] : 0;
+            const int32_t up     = previous ? previous[x] : 0;
+            const int32_t upLeft = previous && x >= channels ? previous[x - channels] : 0;
+            switch (filter)
+            {
+                case 0:
+                    break;
+                case 1:
+                    row[x] = static_cast<uint8_t>(row[x] + left);
+                    break;
+                case 2:
+                    row[x] = static_cast<uint8_t>(row[x] + up);
+                    break;
+                case 3:
+                    row[x] = static_cast<uint8_t>(row[x] + (left + up) / 2);
+                    break;
+                case 4:
+                    row[x] = static_cast<uint8_t>(row[x] + paeth(left, up, upLeft));
+                    break;
+                default:
+                    SRK_CORE_ERROR("{} uses unknown filter {}", path, uint32_t{filter});
+                    return false;
+            }
+        }
+    }
+
+    image.Width  = width;
+    image.Height = height;
+    image.Pixels.resize(size_t{width} * height * 4);
+    for (uint32_t y{}; y < height; ++y)
+    {
+        const uint8_t* row = raw.data() + (stride + 1) * y + 1;
+        for (uint32_t x{}; x < width; ++x)
+        {
+            uint8_t* pixel = image.Pixels.data() + (size_t{width} * y + x) * 4;
+            pixel[0]       = row[x * channels + 0];
+            pixel[1]       = row[x * channels + 1];
+            pixel[2]       = row[x * channels + 2];
+            pixel[3]       = channels == 4 ? row[x * channels + 3] : 255;
+        }
+    }
+
+    return true;
+}
+
+uint32_t MipCount(uint32_t width, uint32_t height) SRK_NOEXCEPT
+{
+    uint32_t count = 1;
+    for (uint32_t largest = std::max(width, height); largest > 1; largest >>= 1)
+        ++count;
+    return count;
+}
+
+bool DownsampleMip(const Image& image, uint32_t mip, uint8_t* dst, size_t size) SRK_NOEXCEPT
+{
+    if (mip >= MipCount(image.Width, image.Height))
+        return false;
+
+    const uint32_t width  = std::max(image.Width >> mip, 1u);
+    const uint32_t height = std::max(image.Height >> mip, 1u);
+    if (size != size_t{width} * height * 4)
+        return false;
+
+    // every texel of the mip covers a block of the image, the edges of odd sizes get whatever is left of it
+    for (uint32_t y{}; y < height; ++y)
+    {
+        const uint32_t top    = static_cast<uint32_t>(uint64_t{y} * image.Height / height);
+        const uint32_t bottom = std::max(static_cast<uint32_t>(uint64_t{y + 1} * image.Height / height), top + 1);
+        for (uint32_t x{}; x < width; ++x)
+        {
+            const uint32_t left  = static_cast<uint32_t>(uint64_t{x} * image.Width / width);
+            const uint32_t right = std::max(static_cast<uint32_t>(uint64_t{x + 1} * image.Width / width), left + 1);
+
+            std::array<uint32_t, 4> sum{};
+            for (uint32_t row = top; row < bottom; ++row)
+            {
+                const uint8_t* pixel = image.Pixels.data() + (size_t{image.Width} * row + left) * 4;
+                for (uint32_t column = left; column < right; ++column, pixel += 4)
+                {
+                    for (uint32_t channel{}; channel < 4; ++channel)
+                        sum[channel] += pixel[channel];
+                }
+            }
+
+            const uint32_t count = (bottom - top) * (right - left);
+            uint8_t*       out   = dst + (size_t{width} * y + x) * 4;
+            for (uint32_t channel{}; channel < 4; ++channel)
+                out[channel] = static_cast<uint8_t>((sum[channel] + count / 2) / count);
+        }
+    }
+
+    return true;
+}
+
+bool WritePng(const std::string& path, const uint8_t* rgba, uint32_t width, uint32_t height) SRK_NOEXCEPT
+{
+    if (width == 0 || height == 0)
+    {
+        SRK_CORE_ERROR("{} has no pixels to write", path);
+        return false;
+    }
+
+    // every row starts with its filter type, 0 is none
+    const size_t         rowSize = 1 + size_t{width} * 3;
+    std::vector<uint8_t> raw(rowSize * height);
+    for (uint32_t y{}; y < height; ++y)
+    {
+        uint8_t*       row    = raw.data() + rowSize * y;
+        const uint8_t* source = rgba + size_t{width} * 4 * y;
+        row[0]                = 0;
+        for (uint32_t x{}; x < width; ++x)
+        {
+            row[1 + x * 3 + 0] = source[x * 4 + 0];
+            row[1 + x * 3 + 1] = source[x * 4 + 1];
+            row[1 + x * 3 + 2] = source[x * 4 + 2];
+        }
+    }
+
+    const std::vector<uint8_t> compressed = storeZlib(raw);
+
+    std::array<uint8_t, 13> header{};
+    header[0]  = static_cast<uint8_t>(width >> 24);
+    header[1]  = static_cast<uint8_t>(width >> 16);
+    header[2]  = static_cast<uint8_t>(width >> 8);
+    header[3]  = static_cast<uint8_t>(width);
+    header[4]  = static_cast<uint8_t>(height >> 24);
+    header[5]  = static_cast<uint8_t>(height >> 16);
+    header[6]  = static_cast<uint8_t>(height >> 8);
+    header[7]  = static_cast<uint8_t>(height);
+    header[8]  = 8; // bits per channel
+    header[9]  = pngColorRgb;
+    header[10] = 0; // compression, filter and interlace methods
+    header[11] = 0;
+    header[12] = 0;
+
+    std::vector<uint8_t> file;
+    file.reserve(compressed.size() + 64);
+    file.insert(file.end(), pngSignature.begin(), pngSignature.end());
+    putChunk(file, "IHDR", header.data(), header.size());
+    putChunk(file, "IDAT", compressed.data(), compressed.size());
+    putChunk(file, "IEND", nullptr, 0);
+
+    return writeFile(path, file.data(), file.size());
+}
+
+Y4mWriter::~Y4mWriter() SRK_NOEXCEPT
+{
+    Close();
+}
+
+bool Y4mWriter::Open(const std::string& path, uint32_t width, uint32_t height, uint32_t framesPerSecond) SRK_NOEXCEPT
+{
+    Close();
+    if (width == 0 || height == 0)
+    {
+        SRK_CORE_ERROR("{} has no pixels to write", path);
+        return false;
+    }
+
+    m_File = std::fopen(path.c_str(), "wb");
+    if (!m_File)
+    {
+        SRK_CORE_ERROR("{} could not be opened for writing", path);
+        return false;
+    }
+
+    m_Width  = width;
+    m_Height = height;
+    m_Planes.resize(size_t{width} * height + 2 * size_t{(width + 1) / 2} * ((height + 1) / 2));
+
+    // progressive, square pixels, chroma sited between the luma samples like jpeg
+    std::string header = fmt::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C420jpeg\n", width, height, framesPerSecond);
+    if (std::fwrite(header.data(), 1, header.size(), m_File) != header.size())
+    {
+        SRK_CORE_ERROR("{} could not be written", path);
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool Y4mWriter::WriteFrame(const uint8_t* rgba) SRK_NOEXCEPT
+{
+    if (!m_File)
+        return false;
+
+    const uint32_t chromaWidth  = (m_Width + 1) / 2;
+    const uint32_t chromaHeight = (m_Height + 1) / 2;
+    uint8_t*       luma         = m_Planes.data();
+    uint8_t*       blue         = luma + size_t{m_Width} * m_Height;
+    uint8_t*       red          = blue + size_t{chromaWidth} * chromaHeight;
+
+    for (uint32_t y{}; y < m_Height; ++y)
+    {
+        const uint8_t* row = rgba + size_t{m_Width} * 4 * y;
+        for (uint32_t x{}; x < m_Width; ++x)
+            luma[size_t{m_Width} * y + x] = lumaOf(row[x * 4 + 0], row[x * 4 + 1], row[x * 4 + 2]);
+    }
+
+    // chroma from the average of each 2x2 block, odd edges reuse the last row or column
+    for (uint32_t y{}; y < chromaHeight; ++y)
+    {
+        const uint32_t top    = y * 2;
+        const uint32_t bottom = std::min(top + 1, m_Height - 1);
+        for (uint32_t x{}; x < chromaWidth; ++x)
+        {
+            const uint32_t left  = x * 2;
+            const uint32_t right = std::min(left + 1, m_Width - 1);
+
+            std::array<int32_t, 3> sum{};
+            for (uint32_t row : {top, bottom})
+            {
+                for (uint32_t column : {left, right})
+                {
+                    const uint8_t* pixel = rgba + (size_t{m_Width} * row + column) * 4;
+                    sum[0] += pixel[0];
+                    sum[1] += pixel[1];
+                    sum[2] += pixel[2];
+                }
+            }
+
+            const int32_t r = (sum[0] + 2) / 4;
+            const int32_t g = (sum[1] + 2) / 4;
+            const int32_t b = (sum[2] + 2) / 4;
+
+            blue[size_t{chromaWidth} * y + x] = blueDifferenceOf(r, g, b);
+            red[size_t{chromaWidth} * y + x]  = redDifferenceOf(r, g, b);
+        }
+    }
+
+    constexpr char frameHeader[] = "FRAME\n";
+    if (std::fwrite(frameHeader, 1, sizeof(frameHeader) - 1, m_File) != sizeof(frameHeader) - 1 ||
+        std::fwrite(m_Planes.data(), 1, m_Planes.size(), m_File) != m_Planes.size())
+    {
+        SRK_CORE_ERROR("Y4M frame could not be written, the stream is closed");
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void Y4mWriter::Close() SRK_NOEXCEPT
+{
+    if (m_File)
+        std::fclose(m_File);
+
+    m_File   = nullptr;
+    m_Width  = 0;
+    m_Height = 0;
+}
+
+} // namespace shrek::asset
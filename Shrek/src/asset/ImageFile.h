@@ -0,0 +1,61 @@
+#pragma once
+#include "defs.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace shrek::asset {
+
+// every reader and writer works on tightly packed 8 bit rgba rows, top row first
+
+struct Image
+{
+    uint32_t             Width{0};
+    uint32_t             Height{0};
+    std::vector<uint8_t> Pixels;
+};
+
+// 8 bit rgb and rgba pngs, not interlaced. false (and logged) for anything else or a corrupt file
+bool ReadPng(const std::string& path, Image& image) SRK_NOEXCEPT;
+
+// mips halve each side (down to 1) of the one before them
+uint32_t MipCount(uint32_t width, uint32_t height) SRK_NOEXCEPT;
+// box filters the mip out of the full image into dst, size has to be exactly the mip's. false when it isn't
+bool DownsampleMip(const Image& image, uint32_t mip, uint8_t* dst, size_t size) SRK_NOEXCEPT;
+
+// 8 bit rgb png, the alpha channel is dropped. the deflate stream is stored (not compressed)
+// so writing is bound by the disk, not the cpu
+bool WritePng(const std::string& path, const uint8_t* rgba, uint32_t width, uint32_t height) SRK_NOEXCEPT;
+
+/*
+ *  Raw YUV4MPEG2 video, one frame appended per call and nothing is compressed.
+ *  Frames are converted to bt.601 limited range 4:2:0 which every player and ffmpeg take as is.
+ */
+class Y4mWriter
+{
+public:
+    Y4mWriter() SRK_NOEXCEPT = default;
+    ~Y4mWriter() SRK_NOEXCEPT;
+
+    Y4mWriter(const Y4mWriter& other) = delete;
+    Y4mWriter& operator=(const Y4mWriter& other) = delete;
+
+    bool Open(const std::string& path, uint32_t width, uint32_t height, uint32_t framesPerSecond) SRK_NOEXCEPT;
+    // the frame has to be as big as the one the stream was opened with
+    bool WriteFrame(const uint8_t* rgba) SRK_NOEXCEPT;
+    void Close() SRK_NOEXCEPT;
+
+    bool     IsOpen() const SRK_NOEXCEPT { return m_File != nullptr; }
+    uint32_t GetWidth() const SRK_NOEXCEPT { return m_Width; }
+    uint32_t GetHeight() const SRK_NOEXCEPT { return m_Height; }
+
+private:
+    std::FILE*           m_File{nullptr};
+    uint32_t             m_Width{0};
+    uint32_t             m_Height{0};
+    std::vector<uint8_t> m_Planes; // y, u and v of one frame, reused
+};
+
+} // namespace shrek::asset
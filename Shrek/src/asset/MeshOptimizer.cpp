@@ -0,0 +1,793 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+#include "base/math/Aabb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace shrek::asset {
+
+namespace {
+
+constexpr uint32_t maxCacheSize     = 64;
+constexpr uint32_t valenceTableSize = 32;
+constexpr uint32_t maxSimplifyGrid  = 1024;
+constexpr uint32_t minLodTriangles  = 8;
+constexpr uint32_t invalidIndex     = ~0u;
+
+std::vector<math::Vec3> readPositions(const MeshData& mesh) SRK_NOEXCEPT
+{
+    std::vector<math::Vec3> positions(mesh.VertexCount);
+
+    const MeshData::Stream& stream = mesh.Streams[render::VertexStream_Position];
+    std::memcpy(positions.data(), stream.Data.data(), std::min(stream.Data.size(), positions.size() * sizeof(math::Vec3)));
+    return positions;
+}
+
+math::Vec3 triangleNormal(const math::Vec3& a, const math::Vec3& b, const math::Vec3& c) SRK_NOEXCEPT
+{
+    // not normalized, the length is twice the area
+    return math::Cross(b - a, c - a);
+}
+
+// plane quadric in the form aa ab ac ad bb bc bd cc cd dd
+struct Quadric
+{
+    float m[10]{};
+
+    void AddPlane(const math::Vec3& n, float d, float weight) SRK_NOEXCEPT
+    {
+        m[0] += n.x * n.x * weight;
+        m[1] += n.x * n.y * weight;
+        m[2] += n.x * n.z * weight;
+        m[3] += n.x * d * weight;
+        m[4] += n.y * n.y * weight;
+        m[5] += n.y * n.z * weight;
+        m[6] += n.y * d * weight;
+        m[7] += n.z * n.z * weight;
+        m[8] += n.z * d * weight;
+        m[9] += d * d * weight;
+    }
+
+    void Add(const Quadric& other) SRK_NOEXCEPT
+    {
+        for (uint32_t idx{}; idx < 10; ++idx)
+            m[idx] += other.m[idx];
+    }
+
+    float Error(const math::Vec3& p) const SRK_NOEXCEPT
+    {
+        return m[0] * p.x * p.x + 2.f * m[1] * p.x * p.y + 2.f * m[2] * p.x * p.z + 2.f * m[3] * p.x +
+               m[4] * p.y * p.y + 2.f * m[5] * p.y * p.z + 2.f * m[6] * p.y +
+               m[7] * p.z * p.z + 2.f * m[8] * p.z + m[9];
+    }
+};
+
+struct Triangle
+{
+    uint32_t a, b, c;
+
+    bool operator==(const Triangle& other) const SRK_NOEXCEPT { return a == other.a && b == other.b && c == other.c; }
+};
+
+struct TriangleHash
+{
+    size_t operator()(const Triangle& t) const SRK_NOEXCEPT
+    {
+        uint64_t h = t.a * 0x9E3779B97F4A7C15ull;
+        h ^= (t.b + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2));
+        h ^= (t.c + 0x85157AF5ull + (h << 6) + (h >> 2));
+        return static_cast<size_t>(h);
+    }
+};
+
+class VertexClusterer
+{
+public:
+    VertexClusterer(const uint32_t* indices, size_t indexCount, const math::Vec3* positions, uint32_t vertexCount) SRK_NOEXCEPT :
+        m_Indices(indices),
+        m_IndexCount(indexCount),
+        m_Positions(positions),
+        m_Quadrics(vertexCount),
+        m_Used(vertexCount, false),
+        m_Cluster(vertexCount, invalidIndex)
+    {
+        for (size_t idx{}; idx + 2 < indexCount; idx += 3)
+        {
+            const uint32_t   tri[3] = {indices[idx], indices[idx + 1], indices[idx + 2]};
+            const math::Vec3 normal = triangleNormal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+            const float      area   = math::Length(normal);
+            if (area <= 0.f)
+                continue;
+
+            const math::Vec3 n = normal * (1.f / area);
+            const float      d = -math::Dot(n, positions[tri[0]]);
+            for (uint32_t vertex : tri)
+                m_Quadrics[vertex].AddPlane(n, d, area);
+        }
+
+        for (size_t idx{}; idx < indexCount; ++idx)
+        {
+            m_Used[indices[idx]] = true;
+            m_Bounds.Min         = math::Min(m_Bounds.Min, positions[indices[idx]]);
+            m_Bounds.Max         = math::Max(m_Bounds.Max, positions[indices[idx]]);
+        }
+    }
+
+    // returns the triangles left after snapping every vertex to a grid with the given cells along the longest axis
+    void Run(uint32_t grid, std::vector<uint32_t>& out) SRK_NOEXCEPT
+    {
+        out.clear();
+        if (!m_Bounds.IsValid())
+            return;
+
+        const math::Vec3 size   = m_Bounds.Max - m_Bounds.Min;
+        const float      extent = std::max(std::max(size.x, size.y), std::max(size.z, 1e-6f));
+        const float      scale  = static_cast<float>(grid) / extent;
+
+        m_Cells.clear();
+        m_ClusterQuadrics.clear();
+        for (uint32_t vertex{}; vertex < m_Cluster.size(); ++vertex)
+        {
+            if (!m_Used[vertex])
+                continue;
+
+            uint64_t key{};
+            for (int axis{}; axis < 3; ++axis)
+            {
+                const float cell = (m_Positions[vertex][axis] - m_Bounds.Min[axis]) * scale;
+                key              = key * maxSimplifyGrid + std::min(static_cast<uint32_t>(std::max(cell, 0.f)), grid - 1);
+            }
+
+            auto [it, inserted] = m_Cells.try_emplace(key, static_cast<uint32_t>(m_ClusterQuadrics.size()));
+            if (inserted)
+                m_ClusterQuadrics.emplace_back();
+
+            m_Cluster[vertex] = it->second;
+            m_ClusterQuadrics[it->second].Add(m_Quadrics[vertex]);
+        }
+
+        // every cluster collapses onto its member that sits closest to the cluster's planes
+        m_Representative.assign(m_ClusterQuadrics.size(), invalidIndex);
+        m_RepresentativeError.assign(m_ClusterQuadrics.size(), 0.f);
+        for (uint32_t vertex{}; vertex < m_Cluster.size(); ++vertex)
+        {
+            if (!m_Used[vertex])
+                continue;
+
+            const uint32_t cluster = m_Cluster[vertex];
+            const float    error   = m_ClusterQuadrics[cluster].Error(m_Positions[vertex]);
+            if (m_Representative[cluster] == invalidIndex || error < m_RepresentativeError[cluster])
+            {
+                m_Representative[cluster]      = vertex;
+                m_RepresentativeError[cluster] = error;
+            }
+        }
+
+        m_Seen.clear();
+        for (size_t idx{}; idx + 2 < m_IndexCount; idx += 3)
+        {
+            const uint32_t a = m_Cluster[m_Indices[idx]];
+            const uint32_t b = m_Cluster[m_Indices[idx + 1]];
+            const uint32_t c = m_Cluster[m_Indices[idx + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+
+            // rotate the smallest cluster first so the same triangle always hashes the same, winding is kept
+            Triangle key = a < b && a < c ? Triangle{a, b, c} : (b < c ? Triangle{b, c, a} : Triangle{c, a, b});
+            if (!m_Seen.insert(key).second)
+                continue;
+
+            out.push_back(m_Representative[a]);
+            out.push_back(m_Representative[b]);
+            out.push_back(m_Representative[c]);
+        }
+    }
+
+private:
+    const uint32_t*   m_Indices;
+    size_t            m_IndexCount;
+    const math::Vec3* m_Positions;
+
+    std::vector<Quadric>  m_Quadrics;
+    std::vector<bool>     m_Used;
+    std::vector<uint32_t> m_Cluster;
+    math::Aabb            m_Bounds;
+
+    std::unordered_map<uint64_t, uint32_t>     m_Cells;
+    std::vector<Quadric>                       m_ClusterQuadrics;
+    std::vector<uint32_t>                      m_Representative;
+    std::vector<float>                         m_RepresentativeError;
+    std::unordered_set<Triangle, TriangleHash> m_Seen;
+};
+
+void finishMeshlet(MeshData& mesh, render::Meshlet& meshlet, const std::vector<math::Vec3>& positions, std::vector<uint32_t>& local) SRK_NOEXCEPT
+{
+    if (meshlet.TriangleCount == 0)
+        return;
+
+    const uint32_t* vertices  = mesh.MeshletVertices.data() + meshlet.VertexOffset;
+    const uint8_t*  triangles = mesh.MeshletTriangles.data() + meshlet.TriangleOffset;
+
+    math::Aabb box;
+    for (uint32_t idx{}; idx < meshlet.VertexCount; ++idx)
+    {
+        box.Min = math::Min(box.Min, positions[vertices[idx]]);
+        box.Max = math::Max(box.Max, positions[vertices[idx]]);
+    }
+
+    meshlet.Center = box.Center();
+    meshlet.Radius = 0.f;
+    for (uint32_t idx{}; idx < meshlet.VertexCount; ++idx)
+        meshlet.Radius = std::max(meshlet.Radius, math::Length(positions[vertices[idx]] - meshlet.Center));
+
+    // normal cone, the average direction and the widest angle any triangle strays from it
+    math::Vec3 axis{};
+    for (uint32_t tri{}; tri < meshlet.TriangleCount; ++tri)
+    {
+        const uint8_t* t = triangles + tri * 3;
+        axis             = axis + math::Normalize(triangleNormal(positions[vertices[t[0]]], positions[vertices[t[1]]], positions[vertices[t[2]]]));
+    }
+    axis = math::Normalize(axis);
+
+    float minDot = 1.f;
+    for (uint32_t tri{}; tri < meshlet.TriangleCount; ++tri)
+    {
+        const uint8_t* t = triangles + tri * 3;
+        minDot           = std::min(minDot, math::Dot(axis, math::Normalize(triangleNormal(positions[vertices[t[0]]], positions[vertices[t[1]]], positions[vertices[t[2]]]))));
+    }
+
+    if (minDot <= 0.1f)
+    {
+        // spread over more than ~84 degrees, some triangle always faces the camera
+        meshlet.ConeApex   = meshlet.Center;
+        meshlet.ConeAxis   = math::Vec3{};
+        meshlet.ConeCutoff = 1.f;
+    }
+    else
+    {
+        // move the apex back until every triangle's plane is in front of it
+        float maxT = 0.f;
+        for (uint32_t tri{}; tri < meshlet.TriangleCount; ++tri)
+        {
+            const uint8_t*   t      = triangles + tri * 3;
+            const math::Vec3 p0     = positions[vertices[t[0]]];
+            const math::Vec3 normal = math::Normalize(triangleNormal(p0, positions[vertices[t[1]]], positions[vertices[t[2]]]));
+            const float      dn     = math::Dot(axis, normal);
+            if (dn > 0.f)
+                maxT = std::max(maxT, math::Dot(meshlet.Center - p0, normal) / dn);
+        }
+
+        meshlet.ConeApex   = meshlet.Center - axis * maxT;
+        meshlet.ConeAxis   = axis;
+        meshlet.ConeCutoff = std::sqrt(1.f - minDot * minDot);
+    }
+
+    for (uint32_t idx{}; idx < meshlet.VertexCount; ++idx)
+        local[vertices[idx]] = invalidIndex;
+
+    // keep the next meshlet's triangles 4 byte aligned so shaders can fetch them as words
+    while (mesh.MeshletTriangles.size() % 4 != 0)
+        mesh.MeshletTriangles.push_back(0);
+
+    mesh.Meshlets.push_back(meshlet);
+}
+
+int8_t toSnorm8(float value) SRK_NOEXCEPT
+{
+    return static_cast<int8_t>(std::lround(std::clamp(value, -1.f, 1.f) * 127.f));
+}
+
+uint16_t toHalf(float value) SRK_NOEXCEPT
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t abs  = bits & 0x7FFFFFFF;
+
+    if (abs >= 0x7F800000)
+        return static_cast<uint16_t>(sign | (abs > 0x7F800000 ? 0x7E00 : 0x7C00));
+    if (abs >= 0x477FF000) // rounds past 65504
+        return static_cast<uint16_t>(sign | 0x7C00);
+    if (abs < 0x38800000) // below the smallest normal half
+    {
+        float magnitude;
+        std::memcpy(&magnitude, &abs, sizeof(magnitude));
+        return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::lround(magnitude * 16777216.f)));
+    }
+
+    // rebias the exponent and round to nearest even
+    const uint32_t rebiased = abs - 0x38000000;
+    return static_cast<uint16_t>(sign | ((rebiased + 0x0FFF + ((rebiased >> 13) & 1)) >> 13));
+}
+
+template<typename Dst, uint32_t Components, typename Convert>
+void quantizeStream(MeshData::Stream& stream, uint32_t vertexCount, uint32_t srcComponents, VkFormat format, Convert convert) SRK_NOEXCEPT
+{
+    std::vector<std::byte> packed(static_cast<size_t>(vertexCount) * sizeof(Dst) * Components);
+    for (uint32_t vertex{}; vertex < vertexCount; ++vertex)
+    {
+        float src[4]{};
+        std::memcpy(src, stream.Data.data() + static_cast<size_t>(vertex) * stream.Stride, srcComponents * sizeof(float));
+
+        Dst dst[Components]{};
+        for (uint32_t idx{}; idx < srcComponents; ++idx)
+            dst[idx] = convert(src[idx]);
+        std::memcpy(packed.data() + static_cast<size_t>(vertex) * sizeof(dst), dst, sizeof(dst));
+    }
+
+    stream.Data   = std::move(packed);
+    stream.Stride = sizeof(Dst) * Components;
+    stream.Format = format;
+}
+
+bool allocateCopy(render::StagingBuffer& staging, const void* data, size_t size, VkDeviceSize alignment, render::StagingAllocation& out) SRK_NOEXCEPT
+{
+    out = staging.Allocate(size, alignment);
+    if (!out.IsValid())
+        return false;
+
+    std::memcpy(out.Data, data, size);
+    return true;
+}
+
+} // namespace
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize) SRK_NOEXCEPT
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2 || vertexCount == 0)
+        return;
+
+    cacheSize = std::clamp(cacheSize, 4u, maxCacheSize);
+
+    // scoring functions from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+    float cacheScores[maxCacheSize];
+    for (uint32_t position{}; position < cacheSize; ++position)
+        cacheScores[position] = position < 3 ? 0.75f : std::pow(1.f - static_cast<float>(position - 3) / static_cast<float>(cacheSize - 3), 1.5f);
+
+    float valenceScores[valenceTableSize]{};
+    for (uint32_t valence = 1; valence < valenceTableSize; ++valence)
+        valenceScores[valence] = 2.f / std::sqrt(static_cast<float>(valence));
+
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (size_t idx{}; idx < triangleCount * 3; ++idx)
+        ++live[indices[idx]];
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t vertex{}; vertex < vertexCount; ++vertex)
+        offsets[vertex + 1] = offsets[vertex] + live[vertex];
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t idx{}; idx < triangleCount * 3; ++idx)
+            adjacency[cursor[indices[idx]]++] = static_cast<uint32_t>(idx / 3);
+    }
+
+    std::vector<int32_t> cachePosition(vertexCount, -1);
+    std::vector<float>   vertexScores(vertexCount);
+
+    auto vertexScore = [&](uint32_t vertex) {
+        const uint32_t valence  = live[vertex];
+        const int32_t  position = cachePosition[vertex];
+
+        float score = position >= 0 ? cacheScores[position] : 0.f;
+        score += valence < valenceTableSize ? valenceScores[valence] : 2.f / std::sqrt(static_cast<float>(valence));
+        return valence == 0 ? 0.f : score;
+    };
+
+    for (uint32_t vertex{}; vertex < vertexCount; ++vertex)
+        vertexScores[vertex] = vertexScore(vertex);
+
+    std::vector<float> triangleScores(triangleCount);
+    size_t             best      = 0;
+    float              bestScore = -1.f;
+    for (size_t tri{}; tri < triangleCount; ++tri)
+    {
+        triangleScores[tri] = vertexScores[indices[tri * 3]] + vertexScores[indices[tri * 3 + 1]] + vertexScores[indices[tri * 3 + 2]];
+        if (triangleScores[tri] > bestScore)
+        {
+            best      = tri;
+            bestScore = triangleScores[tri];
+        }
+    }
+
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+
+    uint32_t cache[maxCacheSize + 3];
+    uint32_t newCache[maxCacheSize + 3];
+    uint32_t cacheCount{0};
+    size_t   cursor{0};
+
+    while (best < triangleCount)
+    {
+        const uint32_t tri[3] = {indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2]};
+        emitted[best]         = true;
+        output.insert(output.end(), tri, tri + 3);
+
+        // the triangle's vertices move to the front, everything else is pushed back and may fall out
+        uint32_t newCount{0};
+        for (uint32_t vertex : tri)
+            newCache[newCount++] = vertex;
+        for (uint32_t idx{}; idx < cacheCount; ++idx)
+        {
+            if (cache[idx] != tri[0] && cache[idx] != tri[1] && cache[idx] != tri[2])
+                newCache[newCount++] = cache[idx];
+        }
+
+        for (uint32_t vertex : tri)
+        {
+            uint32_t* begin = adjacency.data() + offsets[vertex];
+            for (uint32_t idx{}; idx < live[vertex]; ++idx)
+            {
+                if (begin[idx] == best)
+                {
+                    begin[idx] = begin[--live[vertex]];
+                    break;
+                }
+            }
+        }
+
+        for (uint32_t idx{}; idx < newCount; ++idx)
+        {
+            const uint32_t vertex = newCache[idx];
+            cachePosition[vertex] = idx < cacheSize ? static_cast<int32_t>(idx) : -1;
+            vertexScores[vertex]  = vertexScore(vertex);
+        }
+
+        cacheCount = std::min(newCount, cacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        // only triangles touching a vertex whose score changed can become the next best one
+        best      = triangleCount;
+        bestScore = -1.f;
+        for (uint32_t idx{}; idx < newCount; ++idx)
+        {
+            const uint32_t  vertex = newCache[idx];
+            const uint32_t* begin  = adjacency.data() + offsets[vertex];
+            for (uint32_t adj{}; adj < live[vertex]; ++adj)
+            {
+                const uint32_t t  = begin[adj];
+                triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                if (triangleScores[t] > bestScore)
+                {
+                    best      = t;
+                    bestScore = triangleScores[t];
+                }
+            }
+        }
+
+        // dead end, carry on with the next triangle that is still left
+        if (best == triangleCount)
+        {
+            while (cursor < triangleCount && emitted[cursor])
+                ++cursor;
+            best = cursor;
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const math::Vec3* positions, uint32_t cacheSize) SRK_NOEXCEPT
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    uint32_t vertexCount{0};
+    for (size_t idx{}; idx < triangleCount * 3; ++idx)
+        vertexCount = std::max(vertexCount, indices[idx] + 1);
+
+    // a cluster starts wherever the cache order had to start over, reordering whole clusters keeps the cache hits
+    std::vector<uint32_t> clusters;
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t              time = cacheSize + 1;
+    for (size_t tri{}; tri < triangleCount; ++tri)
+    {
+        uint32_t misses{0};
+        for (uint32_t corner{}; corner < 3; ++corner)
+        {
+            const uint32_t vertex = indices[tri * 3 + corner];
+            if (time - timestamps[vertex] > cacheSize)
+            {
+                timestamps[vertex] = time++;
+                ++misses;
+            }
+        }
+
+        if (tri == 0 || misses == 3)
+            clusters.push_back(static_cast<uint32_t>(tri));
+    }
+    clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+    const size_t clusterCount = clusters.size() - 1;
+    if (clusterCount < 2)
+        return;
+
+    std::vector<math::Vec3> centroids(clusterCount);
+    std::vector<math::Vec3> normals(clusterCount);
+    math::Vec3              meshCentroid{};
+    float                   meshArea{0.f};
+
+    for (size_t cluster{}; cluster < clusterCount; ++cluster)
+    {
+        math::Vec3 centroid{};
+        float      area{0.f};
+        for (uint32_t tri = clusters[cluster]; tri < clusters[cluster + 1]; ++tri)
+        {
+            const math::Vec3& a      = positions[indices[tri * 3]];
+            const math::Vec3& b      = positions[indices[tri * 3 + 1]];
+            const math::Vec3& c      = positions[indices[tri * 3 + 2]];
+            const math::Vec3  normal = triangleNormal(a, b, c);
+            const float       weight = math::Length(normal);
+
+            centroid         = centroid + (a + b + c) * (weight / 3.f);
+            normals[cluster] = normals[cluster] + normal;
+            area += weight;
+        }
+
+        centroids[cluster] = area > 0.f ? centroid * (1.f / area) : positions[indices[clusters[cluster] * 3]];
+        meshCentroid       = meshCentroid + centroid;
+        meshArea += area;
+    }
+    meshCentroid = meshArea > 0.f ? meshCentroid * (1.f / meshArea) : meshCentroid;
+
+    // clusters facing away from the middle of the mesh are the likely occluders, draw those first
+    std::vector<float>    sortKeys(clusterCount);
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t cluster{}; cluster < clusterCount; ++cluster)
+    {
+        sortKeys[cluster] = math::Dot(centroids[cluster] - meshCentroid, math::Normalize(normals[cluster]));
+        order[cluster]    = static_cast<uint32_t>(cluster);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(triangleCount * 3);
+    for (uint32_t cluster : order)
+        sorted.insert(sorted.end(), indices + clusters[cluster] * 3, indices + clusters[cluster + 1] * 3);
+
+    std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+uint32_t OptimizeVertexFetch(uint32_t* indices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap) SRK_NOEXCEPT
+{
+    remap.assign(vertexCount, invalidIndex);
+
+    uint32_t next{0};
+    for (size_t idx{}; idx < indexCount; ++idx)
+    {
+        uint32_t& mapped = remap[indices[idx]];
+        if (mapped == invalidIndex)
+            mapped = next++;
+        indices[idx] = mapped;
+    }
+
+    return next;
+}
+
+size_t SimplifyMesh(uint32_t* dst, const uint32_t* indices, size_t indexCount, const math::Vec3* positions, uint32_t vertexCount, size_t targetIndexCount, float& error) SRK_NOEXCEPT
+{
+    VertexClusterer       clusterer(indices, indexCount, positions, vertexCount);
+    std::vector<uint32_t> result;
+
+    // the triangle count only grows with the grid resolution, look for the finest grid that still fits
+    uint32_t low{1};
+    uint32_t high{maxSimplifyGrid};
+
+    clusterer.Run(high, result);
+    if (result.size() > targetIndexCount)
+    {
+        while (high - low > 1)
+        {
+            const uint32_t middle = low + (high - low) / 2;
+            clusterer.Run(middle, result);
+            if (result.size() <= targetIndexCount)
+                low = middle;
+            else
+                high = middle;
+        }
+
+        clusterer.Run(low, result);
+        high = low;
+    }
+
+    error = 1.f / static_cast<float>(high);
+
+    const size_t count = std::min(result.size(), targetIndexCount);
+    std::copy(result.begin(), result.begin() + count, dst);
+    return count;
+}
+
+void BuildMeshlets(MeshData& mesh, size_t indexCount, uint32_t maxVertices, uint32_t maxTriangles) SRK_NOEXCEPT
+{
+    mesh.Meshlets.clear();
+    mesh.MeshletVertices.clear();
+    mesh.MeshletTriangles.clear();
+
+    // local indices are stored as bytes
+    maxVertices  = std::clamp(maxVertices, 3u, 256u);
+    maxTriangles = std::max(maxTriangles, 1u);
+
+    const std::vector<math::Vec3> positions = readPositions(mesh);
+    std::vector<uint32_t>         local(mesh.VertexCount, invalidIndex);
+
+    render::Meshlet meshlet;
+    for (size_t idx{}; idx + 2 < indexCount; idx += 3)
+    {
+        const uint32_t* tri = mesh.Indices.data() + idx;
+
+        uint32_t added{0};
+        for (uint32_t corner{}; corner < 3; ++corner)
+        {
+            const bool repeated = (corner > 0 && tri[corner] == tri[0]) || (corner > 1 && tri[corner] == tri[1]);
+            added += local[tri[corner]] == invalidIndex && !repeated;
+        }
+
+        if (meshlet.VertexCount + added > maxVertices || meshlet.TriangleCount == maxTriangles)
+        {
+            finishMeshlet(mesh, meshlet, positions, local);
+            meshlet                = render::Meshlet{};
+            meshlet.VertexOffset   = static_cast<uint32_t>(mesh.MeshletVertices.size());
+            meshlet.TriangleOffset = static_cast<uint32_t>(mesh.MeshletTriangles.size());
+        }
+
+        for (uint32_t corner{}; corner < 3; ++corner)
+        {
+            uint32_t& slot = local[tri[corner]];
+            if (slot == invalidIndex)
+            {
+                slot = meshlet.VertexCount++;
+                mesh.MeshletVertices.push_back(tri[corner]);
+            }
+            mesh.MeshletTriangles.push_back(static_cast<uint8_t>(slot));
+        }
+        ++meshlet.TriangleCount;
+    }
+
+    finishMeshlet(mesh, meshlet, positions, local);
+}
+
+void QuantizeStreams(MeshData& mesh) SRK_NOEXCEPT
+{
+    MeshData::Stream& normal = mesh.Streams[render::VertexStream_Normal];
+    if (normal.Format == VK_FORMAT_R32G32B32_SFLOAT)
+        quantizeStream<int8_t, 4>(normal, mesh.VertexCount, 3, VK_FORMAT_R8G8B8A8_SNORM, toSnorm8);
+
+    // w only carries the bitangent sign, 8 bits are plenty
+    MeshData::Stream& tangent = mesh.Streams[render::VertexStream_Tangent];
+    if (tangent.Format == VK_FORMAT_R32G32B32A32_SFLOAT)
+        quantizeStream<int8_t, 4>(tangent, mesh.VertexCount, 4, VK_FORMAT_R8G8B8A8_SNORM, toSnorm8);
+
+    MeshData::Stream& texCoord = mesh.Streams[render::VertexStream_TexCoord0];
+    if (texCoord.Format == VK_FORMAT_R32G32_SFLOAT)
+        quantizeStream<uint16_t, 2>(texCoord, mesh.VertexCount, 2, VK_FORMAT_R16G16_SFLOAT, toHalf);
+}
+
+void OptimizeMesh(MeshData& mesh, const MeshOptimizeSettings& settings) SRK_NOEXCEPT
+{
+    if (mesh.Indices.empty())
+    {
+        mesh.Indices.resize(mesh.VertexCount);
+        for (uint32_t idx{}; idx < mesh.VertexCount; ++idx)
+            mesh.Indices[idx] = idx;
+    }
+    mesh.Indices.resize(mesh.Indices.size() - mesh.Indices.size() % 3);
+
+    const size_t lod0Count = mesh.Indices.size();
+    {
+        const std::vector<math::Vec3> positions = readPositions(mesh);
+        OptimizeVertexCache(mesh.Indices.data(), lod0Count, mesh.VertexCount, settings.CacheSize);
+        OptimizeOverdraw(mesh.Indices.data(), lod0Count, positions.data(), settings.CacheSize);
+
+        mesh.Lods.clear();
+        mesh.Lods.push_back(render::MeshLod{0, static_cast<uint32_t>(lod0Count), 0.f});
+
+        // every lod is simplified from lod 0 so the error doesn't pile up along the chain
+        std::vector<uint32_t> lod(lod0Count);
+        size_t                target = lod0Count;
+        for (uint32_t level = 1; level < settings.LodCount; ++level)
+        {
+            target = static_cast<size_t>(static_cast<float>(target / 3) * settings.LodReduction) * 3;
+            if (target < minLodTriangles * 3)
+                break;
+
+            float        error{0.f};
+            const size_t count = SimplifyMesh(lod.data(), mesh.Indices.data(), lod0Count, positions.data(), mesh.VertexCount, target, error);
+            if (count == 0)
+                break;
+
+            OptimizeVertexCache(lod.data(), count, mesh.VertexCount, settings.CacheSize);
+
+            mesh.Lods.push_back(render::MeshLod{static_cast<uint32_t>(mesh.Indices.size()), static_cast<uint32_t>(count), error});
+            mesh.Indices.insert(mesh.Indices.end(), lod.begin(), lod.begin() + count);
+            target = count;
+        }
+    }
+
+    // lods only ever pick existing vertices so one remap over every lod covers them all
+    std::vector<uint32_t> remap;
+    const uint32_t        vertexCount = OptimizeVertexFetch(mesh.Indices.data(), mesh.Indices.size(), mesh.VertexCount, remap);
+
+    for (MeshData::Stream& stream : mesh.Streams)
+    {
+        if (stream.Data.empty())
+            continue;
+
+        std::vector<std::byte> reordered(static_cast<size_t>(vertexCount) * stream.Stride);
+        for (uint32_t vertex{}; vertex < mesh.VertexCount; ++vertex)
+        {
+            if (remap[vertex] != invalidIndex)
+                std::memcpy(reordered.data() + static_cast<size_t>(remap[vertex]) * stream.Stride, stream.Data.data() + static_cast<size_t>(vertex) * stream.Stride, stream.Stride);
+        }
+        stream.Data = std::move(reordered);
+    }
+    mesh.VertexCount = vertexCount;
+
+    BuildMeshlets(mesh, lod0Count, settings.MaxMeshletVertices, settings.MaxMeshletTriangles);
+
+    if (settings.Quantize)
+        QuantizeStreams(mesh);
+}
+
+bool WriteMesh(const MeshData& mesh, render::StagingBuffer& staging, render::MeshPrimitive& primitive) SRK_NOEXCEPT
+{
+    for (uint32_t stream{}; stream < render::VertexStream_Count; ++stream)
+    {
+        const MeshData::Stream& src = mesh.Streams[stream];
+        render::MeshStream&     dst = primitive.Streams[stream];
+        if (src.Data.empty())
+            continue;
+
+        dst.Stride = src.Stride;
+        dst.Format = src.Format;
+        if (!allocateCopy(staging, src.Data.data(), src.Data.size(), 16, dst.Data))
+            return false;
+    }
+
+    primitive.VertexCount = mesh.VertexCount;
+    primitive.Lods        = mesh.Lods;
+    primitive.IndexCount  = mesh.Lods.empty() ? static_cast<uint32_t>(mesh.Indices.size()) : mesh.Lods.front().IndexCount;
+
+    // 16 bit indices whenever they fit, 0xFFFF stays free for primitive restart
+    const bool     wide      = mesh.VertexCount > 0xFFFF;
+    const uint32_t indexSize = wide ? 4 : 2;
+
+    primitive.IndexType = wide ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+    primitive.Indices   = staging.Allocate(static_cast<VkDeviceSize>(indexSize) * mesh.Indices.size(), indexSize);
+    if (!primitive.Indices.IsValid())
+        return false;
+
+    if (wide)
+    {
+        std::memcpy(primitive.Indices.Data, mesh.Indices.data(), primitive.Indices.Size);
+    }
+    else
+    {
+        for (size_t idx{}; idx < mesh.Indices.size(); ++idx)
+        {
+            const uint16_t index = static_cast<uint16_t>(mesh.Indices[idx]);
+            std::memcpy(primitive.Indices.Data + idx * sizeof(uint16_t), &index, sizeof(uint16_t));
+        }
+    }
+
+    primitive.MeshletCount = static_cast<uint32_t>(mesh.Meshlets.size());
+    if (mesh.Meshlets.empty())
+        return true;
+
+    return allocateCopy(staging, mesh.Meshlets.data(), mesh.Meshlets.size() * sizeof(render::Meshlet), 16, primitive.Meshlets) &&
+           allocateCopy(staging, mesh.MeshletVertices.data(), mesh.MeshletVertices.size() * sizeof(uint32_t), 4, primitive.MeshletVertices) &&
+           allocateCopy(staging, mesh.MeshletTriangles.data(), mesh.MeshletTriangles.size(), 4, primitive.MeshletTriangles);
+}
+
+} // namespace shrek::asset
@@ -0,0 +1,72 @@
+#pragma once
+#include "defs.h"
+#include "base/math/Vec.h"
+#include "render/Mesh.h"
+#include "render/StagingBuffer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace shrek::asset {
+
+struct MeshOptimizeSettings
+{
+    uint32_t CacheSize{32}; // post transform cache that is optimized for
+    bool     Quantize{true};
+    uint32_t MaxMeshletVertices{64};
+    uint32_t MaxMeshletTriangles{124};
+    uint32_t LodCount{4};        // including lod 0
+    float    LodReduction{0.5f}; // triangle count of a lod relative to the one before it
+};
+
+// cpu side copy of a primitive while it is being optimized, every stream is tightly packed
+struct MeshData
+{
+    struct Stream
+    {
+        std::vector<std::byte> Data;
+        uint32_t               Stride{0};
+        VkFormat               Format{VK_FORMAT_UNDEFINED};
+    };
+
+    std::array<Stream, render::VertexStream_Count> Streams; // positions are always float3
+    std::vector<uint32_t>                         Indices;  // lod 0 followed by the other lods
+    uint32_t                                      VertexCount{0};
+
+    std::vector<render::MeshLod> Lods;
+    std::vector<render::Meshlet> Meshlets;
+    std::vector<uint32_t>        MeshletVertices;
+    std::vector<uint8_t>         MeshletTriangles;
+};
+
+// reorders triangles for the post transform cache (Forsyth's linear speed optimizer)
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize) SRK_NOEXCEPT;
+
+// sorts cache friendly clusters of an already cache optimized list so outward facing ones come first
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const math::Vec3* positions, uint32_t cacheSize) SRK_NOEXCEPT;
+
+// renumbers vertices in the order they are first used, returns the new vertex count; remap[old] is ~0u for unused vertices
+uint32_t OptimizeVertexFetch(uint32_t* indices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap) SRK_NOEXCEPT;
+
+/*
+ *  Vertex clustering simplifier, writes at most targetIndexCount indices to dst and returns how many were written.
+ *  Every cluster collapses onto the existing vertex with the smallest quadric error so attributes stay valid,
+ *  seams are not preserved which is fine for the distances lods are used at.
+ */
+size_t SimplifyMesh(uint32_t* dst, const uint32_t* indices, size_t indexCount, const math::Vec3* positions, uint32_t vertexCount, size_t targetIndexCount, float& error) SRK_NOEXCEPT;
+
+// greedy meshlets in index order, with bounding spheres and normal cones for culling
+void BuildMeshlets(MeshData& mesh, size_t indexCount, uint32_t maxVertices, uint32_t maxTriangles) SRK_NOEXCEPT;
+
+// normals and tangents become snorm8, texture coordinates half floats
+void QuantizeStreams(MeshData& mesh) SRK_NOEXCEPT;
+
+// runs every step above in order
+void OptimizeMesh(MeshData& mesh, const MeshOptimizeSettings& settings) SRK_NOEXCEPT;
+
+// copies the optimized mesh into staging, false when the staging buffer is full
+bool WriteMesh(const MeshData& mesh, render::StagingBuffer& staging, render::MeshPrimitive& primitive) SRK_NOEXCEPT;
+
+} // namespace shrek::asset
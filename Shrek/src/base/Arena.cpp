@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "Arena.h"
+
+#include <algorithm>
+
+namespace shrek::base {
+
+namespace {
+
+constexpr size_t blockAlignment  = alignof(std::max_align_t);
+constexpr size_t scratchCapacity = 256 * 1024;
+
+} // namespace
+
+Arena::Arena(size_t blockSize, std::pmr::memory_resource* upstream) SRK_NOEXCEPT :
+    m_Upstream(upstream),
+    m_BlockSize(blockSize),
+    m_Blocks(),
+    m_Block(0),
+    m_Offset(0)
+{
+    AddBlock(blockSize);
+}
+
+Arena::~Arena() SRK_NOEXCEPT
+{
+    for (const Block& block : m_Blocks)
+        m_Upstream->deallocate(block.Data, block.Size, blockAlignment);
+}
+
+void Arena::AddBlock(size_t size) SRK_NOEXCEPT
+{
+    // the blocks past the current one are free, reuse the first that fits
+    for (size_t idx = m_Block + 1; idx < m_Blocks.size(); ++idx)
+    {
+        if (m_Blocks[idx].Size >= size)
+        {
+            std::swap(m_Blocks[m_Block + 1], m_Blocks[idx]);
+            return;
+        }
+    }
+
+    Block block{static_cast<std::byte*>(m_Upstream->allocate(size, blockAlignment)), size};
+    m_Blocks.insert(m_Blocks.empty() ? m_Blocks.end() : m_Blocks.begin() + m_Block + 1, block);
+}
+
+void* Arena::Allocate(size_t size, size_t alignment) SRK_NOEXCEPT
+{
+    for (;;)
+    {
+        const Block&    block   = m_Blocks[m_Block];
+        const uintptr_t address = reinterpret_cast<uintptr_t>(block.Data) + m_Offset;
+        const size_t    aligned = m_Offset + ((alignment - address % alignment) % alignment);
+        if (aligned + size <= block.Size)
+        {
+            m_Offset = aligned + size;
+            return block.Data + aligned;
+        }
+
+        // the padding for a large alignment may not fit at the start of a fresh block either
+        AddBlock(std::max(m_BlockSize, size + alignment));
+        ++m_Block;
+        m_Offset = 0;
+    }
+}
+
+void Arena::Rewind(const Marker& marker) SRK_NOEXCEPT
+{
+    m_Block  = marker.Block;
+    m_Offset = marker.Offset;
+}
+
+void Arena::Reset() SRK_NOEXCEPT
+{
+    m_Block  = 0;
+    m_Offset = 0;
+
+    if (m_Blocks.size() == 1)
+        return;
+
+    // one block the size of all of them, so the next frame fits without chaining
+    const size_t capacity = GetCapacity();
+    for (const Block& block : m_Blocks)
+        m_Upstream->deallocate(block.Data, block.Size, blockAlignment);
+
+    m_Blocks.clear();
+    AddBlock(capacity);
+}
+
+size_t Arena::GetUsed() const SRK_NOEXCEPT
+{
+    size_t used = m_Offset;
+    for (size_t idx{}; idx < m_Block; ++idx)
+        used += m_Blocks[idx].Size;
+    return used;
+}
+
+size_t Arena::GetCapacity() const SRK_NOEXCEPT
+{
+    size_t capacity{};
+    for (const Block& block : m_Blocks)
+        capacity += block.Size;
+    return capacity;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    return Allocate(bytes, alignment);
+}
+
+void Arena::do_deallocate([[maybe_unused]] void* pointer, [[maybe_unused]] size_t bytes, [[maybe_unused]] size_t alignment)
+{
+    // freed all at once by Reset or Rewind
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const SRK_NOEXCEPT
+{
+    return this == &other;
+}
+
+Arena& ScratchArena() SRK_NOEXCEPT
+{
+    thread_local Arena arena(scratchCapacity);
+    return arena;
+}
+
+} // namespace shrek::base
@@ -0,0 +1,95 @@
+#pragma once
+#include "defs.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace shrek::base {
+
+/*
+ *  Linear allocator, allocating is a pointer bump and freeing does nothing until the whole arena is reset or rewound.
+ *  Runs out of its block by chaining another one from upstream, Reset folds them into a single block big enough for
+ *  everything so once the high water mark is reached nothing is allocated from upstream again.
+ *  Plugs into std::pmr containers, which then never touch the global heap. Not thread safe, one arena per thread.
+ */
+class Arena final : public std::pmr::memory_resource
+{
+public:
+    struct Marker
+    {
+        size_t Block{0};
+        size_t Offset{0};
+    };
+
+    explicit Arena(size_t blockSize = 64 * 1024, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) SRK_NOEXCEPT;
+    ~Arena() SRK_NOEXCEPT override;
+
+    Arena(const Arena& other) = delete;
+    Arena& operator=(const Arena& other) = delete;
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) SRK_NOEXCEPT;
+
+    // everything allocated since the marker is gone
+    Marker GetMarker() const SRK_NOEXCEPT { return Marker{m_Block, m_Offset}; }
+    void   Rewind(const Marker& marker) SRK_NOEXCEPT;
+    void   Reset() SRK_NOEXCEPT;
+
+    size_t GetUsed() const SRK_NOEXCEPT;
+    size_t GetCapacity() const SRK_NOEXCEPT;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void  do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool  do_is_equal(const std::pmr::memory_resource& other) const SRK_NOEXCEPT override;
+
+private:
+    struct Block
+    {
+        std::byte* Data;
+        size_t     Size;
+    };
+
+    void AddBlock(size_t size) SRK_NOEXCEPT;
+
+private:
+    std::pmr::memory_resource* m_Upstream;
+    size_t                     m_BlockSize;
+    std::vector<Block>         m_Blocks;
+    size_t                     m_Block;  // the block being bumped
+    size_t                     m_Offset; // into that block
+};
+
+// gives the container's memory back and leaves it empty on the same resource, for before the arena it came from is
+// reset. clear() would keep the capacity pointing into memory the reset hands out again
+template <typename Container>
+void Release(Container& container) SRK_NOEXCEPT
+{
+    container = Container(container.get_allocator());
+}
+
+// the calling thread's scratch arena, meant to be used through a ScratchScope
+Arena& ScratchArena() SRK_NOEXCEPT;
+
+/*
+ *  Rewinds the thread's scratch arena to where it was when the scope began.
+ *  Scopes nest, so a job run by a waiting thread can use scratch memory in the middle of its caller's scope.
+ */
+class ScratchScope
+{
+public:
+    ScratchScope() SRK_NOEXCEPT : m_Arena(ScratchArena()), m_Marker(m_Arena.GetMarker()) {}
+    ~ScratchScope() SRK_NOEXCEPT { m_Arena.Rewind(m_Marker); }
+
+    ScratchScope(const ScratchScope& other) = delete;
+    ScratchScope& operator=(const ScratchScope& other) = delete;
+
+    std::pmr::memory_resource* Resource() const SRK_NOEXCEPT { return &m_Arena; }
+
+private:
+    Arena&        m_Arena;
+    Arena::Marker m_Marker;
+};
+
+} // namespace shrek::base
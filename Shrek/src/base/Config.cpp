@@ -0,0 +1,346 @@
+#include "pch.h"
+#include "Config.h"
+
+#include "base/Json.h"
+#include "platform/Log.h"
+#include "platform/MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+
+namespace shrek::base {
+
+namespace {
+
+constexpr std::string_view defaultConfigPath{"shrek.json"};
+constexpr std::string_view environmentPrefix{"SHREK_"};
+
+// render.frames_in_flight -> SHREK_RENDER_FRAMES_IN_FLIGHT
+std::string environmentName(std::string_view name) SRK_NOEXCEPT
+{
+    std::string result(environmentPrefix);
+    for (char c : name)
+        result.push_back(c == '.' || c == '-' ? '_' : static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+    return result;
+}
+
+bool parseBool(std::string_view text, bool& out) SRK_NOEXCEPT
+{
+    if (text == "true" || text == "1" || text == "on" || text == "yes")
+        out = true;
+    else if (text == "false" || text == "0" || text == "off" || text == "no")
+        out = false;
+    else
+        return false;
+    return true;
+}
+
+} // namespace
+
+std::string_view ToString(ConfigType type) SRK_NOEXCEPT
+{
+#define TO_STRING(X)    \
+    case ConfigType::X: \
+        return #X
+    switch (type)
+    {
+        TO_STRING(Bool);
+        TO_STRING(Int);
+        TO_STRING(Float);
+        TO_STRING(String);
+        default:
+            return "UNKNOWN";
+    }
+#undef TO_STRING
+}
+
+std::string_view ToString(ConfigSource source) SRK_NOEXCEPT
+{
+#define TO_STRING(X)      \
+    case ConfigSource::X: \
+        return #X
+    switch (source)
+    {
+        TO_STRING(Default);
+        TO_STRING(File);
+        TO_STRING(Environment);
+        TO_STRING(CommandLine);
+        default:
+            return "UNKNOWN";
+    }
+#undef TO_STRING
+}
+
+Config& Config::Get() SRK_NOEXCEPT
+{
+    // constructed by the first ConfigVar, whichever translation unit that is in
+    static Config config;
+    return config;
+}
+
+void Config::Register(const Entry& entry) SRK_NOEXCEPT
+{
+    SRK_ASSERT(FindEntry(entry.Name) == nullptr, "config var registered twice");
+    m_Entries.push_back(entry);
+}
+
+Config::Entry* Config::FindEntry(std::string_view name) SRK_NOEXCEPT
+{
+    for (Entry& entry : m_Entries)
+    {
+        if (entry.Name == name)
+            return &entry;
+    }
+    return nullptr;
+}
+
+const Config::Entry* Config::Find(std::string_view name) const SRK_NOEXCEPT
+{
+    return const_cast<Config*>(this)->FindEntry(name);
+}
+
+bool Config::Set(std::string_view name, std::string_view text, ConfigSource source) SRK_NOEXCEPT
+{
+    Entry* entry = FindEntry(name);
+    if (!entry)
+    {
+        SRK_CORE_WARN("Unknown config option {}", name);
+        return false;
+    }
+    return Parse(*entry, text, source);
+}
+
+bool Config::Parse(Entry& entry, std::string_view text, ConfigSource source) SRK_NOEXCEPT
+{
+    bool parsed = false;
+    switch (entry.Type)
+    {
+        case ConfigType::Bool:
+            parsed = parseBool(text, *static_cast<bool*>(entry.Value));
+            break;
+
+        case ConfigType::Int:
+        {
+            int32_t value{0};
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            parsed            = error == std::errc{} && end == text.data() + text.size();
+            if (parsed)
+                *static_cast<int32_t*>(entry.Value) = value;
+            break;
+        }
+
+        case ConfigType::Float:
+        {
+            // strtof wants it null terminated
+            const std::string terminated(text);
+            char*             end   = nullptr;
+            const float       value = std::strtof(terminated.c_str(), &end);
+            parsed                  = !terminated.empty() && end == terminated.c_str() + terminated.size();
+            if (parsed)
+                *static_cast<float*>(entry.Value) = value;
+            break;
+        }
+
+        case ConfigType::String:
+            *static_cast<std::string*>(entry.Value) = std::string(text);
+            parsed                                  = true;
+            break;
+    }
+
+    if (!parsed)
+    {
+        SRK_CORE_WARN("Config option {} ({}) can't be set to \"{}\" from {}, keeping {}", entry.Name, ToString(entry.Type), text, ToString(source), Format(entry));
+        return false;
+    }
+
+    entry.Source = source;
+    return true;
+}
+
+std::string Config::Format(const Entry& entry) const SRK_NOEXCEPT
+{
+    switch (entry.Type)
+    {
+        case ConfigType::Bool:
+            return *static_cast<const bool*>(entry.Value) ? "true" : "false";
+        case ConfigType::Int:
+            return std::to_string(*static_cast<const int32_t*>(entry.Value));
+        case ConfigType::Float:
+            return fmt::format("{}", *static_cast<const float*>(entry.Value));
+        case ConfigType::String:
+            return *static_cast<const std::string*>(entry.Value);
+    }
+    return {};
+}
+
+void Config::Load(size_t argc, const char* const* argv) SRK_NOEXCEPT
+{
+    // the file is looked for first since everything else overrides it
+    std::string path;
+    bool        required = true;
+    for (size_t idx = 1; idx < argc; ++idx)
+    {
+        std::string_view arg = argv[idx];
+        if (arg.rfind("--config=", 0) == 0)
+            path = std::string(arg.substr(9));
+        else if (arg == "--config" && idx + 1 < argc)
+            path = argv[idx + 1];
+    }
+
+    if (path.empty())
+    {
+        if (const char* environment = std::getenv("SHREK_CONFIG"))
+            path = environment;
+    }
+
+    // the default file is optional, one that was asked for is not
+    if (path.empty())
+    {
+        path     = std::string(defaultConfigPath);
+        required = false;
+    }
+
+    LoadFile(path, required);
+    LoadEnvironment();
+    LoadCommandLine(argc, argv);
+}
+
+void Config::LoadFile(const std::string& path, bool required) SRK_NOEXCEPT
+{
+    std::error_code error;
+    if (!required && !std::filesystem::exists(path, error))
+        return;
+
+    MappedFile file(path);
+    if (!file.IsValid())
+        return;
+
+    JsonDocument document;
+    if (!document.Parse(file.AsString()) || document.Root().Type() != JsonType::Object)
+    {
+        SRK_CORE_ERROR("Config file {} is not a json object, ignoring it", path);
+        return;
+    }
+
+    // nested objects are joined with '.', { "render": { "validation": false } } sets render.validation
+    auto visit = [this, &path](auto& self, JsonValue object, const std::string& prefix) -> void {
+        for (JsonValue member = object.First(); member.IsValid(); member = member.Next())
+        {
+            const std::string name = prefix.empty() ? std::string(member.Key()) : prefix + "." + std::string(member.Key());
+            if (member.Type() == JsonType::Object)
+            {
+                self(self, member, name);
+                continue;
+            }
+
+            Entry* entry = FindEntry(name);
+            if (!entry)
+            {
+                SRK_CORE_WARN("Unknown config option {} in {}", name, path);
+                continue;
+            }
+
+            switch (member.Type())
+            {
+                case JsonType::Bool:
+                    Parse(*entry, member.AsBool() ? "true" : "false", ConfigSource::File);
+                    break;
+                case JsonType::Number:
+                {
+                    // ints are written without a fraction so they parse as one
+                    const double number = member.AsNumber();
+                    if (entry->Type == ConfigType::Int && number >= std::numeric_limits<int32_t>::min() && number <= std::numeric_limits<int32_t>::max())
+                        Parse(*entry, std::to_string(static_cast<int64_t>(number)), ConfigSource::File);
+                    else
+                        Parse(*entry, fmt::format("{}", number), ConfigSource::File);
+                    break;
+                }
+                case JsonType::String:
+                    Parse(*entry, member.AsString(), ConfigSource::File);
+                    break;
+                default:
+                    SRK_CORE_WARN("Config option {} in {} has to be a bool, number or string", name, path);
+                    break;
+            }
+        }
+    };
+    visit(visit, document.Root(), std::string());
+}
+
+void Config::LoadEnvironment() SRK_NOEXCEPT
+{
+    for (Entry& entry : m_Entries)
+    {
+        if (const char* value = std::getenv(environmentName(entry.Name).c_str()))
+            Parse(entry, value, ConfigSource::Environment);
+    }
+}
+
+void Config::LoadCommandLine(size_t argc, const char* const* argv) SRK_NOEXCEPT
+{
+    for (size_t idx = 1; idx < argc; ++idx)
+    {
+        std::string_view arg = argv[idx];
+        if (arg.size() <= 2 || arg.rfind("--", 0) != 0)
+            continue;
+
+        std::string_view name = arg.substr(2);
+        std::string_view value;
+        bool             hasValue = false;
+        if (size_t equals = name.find('='); equals != std::string_view::npos)
+        {
+            value    = name.substr(equals + 1);
+            name     = name.substr(0, equals);
+            hasValue = true;
+        }
+
+        // read by Load already
+        if (name == "config")
+        {
+            idx += hasValue ? 0 : 1;
+            continue;
+        }
+
+        Entry* entry = FindEntry(name);
+        if (!entry)
+        {
+            SRK_CORE_WARN("Unknown command line option {}", arg);
+            continue;
+        }
+
+        if (!hasValue && entry->Type == ConfigType::Bool)
+        {
+            value = "true";
+        }
+        else if (!hasValue)
+        {
+            if (idx + 1 >= argc)
+            {
+                SRK_CORE_WARN("Command line option {} is missing its value", arg);
+                continue;
+            }
+            value = argv[++idx];
+        }
+
+        Parse(*entry, value, ConfigSource::CommandLine);
+    }
+}
+
+void Config::Print() const SRK_NOEXCEPT
+{
+    // registration order depends on how the translation units were linked
+    std::vector<const Entry*> sorted;
+    sorted.reserve(m_Entries.size());
+    for (const Entry& entry : m_Entries)
+        sorted.push_back(&entry);
+    std::sort(sorted.begin(), sorted.end(), [](const Entry* lhs, const Entry* rhs) { return lhs->Name < rhs->Name; });
+
+    for (const Entry* entry : sorted)
+        SRK_CORE_INFO("{} = {} ({}), {}", entry->Name, Format(*entry), ToString(entry->Source), entry->Description);
+}
+
+} // namespace shrek::base
@@ -0,0 +1,124 @@
+#pragma once
+#include "defs.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace shrek::base {
+
+enum class ConfigType : uint8_t
+{
+    Bool,
+    Int,
+    Float,
+    String
+};
+
+// where the current value came from, a later source overrides an earlier one
+enum class ConfigSource : uint8_t
+{
+    Default,
+    File,
+    Environment,
+    CommandLine
+};
+
+std::string_view ToString(ConfigType type) SRK_NOEXCEPT;
+std::string_view ToString(ConfigSource source) SRK_NOEXCEPT;
+
+/*
+ *  Every ConfigVar in the program, registered by name when it is constructed.
+ *  Load fills them in from the config file, then SHREK_* environment variables, then the command line.
+ *  Values are only written by Load (on the main thread, before anything else starts) so reading them is not synchronised.
+ *
+ *  a var named render.frames_in_flight is set by
+ *      { "render": { "frames_in_flight": 3 } }  in the file (shrek.json, or the one given by --config)
+ *      SHREK_RENDER_FRAMES_IN_FLIGHT=3         in the environment
+ *      --render.frames_in_flight=3             on the command line, "--name value" works as well and a bare --name sets a bool
+ */
+class Config
+{
+public:
+    struct Entry
+    {
+        std::string_view Name;
+        std::string_view Description;
+        ConfigType       Type{ConfigType::Bool};
+        ConfigSource     Source{ConfigSource::Default};
+        void*            Value{nullptr}; // the ConfigVar's value, of the type above
+    };
+
+    static Config& Get() SRK_NOEXCEPT;
+
+    Config(const Config& other) = delete;
+    Config& operator=(const Config& other) = delete;
+
+    // argv[0] is skipped, unknown options are warned about and left alone
+    void Load(size_t argc, const char* const* argv) SRK_NOEXCEPT;
+
+    // text is parsed as the entry's type, false (and logged) when it does not parse
+    bool Set(std::string_view name, std::string_view text, ConfigSource source = ConfigSource::CommandLine) SRK_NOEXCEPT;
+
+    const Entry*              Find(std::string_view name) const SRK_NOEXCEPT;
+    const std::vector<Entry>& GetEntries() const SRK_NOEXCEPT { return m_Entries; }
+    std::string               Format(const Entry& entry) const SRK_NOEXCEPT;
+
+    // every value with where it came from, at info level
+    void Print() const SRK_NOEXCEPT;
+
+    // called by ConfigVar, before main for the ones at namespace scope so nothing may be logged here
+    void Register(const Entry& entry) SRK_NOEXCEPT;
+
+private:
+    Config() SRK_NOEXCEPT = default;
+
+    Entry* FindEntry(std::string_view name) SRK_NOEXCEPT;
+    bool   Parse(Entry& entry, std::string_view text, ConfigSource source) SRK_NOEXCEPT;
+    void   LoadFile(const std::string& path, bool required) SRK_NOEXCEPT;
+    void   LoadEnvironment() SRK_NOEXCEPT;
+    void   LoadCommandLine(size_t argc, const char* const* argv) SRK_NOEXCEPT;
+
+private:
+    std::vector<Entry> m_Entries;
+};
+
+template<typename T>
+class ConfigVar
+{
+public:
+    static_assert(std::is_same_v<T, bool> || std::is_same_v<T, int32_t> || std::is_same_v<T, float> || std::is_same_v<T, std::string>,
+                  "config vars are bool, int32_t, float or std::string");
+
+    static constexpr ConfigType Type = std::is_same_v<T, bool>      ? ConfigType::Bool
+                                       : std::is_same_v<T, int32_t> ? ConfigType::Int
+                                       : std::is_same_v<T, float>   ? ConfigType::Float
+                                                                    : ConfigType::String;
+
+    // name and description have to be literals and the var has to live as long as the registry (namespace scope),
+    // the registry keeps views of them and a pointer to the value
+    ConfigVar(std::string_view name, T defaultValue, std::string_view description) SRK_NOEXCEPT :
+        m_Value(std::move(defaultValue))
+    {
+        Config::Entry entry;
+        entry.Name        = name;
+        entry.Description = description;
+        entry.Type        = Type;
+        entry.Value       = &m_Value;
+        Config::Get().Register(entry);
+    }
+
+    ConfigVar(const ConfigVar& other) = delete;
+    ConfigVar& operator=(const ConfigVar& other) = delete;
+
+    const T& Get() const SRK_NOEXCEPT { return m_Value; }
+    operator const T&() const SRK_NOEXCEPT { return m_Value; }
+
+private:
+    T m_Value;
+};
+
+} // namespace shrek::base
@@ -0,0 +1,41 @@
+#pragma once
+#include "defs.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace shrek::base {
+
+constexpr uint64_t HashSeed = 0xCBF29CE484222325ull;
+
+// FNV-1a, fast enough for cache keys and stable across runs so hashes can be written to disk
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = HashSeed) SRK_NOEXCEPT
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t idx{}; idx < size; ++idx)
+    {
+        hash ^= bytes[idx];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+inline uint64_t HashString(std::string_view string, uint64_t hash = HashSeed) SRK_NOEXCEPT
+{
+    return HashBytes(string.data(), string.size(), hash);
+}
+
+// only for trivially copyable types without padding, padding bytes would make equal values hash differently
+template<typename T>
+uint64_t HashValue(const T& value, uint64_t hash = HashSeed) SRK_NOEXCEPT
+{
+    return HashBytes(&value, sizeof(T), hash);
+}
+
+constexpr uint64_t HashCombine(uint64_t seed, uint64_t hash) SRK_NOEXCEPT
+{
+    return seed ^ (hash + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+
+} // namespace shrek::base
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+#include "platform/Log.h"
+
+#include <algorithm>
+
+namespace shrek::base {
+
+JobSystem::JobSystem(uint32_t workerCount) SRK_NOEXCEPT :
+    base::Singleton<JobSystem>("base::JobSystem"),
+    m_Running(true)
+{
+    if (workerCount == 0)
+    {
+        // hardware_concurrency is allowed to return 0 when it can't tell
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount              = std::max(hardwareThreads, 2u) - 1;
+    }
+
+    m_Workers.reserve(workerCount);
+    for (uint32_t idx{}; idx < workerCount; ++idx)
+        m_Workers.emplace_back([this]() { WorkerLoop(); });
+
+    SRK_CORE_TRACE("JobSystem started with {} workers", workerCount);
+}
+
+JobSystem::~JobSystem() SRK_NOEXCEPT
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Wake.notify_all();
+
+    for (auto& worker : m_Workers)
+        worker.join();
+}
+
+void JobSystem::Submit(Job job, JobCounter* counter) SRK_NOEXCEPT
+{
+    if (counter)
+        counter->Pending.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.push_back(Task{std::move(job), counter});
+    }
+    m_Wake.notify_one();
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t groupSize, const RangeJob& job) SRK_NOEXCEPT
+{
+    if (count == 0)
+        return;
+
+    groupSize = std::max(groupSize, 1u);
+
+    // not worth waking anyone up for a single group
+    if (count <= groupSize || m_Workers.empty())
+    {
+        job(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    for (uint32_t begin{}; begin < count; begin += groupSize)
+    {
+        uint32_t end = std::min(begin + groupSize, count);
+        Submit([&job, begin, end]() { job(begin, end); }, &counter);
+    }
+
+    Wait(counter);
+}
+
+void JobSystem::Wait(JobCounter& counter) SRK_NOEXCEPT
+{
+    while (!counter.Done())
+    {
+        if (!TryRunOne())
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::WorkerLoop() SRK_NOEXCEPT
+{
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [this]() { return !m_Running || !m_Tasks.empty(); });
+
+            if (!m_Running && m_Tasks.empty())
+                return;
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+
+        Run(task);
+    }
+}
+
+bool JobSystem::TryRunOne() SRK_NOEXCEPT
+{
+    Task task;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Tasks.empty())
+            return false;
+
+        task = std::move(m_Tasks.front());
+        m_Tasks.pop_front();
+    }
+
+    Run(task);
+    return true;
+}
+
+void JobSystem::Run(Task& task) SRK_NOEXCEPT
+{
+    task.Function();
+
+    if (task.Counter)
+        task.Counter->Pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+} // namespace shrek::base
@@ -0,0 +1,74 @@
+#pragma once
+#include "defs.h"
+#include "base/Singleton.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace shrek::base {
+
+// counts the jobs that are still in flight, reusable once it hits 0
+struct JobCounter
+{
+    std::atomic<uint32_t> Pending{0};
+
+    bool Done() const SRK_NOEXCEPT { return Pending.load(std::memory_order_acquire) == 0; }
+};
+
+/*
+ *  Fixed pool of worker threads pulling from a shared queue.
+ *  Waiting threads help out by running queued jobs so waiting from inside a job does not deadlock.
+ */
+class JobSystem : private base::Singleton<JobSystem>
+{
+public:
+    using Job      = std::function<void()>;
+    using RangeJob = std::function<void(uint32_t begin, uint32_t end)>;
+
+    // 0 workers means one per hardware thread minus the calling thread
+    explicit JobSystem(uint32_t workerCount = 0) SRK_NOEXCEPT;
+    ~JobSystem() SRK_NOEXCEPT;
+
+    JobSystem(const JobSystem& other) = delete;
+    JobSystem& operator=(const JobSystem& other) = delete;
+
+    JobSystem(JobSystem&& other) = delete;
+    JobSystem& operator=(JobSystem&& other) = delete;
+
+    void Submit(Job job, JobCounter* counter = nullptr) SRK_NOEXCEPT;
+
+    // splits [0, count) into groups of groupSize and blocks until every group has run
+    void ParallelFor(uint32_t count, uint32_t groupSize, const RangeJob& job) SRK_NOEXCEPT;
+
+    void Wait(JobCounter& counter) SRK_NOEXCEPT;
+
+    // runs one queued job on the calling thread, false when there was nothing queued
+    bool TryRunOne() SRK_NOEXCEPT;
+
+    uint32_t GetWorkerCount() const SRK_NOEXCEPT { return static_cast<uint32_t>(m_Workers.size()); }
+
+private:
+    struct Task
+    {
+        Job         Function;
+        JobCounter* Counter;
+    };
+
+    void WorkerLoop() SRK_NOEXCEPT;
+    void Run(Task& task) SRK_NOEXCEPT;
+
+private:
+    std::vector<std::thread> m_Workers;
+    std::deque<Task>         m_Tasks;
+    std::mutex               m_Mutex;
+    std::condition_variable  m_Wake;
+    bool                     m_Running;
+};
+
+} // namespace shrek::base
@@ -0,0 +1,277 @@
+#include "pch.h"
+#include "Json.h"
+
+#include <charconv>
+
+namespace shrek::base {
+
+namespace {
+
+// deep enough for any asset format we read, shallow enough that the recursion can't blow the stack
+constexpr uint32_t maxDepth = 64;
+
+} // namespace
+
+JsonType JsonValue::Type() const SRK_NOEXCEPT
+{
+    return IsValid() ? m_Document->m_Nodes[m_Index].Type : JsonType::Null;
+}
+
+uint32_t JsonValue::Size() const SRK_NOEXCEPT
+{
+    return IsValid() ? m_Document->m_Nodes[m_Index].ChildCount : 0;
+}
+
+JsonValue JsonValue::operator[](std::string_view key) const SRK_NOEXCEPT
+{
+    if (Type() != JsonType::Object)
+        return {};
+
+    for (JsonValue member = First(); member.IsValid(); member = member.Next())
+    {
+        if (member.Key() == key)
+            return member;
+    }
+    return {};
+}
+
+JsonValue JsonValue::operator[](uint32_t idx) const SRK_NOEXCEPT
+{
+    if (Type() != JsonType::Array || idx >= Size())
+        return {};
+
+    JsonValue element = First();
+    while (idx-- > 0)
+        element = element.Next();
+    return element;
+}
+
+JsonValue JsonValue::First() const SRK_NOEXCEPT
+{
+    if (!IsValid())
+        return {};
+
+    uint32_t child = m_Document->m_Nodes[m_Index].FirstChild;
+    return child != JsonDocument::InvalidIndex ? JsonValue(m_Document, child) : JsonValue();
+}
+
+JsonValue JsonValue::Next() const SRK_NOEXCEPT
+{
+    if (!IsValid())
+        return {};
+
+    uint32_t sibling = m_Document->m_Nodes[m_Index].NextSibling;
+    return sibling != JsonDocument::InvalidIndex ? JsonValue(m_Document, sibling) : JsonValue();
+}
+
+std::string_view JsonValue::Key() const SRK_NOEXCEPT
+{
+    return IsValid() ? m_Document->m_Nodes[m_Index].Key : std::string_view{};
+}
+
+bool JsonValue::AsBool(bool fallback) const SRK_NOEXCEPT
+{
+    return Type() == JsonType::Bool ? m_Document->m_Nodes[m_Index].Bool : fallback;
+}
+
+double JsonValue::AsNumber(double fallback) const SRK_NOEXCEPT
+{
+    return Type() == JsonType::Number ? m_Document->m_Nodes[m_Index].Number : fallback;
+}
+
+std::string_view JsonValue::AsString(std::string_view fallback) const SRK_NOEXCEPT
+{
+    return Type() == JsonType::String ? m_Document->m_Nodes[m_Index].Text : fallback;
+}
+
+uint32_t JsonValue::AsUint(uint32_t fallback) const SRK_NOEXCEPT
+{
+    double number = AsNumber(-1.0);
+    if (number < 0.0 || number > static_cast<double>(~0u))
+        return fallback;
+    return static_cast<uint32_t>(number);
+}
+
+bool JsonDocument::Parse(std::string_view text) SRK_NOEXCEPT
+{
+    m_Nodes.clear();
+    m_Text   = text;
+    m_Cursor = 0;
+
+    uint32_t root = ParseValue(0);
+    SkipWhitespace();
+
+    // trailing garbage means we did not understand the document
+    if (root == InvalidIndex || m_Cursor != m_Text.size())
+    {
+        m_Nodes.clear();
+        return false;
+    }
+    return true;
+}
+
+JsonValue JsonDocument::Root() const SRK_NOEXCEPT
+{
+    return m_Nodes.empty() ? JsonValue() : JsonValue(this, 0);
+}
+
+void JsonDocument::SkipWhitespace() SRK_NOEXCEPT
+{
+    while (m_Cursor < m_Text.size())
+    {
+        char c = m_Text[m_Cursor];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+            break;
+        ++m_Cursor;
+    }
+}
+
+bool JsonDocument::ParseString(std::string_view& out) SRK_NOEXCEPT
+{
+    if (m_Cursor >= m_Text.size() || m_Text[m_Cursor] != '"')
+        return false;
+
+    size_t begin = ++m_Cursor;
+    while (m_Cursor < m_Text.size())
+    {
+        char c = m_Text[m_Cursor];
+        if (c == '\\')
+        {
+            m_Cursor += 2; // whatever is escaped can't end the string
+            continue;
+        }
+        if (c == '"')
+        {
+            out = m_Text.substr(begin, m_Cursor - begin);
+            ++m_Cursor;
+            return true;
+        }
+        ++m_Cursor;
+    }
+    return false;
+}
+
+// returns the index of the new node or InvalidIndex on a syntax error
+uint32_t JsonDocument::ParseValue(uint32_t depth) SRK_NOEXCEPT
+{
+    if (depth > maxDepth)
+        return InvalidIndex;
+
+    SkipWhitespace();
+    if (m_Cursor >= m_Text.size())
+        return InvalidIndex;
+
+    const uint32_t idx = static_cast<uint32_t>(m_Nodes.size());
+    m_Nodes.emplace_back();
+
+    const char c = m_Text[m_Cursor];
+    if (c == '{' || c == '[')
+    {
+        const bool isObject = c == '{';
+        const char close    = isObject ? '}' : ']';
+        uint32_t   previous = InvalidIndex;
+        m_Nodes[idx].Type   = isObject ? JsonType::Object : JsonType::Array;
+
+        ++m_Cursor;
+        SkipWhitespace();
+        if (m_Cursor < m_Text.size() && m_Text[m_Cursor] == close)
+        {
+            ++m_Cursor;
+            return idx;
+        }
+
+        while (true)
+        {
+            std::string_view key;
+            if (isObject)
+            {
+                SkipWhitespace();
+                if (!ParseString(key))
+                    return InvalidIndex;
+
+                SkipWhitespace();
+                if (m_Cursor >= m_Text.size() || m_Text[m_Cursor] != ':')
+                    return InvalidIndex;
+                ++m_Cursor;
+            }
+
+            uint32_t child = ParseValue(depth + 1);
+            if (child == InvalidIndex)
+                return InvalidIndex;
+
+            // m_Nodes may have grown, so only index into it from here on
+            m_Nodes[child].Key = key;
+            if (previous == InvalidIndex)
+                m_Nodes[idx].FirstChild = child;
+            else
+                m_Nodes[previous].NextSibling = child;
+            previous = child;
+            ++m_Nodes[idx].ChildCount;
+
+            SkipWhitespace();
+            if (m_Cursor >= m_Text.size())
+                return InvalidIndex;
+
+            if (m_Text[m_Cursor] == ',')
+            {
+                ++m_Cursor;
+                continue;
+            }
+            if (m_Text[m_Cursor] == close)
+            {
+                ++m_Cursor;
+                return idx;
+            }
+            return InvalidIndex;
+        }
+    }
+
+    if (c == '"')
+    {
+        std::string_view text;
+        if (!ParseString(text))
+            return InvalidIndex;
+
+        m_Nodes[idx].Type = JsonType::String;
+        m_Nodes[idx].Text = text;
+        return idx;
+    }
+
+    auto matchLiteral = [this](std::string_view literal) SRK_NOEXCEPT {
+        if (m_Text.substr(m_Cursor, literal.size()) != literal)
+            return false;
+        m_Cursor += literal.size();
+        return true;
+    };
+
+    if (matchLiteral("true"))
+    {
+        m_Nodes[idx].Type = JsonType::Bool;
+        m_Nodes[idx].Bool = true;
+        return idx;
+    }
+
+    if (matchLiteral("false"))
+    {
+        m_Nodes[idx].Type = JsonType::Bool;
+        return idx;
+    }
+
+    if (matchLiteral("null"))
+        return idx;
+
+    const char* begin  = m_Text.data() + m_Cursor;
+    const char* end    = m_Text.data() + m_Text.size();
+    double      number = 0.0;
+
+    auto [ptr, error] = std::from_chars(begin, end, number);
+    if (error != std::errc() || ptr == begin)
+        return InvalidIndex;
+
+    m_Cursor += static_cast<size_t>(ptr - begin);
+    m_Nodes[idx].Type   = JsonType::Number;
+    m_Nodes[idx].Number = number;
+    return idx;
+}
+
+} // namespace shrek::base
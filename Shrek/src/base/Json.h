@@ -0,0 +1,97 @@
+#pragma once
+#include "defs.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace shrek::base {
+
+enum class JsonType : uint8_t
+{
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+class JsonDocument;
+
+/*
+ *  Handle to a value inside a JsonDocument. Looking up something that does not exist gives back an
+ *  invalid value instead of failing, so lookups can be chained and checked once at the end.
+ */
+class JsonValue
+{
+public:
+    JsonValue() SRK_NOEXCEPT = default;
+
+    bool     IsValid() const SRK_NOEXCEPT { return m_Document != nullptr; }
+    JsonType Type() const SRK_NOEXCEPT;
+    uint32_t Size() const SRK_NOEXCEPT; // elements of an array or members of an object
+
+    JsonValue operator[](std::string_view key) const SRK_NOEXCEPT;
+    JsonValue operator[](uint32_t idx) const SRK_NOEXCEPT; // walks the array, prefer First/Next for iteration
+
+    // iteration over array elements/object members
+    JsonValue        First() const SRK_NOEXCEPT;
+    JsonValue        Next() const SRK_NOEXCEPT;
+    std::string_view Key() const SRK_NOEXCEPT;
+
+    bool   AsBool(bool fallback = false) const SRK_NOEXCEPT;
+    double AsNumber(double fallback = 0.0) const SRK_NOEXCEPT;
+    // strings are returned raw (escape sequences are left as they are in the source)
+    std::string_view AsString(std::string_view fallback = {}) const SRK_NOEXCEPT;
+
+    uint32_t AsUint(uint32_t fallback = 0) const SRK_NOEXCEPT;
+
+private:
+    friend class JsonDocument;
+    JsonValue(const JsonDocument* document, uint32_t idx) SRK_NOEXCEPT : m_Document(document), m_Index(idx) {}
+
+    const JsonDocument* m_Document{nullptr};
+    uint32_t            m_Index{0};
+};
+
+/*
+ *  Small DOM parser. Strings and keys point straight into the source text, so the text has to
+ *  outlive the document (usually a MappedFile).
+ */
+class JsonDocument
+{
+public:
+    JsonDocument() SRK_NOEXCEPT = default;
+
+    bool      Parse(std::string_view text) SRK_NOEXCEPT;
+    JsonValue Root() const SRK_NOEXCEPT;
+
+private:
+    friend class JsonValue;
+
+    static constexpr uint32_t InvalidIndex = ~0u;
+
+    struct Node
+    {
+        JsonType         Type{JsonType::Null};
+        bool             Bool{false};
+        uint32_t         FirstChild{InvalidIndex};
+        uint32_t         NextSibling{InvalidIndex};
+        uint32_t         ChildCount{0};
+        double           Number{0.0};
+        std::string_view Key;
+        std::string_view Text;
+    };
+
+    uint32_t ParseValue(uint32_t depth) SRK_NOEXCEPT;
+    bool     ParseString(std::string_view& out) SRK_NOEXCEPT;
+    void     SkipWhitespace() SRK_NOEXCEPT;
+
+private:
+    std::vector<Node> m_Nodes;
+    std::string_view  m_Text;
+    size_t            m_Cursor{0};
+};
+
+} // namespace shrek::base
@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "Metrics.h"
+
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace shrek::base {
+
+namespace {
+
+constexpr std::string_view metricPrefix{"shrek_"};
+
+// render.frame_ms -> shrek_render_frame_ms, prometheus names are [a-zA-Z0-9_:]
+void appendName(std::string& out, std::string_view name) SRK_NOEXCEPT
+{
+    out.append(metricPrefix);
+    for (char c : name)
+        out.push_back(c == '.' || c == '-' ? '_' : c);
+}
+
+void appendHeader(std::string& out, const Metrics::Entry& entry, std::string_view type) SRK_NOEXCEPT
+{
+    out.append("# HELP ");
+    appendName(out, entry.Name);
+    out.push_back(' ');
+    out.append(entry.Description);
+    out.append("\n# TYPE ");
+    appendName(out, entry.Name);
+    out.push_back(' ');
+    out.append(type);
+    out.push_back('\n');
+}
+
+void registerMetric(std::string_view name, std::string_view description, MetricType type, const void* metric) SRK_NOEXCEPT
+{
+    Metrics::Entry entry;
+    entry.Name        = name;
+    entry.Description = description;
+    entry.Type        = type;
+    entry.Metric      = metric;
+    Metrics::Get().Register(entry);
+}
+
+} // namespace
+
+std::string_view ToString(MetricType type) SRK_NOEXCEPT
+{
+#define TO_STRING(X)    \
+    case MetricType::X: \
+        return #X
+    switch (type)
+    {
+        TO_STRING(Counter);
+        TO_STRING(Gauge);
+        TO_STRING(Histogram);
+        default:
+            return "UNKNOWN";
+    }
+#undef TO_STRING
+}
+
+Metrics& Metrics::Get() SRK_NOEXCEPT
+{
+    // constructed by the first metric, whichever translation unit that is in
+    static Metrics metrics;
+    return metrics;
+}
+
+void Metrics::Register(const Entry& entry) SRK_NOEXCEPT
+{
+    SRK_ASSERT(std::none_of(m_Entries.begin(), m_Entries.end(), [&entry](const Entry& other) { return other.Name == entry.Name; }),
+               "metric registered twice");
+    m_Entries.push_back(entry);
+}
+
+void Metrics::Format(std::string& out) const SRK_NOEXCEPT
+{
+    auto inserter = std::back_inserter(out);
+    for (const Entry& entry : m_Entries)
+    {
+        switch (entry.Type)
+        {
+            case MetricType::Counter:
+            {
+                appendHeader(out, entry, "counter");
+                appendName(out, entry.Name);
+                fmt::format_to(inserter, " {}\n", static_cast<const Counter*>(entry.Metric)->Get());
+                break;
+            }
+            case MetricType::Gauge:
+            {
+                appendHeader(out, entry, "gauge");
+                appendName(out, entry.Name);
+                fmt::format_to(inserter, " {}\n", static_cast<const Gauge*>(entry.Metric)->Get());
+                break;
+            }
+            case MetricType::Histogram:
+            {
+                // the text format wants the buckets cumulative, they're kept apart so Observe touches only one
+                const Histogram& histogram = *static_cast<const Histogram*>(entry.Metric);
+                appendHeader(out, entry, "histogram");
+
+                uint64_t cumulative = 0;
+                for (uint32_t bucket{}; bucket <= histogram.GetBucketCount(); ++bucket)
+                {
+                    cumulative += histogram.GetCount(bucket);
+                    appendName(out, entry.Name);
+                    if (bucket < histogram.GetBucketCount())
+                        fmt::format_to(inserter, "_bucket{{le=\"{}\"}} {}\n", histogram.GetBound(bucket), cumulative);
+                    else
+                        fmt::format_to(inserter, "_bucket{{le=\"+Inf\"}} {}\n", cumulative);
+                }
+
+                appendName(out, entry.Name);
+                fmt::format_to(inserter, "_sum {}\n", histogram.GetSum());
+                appendName(out, entry.Name);
+                fmt::format_to(inserter, "_count {}\n", histogram.GetCount());
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+Counter::Counter(std::string_view name, std::string_view description) SRK_NOEXCEPT
+{
+    registerMetric(name, description, MetricType::Counter, this);
+}
+
+Gauge::Gauge(std::string_view name, std::string_view description) SRK_NOEXCEPT
+{
+    registerMetric(name, description, MetricType::Gauge, this);
+}
+
+Histogram::Histogram(std::string_view name, std::string_view description, std::initializer_list<double> bounds) SRK_NOEXCEPT
+{
+    SRK_ASSERT(bounds.size() <= MaxHistogramBuckets, "too many histogram buckets");
+    SRK_ASSERT(std::is_sorted(bounds.begin(), bounds.end()), "histogram bounds have to be increasing");
+
+    for (double bound : bounds)
+    {
+        if (m_BucketCount == MaxHistogramBuckets)
+            break;
+        m_Bounds[m_BucketCount++] = bound;
+    }
+    registerMetric(name, description, MetricType::Histogram, this);
+}
+
+void Histogram::Observe(double value) SRK_NOEXCEPT
+{
+    // a handful of buckets, walking them beats a binary search
+    uint32_t bucket = 0;
+    while (bucket < m_BucketCount && value > m_Bounds[bucket])
+        ++bucket;
+
+    m_Counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_Count.fetch_add(1, std::memory_order_relaxed);
+
+    // no fetch_add for doubles before c++20, a compare exchange loop does the same without a lock
+    double sum = m_Sum.load(std::memory_order_relaxed);
+    while (!m_Sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
+    {
+    }
+}
+
+} // namespace shrek::base
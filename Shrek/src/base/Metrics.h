@@ -0,0 +1,125 @@
+#pragma once
+#include "defs.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace shrek::base {
+
+enum class MetricType : uint8_t
+{
+    Counter,  // only goes up
+    Gauge,    // whatever it was last set to
+    Histogram // how a value was distributed over fixed buckets
+};
+
+std::string_view ToString(MetricType type) SRK_NOEXCEPT;
+
+/*
+ *  Every Counter, Gauge and Histogram in the program, registered by name when it is constructed, the same
+ *  way ConfigVars are. Metrics live at namespace scope next to whatever updates them and updating one is a
+ *  relaxed atomic, so any thread can do it at any time without a lock. Format reads all of them into the
+ *  prometheus text format, which is what MetricsExporter publishes for a dashboard to scrape.
+ *
+ *  a metric named render.frame_ms comes out as
+ *      # HELP shrek_render_frame_ms <description>
+ *      # TYPE shrek_render_frame_ms gauge
+ *      shrek_render_frame_ms 16.6
+ */
+class Metrics
+{
+public:
+    struct Entry
+    {
+        std::string_view Name;
+        std::string_view Description;
+        MetricType       Type{MetricType::Counter};
+        const void*      Metric{nullptr}; // the Counter, Gauge or Histogram, of the type above
+    };
+
+    static Metrics& Get() SRK_NOEXCEPT;
+
+    Metrics(const Metrics& other) = delete;
+    Metrics& operator=(const Metrics& other) = delete;
+
+    // any thread. every value is read on its own, a histogram updated meanwhile may be off by the one observation
+    void Format(std::string& out) const SRK_NOEXCEPT;
+
+    const std::vector<Entry>& GetEntries() const SRK_NOEXCEPT { return m_Entries; }
+
+    // called by the metrics, before main for the ones at namespace scope so nothing may be logged here
+    void Register(const Entry& entry) SRK_NOEXCEPT;
+
+private:
+    Metrics() SRK_NOEXCEPT = default;
+
+private:
+    std::vector<Entry> m_Entries;
+};
+
+// name and description have to be literals and the metrics have to live as long as the registry (namespace scope)
+class Counter
+{
+public:
+    Counter(std::string_view name, std::string_view description) SRK_NOEXCEPT;
+
+    Counter(const Counter& other) = delete;
+    Counter& operator=(const Counter& other) = delete;
+
+    void     Add(uint64_t value = 1) SRK_NOEXCEPT { m_Value.fetch_add(value, std::memory_order_relaxed); }
+    uint64_t Get() const SRK_NOEXCEPT { return m_Value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_Value{0};
+};
+
+class Gauge
+{
+public:
+    Gauge(std::string_view name, std::string_view description) SRK_NOEXCEPT;
+
+    Gauge(const Gauge& other) = delete;
+    Gauge& operator=(const Gauge& other) = delete;
+
+    void   Set(double value) SRK_NOEXCEPT { m_Value.store(value, std::memory_order_relaxed); }
+    double Get() const SRK_NOEXCEPT { return m_Value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> m_Value{0.0};
+};
+
+constexpr uint32_t MaxHistogramBuckets = 16;
+
+class Histogram
+{
+public:
+    // upper bounds of the buckets in increasing order, at most MaxHistogramBuckets. what's above the last one
+    // still counts, it only lands in the implicit +Inf bucket
+    Histogram(std::string_view name, std::string_view description, std::initializer_list<double> bounds) SRK_NOEXCEPT;
+
+    Histogram(const Histogram& other) = delete;
+    Histogram& operator=(const Histogram& other) = delete;
+
+    void Observe(double value) SRK_NOEXCEPT;
+
+    uint32_t GetBucketCount() const SRK_NOEXCEPT { return m_BucketCount; }
+    double   GetBound(uint32_t bucket) const SRK_NOEXCEPT { return m_Bounds[bucket]; }
+    // observations in the bucket alone, not cumulative. GetBucketCount() is the +Inf one
+    uint64_t GetCount(uint32_t bucket) const SRK_NOEXCEPT { return m_Counts[bucket].load(std::memory_order_relaxed); }
+    uint64_t GetCount() const SRK_NOEXCEPT { return m_Count.load(std::memory_order_relaxed); }
+    double   GetSum() const SRK_NOEXCEPT { return m_Sum.load(std::memory_order_relaxed); }
+
+private:
+    std::array<double, MaxHistogramBuckets>                    m_Bounds{};
+    std::array<std::atomic<uint64_t>, MaxHistogramBuckets + 1> m_Counts{};
+    uint32_t                                                   m_BucketCount{0};
+    std::atomic<uint64_t>                                      m_Count{0};
+    std::atomic<double>                                        m_Sum{0.0};
+};
+
+} // namespace shrek::base
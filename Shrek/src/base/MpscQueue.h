@@ -0,0 +1,133 @@
+#pragma once
+#include "defs.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace shrek::base {
+
+/*
+ *  Bounded lock free queue for any number of producers and a single consumer. A ring of cells that each carry
+ *  a sequence number telling whose turn it is: producers claim a cell with a compare exchange on the tail and
+ *  publish it by bumping its sequence, the consumer only ever reads cells whose sequence says they're published.
+ *  No locks and no allocation after construction, a producer never waits on another one that is halfway through.
+ *  Push fails when the ring is full instead of growing. Pop and PopBulk may only be called from one thread.
+ */
+template<typename T>
+class MpscQueue
+{
+public:
+    // rounded up to a power of two
+    explicit MpscQueue(size_t capacity) SRK_NOEXCEPT :
+        m_Capacity(RoundUp(capacity)),
+        m_Mask(m_Capacity - 1),
+        m_Cells(std::make_unique<Cell[]>(m_Capacity)),
+        m_Tail(0),
+        m_Head(0)
+    {
+        for (size_t idx{}; idx < m_Capacity; ++idx)
+            m_Cells[idx].Sequence.store(idx, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue& other) = delete;
+    MpscQueue& operator=(const MpscQueue& other) = delete;
+
+    // any thread, false when the queue is full and value was left alone
+    template<typename U>
+    bool Push(U&& value) SRK_NOEXCEPT
+    {
+        size_t tail = m_Tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell&          cell     = m_Cells[tail & m_Mask];
+            const size_t   sequence = cell.Sequence.load(std::memory_order_acquire);
+            const intptr_t distance = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(tail);
+
+            if (distance == 0)
+            {
+                // the cell is free for this lap, whoever moves the tail past it owns it
+                if (m_Tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                {
+                    cell.Value = std::forward<U>(value);
+                    cell.Sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (distance < 0)
+            {
+                // the consumer hasn't emptied it since the last lap
+                return false;
+            }
+            else
+            {
+                tail = m_Tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // consumer only, false when there was nothing published
+    bool Pop(T& value) SRK_NOEXCEPT { return PopBulk(&value, 1) == 1; }
+
+    // consumer only, moves up to count values into out in the order they were pushed. stops early at a cell
+    // a producer claimed but didn't publish yet, what follows it is picked up by the next call
+    size_t PopBulk(T* out, size_t count) SRK_NOEXCEPT
+    {
+        // only this thread writes the head, the atomic is for GetSizeApprox
+        size_t head   = m_Head.load(std::memory_order_relaxed);
+        size_t popped = 0;
+        while (popped < count)
+        {
+            Cell& cell = m_Cells[head & m_Mask];
+            if (cell.Sequence.load(std::memory_order_acquire) != head + 1)
+                break;
+
+            out[popped++] = std::move(cell.Value);
+            cell.Value    = T{};
+
+            // free for the producers' next lap around the ring
+            cell.Sequence.store(head + m_Capacity, std::memory_order_release);
+            ++head;
+        }
+        m_Head.store(head, std::memory_order_relaxed);
+        return popped;
+    }
+
+    // only a snapshot, producers may be pushing at the same time
+    size_t GetSizeApprox() const SRK_NOEXCEPT
+    {
+        const size_t tail = m_Tail.load(std::memory_order_relaxed);
+        const size_t head = m_Head.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t GetCapacity() const SRK_NOEXCEPT { return m_Capacity; }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> Sequence{0};
+        T                   Value{};
+    };
+
+    static size_t RoundUp(size_t capacity) SRK_NOEXCEPT
+    {
+        size_t power = 2;
+        while (power < capacity)
+            power *= 2;
+        return power;
+    }
+
+private:
+    const size_t            m_Capacity;
+    const size_t            m_Mask;
+    std::unique_ptr<Cell[]> m_Cells;
+
+    // on lines of their own, every producer hammers the tail and the consumer shouldn't pay for that
+    alignas(64) std::atomic<size_t> m_Tail;
+    alignas(64) std::atomic<size_t> m_Head;
+};
+
+} // namespace shrek::base
@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "StartupGraph.h"
+
+#include "platform/Log.h"
+
+#include <algorithm>
+
+namespace shrek::base {
+
+StartupGraph::PhaseId StartupGraph::Add(std::string name, std::function<void()> run, std::initializer_list<PhaseId> dependencies, PhaseThread thread) SRK_NOEXCEPT
+{
+    const PhaseId id = static_cast<PhaseId>(m_Phases.size());
+
+    auto phase = std::make_unique<Phase>();
+    phase->Run = std::move(run);
+    for (PhaseId dependency : dependencies)
+    {
+        SRK_ASSERT(dependency < id, "startup phases can only depend on phases added before them");
+        phase->Dependencies.push_back(dependency);
+        m_Phases[dependency]->Dependents.push_back(id);
+    }
+    phase->Waiting.store(static_cast<uint32_t>(phase->Dependencies.size()), std::memory_order_relaxed);
+    m_Phases.push_back(std::move(phase));
+
+    PhaseTiming timing;
+    timing.Name   = std::move(name);
+    timing.Thread = thread;
+    m_Timings.push_back(std::move(timing));
+
+    return id;
+}
+
+double StartupGraph::Now() const SRK_NOEXCEPT
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Begin).count();
+}
+
+void StartupGraph::Run(JobSystem& jobs) SRK_NOEXCEPT
+{
+    m_Begin      = std::chrono::steady_clock::now();
+    m_MainThread = std::this_thread::get_id();
+    m_Finished.Pending.store(static_cast<uint32_t>(m_Phases.size()), std::memory_order_relaxed);
+
+    for (PhaseId id{}; id < m_Phases.size(); ++id)
+    {
+        if (m_Phases[id]->Dependencies.empty())
+            Start(id, jobs);
+    }
+
+    // the main thread runs its own phases as they become ready and helps with the rest in between
+    while (!m_Finished.Done())
+    {
+        PhaseId id    = 0;
+        bool    ready = false;
+        {
+            std::lock_guard<std::mutex> lock(m_MainMutex);
+            if (!m_MainReady.empty())
+            {
+                id    = m_MainReady.front();
+                ready = true;
+                m_MainReady.erase(m_MainReady.begin());
+            }
+        }
+
+        if (ready)
+            Execute(id, jobs);
+        else if (!jobs.TryRunOne())
+            std::this_thread::yield();
+    }
+
+    m_TotalMs = Now();
+    ComputeCriticalPath();
+}
+
+void StartupGraph::Start(PhaseId id, JobSystem& jobs) SRK_NOEXCEPT
+{
+    if (m_Timings[id].Thread == PhaseThread::Main)
+    {
+        std::lock_guard<std::mutex> lock(m_MainMutex);
+        m_MainReady.push_back(id);
+        return;
+    }
+
+    jobs.Submit([this, id, &jobs]() { Execute(id, jobs); });
+}
+
+void StartupGraph::Execute(PhaseId id, JobSystem& jobs) SRK_NOEXCEPT
+{
+    PhaseTiming& timing = m_Timings[id];
+    timing.OnMainThread = std::this_thread::get_id() == m_MainThread;
+    timing.BeginMs      = Now();
+
+    m_Phases[id]->Run();
+
+    timing.EndMs = Now();
+
+    // whoever finishes the last dependency starts the phase
+    for (PhaseId dependent : m_Phases[id]->Dependents)
+    {
+        if (m_Phases[dependent]->Waiting.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            Start(dependent, jobs);
+    }
+
+    // release so Run sees every timing written once it's done
+    m_Finished.Pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void StartupGraph::ComputeCriticalPath() SRK_NOEXCEPT
+{
+    if (m_Phases.empty())
+        return;
+
+    // walking back from the end, a phase has to finish before anything depending on it has to start.
+    // phases only depend on earlier ones so reverse order visits every dependent first
+    std::vector<double> latestEnd(m_Phases.size(), m_TotalMs);
+    for (size_t idx = m_Phases.size(); idx-- > 0;)
+    {
+        for (PhaseId dependent : m_Phases[idx]->Dependents)
+            latestEnd[idx] = std::min(latestEnd[idx], latestEnd[dependent] - m_Timings[dependent].GetDurationMs());
+
+        m_Timings[idx].SlackMs = std::max(0.0, latestEnd[idx] - m_Timings[idx].EndMs);
+    }
+
+    // from the phase that finished last back through whichever dependency held it up the longest
+    auto latest = [this](PhaseId lhs, PhaseId rhs) { return m_Timings[lhs].EndMs < m_Timings[rhs].EndMs; };
+
+    std::vector<PhaseId> all(m_Phases.size());
+    for (PhaseId id{}; id < all.size(); ++id)
+        all[id] = id;
+
+    PhaseId id = *std::max_element(all.begin(), all.end(), latest);
+    while (true)
+    {
+        m_Timings[id].Critical = true;
+        m_Timings[id].SlackMs  = 0.0;
+
+        const std::vector<PhaseId>& dependencies = m_Phases[id]->Dependencies;
+        if (dependencies.empty())
+            break;
+        id = *std::max_element(dependencies.begin(), dependencies.end(), latest);
+    }
+}
+
+void StartupGraph::Report() const SRK_NOEXCEPT
+{
+    double work = 0.0;
+    for (const PhaseTiming& timing : m_Timings)
+        work += timing.GetDurationMs();
+
+    SRK_CORE_INFO("Startup took {:.2f} ms for {:.2f} ms of work in {} phases", m_TotalMs, work, m_Timings.size());
+
+    std::vector<const PhaseTiming*> sorted;
+    sorted.reserve(m_Timings.size());
+    for (const PhaseTiming& timing : m_Timings)
+        sorted.push_back(&timing);
+    std::sort(sorted.begin(), sorted.end(), [](const PhaseTiming* lhs, const PhaseTiming* rhs) { return lhs->BeginMs < rhs->BeginMs; });
+
+    for (const PhaseTiming* timing : sorted)
+    {
+        SRK_CORE_INFO("    {:<24} {:>9.2f} ms  [{:>9.2f} .. {:>9.2f}]  {:<6} {}", timing->Name, timing->GetDurationMs(), timing->BeginMs, timing->EndMs,
+                      timing->OnMainThread ? "main" : "worker", timing->Critical ? std::string("critical") : fmt::format("{:.2f} ms slack", timing->SlackMs));
+    }
+}
+
+} // namespace shrek::base
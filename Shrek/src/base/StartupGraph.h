@@ -0,0 +1,91 @@
+#pragma once
+#include "defs.h"
+#include "base/JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace shrek::base {
+
+enum class PhaseThread : uint8_t
+{
+    Any, // on the job system, or the main thread when it has nothing else to do
+    Main // only the thread calling Run, for glfw and anything else tied to the main thread
+};
+
+struct PhaseTiming
+{
+    std::string Name;
+    PhaseThread Thread{PhaseThread::Any};
+    bool        OnMainThread{false}; // where it ended up running
+    double      BeginMs{0.0};        // since Run was called
+    double      EndMs{0.0};
+    double      SlackMs{0.0};     // how much later it could have finished without making startup longer
+    bool        Critical{false}; // on the chain of dependencies that finished last, making these faster is what shortens startup
+
+    double GetDurationMs() const SRK_NOEXCEPT { return EndMs - BeginMs; }
+};
+
+/*
+ *  Startup split into named phases with dependencies between them. Run starts every phase as soon as what
+ *  it depends on has finished, so independent work (window creation, shader compiles, device creation)
+ *  overlaps instead of running one after the other. Every phase is timed and Report logs how long each took
+ *  and which ones were on the critical path, which is what has to get faster for startup to get faster.
+ */
+class StartupGraph
+{
+public:
+    using PhaseId = uint32_t;
+
+    StartupGraph() SRK_NOEXCEPT = default;
+
+    StartupGraph(const StartupGraph& other) = delete;
+    StartupGraph& operator=(const StartupGraph& other) = delete;
+
+    // dependencies have to be added before the phases depending on them, so there can't be a cycle
+    PhaseId Add(std::string name, std::function<void()> run, std::initializer_list<PhaseId> dependencies = {}, PhaseThread thread = PhaseThread::Any) SRK_NOEXCEPT;
+
+    // blocks until every phase has run, main thread phases run on the calling thread
+    void Run(JobSystem& jobs) SRK_NOEXCEPT;
+
+    // every phase in the order it was added, after Run
+    const std::vector<PhaseTiming>& GetTimings() const SRK_NOEXCEPT { return m_Timings; }
+    double                          GetTotalMs() const SRK_NOEXCEPT { return m_TotalMs; }
+
+    void Report() const SRK_NOEXCEPT;
+
+private:
+    struct Phase
+    {
+        std::function<void()> Run;
+        std::vector<PhaseId>  Dependencies;
+        std::vector<PhaseId>  Dependents;
+        std::atomic<uint32_t> Waiting{0}; // dependencies that have not finished yet
+    };
+
+    void   Start(PhaseId id, JobSystem& jobs) SRK_NOEXCEPT;
+    void   Execute(PhaseId id, JobSystem& jobs) SRK_NOEXCEPT;
+    double Now() const SRK_NOEXCEPT; // ms since Run was called
+    void   ComputeCriticalPath() SRK_NOEXCEPT;
+
+private:
+    std::vector<std::unique_ptr<Phase>>   m_Phases;
+    std::vector<PhaseTiming>              m_Timings;
+    double                                m_TotalMs{0.0};
+    std::chrono::steady_clock::time_point m_Begin;
+    std::thread::id                       m_MainThread;
+
+    std::mutex           m_MainMutex;
+    std::vector<PhaseId> m_MainReady; // main thread phases whose dependencies have finished
+    JobCounter           m_Finished;  // phases that have not finished yet
+};
+
+} // namespace shrek::base
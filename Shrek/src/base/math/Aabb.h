@@ -0,0 +1,56 @@
+#pragma once
+#include "defs.h"
+#include "Mat.h"
+#include "Vec.h"
+
+#include <limits>
+
+namespace shrek::math {
+
+struct Aabb
+{
+    Vec3 Min{std::numeric_limits<float>::max()};
+    Vec3 Max{std::numeric_limits<float>::lowest()};
+
+    Vec3 Center() const SRK_NOEXCEPT { return (Min + Max) * 0.5f; }
+    Vec3 Extents() const SRK_NOEXCEPT { return (Max - Min) * 0.5f; }
+    bool IsValid() const SRK_NOEXCEPT { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+
+    float SurfaceArea() const SRK_NOEXCEPT
+    {
+        Vec3 d = Max - Min;
+        return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+};
+
+inline Aabb Merge(const Aabb& a, const Aabb& b) SRK_NOEXCEPT { return Aabb{Min(a.Min, b.Min), Max(a.Max, b.Max)}; }
+
+inline bool Contains(const Aabb& outer, const Aabb& inner) SRK_NOEXCEPT
+{
+    return outer.Min.x <= inner.Min.x && outer.Min.y <= inner.Min.y && outer.Min.z <= inner.Min.z &&
+           outer.Max.x >= inner.Max.x && outer.Max.y >= inner.Max.y && outer.Max.z >= inner.Max.z;
+}
+
+inline bool Overlaps(const Aabb& a, const Aabb& b) SRK_NOEXCEPT
+{
+    return a.Min.x <= b.Max.x && a.Max.x >= b.Min.x &&
+           a.Min.y <= b.Max.y && a.Max.y >= b.Min.y &&
+           a.Min.z <= b.Max.z && a.Max.z >= b.Min.z;
+}
+
+inline Aabb Expand(const Aabb& box, float margin) SRK_NOEXCEPT
+{
+    return Aabb{box.Min - Vec3{margin}, box.Max + Vec3{margin}};
+}
+
+// center/extent form (Arvo), exact for the rotated box's bounds
+inline Aabb Transform(const Mat4& m, const Aabb& box) SRK_NOEXCEPT
+{
+    const Vec3 c = TransformPoint(m, box.Center());
+    const Vec3 e = box.Extents();
+
+    const Vec3 extent = Abs(m.Columns[0].Xyz()) * e.x + Abs(m.Columns[1].Xyz()) * e.y + Abs(m.Columns[2].Xyz()) * e.z;
+    return Aabb{c - extent, c + extent};
+}
+
+} // namespace shrek::math
@@ -0,0 +1,440 @@
+#include "pch.h"
+#include "Batch.h"
+#include "Simd.h"
+
+namespace shrek::math {
+
+namespace scalar {
+
+namespace {
+
+inline Vec4 mulColumn(const Mat4& m, const Vec4& v) SRK_NOEXCEPT
+{
+    return Vec4{
+        m[0].x * v.x + m[1].x * v.y + m[2].x * v.z + m[3].x * v.w,
+        m[0].y * v.x + m[1].y * v.y + m[2].y * v.z + m[3].y * v.w,
+        m[0].z * v.x + m[1].z * v.y + m[2].z * v.z + m[3].z * v.w,
+        m[0].w * v.x + m[1].w * v.y + m[2].w * v.z + m[3].w * v.w};
+}
+
+inline Mat4 mul(const Mat4& a, const Mat4& b) SRK_NOEXCEPT
+{
+    Mat4 m;
+    for (int col{}; col < 4; ++col)
+        m[col] = mulColumn(a, b[col]);
+    return m;
+}
+
+} // namespace
+
+void MultiplyMatrices(const Mat4* lhs, const Mat4* rhs, Mat4* out, size_t count) SRK_NOEXCEPT
+{
+    for (size_t idx{}; idx < count; ++idx)
+        out[idx] = mul(lhs[idx], rhs[idx]);
+}
+
+void MultiplyMatrices(const Mat4& parent, const Mat4* local, Mat4* out, size_t count) SRK_NOEXCEPT
+{
+    for (size_t idx{}; idx < count; ++idx)
+        out[idx] = mul(parent, local[idx]);
+}
+
+void TransformAabbs(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count) SRK_NOEXCEPT
+{
+    for (size_t idx{}; idx < count; ++idx)
+    {
+        const Mat4& m = matrices[idx];
+        const Vec3  c = boxes[idx].Center();
+        const Vec3  e = boxes[idx].Extents();
+
+        Vec3 center{
+            m[0].x * c.x + m[1].x * c.y + m[2].x * c.z + m[3].x,
+            m[0].y * c.x + m[1].y * c.y + m[2].y * c.z + m[3].y,
+            m[0].z * c.x + m[1].z * c.y + m[2].z * c.z + m[3].z};
+
+        Vec3 extent{
+            std::fabs(m[0].x) * e.x + std::fabs(m[1].x) * e.y + std::fabs(m[2].x) * e.z,
+            std::fabs(m[0].y) * e.x + std::fabs(m[1].y) * e.y + std::fabs(m[2].y) * e.z,
+            std::fabs(m[0].z) * e.x + std::fabs(m[1].z) * e.y + std::fabs(m[2].z) * e.z};
+
+        out[idx] = Aabb{center - extent, center + extent};
+    }
+}
+
+void ComposeTransforms(const TransformBatch& transforms, Mat4Batch& out) SRK_NOEXCEPT
+{
+    for (uint32_t lane{}; lane < BatchWidth; ++lane)
+    {
+        const Vec3 position{transforms.PositionX[lane], transforms.PositionY[lane], transforms.PositionZ[lane]};
+        const Quat rotation{transforms.RotationX[lane], transforms.RotationY[lane], transforms.RotationZ[lane], transforms.RotationW[lane]};
+        const Vec3 scale{transforms.ScaleX[lane], transforms.ScaleY[lane], transforms.ScaleZ[lane]};
+        out.Set(lane, Mat4::FromTRS(position, rotation, scale));
+    }
+}
+
+void TransformAabbs(const Mat4Batch& matrices, const AabbBatch& boxes, AabbBatch& out) SRK_NOEXCEPT
+{
+    for (uint32_t lane{}; lane < BatchWidth; ++lane)
+    {
+        const Mat4 m = matrices.Get(lane);
+        const Vec3 c{boxes.CenterX[lane], boxes.CenterY[lane], boxes.CenterZ[lane]};
+        const Vec3 e{boxes.ExtentX[lane], boxes.ExtentY[lane], boxes.ExtentZ[lane]};
+
+        out.CenterX[lane] = m[0].x * c.x + m[1].x * c.y + m[2].x * c.z + m[3].x;
+        out.CenterY[lane] = m[0].y * c.x + m[1].y * c.y + m[2].y * c.z + m[3].y;
+        out.CenterZ[lane] = m[0].z * c.x + m[1].z * c.y + m[2].z * c.z + m[3].z;
+        out.ExtentX[lane] = std::fabs(m[0].x) * e.x + std::fabs(m[1].x) * e.y + std::fabs(m[2].x) * e.z;
+        out.ExtentY[lane] = std::fabs(m[0].y) * e.x + std::fabs(m[1].y) * e.y + std::fabs(m[2].y) * e.z;
+        out.ExtentZ[lane] = std::fabs(m[0].z) * e.x + std::fabs(m[1].z) * e.y + std::fabs(m[2].z) * e.z;
+    }
+}
+
+void CenterDistances(const AabbBatch& boxes, const Vec3& point, float* out) SRK_NOEXCEPT
+{
+    for (uint32_t lane{}; lane < BatchWidth; ++lane)
+        out[lane] = Length(Vec3{boxes.CenterX[lane], boxes.CenterY[lane], boxes.CenterZ[lane]} - point);
+}
+
+} // namespace scalar
+
+#if SRK_SIMD_HAS_SSE
+
+namespace {
+
+inline __m128 absPs(__m128 v) SRK_NOEXCEPT
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+}
+
+#    define SRK_SPLAT(v, lane) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(lane, lane, lane, lane))
+
+inline void mulSse(const Mat4& a, const Mat4& b, Mat4& out) SRK_NOEXCEPT
+{
+    const __m128 a0 = _mm_load_ps(&a[0].x);
+    const __m128 a1 = _mm_load_ps(&a[1].x);
+    const __m128 a2 = _mm_load_ps(&a[2].x);
+    const __m128 a3 = _mm_load_ps(&a[3].x);
+
+    // results go through registers first so out can alias a or b
+    __m128 cols[4];
+    for (int col{}; col < 4; ++col)
+    {
+        const __m128 v = _mm_load_ps(&b[col].x);
+        __m128       r = _mm_mul_ps(a0, SRK_SPLAT(v, 0));
+        r              = _mm_add_ps(r, _mm_mul_ps(a1, SRK_SPLAT(v, 1)));
+        r              = _mm_add_ps(r, _mm_mul_ps(a2, SRK_SPLAT(v, 2)));
+        r              = _mm_add_ps(r, _mm_mul_ps(a3, SRK_SPLAT(v, 3)));
+        cols[col]      = r;
+    }
+
+    for (int col{}; col < 4; ++col)
+        _mm_store_ps(&out[col].x, cols[col]);
+}
+
+// Aabb is 6 floats, these loads/stores stay inside the struct: [min.xyz max.x] and [min.z max.xyz]
+inline void loadAabb(const Aabb& box, __m128& min, __m128& max) SRK_NOEXCEPT
+{
+    min             = _mm_loadu_ps(&box.Min.x);
+    const __m128 hi = _mm_loadu_ps(&box.Min.z);
+    max             = _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(3, 3, 2, 1));
+}
+
+inline void storeAabb(Aabb& box, __m128 min, __m128 max) SRK_NOEXCEPT
+{
+    // [min.z, max.x, max.y, max.z]
+    const __m128 zx = _mm_shuffle_ps(min, max, _MM_SHUFFLE(0, 0, 2, 2));
+    const __m128 hi = _mm_shuffle_ps(zx, max, _MM_SHUFFLE(2, 1, 2, 0));
+    // [min.x, min.y, min.z, max.x]
+    const __m128 lo = _mm_shuffle_ps(min, zx, _MM_SHUFFLE(2, 0, 1, 0));
+
+    _mm_storeu_ps(&box.Min.x, lo);
+    _mm_storeu_ps(&box.Min.z, hi);
+}
+
+inline void transformAabbSse(const Mat4& m, const Aabb& box, Aabb& out) SRK_NOEXCEPT
+{
+    __m128 min, max;
+    loadAabb(box, min, max);
+
+    const __m128 half   = _mm_set1_ps(0.5f);
+    const __m128 center = _mm_mul_ps(_mm_add_ps(min, max), half);
+    const __m128 extent = _mm_mul_ps(_mm_sub_ps(max, min), half);
+
+    const __m128 c0 = _mm_load_ps(&m[0].x);
+    const __m128 c1 = _mm_load_ps(&m[1].x);
+    const __m128 c2 = _mm_load_ps(&m[2].x);
+    const __m128 c3 = _mm_load_ps(&m[3].x);
+
+    __m128 c = _mm_add_ps(c3, _mm_mul_ps(c0, SRK_SPLAT(center, 0)));
+    c        = _mm_add_ps(c, _mm_mul_ps(c1, SRK_SPLAT(center, 1)));
+    c        = _mm_add_ps(c, _mm_mul_ps(c2, SRK_SPLAT(center, 2)));
+
+    __m128 e = _mm_mul_ps(absPs(c0), SRK_SPLAT(extent, 0));
+    e        = _mm_add_ps(e, _mm_mul_ps(absPs(c1), SRK_SPLAT(extent, 1)));
+    e        = _mm_add_ps(e, _mm_mul_ps(absPs(c2), SRK_SPLAT(extent, 2)));
+
+    storeAabb(out, _mm_sub_ps(c, e), _mm_add_ps(c, e));
+}
+
+#    if SRK_SIMD_HAS_AVX2
+
+#        define SRK_SPLAT8(v, lane) _mm256_permute_ps((v), _MM_SHUFFLE(lane, lane, lane, lane))
+
+inline __m256 combine(__m128 lo, __m128 hi) SRK_NOEXCEPT
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+// two columns of the result per iteration, each 128 bit lane works on its own column
+inline void mulAvx(const Mat4& a, const Mat4& b, Mat4& out) SRK_NOEXCEPT
+{
+    const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[0].x));
+    const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[1].x));
+    const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[2].x));
+    const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[3].x));
+
+    __m256 cols[2];
+    for (int half{}; half < 2; ++half)
+    {
+        const __m256 v = _mm256_loadu_ps(&b[half * 2].x);
+        __m256       r = _mm256_mul_ps(a0, SRK_SPLAT8(v, 0));
+        r              = _mm256_add_ps(r, _mm256_mul_ps(a1, SRK_SPLAT8(v, 1)));
+        r              = _mm256_add_ps(r, _mm256_mul_ps(a2, SRK_SPLAT8(v, 2)));
+        r              = _mm256_add_ps(r, _mm256_mul_ps(a3, SRK_SPLAT8(v, 3)));
+        cols[half]     = r;
+    }
+
+    _mm256_storeu_ps(&out[0].x, cols[0]);
+    _mm256_storeu_ps(&out[2].x, cols[1]);
+}
+
+// two boxes at a time, lower lane is box 0 and the upper lane box 1
+inline void transformAabbsAvx(const Mat4& m0, const Mat4& m1, const Aabb& box0, const Aabb& box1, Aabb& out0, Aabb& out1) SRK_NOEXCEPT
+{
+    __m128 min0, max0, min1, max1;
+    loadAabb(box0, min0, max0);
+    loadAabb(box1, min1, max1);
+
+    const __m256 min = combine(min0, min1);
+    const __m256 max = combine(max0, max1);
+
+    const __m256 half   = _mm256_set1_ps(0.5f);
+    const __m256 center = _mm256_mul_ps(_mm256_add_ps(min, max), half);
+    const __m256 extent = _mm256_mul_ps(_mm256_sub_ps(max, min), half);
+    const __m256 sign   = _mm256_set1_ps(-0.f);
+
+    const __m256 c0 = combine(_mm_load_ps(&m0[0].x), _mm_load_ps(&m1[0].x));
+    const __m256 c1 = combine(_mm_load_ps(&m0[1].x), _mm_load_ps(&m1[1].x));
+    const __m256 c2 = combine(_mm_load_ps(&m0[2].x), _mm_load_ps(&m1[2].x));
+    const __m256 c3 = combine(_mm_load_ps(&m0[3].x), _mm_load_ps(&m1[3].x));
+
+    __m256 c = _mm256_add_ps(c3, _mm256_mul_ps(c0, SRK_SPLAT8(center, 0)));
+    c        = _mm256_add_ps(c, _mm256_mul_ps(c1, SRK_SPLAT8(center, 1)));
+    c        = _mm256_add_ps(c, _mm256_mul_ps(c2, SRK_SPLAT8(center, 2)));
+
+    __m256 e = _mm256_mul_ps(_mm256_andnot_ps(sign, c0), SRK_SPLAT8(extent, 0));
+    e        = _mm256_add_ps(e, _mm256_mul_ps(_mm256_andnot_ps(sign, c1), SRK_SPLAT8(extent, 1)));
+    e        = _mm256_add_ps(e, _mm256_mul_ps(_mm256_andnot_ps(sign, c2), SRK_SPLAT8(extent, 2)));
+
+    const __m256 outMin = _mm256_sub_ps(c, e);
+    const __m256 outMax = _mm256_add_ps(c, e);
+
+    storeAabb(out0, _mm256_castps256_ps128(outMin), _mm256_castps256_ps128(outMax));
+    storeAabb(out1, _mm256_extractf128_ps(outMin, 1), _mm256_extractf128_ps(outMax, 1));
+}
+
+#        undef SRK_SPLAT8
+#    endif
+
+#    undef SRK_SPLAT
+
+// one register holds a whole batch field, BatchWidth matches the register width
+#    if SRK_SIMD_HAS_AVX2
+using Lanes = __m256;
+
+inline Lanes load(const float* p) SRK_NOEXCEPT { return _mm256_load_ps(p); }
+inline void  store(float* p, Lanes v) SRK_NOEXCEPT { _mm256_store_ps(p, v); }
+inline void  storeUnaligned(float* p, Lanes v) SRK_NOEXCEPT { _mm256_storeu_ps(p, v); }
+inline Lanes splat(float v) SRK_NOEXCEPT { return _mm256_set1_ps(v); }
+inline Lanes add(Lanes a, Lanes b) SRK_NOEXCEPT { return _mm256_add_ps(a, b); }
+inline Lanes sub(Lanes a, Lanes b) SRK_NOEXCEPT { return _mm256_sub_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) SRK_NOEXCEPT { return _mm256_mul_ps(a, b); }
+inline Lanes abs(Lanes v) SRK_NOEXCEPT { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), v); }
+inline Lanes sqrt(Lanes v) SRK_NOEXCEPT { return _mm256_sqrt_ps(v); }
+#    else
+using Lanes = __m128;
+
+inline Lanes load(const float* p) SRK_NOEXCEPT { return _mm_load_ps(p); }
+inline void  store(float* p, Lanes v) SRK_NOEXCEPT { _mm_store_ps(p, v); }
+inline void  storeUnaligned(float* p, Lanes v) SRK_NOEXCEPT { _mm_storeu_ps(p, v); }
+inline Lanes splat(float v) SRK_NOEXCEPT { return _mm_set1_ps(v); }
+inline Lanes add(Lanes a, Lanes b) SRK_NOEXCEPT { return _mm_add_ps(a, b); }
+inline Lanes sub(Lanes a, Lanes b) SRK_NOEXCEPT { return _mm_sub_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) SRK_NOEXCEPT { return _mm_mul_ps(a, b); }
+inline Lanes abs(Lanes v) SRK_NOEXCEPT { return absPs(v); }
+inline Lanes sqrt(Lanes v) SRK_NOEXCEPT { return _mm_sqrt_ps(v); }
+#    endif
+
+static_assert(sizeof(Lanes) == BatchWidth * sizeof(float), "a batch field has to fill exactly one register");
+
+// a * b + c * d + e * f + g
+inline Lanes dot3(Lanes a, Lanes b, Lanes c, Lanes d, Lanes e, Lanes f, Lanes g) SRK_NOEXCEPT
+{
+    return add(add(mul(a, b), mul(c, d)), add(mul(e, f), g));
+}
+
+} // namespace
+
+void MultiplyMatrices(const Mat4* lhs, const Mat4* rhs, Mat4* out, size_t count) SRK_NOEXCEPT
+{
+    for (size_t idx{}; idx < count; ++idx)
+    {
+#    if SRK_SIMD_HAS_AVX2
+        mulAvx(lhs[idx], rhs[idx], out[idx]);
+#    else
+        mulSse(lhs[idx], rhs[idx], out[idx]);
+#    endif
+    }
+}
+
+void MultiplyMatrices(const Mat4& parent, const Mat4* local, Mat4* out, size_t count) SRK_NOEXCEPT
+{
+    for (size_t idx{}; idx < count; ++idx)
+    {
+#    if SRK_SIMD_HAS_AVX2
+        mulAvx(parent, local[idx], out[idx]);
+#    else
+        mulSse(parent, local[idx], out[idx]);
+#    endif
+    }
+}
+
+void TransformAabbs(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count) SRK_NOEXCEPT
+{
+    size_t idx{};
+
+#    if SRK_SIMD_HAS_AVX2
+    for (; idx + 2 <= count; idx += 2)
+        transformAabbsAvx(matrices[idx], matrices[idx + 1], boxes[idx], boxes[idx + 1], out[idx], out[idx + 1]);
+#    endif
+
+    for (; idx < count; ++idx)
+        transformAabbSse(matrices[idx], boxes[idx], out[idx]);
+}
+
+void ComposeTransforms(const TransformBatch& transforms, Mat4Batch& out) SRK_NOEXCEPT
+{
+    const Lanes x = load(transforms.RotationX);
+    const Lanes y = load(transforms.RotationY);
+    const Lanes z = load(transforms.RotationZ);
+    const Lanes w = load(transforms.RotationW);
+
+    const Lanes xx = mul(x, x), yy = mul(y, y), zz = mul(z, z);
+    const Lanes xy = mul(x, y), xz = mul(x, z), yz = mul(y, z);
+    const Lanes wx = mul(w, x), wy = mul(w, y), wz = mul(w, z);
+
+    const Lanes one  = splat(1.f);
+    const Lanes two  = splat(2.f);
+    const Lanes zero = splat(0.f);
+
+    const Lanes sx = load(transforms.ScaleX);
+    const Lanes sy = load(transforms.ScaleY);
+    const Lanes sz = load(transforms.ScaleZ);
+
+    store(out.Elements[0], mul(sub(one, mul(two, add(yy, zz))), sx));
+    store(out.Elements[1], mul(mul(two, add(xy, wz)), sx));
+    store(out.Elements[2], mul(mul(two, sub(xz, wy)), sx));
+    store(out.Elements[3], zero);
+
+    store(out.Elements[4], mul(mul(two, sub(xy, wz)), sy));
+    store(out.Elements[5], mul(sub(one, mul(two, add(xx, zz))), sy));
+    store(out.Elements[6], mul(mul(two, add(yz, wx)), sy));
+    store(out.Elements[7], zero);
+
+    store(out.Elements[8], mul(mul(two, add(xz, wy)), sz));
+    store(out.Elements[9], mul(mul(two, sub(yz, wx)), sz));
+    store(out.Elements[10], mul(sub(one, mul(two, add(xx, yy))), sz));
+    store(out.Elements[11], zero);
+
+    store(out.Elements[12], load(transforms.PositionX));
+    store(out.Elements[13], load(transforms.PositionY));
+    store(out.Elements[14], load(transforms.PositionZ));
+    store(out.Elements[15], one);
+}
+
+void TransformAabbs(const Mat4Batch& matrices, const AabbBatch& boxes, AabbBatch& out) SRK_NOEXCEPT
+{
+    // everything is loaded before the first store so out can alias boxes
+    const Lanes cx = load(boxes.CenterX);
+    const Lanes cy = load(boxes.CenterY);
+    const Lanes cz = load(boxes.CenterZ);
+    const Lanes ex = load(boxes.ExtentX);
+    const Lanes ey = load(boxes.ExtentY);
+    const Lanes ez = load(boxes.ExtentZ);
+
+    Lanes center[3];
+    Lanes extent[3];
+    for (int row{}; row < 3; ++row)
+    {
+        const Lanes m0 = load(matrices.Elements[row]);
+        const Lanes m1 = load(matrices.Elements[4 + row]);
+        const Lanes m2 = load(matrices.Elements[8 + row]);
+        const Lanes m3 = load(matrices.Elements[12 + row]);
+
+        center[row] = dot3(m0, cx, m1, cy, m2, cz, m3);
+        extent[row] = dot3(abs(m0), ex, abs(m1), ey, abs(m2), ez, splat(0.f));
+    }
+
+    store(out.CenterX, center[0]);
+    store(out.CenterY, center[1]);
+    store(out.CenterZ, center[2]);
+    store(out.ExtentX, extent[0]);
+    store(out.ExtentY, extent[1]);
+    store(out.ExtentZ, extent[2]);
+}
+
+void CenterDistances(const AabbBatch& boxes, const Vec3& point, float* out) SRK_NOEXCEPT
+{
+    const Lanes dx = sub(load(boxes.CenterX), splat(point.x));
+    const Lanes dy = sub(load(boxes.CenterY), splat(point.y));
+    const Lanes dz = sub(load(boxes.CenterZ), splat(point.z));
+
+    // out is only guaranteed float alignment
+    storeUnaligned(out, sqrt(dot3(dx, dx, dy, dy, dz, dz, splat(0.f))));
+}
+
+#else
+
+void MultiplyMatrices(const Mat4* lhs, const Mat4* rhs, Mat4* out, size_t count) SRK_NOEXCEPT
+{
+    scalar::MultiplyMatrices(lhs, rhs, out, count);
+}
+
+void MultiplyMatrices(const Mat4& parent, const Mat4* local, Mat4* out, size_t count) SRK_NOEXCEPT
+{
+    scalar::MultiplyMatrices(parent, local, out, count);
+}
+
+void TransformAabbs(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count) SRK_NOEXCEPT
+{
+    scalar::TransformAabbs(matrices, boxes, out, count);
+}
+
+void ComposeTransforms(const TransformBatch& transforms, Mat4Batch& out) SRK_NOEXCEPT
+{
+    scalar::ComposeTransforms(transforms, out);
+}
+
+void TransformAabbs(const Mat4Batch& matrices, const AabbBatch& boxes, AabbBatch& out) SRK_NOEXCEPT
+{
+    scalar::TransformAabbs(matrices, boxes, out);
+}
+
+void CenterDistances(const AabbBatch& boxes, const Vec3& point, float* out) SRK_NOEXCEPT
+{
+    scalar::CenterDistances(boxes, point, out);
+}
+
+#endif
+
+} // namespace shrek::math
@@ -0,0 +1,137 @@
+#pragma once
+#include "defs.h"
+#include "Aabb.h"
+#include "Mat.h"
+#include "Quat.h"
+#include "Simd.h"
+#include "Vec.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ *  Array kernels for the hot loops (transform propagation, bounds updates).
+ *  The plain functions use the widest path the build was configured with, math::scalar has the reference versions.
+ *  Inputs and outputs may alias as long as they are the exact same array.
+ *
+ *  The batch types are the structure of arrays side, BatchWidth elements with one per simd lane so every kernel
+ *  is a straight run of wide instructions without any shuffling. Callers gather into them and scatter back out.
+ */
+namespace shrek::math {
+
+#if SRK_SIMD_HAS_AVX2
+constexpr uint32_t BatchWidth = 8;
+#else
+constexpr uint32_t BatchWidth = 4;
+#endif
+
+// translation, rotation and scale per lane
+struct alignas(32) TransformBatch
+{
+    float PositionX[BatchWidth];
+    float PositionY[BatchWidth];
+    float PositionZ[BatchWidth];
+    float RotationX[BatchWidth];
+    float RotationY[BatchWidth];
+    float RotationZ[BatchWidth];
+    float RotationW[BatchWidth];
+    float ScaleX[BatchWidth];
+    float ScaleY[BatchWidth];
+    float ScaleZ[BatchWidth];
+
+    void Set(uint32_t lane, const Vec3& position, const Quat& rotation, const Vec3& scale) SRK_NOEXCEPT
+    {
+        PositionX[lane] = position.x;
+        PositionY[lane] = position.y;
+        PositionZ[lane] = position.z;
+        RotationX[lane] = rotation.x;
+        RotationY[lane] = rotation.y;
+        RotationZ[lane] = rotation.z;
+        RotationW[lane] = rotation.w;
+        ScaleX[lane]    = scale.x;
+        ScaleY[lane]    = scale.y;
+        ScaleZ[lane]    = scale.z;
+    }
+};
+
+// Elements[col * 4 + row] is that element of every lane's matrix
+struct alignas(32) Mat4Batch
+{
+    float Elements[16][BatchWidth];
+
+    void Set(uint32_t lane, const Mat4& m) SRK_NOEXCEPT
+    {
+        for (int idx{}; idx < 16; ++idx)
+            Elements[idx][lane] = m[idx / 4][idx % 4];
+    }
+
+    Mat4 Get(uint32_t lane) const SRK_NOEXCEPT
+    {
+        Mat4 m;
+        for (int idx{}; idx < 16; ++idx)
+            m[idx / 4][idx % 4] = Elements[idx][lane];
+        return m;
+    }
+};
+
+// boxes in center/extent form, one lane per box
+struct alignas(32) AabbBatch
+{
+    float CenterX[BatchWidth];
+    float CenterY[BatchWidth];
+    float CenterZ[BatchWidth];
+    float ExtentX[BatchWidth];
+    float ExtentY[BatchWidth];
+    float ExtentZ[BatchWidth];
+
+    void Set(uint32_t lane, const Aabb& box) SRK_NOEXCEPT
+    {
+        const Vec3 c = box.Center();
+        const Vec3 e = box.Extents();
+
+        CenterX[lane] = c.x;
+        CenterY[lane] = c.y;
+        CenterZ[lane] = c.z;
+        ExtentX[lane] = e.x;
+        ExtentY[lane] = e.y;
+        ExtentZ[lane] = e.z;
+    }
+
+    Aabb Get(uint32_t lane) const SRK_NOEXCEPT
+    {
+        const Vec3 c{CenterX[lane], CenterY[lane], CenterZ[lane]};
+        const Vec3 e{ExtentX[lane], ExtentY[lane], ExtentZ[lane]};
+        return Aabb{c - e, c + e};
+    }
+};
+
+// out[i] = lhs[i] * rhs[i]
+void MultiplyMatrices(const Mat4* lhs, const Mat4* rhs, Mat4* out, size_t count) SRK_NOEXCEPT;
+
+// out[i] = parent * local[i]
+void MultiplyMatrices(const Mat4& parent, const Mat4* local, Mat4* out, size_t count) SRK_NOEXCEPT;
+
+// out[i] = Transform(matrices[i], boxes[i])
+void TransformAabbs(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count) SRK_NOEXCEPT;
+
+// every lane of out = Mat4::FromTRS of the same lane
+void ComposeTransforms(const TransformBatch& transforms, Mat4Batch& out) SRK_NOEXCEPT;
+
+// every lane of out = Transform(matrix, box) of the same lane
+void TransformAabbs(const Mat4Batch& matrices, const AabbBatch& boxes, AabbBatch& out) SRK_NOEXCEPT;
+
+// out[lane] = distance from point to the center of that lane's box, out holds BatchWidth floats
+void CenterDistances(const AabbBatch& boxes, const Vec3& point, float* out) SRK_NOEXCEPT;
+
+namespace scalar {
+
+void MultiplyMatrices(const Mat4* lhs, const Mat4* rhs, Mat4* out, size_t count) SRK_NOEXCEPT;
+void MultiplyMatrices(const Mat4& parent, const Mat4* local, Mat4* out, size_t count) SRK_NOEXCEPT;
+void TransformAabbs(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count) SRK_NOEXCEPT;
+void ComposeTransforms(const TransformBatch& transforms, Mat4Batch& out) SRK_NOEXCEPT;
+void TransformAabbs(const Mat4Batch& matrices, const AabbBatch& boxes, AabbBatch& out) SRK_NOEXCEPT;
+void CenterDistances(const AabbBatch& boxes, const Vec3& point, float* out) SRK_NOEXCEPT;
+
+} // namespace scalar
+
+} // namespace shrek::math
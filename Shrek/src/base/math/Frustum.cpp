@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "Frustum.h"
+
+#include <cmath>
+
+namespace shrek::math {
+
+namespace {
+
+inline Vec4 row(const Mat4& m, int idx) SRK_NOEXCEPT
+{
+    return Vec4{m[0][idx], m[1][idx], m[2][idx], m[3][idx]};
+}
+
+inline Vec4 normalizePlane(const Vec4& plane) SRK_NOEXCEPT
+{
+    const float length = Length(plane.Xyz());
+    return length > 0.f ? plane * (1.f / length) : plane;
+}
+
+inline uint32_t laneMask(uint32_t count) SRK_NOEXCEPT
+{
+    return count >= 32 ? ~0u : (1u << count) - 1;
+}
+
+} // namespace
+
+Frustum Frustum::FromViewProjection(const Mat4& viewProjection) SRK_NOEXCEPT
+{
+    const Vec4 r0 = row(viewProjection, 0);
+    const Vec4 r1 = row(viewProjection, 1);
+    const Vec4 r2 = row(viewProjection, 2);
+    const Vec4 r3 = row(viewProjection, 3);
+
+    Frustum frustum;
+    frustum.Planes[0] = normalizePlane(r3 + r0); // left
+    frustum.Planes[1] = normalizePlane(r3 - r0); // right
+    frustum.Planes[2] = normalizePlane(r3 + r1); // bottom
+    frustum.Planes[3] = normalizePlane(r3 - r1); // top
+    frustum.Planes[4] = normalizePlane(r2);      // near, clip z starts at 0
+    frustum.Planes[5] = normalizePlane(r3 - r2); // far
+    return frustum;
+}
+
+namespace scalar {
+
+// distance of the center against the projected radius of the box on the plane normal
+CullMask TestAabbBatch(const Frustum& frustum, const AabbBatch& batch, uint32_t count) SRK_NOEXCEPT
+{
+    CullMask mask{0, 0};
+    for (uint32_t lane{}; lane < count; ++lane)
+    {
+        bool visible = true;
+        bool inside  = true;
+        for (const auto& plane : frustum.Planes)
+        {
+            const float distance = plane.x * batch.CenterX[lane] + plane.y * batch.CenterY[lane] + plane.z * batch.CenterZ[lane] + plane.w;
+            const float radius   = std::fabs(plane.x) * batch.ExtentX[lane] + std::fabs(plane.y) * batch.ExtentY[lane] + std::fabs(plane.z) * batch.ExtentZ[lane];
+
+            if (distance < -radius)
+            {
+                visible = false;
+                break;
+            }
+
+            if (distance < radius)
+                inside = false;
+        }
+
+        mask.Visible |= static_cast<uint32_t>(visible) << lane;
+        mask.Inside |= static_cast<uint32_t>(visible && inside) << lane;
+    }
+    return mask;
+}
+
+} // namespace scalar
+
+#if SRK_SIMD_HAS_AVX2
+
+CullMask TestAabbBatch(const Frustum& frustum, const AabbBatch& batch, uint32_t count) SRK_NOEXCEPT
+{
+    const __m256 cx = _mm256_load_ps(batch.CenterX);
+    const __m256 cy = _mm256_load_ps(batch.CenterY);
+    const __m256 cz = _mm256_load_ps(batch.CenterZ);
+    const __m256 ex = _mm256_load_ps(batch.ExtentX);
+    const __m256 ey = _mm256_load_ps(batch.ExtentY);
+    const __m256 ez = _mm256_load_ps(batch.ExtentZ);
+
+    __m256 outside   = _mm256_setzero_ps();
+    __m256 intersect = _mm256_setzero_ps();
+
+    for (const auto& plane : frustum.Planes)
+    {
+        const __m256 distance = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_mul_ps(cy, _mm256_set1_ps(plane.y))),
+            _mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+        const __m256 radius = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(std::fabs(plane.x))), _mm256_mul_ps(ey, _mm256_set1_ps(std::fabs(plane.y)))),
+            _mm256_mul_ps(ez, _mm256_set1_ps(std::fabs(plane.z))));
+
+        outside   = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_sub_ps(_mm256_setzero_ps(), radius), _CMP_LT_OQ));
+        intersect = _mm256_or_ps(intersect, _mm256_cmp_ps(distance, radius, _CMP_LT_OQ));
+    }
+
+    const uint32_t lanes     = laneMask(count);
+    const uint32_t visible   = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & lanes;
+    const uint32_t straddles = static_cast<uint32_t>(_mm256_movemask_ps(intersect));
+    return CullMask{visible, visible & ~straddles};
+}
+
+#elif SRK_SIMD_HAS_SSE
+
+CullMask TestAabbBatch(const Frustum& frustum, const AabbBatch& batch, uint32_t count) SRK_NOEXCEPT
+{
+    const __m128 cx = _mm_load_ps(batch.CenterX);
+    const __m128 cy = _mm_load_ps(batch.CenterY);
+    const __m128 cz = _mm_load_ps(batch.CenterZ);
+    const __m128 ex = _mm_load_ps(batch.ExtentX);
+    const __m128 ey = _mm_load_ps(batch.ExtentY);
+    const __m128 ez = _mm_load_ps(batch.ExtentZ);
+
+    __m128 outside   = _mm_setzero_ps();
+    __m128 intersect = _mm_setzero_ps();
+
+    for (const auto& plane : frustum.Planes)
+    {
+        const __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+            _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+        const __m128 radius = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::fabs(plane.x))), _mm_mul_ps(ey, _mm_set1_ps(std::fabs(plane.y)))),
+            _mm_mul_ps(ez, _mm_set1_ps(std::fabs(plane.z))));
+
+        outside   = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), radius)));
+        intersect = _mm_or_ps(intersect, _mm_cmplt_ps(distance, radius));
+    }
+
+    const uint32_t lanes     = laneMask(count);
+    const uint32_t visible   = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & lanes;
+    const uint32_t straddles = static_cast<uint32_t>(_mm_movemask_ps(intersect));
+    return CullMask{visible, visible & ~straddles};
+}
+
+#else
+
+CullMask TestAabbBatch(const Frustum& frustum, const AabbBatch& batch, uint32_t count) SRK_NOEXCEPT
+{
+    return scalar::TestAabbBatch(frustum, batch, count);
+}
+
+#endif
+
+} // namespace shrek::math
@@ -0,0 +1,40 @@
+#pragma once
+#include "defs.h"
+#include "Aabb.h"
+#include "Batch.h"
+#include "Mat.h"
+#include "Simd.h"
+#include "Vec.h"
+
+#include <cstdint>
+
+namespace shrek::math {
+
+// boxes tested per call of TestAabbBatch, one per simd lane. unused lanes of the batch are ignored.
+constexpr uint32_t CullBatchWidth = BatchWidth;
+
+// planes point inwards, a point is inside when Dot(plane.xyz, p) + plane.w >= 0
+struct Frustum
+{
+    Vec4 Planes[6];
+
+    // works on a vulkan style (depth 0 to 1) view projection matrix
+    static Frustum FromViewProjection(const Mat4& viewProjection) SRK_NOEXCEPT;
+};
+
+// bit i of Visible is set when box i touches the frustum, bit i of Inside when it is completely inside
+struct CullMask
+{
+    uint32_t Visible;
+    uint32_t Inside;
+};
+
+CullMask TestAabbBatch(const Frustum& frustum, const AabbBatch& batch, uint32_t count) SRK_NOEXCEPT;
+
+namespace scalar {
+
+CullMask TestAabbBatch(const Frustum& frustum, const AabbBatch& batch, uint32_t count) SRK_NOEXCEPT;
+
+} // namespace scalar
+
+} // namespace shrek::math
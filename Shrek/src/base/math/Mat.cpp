@@ -0,0 +1,53 @@
+#include "pch.h"
+#include "Mat.h"
+
+namespace shrek::math {
+
+Mat4 Inverse(const Mat4& m) SRK_NOEXCEPT
+{
+    // 2x2 sub determinants, named after the rows/cols they use
+    const float a00 = m[0][0], a01 = m[0][1], a02 = m[0][2], a03 = m[0][3];
+    const float a10 = m[1][0], a11 = m[1][1], a12 = m[1][2], a13 = m[1][3];
+    const float a20 = m[2][0], a21 = m[2][1], a22 = m[2][2], a23 = m[2][3];
+    const float a30 = m[3][0], a31 = m[3][1], a32 = m[3][2], a33 = m[3][3];
+
+    const float b00 = a00 * a11 - a01 * a10;
+    const float b01 = a00 * a12 - a02 * a10;
+    const float b02 = a00 * a13 - a03 * a10;
+    const float b03 = a01 * a12 - a02 * a11;
+    const float b04 = a01 * a13 - a03 * a11;
+    const float b05 = a02 * a13 - a03 * a12;
+    const float b06 = a20 * a31 - a21 * a30;
+    const float b07 = a20 * a32 - a22 * a30;
+    const float b08 = a20 * a33 - a23 * a30;
+    const float b09 = a21 * a32 - a22 * a31;
+    const float b10 = a21 * a33 - a23 * a31;
+    const float b11 = a22 * a33 - a23 * a32;
+
+    const float det = b00 * b11 - b01 * b10 + b02 * b09 + b03 * b08 - b04 * b07 + b05 * b06;
+    if (det == 0.f)
+        return Mat4::Identity();
+
+    const float inv = 1.f / det;
+
+    Mat4 r;
+    r[0] = Vec4{(a11 * b11 - a12 * b10 + a13 * b09) * inv,
+                (a02 * b10 - a01 * b11 - a03 * b09) * inv,
+                (a31 * b05 - a32 * b04 + a33 * b03) * inv,
+                (a22 * b04 - a21 * b05 - a23 * b03) * inv};
+    r[1] = Vec4{(a12 * b08 - a10 * b11 - a13 * b07) * inv,
+                (a00 * b11 - a02 * b08 + a03 * b07) * inv,
+                (a32 * b02 - a30 * b05 - a33 * b01) * inv,
+                (a20 * b05 - a22 * b02 + a23 * b01) * inv};
+    r[2] = Vec4{(a10 * b10 - a11 * b08 + a13 * b06) * inv,
+                (a01 * b08 - a00 * b10 - a03 * b06) * inv,
+                (a30 * b04 - a31 * b02 + a33 * b00) * inv,
+                (a21 * b02 - a20 * b04 - a23 * b00) * inv};
+    r[3] = Vec4{(a11 * b07 - a10 * b09 - a12 * b06) * inv,
+                (a00 * b09 - a01 * b07 + a02 * b06) * inv,
+                (a31 * b01 - a30 * b03 - a32 * b00) * inv,
+                (a20 * b03 - a21 * b01 + a22 * b00) * inv};
+    return r;
+}
+
+} // namespace shrek::math
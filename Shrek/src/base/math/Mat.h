@@ -0,0 +1,126 @@
+#pragma once
+#include "defs.h"
+#include "Quat.h"
+#include "Simd.h"
+#include "Vec.h"
+
+#include <cmath>
+
+namespace shrek::math {
+
+// column major, so Columns[3] holds the translation (same memory layout glsl expects)
+struct alignas(16) Mat4
+{
+    Vec4 Columns[4]{
+        {1.f, 0.f, 0.f, 0.f},
+        {0.f, 1.f, 0.f, 0.f},
+        {0.f, 0.f, 1.f, 0.f},
+        {0.f, 0.f, 0.f, 1.f}};
+
+    Vec4&       operator[](int idx) SRK_NOEXCEPT { return Columns[idx]; }
+    const Vec4& operator[](int idx) const SRK_NOEXCEPT { return Columns[idx]; }
+
+    static constexpr Mat4 Identity() SRK_NOEXCEPT { return Mat4{}; }
+
+    static constexpr Mat4 Translation(const Vec3& t) SRK_NOEXCEPT
+    {
+        Mat4 m{};
+        m.Columns[3] = Vec4{t, 1.f};
+        return m;
+    }
+
+    static constexpr Mat4 Scale(const Vec3& s) SRK_NOEXCEPT
+    {
+        Mat4 m{};
+        m.Columns[0].x = s.x;
+        m.Columns[1].y = s.y;
+        m.Columns[2].z = s.z;
+        return m;
+    }
+
+    static constexpr Mat4 FromQuat(const Quat& q) SRK_NOEXCEPT { return FromTRS(Vec3{}, q, Vec3{1.f}); }
+
+    static constexpr Mat4 FromTRS(const Vec3& t, const Quat& r, const Vec3& s) SRK_NOEXCEPT
+    {
+        const float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+        const float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+        const float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+
+        Mat4 m{};
+        m.Columns[0] = Vec4{(1.f - 2.f * (yy + zz)) * s.x, 2.f * (xy + wz) * s.x, 2.f * (xz - wy) * s.x, 0.f};
+        m.Columns[1] = Vec4{2.f * (xy - wz) * s.y, (1.f - 2.f * (xx + zz)) * s.y, 2.f * (yz + wx) * s.y, 0.f};
+        m.Columns[2] = Vec4{2.f * (xz + wy) * s.z, 2.f * (yz - wx) * s.z, (1.f - 2.f * (xx + yy)) * s.z, 0.f};
+        m.Columns[3] = Vec4{t, 1.f};
+        return m;
+    }
+
+    // right handed, vulkan clip space (y down, depth 0 to 1)
+    static Mat4 Perspective(float fovY, float aspect, float nearZ, float farZ) SRK_NOEXCEPT
+    {
+        const float f = 1.f / std::tan(fovY * 0.5f);
+
+        Mat4 m{};
+        m.Columns[0] = Vec4{f / aspect, 0.f, 0.f, 0.f};
+        m.Columns[1] = Vec4{0.f, -f, 0.f, 0.f};
+        m.Columns[2] = Vec4{0.f, 0.f, farZ / (nearZ - farZ), -1.f};
+        m.Columns[3] = Vec4{0.f, 0.f, (nearZ * farZ) / (nearZ - farZ), 0.f};
+        return m;
+    }
+
+    static Mat4 LookAt(const Vec3& eye, const Vec3& target, const Vec3& up) SRK_NOEXCEPT
+    {
+        const Vec3 f = Normalize(target - eye);
+        const Vec3 s = Normalize(Cross(f, up));
+        const Vec3 u = Cross(s, f);
+
+        Mat4 m{};
+        m.Columns[0] = Vec4{s.x, u.x, -f.x, 0.f};
+        m.Columns[1] = Vec4{s.y, u.y, -f.y, 0.f};
+        m.Columns[2] = Vec4{s.z, u.z, -f.z, 0.f};
+        m.Columns[3] = Vec4{-Dot(s, eye), -Dot(u, eye), Dot(f, eye), 1.f};
+        return m;
+    }
+};
+
+inline Vec4 operator*(const Mat4& m, const Vec4& v) SRK_NOEXCEPT
+{
+#if SRK_SIMD_HAS_SSE
+    __m128 r = _mm_mul_ps(_mm_load_ps(&m.Columns[0].x), _mm_set1_ps(v.x));
+    r        = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&m.Columns[1].x), _mm_set1_ps(v.y)));
+    r        = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&m.Columns[2].x), _mm_set1_ps(v.z)));
+    r        = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&m.Columns[3].x), _mm_set1_ps(v.w)));
+
+    Vec4 result;
+    _mm_store_ps(&result.x, r);
+    return result;
+#else
+    return m.Columns[0] * v.x + m.Columns[1] * v.y + m.Columns[2] * v.z + m.Columns[3] * v.w;
+#endif
+}
+
+inline Mat4 operator*(const Mat4& a, const Mat4& b) SRK_NOEXCEPT
+{
+    Mat4 m;
+    for (int idx{}; idx < 4; ++idx)
+        m.Columns[idx] = a * b.Columns[idx];
+    return m;
+}
+
+inline Vec3 TransformPoint(const Mat4& m, const Vec3& p) SRK_NOEXCEPT { return (m * Vec4{p, 1.f}).Xyz(); }
+inline Vec3 TransformVector(const Mat4& m, const Vec3& v) SRK_NOEXCEPT { return (m * Vec4{v, 0.f}).Xyz(); }
+
+constexpr Mat4 Transpose(const Mat4& m) SRK_NOEXCEPT
+{
+    Mat4 t{};
+    for (int col{}; col < 4; ++col)
+    {
+        for (int row{}; row < 4; ++row)
+            t.Columns[row][col] = m.Columns[col][row];
+    }
+    return t;
+}
+
+// general inverse through cofactors, returns identity for singular matrices
+Mat4 Inverse(const Mat4& m) SRK_NOEXCEPT;
+
+} // namespace shrek::math
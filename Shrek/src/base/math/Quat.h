@@ -0,0 +1,53 @@
+#pragma once
+#include "defs.h"
+#include "Vec.h"
+
+#include <cmath>
+
+namespace shrek::math {
+
+struct alignas(16) Quat
+{
+    float x{0.f};
+    float y{0.f};
+    float z{0.f};
+    float w{1.f};
+
+    static Quat FromAxisAngle(const Vec3& axis, float radians) SRK_NOEXCEPT
+    {
+        Vec3  n = Normalize(axis);
+        float s = std::sin(radians * 0.5f);
+        return Quat{n.x * s, n.y * s, n.z * s, std::cos(radians * 0.5f)};
+    }
+};
+
+constexpr Quat operator*(const Quat& a, const Quat& b) SRK_NOEXCEPT
+{
+    return Quat{
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+
+constexpr Quat Conjugate(const Quat& q) SRK_NOEXCEPT { return Quat{-q.x, -q.y, -q.z, q.w}; }
+
+inline Quat Normalize(const Quat& q) SRK_NOEXCEPT
+{
+    float length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    if (length <= 0.f)
+        return Quat{};
+
+    float inv = 1.f / length;
+    return Quat{q.x * inv, q.y * inv, q.z * inv, q.w * inv};
+}
+
+// v' = v + 2w(q x v) + 2(q x (q x v))
+constexpr Vec3 Rotate(const Quat& q, const Vec3& v) SRK_NOEXCEPT
+{
+    Vec3 u{q.x, q.y, q.z};
+    Vec3 t = Cross(u, v) * 2.f;
+    return v + t * q.w + Cross(u, t);
+}
+
+} // namespace shrek::math
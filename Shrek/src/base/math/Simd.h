@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+ *  Compile time dispatch for the math kernels, selected with `premake5 --simd=<scalar|sse|avx2>`.
+ *  AVX2 builds get the SSE paths as well. The scalar kernels are always compiled so they can be
+ *  compared against (see ShrekBench).
+ */
+
+#if defined(SRK_SIMD_AVX2)
+#    define SRK_SIMD_HAS_SSE  1
+#    define SRK_SIMD_HAS_AVX2 1
+#    define SRK_SIMD_WIDTH    8
+#    define SRK_SIMD_NAME     "avx2"
+#elif defined(SRK_SIMD_SSE)
+#    define SRK_SIMD_HAS_SSE  1
+#    define SRK_SIMD_HAS_AVX2 0
+#    define SRK_SIMD_WIDTH    4
+#    define SRK_SIMD_NAME     "sse"
+#else
+#    define SRK_SIMD_HAS_SSE  0
+#    define SRK_SIMD_HAS_AVX2 0
+#    define SRK_SIMD_WIDTH    1
+#    define SRK_SIMD_NAME     "scalar"
+#endif
+
+#if SRK_SIMD_HAS_AVX2
+#    include <immintrin.h>
+#elif SRK_SIMD_HAS_SSE
+#    include <emmintrin.h>
+#    include <xmmintrin.h>
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+#include "defs.h"
+
+#include <cmath>
+
+namespace shrek::math {
+
+struct Vec2
+{
+    float x{0.f};
+    float y{0.f};
+};
+
+struct Vec3
+{
+    float x{0.f};
+    float y{0.f};
+    float z{0.f};
+
+    constexpr Vec3() SRK_NOEXCEPT = default;
+    constexpr Vec3(float x_, float y_, float z_) SRK_NOEXCEPT : x(x_), y(y_), z(z_) {}
+    constexpr explicit Vec3(float s) SRK_NOEXCEPT : x(s), y(s), z(s) {}
+
+    float&       operator[](int idx) SRK_NOEXCEPT { return (&x)[idx]; }
+    const float& operator[](int idx) const SRK_NOEXCEPT { return (&x)[idx]; }
+};
+
+// aligned so that it can be loaded straight into a sse register
+struct alignas(16) Vec4
+{
+    float x{0.f};
+    float y{0.f};
+    float z{0.f};
+    float w{0.f};
+
+    constexpr Vec4() SRK_NOEXCEPT = default;
+    constexpr Vec4(float x_, float y_, float z_, float w_) SRK_NOEXCEPT : x(x_), y(y_), z(z_), w(w_) {}
+    constexpr Vec4(const Vec3& v, float w_) SRK_NOEXCEPT : x(v.x), y(v.y), z(v.z), w(w_) {}
+
+    float&       operator[](int idx) SRK_NOEXCEPT { return (&x)[idx]; }
+    const float& operator[](int idx) const SRK_NOEXCEPT { return (&x)[idx]; }
+
+    constexpr Vec3 Xyz() const SRK_NOEXCEPT { return Vec3{x, y, z}; }
+};
+
+constexpr Vec3 operator+(const Vec3& a, const Vec3& b) SRK_NOEXCEPT { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+constexpr Vec3 operator-(const Vec3& a, const Vec3& b) SRK_NOEXCEPT { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+constexpr Vec3 operator*(const Vec3& a, const Vec3& b) SRK_NOEXCEPT { return {a.x * b.x, a.y * b.y, a.z * b.z}; }
+constexpr Vec3 operator*(const Vec3& a, float s) SRK_NOEXCEPT { return {a.x * s, a.y * s, a.z * s}; }
+constexpr Vec3 operator*(float s, const Vec3& a) SRK_NOEXCEPT { return a * s; }
+constexpr Vec3 operator-(const Vec3& a) SRK_NOEXCEPT { return {-a.x, -a.y, -a.z}; }
+
+constexpr Vec4 operator+(const Vec4& a, const Vec4& b) SRK_NOEXCEPT { return {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w}; }
+constexpr Vec4 operator-(const Vec4& a, const Vec4& b) SRK_NOEXCEPT { return {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w}; }
+constexpr Vec4 operator*(const Vec4& a, float s) SRK_NOEXCEPT { return {a.x * s, a.y * s, a.z * s, a.w * s}; }
+
+constexpr float Dot(const Vec3& a, const Vec3& b) SRK_NOEXCEPT { return a.x * b.x + a.y * b.y + a.z * b.z; }
+constexpr float Dot(const Vec4& a, const Vec4& b) SRK_NOEXCEPT { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+constexpr Vec3 Cross(const Vec3& a, const Vec3& b) SRK_NOEXCEPT
+{
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+inline float Length(const Vec3& v) SRK_NOEXCEPT { return std::sqrt(Dot(v, v)); }
+
+inline Vec3 Normalize(const Vec3& v) SRK_NOEXCEPT
+{
+    float length = Length(v);
+    return length > 0.f ? v * (1.f / length) : v;
+}
+
+inline Vec3 Min(const Vec3& a, const Vec3& b) SRK_NOEXCEPT { return {std::fmin(a.x, b.x), std::fmin(a.y, b.y), std::fmin(a.z, b.z)}; }
+inline Vec3 Max(const Vec3& a, const Vec3& b) SRK_NOEXCEPT { return {std::fmax(a.x, b.x), std::fmax(a.y, b.y), std::fmax(a.z, b.z)}; }
+inline Vec3 Abs(const Vec3& v) SRK_NOEXCEPT { return {std::fabs(v.x), std::fabs(v.y), std::fabs(v.z)}; }
+
+} // namespace shrek::math
@@ -1,15 +1,29 @@
 #include "pch.h"
 
+#include "base/Config.h"
 #include "platform/Log.h"
 #include "platform/Application.h"
 
+namespace {
+
+shrek::base::ConfigVar<std::string> logLevel{"log.level", "trace", "trace, debug, info, warn, error, critical or off"};
+
+} // namespace
+
 int main(int argc, char** argv)
 {
     shrek::Log::Init();
+    int exitCode{0};
+
+    // file, environment then command line. read before the engine is created since it decides validation and the rest
+    shrek::base::Config::Get().Load(static_cast<size_t>(argc), argv);
+    if (!shrek::Log::SetLevel(logLevel.Get()))
+        SRK_CORE_WARN("Unknown log level {}, keeping trace", logLevel.Get());
+    shrek::base::Config::Get().Print();
 
     // scope the creation of everything else
     {
-        shrek::Application app(shrek::ApplicationCmdLineArgs(argc, argv));
+        shrek::Application app;
 
         SRK_CORE_TRACE("Loading engine now");
         app.Load();
@@ -21,8 +35,9 @@ int main(int argc, char** argv)
 
         SRK_CORE_INFO("Exitting from {} engine now...", "Shrek");
         app.Cleanup();
+        exitCode = app.GetExitCode();
     }
 
     shrek::Log::Exit();
-    return 0;
+    return exitCode;
 }
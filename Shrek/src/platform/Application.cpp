@@ -2,6 +2,15 @@
 
 #include "Log.h"
 #include "Application.h"
+#include "asset/GltfLoader.h"
+#include "asset/ImageFile.h"
+#include "render/Surface.h"
+#include "base/Config.h"
+#include "base/Metrics.h"
+#include "scene/TransformSystem.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace shrek {
 
@@ -9,6 +18,137 @@ namespace {
 
 using Singleton = base::Singleton<Application>;
 
+base::ConfigVar<int32_t>     workerCount{"jobs.workers", 0, "job system threads, 0 is one per hardware thread minus the main thread"};
+base::ConfigVar<std::string> shaderDirectory{"shader.directory", "assets/shader", "where shaders are loaded and hot reloaded from"};
+base::ConfigVar<std::string> pipelineCachePath{"pipeline.cache_path", "cache/pipelines.bin", "driver pipeline cache kept between runs, empty keeps nothing"};
+base::ConfigVar<std::string> captureDirectory{"capture.directory", "", "captured frames are written here, empty captures nothing"};
+base::ConfigVar<std::string> captureFormat{"capture.format", "png", "png or y4m"};
+base::ConfigVar<bool>        runRegression{"regression.run", false, "render the regression scenes headless and exit with their result"};
+base::ConfigVar<bool>        updateGoldens{"regression.update_goldens", false, "write the regression goldens instead of comparing against them"};
+base::ConfigVar<bool>        requireGoldens{"regression.require_goldens", true, "fail regression scenes that have no golden, false skips them instead"};
+base::ConfigVar<float>       lodErrorPixels{"render.lod_error_pixels", 1.f, "screen space error in pixels of a 1080 line output a mesh lod may have"};
+base::ConfigVar<std::string> sceneMeshes{"scene.meshes", "assets/mesh/TestScene.glb", "comma separated glb files the scene's meshes are loaded from"};
+base::ConfigVar<std::string> sceneTextures{"scene.textures", "assets/texture/Checker.png", "comma separated pngs streamed as the albedo of a material each, in order"};
+
+// published through MetricsExporter, the main thread and the render thread each set their own
+base::Counter   framesBuilt{"frame.count", "frames the main thread built and handed to the render thread"};
+base::Histogram frameTime{"frame.ms", "main thread time between two frames", {4.0, 8.0, 11.1, 16.7, 20.0, 25.0, 33.3, 50.0, 100.0, 250.0}};
+base::Gauge     startupTime{"startup.ms", "the startup graph, from its first phase starting to its last one finishing"};
+base::Gauge     drawBatches{"scene.draw_batches", "draw calls of the culled scene before occlusion culling"};
+base::Gauge     drawInstances{"scene.instances", "instances of the culled scene before occlusion culling"};
+base::Gauge     produceWait{"render_thread.produce_wait_ms", "the main thread waited for the render thread, the renderer is the bottleneck"};
+base::Gauge     consumeWait{"render_thread.consume_wait_ms", "the render thread waited for the main thread"};
+base::Gauge     gpuFrameTime{"gpu.frame_ms", "gpu time of the last frame read back"};
+base::Gauge     renderScale{"gpu.render_scale", "of the output's width and height the scene renders at"};
+base::Gauge     postChainTime{"gpu.post_ms", "bloom and tonemapping"};
+base::Gauge     postOverlap{"gpu.post_overlap_ms", "of the post chain that ran alongside the next frame's graphics work"};
+base::Gauge     memoryUsage{"memory.device_usage_bytes", "device local memory the process uses, 0 without VK_EXT_memory_budget"};
+base::Gauge     memoryBudget{"memory.device_budget_bytes", "device local memory the process can use before the driver pages"};
+base::Gauge     reducedResources{"memory.reduced_resources", "resources currently evicted below their finest level"};
+base::Gauge     streamedResident{"streaming.resident_bytes", "memory of every streamed texture"};
+base::Gauge     streamedUploaded{"streaming.uploaded_bytes", "streamed since startup"};
+base::Gauge     occlusionObjects{"occlusion.objects", "went into the occlusion cull"};
+base::Gauge     occlusionCulled{"occlusion.occluded", "hidden by the hi-z pyramid"};
+base::Gauge     lightCount{"lights.count", "point lights binned into clusters"};
+base::Gauge     lightOverflow{"lights.overflowed", "light and cluster pairs that didn't fit render.lights.per_cluster"};
+base::Gauge     commandsQueued{"commands.queued", "render commands waiting when the last frame drained the queue"};
+base::Gauge     commandsDeferred{"commands.deferred", "uploads waiting for staging of a later frame"};
+base::Gauge     commandsRejected{"commands.rejected", "render commands dropped because the queue was full, since startup"};
+
+// compiled while the device is being created, Load and RunRegression only make their modules
+constexpr std::array<const char*, 10> startupShaders{"Test.vert",          "Test.frag",      "BloomDownsample.comp", "BloomUpsample.comp",
+                                                     "Tonemap.comp",       "HiZBuild.comp",  "OcclusionCull.comp",   "LightCull.comp",
+                                                     "Forward.vert",       "ClusteredForward.frag"};
+
+std::optional<render::RegressionSettings> regressionSettings() SRK_NOEXCEPT
+{
+    // --regression.run [--regression.update_goldens] renders the regression scenes headless and exits with their result
+    if (!runRegression && !updateGoldens)
+        return std::nullopt;
+
+    render::RegressionSettings settings;
+    settings.UpdateGoldens  = updateGoldens;
+    settings.RequireGoldens = requireGoldens;
+    return settings;
+}
+
+constexpr static VkDeviceSize uniformBytesPerFrame{8 * 1024 * 1024}; // the scene's transforms alone take up to 4mb
+constexpr static uint32_t     streamedTextureSlots{4096};
+constexpr static uint32_t     occludedObjects{64 * 1024}; // the scene's draws have room for as many
+constexpr static uint32_t     sceneVertices{1024 * 1024};
+constexpr static uint32_t     sceneIndices{4 * 1024 * 1024};
+constexpr static uint32_t     clusteredLights{16 * 1024};
+constexpr static uint32_t     renderCommandCapacity{16 * 1024};
+constexpr static VkDeviceSize commandStagingBytes{8 * 1024 * 1024};
+constexpr static VkDeviceSize assetStagingBytes{64 * 1024 * 1024};
+constexpr static float        cameraFovY{1.0472f}; // 60 degrees
+constexpr static float        lodReferenceHeight{1080.f};
+constexpr static uint32_t     testSceneSpheres{12}; // along each side of the grid
+constexpr static float        testSceneSpacing{1.5f};
+constexpr static uint32_t     testSceneLights{32}; // along each side of their grid
+
+constexpr static std::string_view engineWindowName{"Shrek Engine"};
+
+VkImageMemoryBarrier imageBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess) SRK_NOEXCEPT
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask               = srcAccess;
+    barrier.dstAccessMask               = dstAccess;
+    barrier.oldLayout                   = oldLayout;
+    barrier.newLayout                   = newLayout;
+    barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                       = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+// what goes on the screen, the post chain's output of the last frame. it is already tonemapped and sRGB encoded
+// for the UNORM swapchain, the scene itself is linear HDR and never goes there as is
+struct ComposeSource
+{
+    VkImage       Image{VK_NULL_HANDLE};
+    VkImageLayout Layout{VK_IMAGE_LAYOUT_GENERAL}; // left in it again after
+    VkExtent2D    Extent{0, 0};                    // the rendered top left corner of the image, stretched over the output
+};
+
+// upscales the source over the swapchain image and leaves the image ready to present, black without a source.
+// the acquire semaphore and the post chain's are waited on at the transfer stage
+void composeFrame(VkCommandBuffer cmd, const render::DynamicResolution& resolution, const ComposeSource& source, VkImage output,
+                  VkExtent2D extent) SRK_NOEXCEPT
+{
+    const bool hasSource = source.Image != VK_NULL_HANDLE;
+
+    std::array<VkImageMemoryBarrier, 2> barriers{};
+    uint32_t                            barrierCount = 0;
+    barriers[barrierCount++] = imageBarrier(output, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    if (hasSource)
+        barriers[barrierCount++] = imageBarrier(source.Image, source.Layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT,
+                                                VK_ACCESS_TRANSFER_READ_BIT);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, barrierCount, barriers.data());
+
+    if (hasSource)
+    {
+        resolution.Upscale(cmd, source.Image, source.Extent, extent, output);
+    }
+    else
+    {
+        VkClearColorValue       black{{0.f, 0.f, 0.f, 1.f}};
+        VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        vkCmdClearColorImage(cmd, output, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &black, 1, &range);
+    }
+
+    // the post chain writes its output again after, it waits on the whole submit
+    barriers[0]  = imageBarrier(output, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+    barriers[1]  = imageBarrier(source.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, source.Layout, VK_ACCESS_TRANSFER_READ_BIT, 0);
+    barrierCount = hasSource ? 2 : 1;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, barrierCount, barriers.data());
+}
+
 constexpr static size_t      loadingScreenWidth{640};
 constexpr static size_t      loadingScreenHeight{480};
 constexpr static WindowParam loadingScreenParams{
@@ -26,46 +166,134 @@ constexpr static WindowParam loadingScreenParams{
     }()};
 } // namespace
 
-
-ApplicationCmdLineArgs::ApplicationCmdLineArgs(int argc, char** argv) SRK_NOEXCEPT :
-    m_Size(static_cast<size_t>(argc)),
-    m_Arguments(argv)
-{
-}
-
-const char* ApplicationCmdLineArgs::operator[](size_t idx) const SRK_NOEXCEPT
-{
-    if (idx >= m_Size)
-        return nullptr;
-
-    return m_Arguments[idx];
-}
-
-size_t ApplicationCmdLineArgs::Size() const SRK_NOEXCEPT
-{
-    return m_Size;
-}
-
 Application::Application() SRK_NOEXCEPT :
     Singleton("Application"),
     m_WindowManager(),
     m_Running(true),
-    m_RenderEngine()
+    m_ExitCode(0),
+    m_Regression(regressionSettings()),
+    m_JobSystem(static_cast<uint32_t>(std::max<int32_t>(workerCount, 0))),
+    m_RenderEngine(),
+    m_LoadingWindow(nullptr),
+    m_StartupShaders(),
+    m_SavedPipelines(),
+    m_StartupTimings(RunStartup()),
+    m_Shaders(m_RenderEngine.GetLogicalGpu(), m_JobSystem, shaderDirectory),
+    m_Layouts(m_RenderEngine.GetLogicalGpu()),
+    m_Pipelines(m_RenderEngine.GetLogicalGpu(), m_JobSystem, m_Layouts, pipelineCachePath, m_SavedPipelines),
+    m_PipelineReloadHandler(0),
+    m_Uniforms(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), uniformBytesPerFrame),
+    m_MemoryBudget(m_RenderEngine.GetGpu(), m_RenderEngine.HasMemoryBudget()),
+    m_Residency(m_MemoryBudget.GetHeapCount()),
+    m_Streamer(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), m_JobSystem, m_Residency, streamedTextureSlots),
+    m_Images(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), m_RenderEngine.GetQueueFamilyIndices(), m_MemoryBudget, m_Residency),
+    m_Post(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), m_RenderEngine.GetQueueFamilyIndices(), m_RenderEngine.GetQueue(),
+           m_RenderEngine.GetComputeQueue(), m_Shaders, m_Pipelines, m_Images),
+    m_Resolution(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), m_RenderEngine.GetQueueFamilyIndices().Graphics),
+    m_Occlusion(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), m_Shaders, m_Pipelines, occludedObjects),
+    m_Lighting(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), m_Shaders, m_Pipelines, clusteredLights),
+    m_Commands(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), renderCommandCapacity, commandStagingBytes),
+    m_AssetStaging(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), assetStagingBytes),
+    m_SceneRenderer(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), m_Shaders, m_Pipelines, m_Uniforms, m_Occlusion, m_Lighting, m_Images,
+                    m_Commands, m_MemoryBudget, m_Residency, m_Streamer, sceneVertices, sceneIndices, occludedObjects),
+    m_SceneMeshes(),
+    m_Scene(),
+    m_SceneBvh(),
+    m_Views(1),
+    m_Camera(),
+    m_LastTick(std::chrono::steady_clock::now()),
+    m_Capture(),
+    m_Metrics(),
+    m_Frames(m_RenderEngine.GetLogicalGpu(), m_RenderEngine.GetQueue(), m_RenderEngine.GetQueueFamilyIndices().Graphics),
+    m_RenderThread([this](const render::FramePacket& packet) { RenderFrame(packet); })
 {
+    // a fixed camera over the origin until something in the scene drives one
+    m_Camera.Eye        = math::Vec3{0.f, 2.f, 5.f};
+    m_Camera.View       = math::Mat4::LookAt(m_Camera.Eye, math::Vec3{0.f}, math::Vec3{0.f, 1.f, 0.f});
+    m_Camera.Projection = math::Mat4::Perspective(cameraFovY, 16.f / 9.f, m_Camera.Near, m_Camera.Far);
+
+    // pipelines using a reloaded shader are compiled again before the reload is committed, the ones it replaced are
+    // retired when it is
+    m_PipelineReloadHandler = m_Shaders.AddReloadHandler({[this](const render::pipeline::ShaderRef& shader) { m_Pipelines.Rebuild(shader); },
+                                                          [this](const render::pipeline::ShaderRef& shader) { m_Pipelines.Commit(shader); }});
+
+    // the ones that failed are compiled again by whoever loads them, which logs why
+    for (StartupShader& shader : m_StartupShaders)
+    {
+        if (!shader.Spirv.empty())
+            m_Shaders.Load(shader.Name, std::move(shader.Spirv));
+    }
+    m_StartupShaders.clear();
+    m_SavedPipelines.Close();
+
+    // packets may still point at the surface of a window that was just closed
+    m_WindowManager.SetCloseCallback([this](std::string_view, WindowsWindow&) {
+        m_RenderThread.Flush();
+        vkDeviceWaitIdle(m_RenderEngine.GetLogicalGpu());
+    });
+
+    // --capture.directory <directory> [--capture.format png|y4m] writes captured frames to disk
+    if (!captureDirectory.Get().empty())
+    {
+        render::CaptureSettings settings;
+        settings.Directory = captureDirectory;
+        settings.Format    = captureFormat.Get() == "y4m" ? render::CaptureFormat::Y4m : render::CaptureFormat::Png;
+        m_Capture          = std::make_unique<render::FrameCapture>(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), std::move(settings));
+    }
 }
 
 // for linux based applications(?)
-Application::Application([[maybe_unused]] ApplicationCmdLineArgs params) SRK_NOEXCEPT :
-    Application()
+// the arguments were already read into base::Config by main, before anything here was created
+std::vector<base::PhaseTiming> Application::RunStartup() SRK_NOEXCEPT
 {
+    base::StartupGraph startup;
+
+    const auto instance = startup.Add("render.instance", [this]() { m_RenderEngine.CreateInstance(); });
+    startup.Add("render.device", [this]() { m_RenderEngine.CreateDevice(); }, {instance});
+
+    // glfw windows have to be made on the main thread, which is free while the workers bring up vulkan
+    if (!m_Regression)
+        startup.Add("window.loading", [this]() { m_LoadingWindow = WindowsWindow::CreateHandle(loadingScreenParams); }, {}, base::PhaseThread::Main);
+
+    // the driver's pipeline cache from the last run, off the main thread since it can be tens of megabytes
+    startup.Add("pipeline.cache", [this]() { m_SavedPipelines = render::pipeline::PipelineCache::ReadCacheFile(pipelineCachePath); });
+
+    m_StartupShaders.resize(startupShaders.size());
+    for (size_t idx{}; idx < startupShaders.size(); ++idx)
+    {
+        m_StartupShaders[idx].Name = startupShaders[idx];
+        startup.Add("shader." + m_StartupShaders[idx].Name, [this, idx]() {
+            StartupShader& shader = m_StartupShaders[idx];
+            if (!render::pipeline::ShaderLibrary::CompileFile(shaderDirectory, shader.Name, shader.Spirv))
+                shader.Spirv.clear();
+        });
+    }
+
+    startup.Run(m_JobSystem);
+    startup.Report();
+
+    double startupMs = 0.0;
+    for (const base::PhaseTiming& timing : startup.GetTimings())
+        startupMs = std::max(startupMs, timing.EndMs);
+    startupTime.Set(startupMs);
+
+    return startup.GetTimings();
 }
 
 // should load here
 // display loading screen here
 void Application::Load() SRK_NOEXCEPT
 {
+    if (m_Regression)
+    {
+        RunRegression();
+        return;
+    }
+
     std::string_view loadingScreenName{"Shrek Loading Screen"};
-    m_WindowManager.AddWindow(loadingScreenName, new WindowsWindow(m_RenderEngine, loadingScreenParams));
+    WindowsWindow* loadingScreen = m_LoadingWindow ? new WindowsWindow(m_RenderEngine, m_LoadingWindow) : new WindowsWindow(m_RenderEngine, loadingScreenParams);
+    m_LoadingWindow              = nullptr;
+    m_WindowManager.AddWindow(loadingScreenName, loadingScreen);
     bool loading = true;
 
     while (loading)
@@ -88,13 +316,214 @@ void Application::Load() SRK_NOEXCEPT
         params.Height     = loadingScreenHeight;
         params.Maximize   = false;
         params.Resizable  = false;
-        params.WindowName = "Shrek Engine";
+        params.WindowName = engineWindowName;
         params.TitleBar   = true;
     }
-    m_WindowManager.AddWindow("Shrek Engine", new WindowsWindow(m_RenderEngine, params));
+    m_WindowManager.AddWindow(engineWindowName, new WindowsWindow(m_RenderEngine, params));
+
+    for (const char* shader : startupShaders)
+        m_Shaders.Load(shader);
+
+    LoadScene();
+    BuildTestScene();
 }
 
-Application::~Application() SRK_NOEXCEPT = default;
+void Application::BuildTestScene() SRK_NOEXCEPT
+{
+    auto find = [this](std::string_view name) -> const SceneMesh* {
+        auto found = std::find_if(m_SceneMeshes.begin(), m_SceneMeshes.end(), [name](const SceneMesh& mesh) { return mesh.Name == name; });
+        return found != m_SceneMeshes.end() ? &*found : nullptr;
+    };
+
+    const SceneMesh* sphere = find("Sphere");
+    const SceneMesh* box    = find("Box");
+    if (!sphere || !box)
+    {
+        SRK_CORE_ERROR("The test scene is made of the Sphere and Box of scene.meshes, without them the scene stays empty");
+        return;
+    }
+
+    // the bounds are derived from the transforms before the first cull
+    auto add = [this](const SceneMesh& mesh, const math::Vec3& position, const math::Vec3& scale) {
+        scene::Transform transform;
+        transform.Position = position;
+        transform.Scale    = scale;
+
+        scene::Renderable renderable;
+        renderable.Mesh = mesh.Mesh;
+        m_Scene.Create(transform, scene::WorldTransform{}, scene::LocalBounds{mesh.Bounds}, scene::Bounds{}, renderable, mesh.Lods, scene::CullProxy{});
+    };
+
+    // a grid of spheres on a ground plane, running from in front of the camera off into the distance
+    const float extent = testSceneSpacing * static_cast<float>(testSceneSpheres);
+    const float left   = -0.5f * extent + 0.5f * testSceneSpacing;
+    const float front  = 1.f;
+    add(*box, math::Vec3{0.f, -0.05f, front - 0.5f * extent}, math::Vec3{extent + 2.f, 0.1f, extent + 2.f});
+    for (uint32_t row{}; row < testSceneSpheres; ++row)
+    {
+        for (uint32_t column{}; column < testSceneSpheres; ++column)
+            add(*sphere, math::Vec3{left + testSceneSpacing * column, 0.5f, front - testSceneSpacing * row}, math::Vec3{1.f});
+    }
+
+    // walls between rows across the grid, alternating sides, so the rows behind each are mostly hidden and the
+    // hi-z cull has something to reject
+    for (uint32_t wall{1}; wall < 4; ++wall)
+    {
+        const float side = wall % 2 ? -0.2f : 0.2f;
+        add(*box, math::Vec3{side * extent, 1.25f, front - 0.25f * extent * wall - 0.5f * testSceneSpacing}, math::Vec3{0.7f * extent, 2.5f, 0.25f});
+    }
+
+    // a grid of small colored lights among the spheres, far more of them than any cluster sees at once
+    const float lightSpacing = extent / static_cast<float>(testSceneLights);
+    for (uint32_t row{}; row < testSceneLights; ++row)
+    {
+        for (uint32_t column{}; column < testSceneLights; ++column)
+        {
+            scene::Transform transform;
+            transform.Position = math::Vec3{-0.5f * extent + lightSpacing * (column + 0.5f), 0.3f, front - lightSpacing * (row + 0.5f)};
+
+            // the hue goes around the color wheel along the rows, every channel a phase of it
+            const float hue = 6.2832f * static_cast<float>(row * testSceneLights + column) / static_cast<float>(testSceneLights * testSceneLights);
+
+            scene::PointLight light;
+            light.Color     = math::Vec3{0.5f + 0.5f * std::cos(hue), 0.5f + 0.5f * std::cos(hue - 2.0944f), 0.5f + 0.5f * std::cos(hue + 2.0944f)};
+            light.Radius    = 1.25f;
+            light.Intensity = 2.f;
+            m_Scene.Create(transform, scene::WorldTransform{}, light);
+        }
+    }
+
+    SRK_CORE_INFO("Built a test scene of {} entities", m_Scene.GetEntityCount());
+}
+
+void Application::LoadScene() SRK_NOEXCEPT
+{
+    auto split = [](const std::string& list) {
+        std::vector<std::string> items;
+        for (size_t begin{}; begin <= list.size();)
+        {
+            const size_t end = std::min(list.find(',', begin), list.size());
+            if (end > begin)
+                items.push_back(list.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        return items;
+    };
+
+    const std::vector<std::string> paths = split(sceneMeshes);
+
+    // a job per file, all of them writing into the asset staging at once. the copies out of it only run once
+    // the render thread drains them, nothing resets it after. the meshlets are left in the staging, nothing
+    // draws with mesh shaders
+    const asset::MeshOptimizeSettings optimize{};
+    std::vector<asset::GlbLoad>       loads;
+    asset::LoadGlbs(paths, m_AssetStaging, m_JobSystem, loads, &optimize);
+
+    // files that failed were logged by the loader and have no meshes
+    for (const asset::GlbLoad& load : loads)
+    {
+        for (const render::Mesh& mesh : load.Meshes)
+        {
+            for (const render::MeshPrimitive& primitive : mesh.Primitives)
+            {
+                SceneMesh sceneMesh;
+                sceneMesh.Name   = mesh.Name;
+                sceneMesh.Mesh   = m_SceneRenderer.AddMesh(primitive, m_AssetStaging);
+                sceneMesh.Bounds = primitive.Bounds;
+                if (sceneMesh.Mesh == render::NoSceneMesh)
+                    continue;
+
+                sceneMesh.Lods.Count = static_cast<uint32_t>(std::clamp<size_t>(primitive.Lods.size(), 1, scene::MaxMeshLods));
+                for (uint32_t lod{}; lod < sceneMesh.Lods.Count && lod < primitive.Lods.size(); ++lod)
+                    sceneMesh.Lods.Errors[lod] = primitive.Lods[lod].Error;
+                m_SceneMeshes.push_back(std::move(sceneMesh));
+            }
+        }
+    }
+
+    SRK_CORE_INFO("Loaded {} scene meshes from {} files, {} bytes of staging", m_SceneMeshes.size(), paths.size(), m_AssetStaging.GetUsed());
+
+    // the whole png stays in memory and every mip the streamer asks for is filtered out of it on the job that
+    // loads it. a texture that can't be read is logged and skipped, the ones after it take its material
+    for (const std::string& path : split(sceneTextures))
+    {
+        auto image = std::make_shared<asset::Image>();
+        if (!asset::ReadPng(path, *image))
+            continue;
+
+        render::StreamedTextureDesc albedo;
+        albedo.Width         = image->Width;
+        albedo.Height        = image->Height;
+        albedo.MipCount      = asset::MipCount(image->Width, image->Height);
+        albedo.Format        = VK_FORMAT_R8G8B8A8_SRGB;
+        albedo.BytesPerPixel = 4;
+        albedo.LoadMip       = [image](uint32_t mip, std::byte* dst, size_t size) {
+            return asset::DownsampleMip(*image, mip, reinterpret_cast<uint8_t*>(dst), size);
+        };
+        m_SceneRenderer.AddMaterial(std::move(albedo));
+    }
+}
+
+Application::~Application() SRK_NOEXCEPT
+{
+    // nothing may be rendering while the members go, starting with the reload handler below
+    m_RenderThread.Stop();
+
+    // the pipeline cache goes before the shader library
+    m_Shaders.RemoveReloadHandler(m_PipelineReloadHandler);
+}
+
+void Application::RunRegression() SRK_NOEXCEPT
+{
+    render::pipeline::ShaderRef vertex   = m_Shaders.Load("Test.vert");
+    render::pipeline::ShaderRef fragment = m_Shaders.Load("Test.frag");
+
+    // the test triangle with no vertex buffers, instanced on top of itself for the overdraw scene
+    auto triangle = [this, vertex, fragment](bool blend, uint32_t instances) {
+        return [this, vertex, fragment, blend, instances](VkCommandBuffer cmd, const render::RegressionTarget& target) {
+            if (!vertex || !fragment)
+                return;
+
+            render::pipeline::PipelineDesc desc;
+            desc.Shaders[0]              = vertex;
+            desc.Shaders[1]              = fragment;
+            desc.ShaderCount             = 2;
+            desc.Targets.ColorFormats[0] = target.Format;
+            desc.Targets.ColorCount      = 1;
+            desc.State.CullMode          = VK_CULL_MODE_NONE;
+            desc.State.BlendEnable       = blend ? VK_TRUE : VK_FALSE;
+            desc.RenderPass              = target.RenderPass;
+
+            // the first warmup frame compiles it, every other frame hits
+            const render::pipeline::Pipeline* pipeline = m_Pipelines.GetBlocking(desc);
+            if (!pipeline)
+                return;
+
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->Handle);
+            vkCmdDraw(cmd, 3, instances, 0, 0);
+        };
+    };
+
+    std::vector<render::RegressionScene> scenes(3);
+    scenes[0].Name       = "clear";
+    scenes[0].ClearColor = {{0.2f, 0.4f, 0.8f, 1.f}};
+
+    scenes[1].Name   = "triangle";
+    scenes[1].Record = triangle(false, 1);
+
+    scenes[2].Name   = "overdraw";
+    scenes[2].Extent = {1024, 1024};
+    scenes[2].Record = triangle(true, 256);
+
+    render::RegressionRunner runner(m_RenderEngine.GetGpu(), m_RenderEngine.GetLogicalGpu(), m_RenderEngine.GetQueue(),
+                                    m_RenderEngine.GetQueueFamilyIndices().Graphics, *m_Regression);
+
+    const bool passed = runner.IsValid() && runner.Run(scenes);
+    SRK_CORE_INFO("Regression run {}", passed ? "passed" : "failed");
+
+    m_ExitCode = passed ? 0 : 1;
+    m_Running  = false;
+}
 
 bool Application::ShouldClose() SRK_NOEXCEPT
 {
@@ -108,8 +537,203 @@ void Application::Cleanup() SRK_NOEXCEPT
 
 void Application::Tick() SRK_NOEXCEPT
 {
+    // glfw only works from the main thread, the render thread never touches the windows
     m_WindowManager.Update();
     m_Running = !m_WindowManager.Empty();
+
+    // waits while the render thread still has the packet published two frames ago
+    render::FramePacket& packet = m_RenderThread.BeginPacket();
+    BuildPacket(packet);
+    m_RenderThread.Publish();
+
+    const render::RenderThreadStats stats = m_RenderThread.GetStats();
+    produceWait.Set(stats.ProduceWaitMs);
+    consumeWait.Set(stats.ConsumeWaitMs);
+    m_Metrics.Publish();
+}
+
+void Application::BuildPacket(render::FramePacket& packet) SRK_NOEXCEPT
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    packet.DeltaSeconds = std::chrono::duration<double>(now - m_LastTick).count();
+    packet.Camera       = m_Camera;
+    m_LastTick          = now;
+
+    // the scene is only touched here, the render thread gets what it needs of it through the packet.
+    // the boxes the tree and the cull go by are derived from the transforms first
+    scene::UpdateTransforms(m_Scene, m_JobSystem);
+    scene::SyncBvh(m_Scene, m_SceneBvh);
+
+    scene::View& view = m_Views.front();
+    view.Frustum      = math::Frustum::FromViewProjection(m_Camera.Projection * m_Camera.View);
+    view.Eye          = m_Camera.Eye;
+    view.Near         = m_Camera.Near;
+    view.Far          = m_Camera.Far;
+    view.Queue        = &packet.Queue;
+    view.LodScale     = lodErrorPixels > 0.f ? lodReferenceHeight / (2.f * std::tan(cameraFovY * 0.5f) * lodErrorPixels) : 0.f;
+    scene::CullViews(m_Scene, m_SceneBvh, m_Views, m_JobSystem);
+
+    packet.Queue.Build();
+    scene::GatherInstances(m_Scene, view, packet.Bounds, packet.Transforms);
+
+    // gone once its window is closed, the close callback made sure no packet still uses it
+    WindowsWindow* window = m_WindowManager.GetWindow(engineWindowName);
+    packet.Output         = window ? &window->GetSurface() : nullptr;
+
+    framesBuilt.Add();
+    frameTime.Observe(packet.DeltaSeconds * 1000.0);
+    drawBatches.Set(static_cast<double>(packet.Queue.GetBatches().size()));
+    drawInstances.Set(static_cast<double>(packet.Queue.GetInstances().size()));
+
+    // every light goes to the render thread, the binning leaves out the ones no cluster sees
+    packet.Lights.clear();
+    m_Scene.Query<scene::WorldTransform, scene::PointLight>().Each([&packet](scene::Entity, scene::WorldTransform& transform, scene::PointLight& light) {
+        packet.Lights.push_back(render::PointLight{transform.Matrix[3].Xyz(), light.Radius, light.Color, light.Intensity});
+    });
+}
+
+void Application::RenderFrame(const render::FramePacket& packet) SRK_NOEXCEPT
+{
+    // frame boundary, shaders that finished recompiling get swapped in before anything is recorded
+    m_Shaders.ApplyReloads();
+    m_Shaders.Update();
+
+    // the window was resized or the swapchain went out of date, nothing may still use the old one
+    render::Surface* surface = packet.Output;
+    if (surface && surface->NeedsRecreate())
+    {
+        vkDeviceWaitIdle(m_RenderEngine.GetLogicalGpu());
+        surface->Recreate();
+    }
+
+    // waits for the gpu to be done with this slot, after which its uniforms can be overwritten
+    const render::Frame& frame = m_Frames.BeginFrame();
+    m_Uniforms.BeginFrame(frame.Index);
+    m_Pipelines.BeginFrame(frame);
+
+    // uploads and destroys other threads queued since the last frame, before anything recorded could read them
+    m_Commands.Drain(frame);
+
+    // the post chain of this slot may still be running on the compute queue, the pool waits on it through here
+    m_Post.BeginFrame(frame);
+    m_Images.BeginFrame(frame.Number);
+    m_SceneRenderer.BeginFrame(frame);
+
+    // the scale moves with the time of the frame that last used this slot, the scene renders at GetRenderExtent
+    m_Resolution.BeginFrame(frame);
+
+    // what the culling and the light binning of this slot wrote is read back before the scene culls again
+    m_Occlusion.BeginFrame(frame);
+    m_Lighting.BeginFrame(frame);
+
+    // other processes change the budget as well, so it's looked at every frame rather than on allocation
+    m_MemoryBudget.Update();
+    m_Residency.Update(frame.Number, m_MemoryBudget);
+
+    // before anything is recorded so whatever samples the textures sees their new mips
+    m_Streamer.Update(frame, m_MemoryBudget);
+
+    // without an image to present to (minimized, closing) the scene isn't drawn at all
+    uint32_t image    = 0;
+    bool     acquired = false;
+    if (surface)
+    {
+        const VkResult result = surface->AcquireImage(frame, image);
+        acquired              = result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR;
+    }
+
+    // the last frame's post chain finished on the compute queue while this one was recorded, its output is
+    // what goes on the screen. waited on even without an image so the semaphore is free for the next chain
+    const render::PostOutput post = m_Post.TakeOutput();
+
+    render::FrameSubmit submit;
+    submit.AddWait(post.Done, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    if (acquired)
+    {
+        // the scene draws into a corner of images that fit the largest scale, the compose stretches it back up
+        const VkExtent2D    extent       = surface->GetExtent();
+        const VkExtent2D    targetExtent = m_Resolution.GetTargetExtent(extent);
+        const VkExtent2D    renderExtent = m_Resolution.GetRenderExtent(extent);
+        render::SceneTarget scene;
+        const bool          rendered = m_SceneRenderer.Record(frame, packet, targetExtent, renderExtent, scene);
+
+        // black for the first frame, before the post chain has output anything
+        ComposeSource source;
+        if (post.Image)
+            source = ComposeSource{post.Image->Image, VK_IMAGE_LAYOUT_GENERAL, post.Rendered};
+        composeFrame(frame.CommandBuffer, m_Resolution, source, surface->GetImage(image), extent);
+
+        // exactly what gets presented, copied out in the same submit and handed to the writer by Submit below
+        if (m_Capture)
+            m_Capture->Capture(frame.CommandBuffer, surface->GetImage(image), VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, surface->GetFormat(), extent);
+
+        // bloom and tonemapping of the scene run on the compute queue once this frame's submit is done
+        if (rendered)
+            m_Post.Record(frame, render::PostInput{scene.Color, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, scene.Extent});
+
+        submit.AddWait(surface->GetAcquired(frame.Index), VK_PIPELINE_STAGE_TRANSFER_BIT);
+        submit.AddSignal(surface->GetRendered(image));
+    }
+
+    // the post chain waits on the graphics submit on the gpu, so the compute queue picks it up while
+    // the next frame is already being recorded
+    m_Streamer.EndFrame(frame);
+    m_Resolution.EndFrame(frame);
+    submit.AddSignal(m_Post.EndFrame(frame));
+    const VkResult submitted = m_Frames.EndFrame(submit);
+    m_Post.Submit(submitted == VK_SUCCESS);
+
+    // a failed submit never signals what the present would wait on
+    if (acquired && submitted == VK_SUCCESS)
+        surface->Present(m_RenderEngine.GetQueue(), image);
+
+    // copies recorded into this frame are handed to the capture writer once the frame is submitted
+    if (m_Capture)
+        m_Capture->Submit(m_RenderEngine.GetQueue());
+
+    SampleRenderMetrics();
+}
+
+void Application::SampleRenderMetrics() SRK_NOEXCEPT
+{
+    const render::ResolutionStats& resolution = m_Resolution.GetStats();
+    gpuFrameTime.Set(resolution.GpuMs);
+    renderScale.Set(resolution.Scale);
+
+    const render::PostTimings& post = m_Post.GetTimings();
+    postChainTime.Set(post.ChainMs);
+    postOverlap.Set(post.OverlapMs);
+
+    VkDeviceSize usage  = 0;
+    VkDeviceSize budget = 0;
+    for (const render::HeapBudget& heap : m_MemoryBudget.GetHeaps())
+    {
+        if (!heap.DeviceLocal)
+            continue;
+        usage += heap.Usage;
+        budget += heap.Budget;
+    }
+    memoryUsage.Set(static_cast<double>(usage));
+    memoryBudget.Set(static_cast<double>(budget));
+    reducedResources.Set(m_Residency.GetStats().Reduced);
+
+    const render::StreamingStats streaming = m_Streamer.GetStats();
+    streamedResident.Set(static_cast<double>(streaming.Resident));
+    streamedUploaded.Set(static_cast<double>(streaming.Uploaded));
+
+    const render::OcclusionStats& occlusion = m_Occlusion.GetStats();
+    occlusionObjects.Set(occlusion.Objects);
+    occlusionCulled.Set(occlusion.Occluded);
+
+    const render::ClusterStats& lighting = m_Lighting.GetStats();
+    lightCount.Set(lighting.Lights);
+    lightOverflow.Set(lighting.Overflowed);
+
+    const render::RenderCommandStats commands = m_Commands.GetStats();
+    commandsQueued.Set(commands.Queued);
+    commandsDeferred.Set(commands.Deferred);
+    commandsRejected.Set(static_cast<double>(commands.Rejected));
 }
 
 } // namespace shrek
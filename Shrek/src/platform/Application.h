@@ -3,9 +3,37 @@
 #include "base/Singleton.h"
 #include "defs.h"
 #include "WindowManager.h"
+#include <chrono>
 #include <memory>
+#include <optional>
 
+#include "base/JobSystem.h"
+#include "MappedFile.h"
+#include "MetricsExporter.h"
+#include "base/StartupGraph.h"
+#include "render/ClusteredLighting.h"
+#include "render/DynamicResolution.h"
 #include "render/Engine.h"
+#include "render/FrameCapture.h"
+#include "render/FrameContext.h"
+#include "render/ImagePool.h"
+#include "render/MemoryBudget.h"
+#include "render/OcclusionCuller.h"
+#include "render/PostChain.h"
+#include "render/Regression.h"
+#include "render/RenderCommands.h"
+#include "render/RenderThread.h"
+#include "render/Residency.h"
+#include "render/SceneRenderer.h"
+#include "render/TextureStreamer.h"
+#include "render/UniformRing.h"
+#include "render/pipeline/LayoutCache.h"
+#include "render/pipeline/PipelineCache.h"
+#include "render/pipeline/ShaderLibrary.h"
+#include "scene/Bvh.h"
+#include "scene/Components.h"
+#include "scene/Culling.h"
+#include "scene/World.h"
 
 namespace shrek {
 
@@ -15,25 +43,11 @@ namespace shrek {
  *  mutex to control the access of this class
  */
 
-class ApplicationCmdLineArgs
-{
-public:
-    ApplicationCmdLineArgs(int argc, char** argv) SRK_NOEXCEPT;
-    const char* operator[](size_t idx) const SRK_NOEXCEPT;
-    size_t      Size() const SRK_NOEXCEPT;
-
-private:
-    size_t m_Size;
-    char** m_Arguments;
-};
-
 class Application : private base::Singleton<Application>
 {
 public:
+    // the command line is read into base::Config before this, everything configurable comes from there
     Application() SRK_NOEXCEPT;
-
-    // for linux based applications(?)
-    Application(ApplicationCmdLineArgs params) SRK_NOEXCEPT;
     ~Application() SRK_NOEXCEPT;
 
     void Tick() SRK_NOEXCEPT;
@@ -49,10 +63,89 @@ public:
     void Load() SRK_NOEXCEPT;
     void Cleanup() SRK_NOEXCEPT;
 
+    // what the process should exit with, non zero when a regression run failed
+    int GetExitCode() const SRK_NOEXCEPT { return m_ExitCode; }
+
+    const std::vector<base::PhaseTiming>& GetStartupTimings() const SRK_NOEXCEPT { return m_StartupTimings; }
+
+    // any thread, resource work for the renderer that shows up in the next frame it renders
+    render::RenderCommandQueue& GetRenderCommands() SRK_NOEXCEPT { return m_Commands; }
+
+private:
+    struct StartupShader
+    {
+        std::string           Name;
+        std::vector<uint32_t> Spirv; // empty when it failed to compile
+    };
+
+    // a primitive LoadScene handed to the scene renderer, what an entity drawing it needs
+    struct SceneMesh
+    {
+        std::string     Name; // of the gltf mesh it's a primitive of
+        uint32_t        Mesh{render::NoSceneMesh}; // of lod 0
+        scene::MeshLods Lods;
+        math::Aabb      Bounds;
+    };
+
+    // device creation, the loading window and shader compiles overlapping each other. runs from the member
+    // initializers since everything declared after m_StartupTimings needs the device
+    std::vector<base::PhaseTiming> RunStartup() SRK_NOEXCEPT;
+
+    // renders the regression scenes offscreen instead of opening any window, then stops the application
+    void RunRegression() SRK_NOEXCEPT;
+
+    // loads and optimizes the meshes of scene.meshes into m_AssetStaging and hands their primitives to the scene renderer,
+    // the pngs of scene.textures become its materials
+    void LoadScene() SRK_NOEXCEPT;
+
+    // the scene has no file of its own yet, fills it with entities drawing the Sphere and Box of the loaded meshes
+    // and a grid of point lights
+    void BuildTestScene() SRK_NOEXCEPT;
+
+    // main thread, culls the scene into the packet the render thread gets next
+    void BuildPacket(render::FramePacket& packet) SRK_NOEXCEPT;
+    // render thread, everything that records or submits gpu work
+    void RenderFrame(const render::FramePacket& packet) SRK_NOEXCEPT;
+    // render thread, after the submit. copies the stats of this frame into the metrics
+    void SampleRenderMetrics() SRK_NOEXCEPT;
+
 private:
-    WindowManager  m_WindowManager;
-    bool           m_Running;
-    render::Engine m_RenderEngine;
+    WindowManager                             m_WindowManager;
+    bool                                      m_Running;
+    int                                       m_ExitCode;
+    std::optional<render::RegressionSettings> m_Regression; // only with regression.run
+    base::JobSystem                           m_JobSystem;
+    render::Engine                            m_RenderEngine;
+    GLFWwindow*                               m_LoadingWindow; // made during startup, Load puts a surface on it
+    std::vector<StartupShader>                m_StartupShaders;
+    MappedFile                                m_SavedPipelines; // read during startup, closed once m_Pipelines has it
+    std::vector<base::PhaseTiming>            m_StartupTimings;
+    render::pipeline::ShaderLibrary           m_Shaders;
+    render::pipeline::LayoutCache             m_Layouts;
+    render::pipeline::PipelineCache           m_Pipelines;
+    uint32_t                                  m_PipelineReloadHandler;
+    render::UniformRing                       m_Uniforms;
+    render::MemoryBudget                      m_MemoryBudget;
+    render::ResidencyManager                  m_Residency; // streamed textures, the scene's geometry and the pooled images register here to be shrunk when the heap runs out of budget
+    render::TextureStreamer                   m_Streamer;
+    render::ImagePool                         m_Images;
+    render::PostChain                         m_Post; // bloom and tonemapping, on the compute queue when there is one
+    render::DynamicResolution                 m_Resolution;
+    render::OcclusionCuller                   m_Occlusion; // indirect draws of the scene's render queue
+    render::ClusteredLighting                 m_Lighting;
+    render::RenderCommandQueue                m_Commands; // drained by the render thread at the start of every frame
+    render::StagingBuffer                     m_AssetStaging; // what the scene's meshes were loaded into, the copies out of it run in later frames
+    render::SceneRenderer                     m_SceneRenderer;
+    std::vector<SceneMesh>                    m_SceneMeshes; // every primitive the scene renderer took, in the order they were loaded
+    scene::World                              m_Scene; // main thread only, as are the four below
+    scene::Bvh                                m_SceneBvh;
+    std::vector<scene::View>                  m_Views;
+    render::FrameCamera                       m_Camera;
+    std::chrono::steady_clock::time_point     m_LastTick;
+    std::unique_ptr<render::FrameCapture>     m_Capture; // only with capture.directory set
+    MetricsExporter                           m_Metrics; // main thread, only publishes with metrics.shm set
+    render::FrameContext                      m_Frames; // destroyed right after the render thread stops, it waits for the gpu to be done with everything above
+    render::RenderThread                      m_RenderThread; // last so it is stopped before anything it renders with goes
 };
 
 } // namespace shrek
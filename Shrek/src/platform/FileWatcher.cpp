@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "FileWatcher.h"
+
+#include "Log.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#    include <sys/inotify.h>
+#    include <unistd.h>
+#endif
+
+namespace shrek {
+
+namespace {
+
+void addUnique(std::vector<std::string>& changed, std::string name) SRK_NOEXCEPT
+{
+    // editors like to save in several writes, one reload per file is enough
+    if (std::find(changed.begin(), changed.end(), name) == changed.end())
+        changed.push_back(std::move(name));
+}
+
+} // namespace
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher(const std::string& directory) SRK_NOEXCEPT :
+    m_Directory(directory)
+{
+    m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_Inotify < 0)
+    {
+        SRK_CORE_ERROR("inotify_init1 failed, {} will not be watched", directory);
+        return;
+    }
+
+    // IN_MOVED_TO catches editors that write a temporary file and rename it over the original
+    m_Watch = inotify_add_watch(m_Inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (m_Watch < 0)
+    {
+        SRK_CORE_ERROR("Unable to watch {}", directory);
+        close(m_Inotify);
+        m_Inotify = -1;
+        return;
+    }
+
+    m_Valid = true;
+}
+
+FileWatcher::~FileWatcher() SRK_NOEXCEPT
+{
+    if (m_Inotify >= 0)
+        close(m_Inotify);
+}
+
+void FileWatcher::Poll(std::vector<std::string>& changed) SRK_NOEXCEPT
+{
+    if (!m_Valid)
+        return;
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        const ssize_t length = read(m_Inotify, buffer, sizeof(buffer));
+        if (length <= 0)
+            break; // EAGAIN, nothing left to read
+
+        for (ssize_t offset{}; offset < length;)
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && !(event->mask & IN_ISDIR))
+                addUnique(changed, event->name);
+
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+}
+
+#else
+
+FileWatcher::FileWatcher(const std::string& directory) SRK_NOEXCEPT :
+    m_Directory(directory),
+    m_LastPoll(std::chrono::steady_clock::now())
+{
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(m_Directory, error))
+    {
+        if (entry.is_regular_file(error))
+            m_WriteTimes[entry.path().filename().string()] = entry.last_write_time(error);
+    }
+
+    if (error)
+    {
+        SRK_CORE_ERROR("Unable to watch {}: {}", directory, error.message());
+        return;
+    }
+
+    m_Valid = true;
+}
+
+FileWatcher::~FileWatcher() SRK_NOEXCEPT = default;
+
+void FileWatcher::Poll(std::vector<std::string>& changed) SRK_NOEXCEPT
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (!m_Valid || now - m_LastPoll < PollInterval)
+        return;
+
+    m_LastPoll = now;
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(m_Directory, error))
+    {
+        if (!entry.is_regular_file(error))
+            continue;
+
+        const auto  writeTime = entry.last_write_time(error);
+        std::string name      = entry.path().filename().string();
+
+        auto [it, inserted] = m_WriteTimes.try_emplace(name, writeTime);
+        if (inserted || it->second != writeTime)
+        {
+            it->second = writeTime;
+            addUnique(changed, std::move(name));
+        }
+    }
+}
+
+#endif
+
+} // namespace shrek
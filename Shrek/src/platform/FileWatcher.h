@@ -0,0 +1,47 @@
+#pragma once
+#include "defs.h"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace shrek {
+
+/*
+ *  Watches the files directly inside a directory for modifications.
+ *  Uses inotify on linux, other platforms fall back to comparing write times every PollInterval.
+ *  Poll never blocks so it can be called once per frame.
+ */
+class FileWatcher
+{
+public:
+    static constexpr std::chrono::milliseconds PollInterval{250};
+
+    FileWatcher() SRK_NOEXCEPT = default;
+    explicit FileWatcher(const std::string& directory) SRK_NOEXCEPT;
+    ~FileWatcher() SRK_NOEXCEPT;
+
+    FileWatcher(const FileWatcher& other) = delete;
+    FileWatcher& operator=(const FileWatcher& other) = delete;
+
+    bool IsValid() const SRK_NOEXCEPT { return m_Valid; }
+
+    // appends the names (relative to the directory) of files written since the last call, every name at most once
+    void Poll(std::vector<std::string>& changed) SRK_NOEXCEPT;
+
+private:
+    std::filesystem::path m_Directory;
+    bool                  m_Valid{false};
+
+#ifdef __linux__
+    int m_Inotify{-1};
+    int m_Watch{-1};
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_WriteTimes;
+    std::chrono::steady_clock::time_point                            m_LastPoll;
+#endif
+};
+
+} // namespace shrek
@@ -29,6 +29,18 @@ void Log::Init() SRK_NOEXCEPT
     s_ClientLogger->flush_on(spdlog::level::trace);
 }
 
+bool Log::SetLevel(std::string_view level) SRK_NOEXCEPT
+{
+    // from_str gives back off for anything it does not know
+    const spdlog::level::level_enum parsed = spdlog::level::from_str(std::string(level));
+    if (parsed == spdlog::level::off && level != "off")
+        return false;
+
+    s_CoreLogger->set_level(parsed);
+    s_ClientLogger->set_level(parsed);
+    return true;
+}
+
 void Log::Exit() SRK_NOEXCEPT
 {
     spdlog::shutdown();
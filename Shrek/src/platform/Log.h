@@ -2,13 +2,18 @@
 
 #include "defs.h"
 
-#pragma warning(push, 0)
+#ifdef _MSC_VER
+#    pragma warning(push, 0)
+#endif
 #include "spdlog/spdlog.h"
 #include "spdlog/fmt/ostr.h"
 
-#pragma warning(pop)
+#ifdef _MSC_VER
+#    pragma warning(pop)
+#endif
 
 #include <memory>
+#include <string_view>
 
 namespace shrek {
 
@@ -18,6 +23,9 @@ public:
     static void Init() SRK_NOEXCEPT;
     static void Exit() SRK_NOEXCEPT;
 
+    // trace, debug, info, warn, error, critical or off for both loggers, false for anything else
+    static bool SetLevel(std::string_view level) SRK_NOEXCEPT;
+
     inline static const std::shared_ptr<spdlog::logger>& GetClientLogger() SRK_NOEXCEPT { return s_ClientLogger; }
     inline static const std::shared_ptr<spdlog::logger>& GetCoreLogger() SRK_NOEXCEPT { return s_CoreLogger; }
 
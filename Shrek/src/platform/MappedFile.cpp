@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#include "Log.h"
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace shrek {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) SRK_NOEXCEPT
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        SRK_CORE_ERROR("Unable to open {} for mapping", path);
+        return;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        // empty files can not be mapped on windows
+        CloseHandle(file);
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        SRK_CORE_ERROR("Unable to create a file mapping for {}", path);
+        CloseHandle(file);
+        return;
+    }
+
+    m_Data    = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    m_Size    = static_cast<size_t>(size.QuadPart);
+    m_File    = file;
+    m_Mapping = mapping;
+
+    if (!m_Data)
+    {
+        SRK_CORE_ERROR("Unable to map a view of {}", path);
+        Close();
+    }
+}
+
+void MappedFile::Close() SRK_NOEXCEPT
+{
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+    if (m_File)
+        CloseHandle(m_File);
+
+    m_Data    = nullptr;
+    m_Size    = 0;
+    m_File    = nullptr;
+    m_Mapping = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile&& other) SRK_NOEXCEPT
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) SRK_NOEXCEPT
+{
+    std::swap(m_Data, other.m_Data);
+    std::swap(m_Size, other.m_Size);
+    std::swap(m_File, other.m_File);
+    std::swap(m_Mapping, other.m_Mapping);
+    return *this;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) SRK_NOEXCEPT
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        SRK_CORE_ERROR("Unable to open {} for mapping", path);
+        return;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps its own reference to the file
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        SRK_CORE_ERROR("Unable to mmap {}", path);
+        return;
+    }
+
+    // most loads read the whole file front to back
+    madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL | MADV_WILLNEED);
+
+    m_Data = static_cast<const std::byte*>(data);
+    m_Size = static_cast<size_t>(info.st_size);
+}
+
+void MappedFile::Close() SRK_NOEXCEPT
+{
+    if (m_Data)
+        munmap(const_cast<std::byte*>(m_Data), m_Size);
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) SRK_NOEXCEPT
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) SRK_NOEXCEPT
+{
+    std::swap(m_Data, other.m_Data);
+    std::swap(m_Size, other.m_Size);
+    return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() SRK_NOEXCEPT
+{
+    Close();
+}
+
+} // namespace shrek
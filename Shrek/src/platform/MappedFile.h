@@ -0,0 +1,43 @@
+#pragma once
+#include "defs.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace shrek {
+
+// read only view of a whole file, the pages are only read in when touched
+class MappedFile
+{
+public:
+    MappedFile() SRK_NOEXCEPT = default;
+    explicit MappedFile(const std::string& path) SRK_NOEXCEPT;
+    ~MappedFile() SRK_NOEXCEPT;
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    MappedFile(MappedFile&& other) SRK_NOEXCEPT;
+    MappedFile& operator=(MappedFile&& other) SRK_NOEXCEPT;
+
+    bool IsValid() const SRK_NOEXCEPT { return m_Data != nullptr; }
+
+    const std::byte* Data() const SRK_NOEXCEPT { return m_Data; }
+    size_t           Size() const SRK_NOEXCEPT { return m_Size; }
+
+    std::string_view AsString() const SRK_NOEXCEPT { return {reinterpret_cast<const char*>(m_Data), m_Size}; }
+
+    void Close() SRK_NOEXCEPT;
+
+private:
+    const std::byte* m_Data{nullptr};
+    size_t           m_Size{0};
+
+#ifdef _WIN32
+    void* m_File{nullptr};
+    void* m_Mapping{nullptr};
+#endif
+};
+
+} // namespace shrek
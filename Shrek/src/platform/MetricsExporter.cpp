@@ -0,0 +1,184 @@
+#include "pch.h"
+#include "MetricsExporter.h"
+
+#include "Log.h"
+#include "base/Config.h"
+#include "base/Metrics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+namespace shrek {
+
+namespace {
+
+base::ConfigVar<std::string> segmentName{"metrics.shm", "", "shared memory segment the metrics are published through, empty publishes nothing"};
+base::ConfigVar<int32_t>     publishInterval{"metrics.interval_ms", 250, "how often the metrics segment is refreshed"};
+
+constexpr char     segmentMagic[8] = "SRKMETR";
+constexpr uint32_t segmentVersion  = 1;
+// a few hundred metrics with long descriptions still fit
+constexpr size_t segmentBytes = 256 * 1024;
+
+} // namespace
+
+#ifdef _WIN32
+
+MetricsExporter::MetricsExporter() SRK_NOEXCEPT :
+    m_Name(segmentName.Get())
+{
+    if (m_Name.empty())
+        return;
+
+    // Local\ keeps it to this session, which is where a dashboard next to the engine runs
+    const std::string mappingName = "Local\\" + m_Name;
+    HANDLE            mapping     = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(segmentBytes), mappingName.c_str());
+    if (!mapping)
+    {
+        SRK_CORE_ERROR("Unable to create the metrics segment {}", mappingName);
+        return;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, segmentBytes);
+    if (!data)
+    {
+        SRK_CORE_ERROR("Unable to map the metrics segment {}", mappingName);
+        CloseHandle(mapping);
+        return;
+    }
+
+    m_Mapping = mapping;
+    m_Header  = static_cast<MetricsSegmentHeader*>(data);
+}
+
+void MetricsExporter::Close() SRK_NOEXCEPT
+{
+    if (m_Header)
+        UnmapViewOfFile(m_Header);
+    if (m_Mapping)
+        CloseHandle(m_Mapping);
+
+    m_Header  = nullptr;
+    m_Mapping = nullptr;
+}
+
+#else
+
+MetricsExporter::MetricsExporter() SRK_NOEXCEPT :
+    m_Name(segmentName.Get())
+{
+    if (m_Name.empty())
+        return;
+
+    // shm_open wants a single leading slash, the segment shows up as /dev/shm/<name>
+    if (m_Name.front() != '/')
+        m_Name.insert(m_Name.begin(), '/');
+
+    // a segment left behind by a run that crashed is simply taken over
+    int fd = shm_open(m_Name.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        SRK_CORE_ERROR("Unable to open the metrics segment {}", m_Name);
+        return;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(segmentBytes)) != 0)
+    {
+        SRK_CORE_ERROR("Unable to size the metrics segment {}", m_Name);
+        close(fd);
+        shm_unlink(m_Name.c_str());
+        return;
+    }
+
+    void* data = mmap(nullptr, segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping keeps its own reference to the segment
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        SRK_CORE_ERROR("Unable to mmap the metrics segment {}", m_Name);
+        shm_unlink(m_Name.c_str());
+        return;
+    }
+
+    m_Header = static_cast<MetricsSegmentHeader*>(data);
+}
+
+void MetricsExporter::Close() SRK_NOEXCEPT
+{
+    if (m_Header)
+    {
+        munmap(m_Header, segmentBytes);
+        shm_unlink(m_Name.c_str());
+    }
+
+    m_Header = nullptr;
+}
+
+#endif
+
+MetricsExporter::~MetricsExporter() SRK_NOEXCEPT
+{
+    Close();
+}
+
+void MetricsExporter::Publish() SRK_NOEXCEPT
+{
+    if (!m_Header)
+        return;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (m_Text && now - m_LastPublish < std::chrono::milliseconds(publishInterval.Get()))
+        return;
+
+    if (!m_Text)
+    {
+        // the header goes in on the first publish rather than in the constructor, a reader that finds the magic
+        // knows a snapshot follows
+        new (m_Header) MetricsSegmentHeader{};
+        m_Header->Version  = segmentVersion;
+        m_Header->Capacity = static_cast<uint32_t>(segmentBytes - sizeof(MetricsSegmentHeader));
+        m_Text             = reinterpret_cast<char*>(m_Header + 1);
+        m_Snapshot.reserve(m_Header->Capacity);
+        SRK_CORE_TRACE("Publishing metrics through {} every {} ms", m_Name, publishInterval.Get());
+    }
+    m_LastPublish = now;
+
+    m_Snapshot.clear();
+    base::Metrics::Get().Format(m_Snapshot);
+
+    // cut at the last whole line that fits so a reader never sees half a sample
+    size_t size = m_Snapshot.size();
+    if (size > m_Header->Capacity)
+    {
+        const size_t line = m_Snapshot.rfind('\n', m_Header->Capacity - 1);
+        size              = line == std::string::npos ? 0 : line + 1;
+        if (!m_Truncated)
+            SRK_CORE_WARN("{} bytes of metrics don't fit the {} of the segment, the rest is left out", m_Snapshot.size(), m_Header->Capacity);
+        m_Truncated = true;
+    }
+
+    const uint64_t sequence = m_Header->Sequence.load(std::memory_order_relaxed);
+    m_Header->Sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(m_Text, m_Snapshot.data(), size);
+    m_Header->Size        = size;
+    m_Header->TimestampMs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    // the magic last on the first snapshot, a reader that sees it sees a valid header
+    std::memcpy(m_Header->Magic, segmentMagic, sizeof(segmentMagic));
+
+    m_Header->Sequence.store(sequence + 2, std::memory_order_release);
+}
+
+} // namespace shrek
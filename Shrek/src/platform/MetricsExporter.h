@@ -0,0 +1,66 @@
+#pragma once
+#include "defs.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace shrek {
+
+/*
+ *  What a dashboard finds at the start of the segment, the text follows right after it. A seqlock: the
+ *  sequence is odd while the engine writes, so a reader copies Size bytes of text and keeps the copy only
+ *  if the sequence was the same even number before and after.
+ *
+ *      do { before = Sequence; copy the text; after = Sequence; } while (before != after || (before & 1));
+ */
+struct MetricsSegmentHeader
+{
+    char                  Magic[8];    // "SRKMETR"
+    uint32_t              Version;     // of this layout
+    uint32_t              Capacity;    // bytes of text the segment has room for
+    std::atomic<uint64_t> Sequence;
+    uint64_t              Size;        // bytes of text in the last snapshot
+    uint64_t              TimestampMs; // unix time the snapshot was taken
+};
+
+/*
+ *  Publishes base::Metrics in the prometheus text format through a named shared memory segment, so a
+ *  process on the same machine can scrape live numbers without attaching to the engine or parsing its log.
+ *  metrics.shm names the segment (shm_open on linux, a named file mapping on windows), empty publishes nothing.
+ *  Publish snapshots at most every metrics.interval_ms, formatting and copying happen on the calling thread.
+ */
+class MetricsExporter
+{
+public:
+    MetricsExporter() SRK_NOEXCEPT;
+    ~MetricsExporter() SRK_NOEXCEPT;
+
+    MetricsExporter(const MetricsExporter& other) = delete;
+    MetricsExporter& operator=(const MetricsExporter& other) = delete;
+
+    bool IsValid() const SRK_NOEXCEPT { return m_Header != nullptr; }
+
+    // one thread only, nothing happens when the last snapshot is younger than the interval
+    void Publish() SRK_NOEXCEPT;
+
+private:
+    void Close() SRK_NOEXCEPT;
+
+private:
+    MetricsSegmentHeader*                 m_Header{nullptr};
+    char*                                 m_Text{nullptr};
+    size_t                                m_Bytes{0}; // of the whole segment
+    std::string                           m_Name;
+    std::string                           m_Snapshot; // formatted into, keeps its memory between snapshots
+    std::chrono::steady_clock::time_point m_LastPublish{};
+    bool                                  m_Truncated{false};
+
+#ifdef _WIN32
+    void* m_Mapping{nullptr};
+#endif
+};
+
+} // namespace shrek
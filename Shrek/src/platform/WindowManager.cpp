@@ -2,24 +2,64 @@
 
 #include "Log.h"
 #include "WindowManager.h"
+#include "base/Config.h"
 
-#define GLFW_EXPOSE_NATIVE_WIN32
-#define GLFW_EXPOSE_NATIVE_WGL
-
-#include <GLFW/glfw3native.h>
+#ifdef _WIN32
+#    define GLFW_EXPOSE_NATIVE_WIN32
+#    define GLFW_EXPOSE_NATIVE_WGL
+#    include <GLFW/glfw3native.h>
+#endif
 
 
 namespace shrek {
 
 using Singleton = base::Singleton<WindowManager>;
 
+namespace {
+
+base::ConfigVar<std::string> windowPlatform{"window.platform", "auto", "auto, x11 or wayland on linux, auto lets glfw pick whichever the session runs"};
+
+// glfw 3.4 picks between x11 and wayland at runtime, older ones were built for exactly one of them
+void hintPlatform() SRK_NOEXCEPT
+{
+    const std::string_view name = windowPlatform.Get();
+#ifdef GLFW_PLATFORM
+    int platform = GLFW_ANY_PLATFORM;
+    if (name == "x11")
+        platform = GLFW_PLATFORM_X11;
+    else if (name == "wayland")
+        platform = GLFW_PLATFORM_WAYLAND;
+    else if (name != "auto")
+        SRK_CORE_WARN("Unknown window platform {}, using auto", name);
+
+    if (platform != GLFW_ANY_PLATFORM && glfwPlatformSupported(platform) == GLFW_FALSE)
+    {
+        SRK_CORE_WARN("This glfw wasn't built with {} support, using auto", name);
+        platform = GLFW_ANY_PLATFORM;
+    }
+    glfwInitHint(GLFW_PLATFORM, platform);
+#else
+    if (name != "auto")
+        SRK_CORE_WARN("glfw {} can't choose its platform at runtime, ignoring window.platform {}", glfwGetVersionString(), name);
+#endif
+}
+
+} // namespace
+
 WindowManager::WindowManager() SRK_NOEXCEPT : Singleton("WindowManager")
 {
+    hintPlatform();
     if (!glfwInit())
     {
         SRK_CORE_ERROR("Unable to initialize WindowContext!");
         std::exit(-1);
     }
+
+#ifdef GLFW_PLATFORM
+    const int platform = glfwGetPlatform();
+    SRK_CORE_TRACE("glfw {} running on {}", glfwGetVersionString(),
+                   platform == GLFW_PLATFORM_WAYLAND ? "wayland" : platform == GLFW_PLATFORM_X11 ? "x11" : platform == GLFW_PLATFORM_WIN32 ? "win32" : "another platform");
+#endif
 }
 
 WindowManager::~WindowManager() SRK_NOEXCEPT
@@ -53,6 +93,8 @@ void WindowManager::ValidateAndPurge() SRK_NOEXCEPT
         {
             // TODO: need to optimize this part as delete will cause too loop time.
             SRK_CORE_TRACE("Deleting window now {}", begin->first);
+            if (m_OnClose)
+                m_OnClose(begin->first, *begin->second);
 
             // deleting because it's still the manager's ownership
             delete begin->second;
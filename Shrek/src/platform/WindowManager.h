@@ -3,7 +3,7 @@
 
 #include "defs.h"
 #include <GLFW/glfw3.h>
-#include <windows.h>
+#include <functional>
 #include <memory>
 #include "WindowsWindow.h"
 #include "base/Singleton.h"
@@ -13,6 +13,8 @@ namespace shrek {
 class WindowManager : private base::Singleton<WindowManager>
 {
 public:
+    using CloseCallback = std::function<void(std::string_view name, WindowsWindow& window)>;
+
     WindowManager() SRK_NOEXCEPT;
     ~WindowManager() SRK_NOEXCEPT;
 
@@ -31,6 +33,9 @@ public:
     WindowsWindow* GetWindow(std::string_view name) const SRK_NOEXCEPT;
     WindowsWindow* ReleaseWindow(std::string_view name) SRK_NOEXCEPT;
 
+    // called right before a window that was closed is deleted, for whatever still uses its surface to let go of it
+    void SetCloseCallback(CloseCallback callback) SRK_NOEXCEPT { m_OnClose = std::move(callback); }
+
     // just to check if there are any windows
     bool Empty() const SRK_NOEXCEPT;
 
@@ -43,5 +48,6 @@ private:
 
 private:
     std::unordered_map<std::string_view, WindowsWindow*> m_Windows;
+    CloseCallback                                        m_OnClose;
 };
 } // namespace shrek
@@ -3,16 +3,15 @@
 #include "Log.h"
 #include "WindowsWindow.h"
 
-#define GLFW_EXPOSE_NATIVE_WIN32
-#define GLFW_EXPOSE_NATIVE_WGL
-
-#include <GLFW/glfw3native.h>
+#ifdef _WIN32
+#    define GLFW_EXPOSE_NATIVE_WIN32
+#    define GLFW_EXPOSE_NATIVE_WGL
+#    include <GLFW/glfw3native.h>
+#endif
 
 namespace shrek {
 
-namespace {
-
-GLFWwindow* CreateGLFWwindow(const WindowParam& param) SRK_NOEXCEPT
+GLFWwindow* WindowsWindow::CreateHandle(const WindowParam& param) SRK_NOEXCEPT
 {
     GLFWwindow* window;
 
@@ -43,10 +42,13 @@ GLFWwindow* CreateGLFWwindow(const WindowParam& param) SRK_NOEXCEPT
     return window;
 }
 
-} // namespace
-
 WindowsWindow::WindowsWindow(const render::Engine& engine, const WindowParam& param) SRK_NOEXCEPT :
-    m_Surface(engine.GetInstance(), engine.GetGpu(), engine.GetLogicalGpu(), CreateGLFWwindow(param), engine.GetQueueFamilyIndices())
+    WindowsWindow(engine, CreateHandle(param))
+{
+}
+
+WindowsWindow::WindowsWindow(const render::Engine& engine, GLFWwindow* window) SRK_NOEXCEPT :
+    m_Surface(engine.GetInstance(), engine.GetGpu(), engine.GetLogicalGpu(), window, engine.GetQueueFamilyIndices())
 {
     // so that user pointer won't throw from null exception
     if (m_Surface.GetWindow() != nullptr)
@@ -57,8 +59,8 @@ WindowsWindow::WindowsWindow(const render::Engine& engine, const WindowParam& pa
 
 void WindowsWindow::Resize(size_t width, size_t height) SRK_NOEXCEPT
 {
-    (void)width;
-    (void)height;
+    // the render thread picks it up at the start of its next frame
+    m_Surface.Resize(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
 }
 
 bool WindowsWindow::IsValid() const SRK_NOEXCEPT
@@ -70,17 +72,6 @@ WindowsWindow::~WindowsWindow() SRK_NOEXCEPT
 {
 }
 
-WindowsWindow::WindowsWindow(WindowsWindow&& other) SRK_NOEXCEPT : m_Surface()
-{
-    *this = std::move(other);
-}
-
-WindowsWindow& WindowsWindow::operator=(WindowsWindow&& other) SRK_NOEXCEPT
-{
-    std::swap(m_Surface, other.m_Surface);
-    return *this;
-}
-
 // HWND WindowsWindow::GetRenderContext() const SRK_NOEXCEPT
 // {
 //     return glfwGetWin32Window(m_Surface.GetWindow());
@@ -2,7 +2,6 @@
 
 #include "defs.h"
 #include <GLFW/glfw3.h>
-#include <windows.h>
 #include <cstdint>
 #include <string_view>
 
@@ -27,14 +26,17 @@ class WindowsWindow
 {
 public:
     WindowsWindow(const render::Engine& engine, const WindowParam& param = {}) SRK_NOEXCEPT;
+    // takes over a window made by CreateHandle, which unlike the surface doesn't have to wait for the device
+    WindowsWindow(const render::Engine& engine, GLFWwindow* window) SRK_NOEXCEPT;
     ~WindowsWindow() SRK_NOEXCEPT;
 
     // deleting both copy and move until we can find a way to make glfw initialize be called once
     WindowsWindow(const WindowsWindow& other) = delete;
     WindowsWindow& operator=(const WindowsWindow& other) = delete;
 
-    WindowsWindow(WindowsWindow&& other) SRK_NOEXCEPT;
-    WindowsWindow& operator=(WindowsWindow&& other) SRK_NOEXCEPT;
+    // the surface can't move either, the render thread keeps a pointer to it
+    WindowsWindow(WindowsWindow&& other) SRK_NOEXCEPT = delete;
+    WindowsWindow& operator=(WindowsWindow&& other) SRK_NOEXCEPT = delete;
 
     void               Update() SRK_NOEXCEPT;
     bool               ShouldClose() const SRK_NOEXCEPT;
@@ -43,7 +45,11 @@ public:
     bool               IsValid() const SRK_NOEXCEPT;
     void               SetCallbacks() SRK_NOEXCEPT;
 
-    GLFWwindow* Raw() const SRK_NOEXCEPT { return m_Surface.GetWindow(); };
+    GLFWwindow*      Raw() const SRK_NOEXCEPT { return m_Surface.GetWindow(); };
+    render::Surface& GetSurface() SRK_NOEXCEPT { return m_Surface; }
+
+    // main thread only, like everything else glfw does with windows. null when it failed
+    static GLFWwindow* CreateHandle(const WindowParam& param) SRK_NOEXCEPT;
 
 private:
     render::Surface m_Surface;
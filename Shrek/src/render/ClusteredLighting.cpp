@@ -0,0 +1,293 @@
+#include "pch.h"
+#include "ClusteredLighting.h"
+
+#include "base/Config.h"
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace shrek::render {
+
+namespace {
+
+base::ConfigVar<int32_t> lightsPerCluster{"render.lights.per_cluster", 128, "lights a single cluster has room for, the rest are dropped from it"};
+
+// the shader side Params of LightCull.comp and ClusteredForward.frag
+struct ClusterParams
+{
+    math::Mat4 View;
+    float      Projection[4]; // x and y scale of the projection, near, far
+    float      Screen[4];     // render extent, slice scale and bias
+    uint32_t   Grid[4];       // clusters along x, y and z, lights a cluster has room for
+    uint32_t   LightCount;
+    uint32_t   Padding[3];
+};
+
+static_assert(sizeof(ClusterParams) == 128, "ClusterParams has to match the shader side layout");
+
+struct ClusterReadback
+{
+    uint32_t Overflowed;
+    uint32_t Busiest;
+};
+
+constexpr uint32_t cullGroupSize = 64;
+
+// whether any of the sphere (view space, looking down -z) is inside the view
+bool inView(const math::Vec3& center, float radius, const ClusterCamera& camera) SRK_NOEXCEPT
+{
+    if (center.z - radius > -camera.Near || center.z + radius < -camera.Far)
+        return false;
+
+    // the side planes go through the eye, x * scale = -z on the edges of the screen
+    const float scaleX = camera.Projection.Columns[0].x;
+    const float scaleY = std::abs(camera.Projection.Columns[1].y);
+    const float normX  = std::sqrt(scaleX * scaleX + 1.f);
+    const float normY  = std::sqrt(scaleY * scaleY + 1.f);
+    return (scaleX * std::abs(center.x) + center.z) / normX <= radius && (scaleY * std::abs(center.y) + center.z) / normY <= radius;
+}
+
+} // namespace
+
+ClusteredLighting::ClusteredLighting(VkPhysicalDevice gpu, VkDevice device, pipeline::ShaderLibrary& shaders, pipeline::PipelineCache& pipelines,
+                                     uint32_t maxLights) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Shaders(shaders),
+    m_Pipelines(pipelines),
+    m_MaxLights(maxLights),
+    m_PerCluster(static_cast<uint32_t>(std::clamp<int32_t>(lightsPerCluster, 1, 1024))),
+    m_Valid(false),
+    m_LightsOffset(0),
+    m_StatsOffset(0),
+    m_IndicesOffset(0),
+    m_Slots(GetFramesInFlight()),
+    m_Stats()
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(gpu, &properties);
+    const VkDeviceSize alignment = properties.limits.minStorageBufferOffsetAlignment;
+
+    // params, lights and stats in the host visible buffer, counts and indices in the device local one
+    m_LightsOffset                  = helper::AlignUp(sizeof(ClusterParams), alignment);
+    m_StatsOffset                   = helper::AlignUp(m_LightsOffset + VkDeviceSize{std::max(m_MaxLights, 1u)} * sizeof(PointLight), alignment);
+    m_IndicesOffset                 = helper::AlignUp(VkDeviceSize{ClusterCount} * sizeof(uint32_t), alignment);
+    const VkDeviceSize uploadSize   = m_StatsOffset + sizeof(ClusterReadback);
+    const VkDeviceSize clustersSize = m_IndicesOffset + VkDeviceSize{ClusterCount} * m_PerCluster * sizeof(uint32_t);
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 5;
+
+    VkDescriptorPoolCreateInfo descriptorInfo{};
+    descriptorInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorInfo.maxSets       = 1;
+    descriptorInfo.poolSizeCount = 1;
+    descriptorInfo.pPoolSizes    = &poolSize;
+
+    VkResult result = VK_SUCCESS;
+    for (Slot& slot : m_Slots)
+    {
+        result = helper::CreateBuffer(gpu, m_Device, uploadSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, slot.Upload);
+        if (result == VK_SUCCESS)
+            result = helper::CreateBuffer(gpu, m_Device, clustersSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, slot.Clusters);
+        if (result == VK_SUCCESS)
+            result = vkCreateDescriptorPool(m_Device, &descriptorInfo, nullptr, &slot.Descriptors);
+        if (result != VK_SUCCESS)
+            break;
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Clustered lighting could not be created with {}", result);
+        return;
+    }
+
+    m_Valid = true;
+}
+
+ClusteredLighting::~ClusteredLighting() SRK_NOEXCEPT
+{
+    // FrameContext waited for the gpu before anything here goes
+    for (Slot& slot : m_Slots)
+    {
+        helper::DestroyBuffer(m_Device, slot.Upload);
+        helper::DestroyBuffer(m_Device, slot.Clusters);
+        if (slot.Descriptors != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_Device, slot.Descriptors, nullptr);
+    }
+}
+
+void ClusteredLighting::BeginFrame(const Frame& frame) SRK_NOEXCEPT
+{
+    if (!m_Valid)
+        return;
+
+    // the slot's fence was waited on and the binning made its writes available to the host
+    Slot& slot = m_Slots[frame.Index];
+    if (slot.Binned)
+    {
+        ClusterReadback readback;
+        std::memcpy(&readback, static_cast<const std::byte*>(slot.Upload.Mapped) + m_StatsOffset, sizeof(readback));
+
+        m_Stats.Lights     = slot.Lights;
+        m_Stats.Dropped    = slot.Dropped;
+        m_Stats.Overflowed = readback.Overflowed;
+        m_Stats.Busiest    = readback.Busiest;
+    }
+
+    vkResetDescriptorPool(m_Device, slot.Descriptors, 0);
+    slot.Updated = false;
+    slot.Binned  = false;
+}
+
+void ClusteredLighting::Update(const Frame& frame, const PointLight* lights, uint32_t count, const ClusterCamera& camera) SRK_NOEXCEPT
+{
+    Slot& slot = m_Slots[frame.Index];
+    if (!m_Valid)
+        return;
+
+    std::byte*  mapped   = static_cast<std::byte*>(slot.Upload.Mapped);
+    PointLight* uploaded = reinterpret_cast<PointLight*>(mapped + m_LightsOffset);
+
+    // the binning and the shading both work in view space, so the lights are moved there once here
+    uint32_t kept = 0;
+    for (uint32_t idx{}; idx < count && kept < m_MaxLights; ++idx)
+    {
+        const math::Vec4 position = camera.View * math::Vec4{lights[idx].Position, 1.f};
+        const math::Vec3 center{position.x, position.y, position.z};
+        if (lights[idx].Radius <= 0.f || !inView(center, lights[idx].Radius, camera))
+            continue;
+
+        uploaded[kept]          = lights[idx];
+        uploaded[kept].Position = center;
+        ++kept;
+    }
+
+    // d = near * (far / near)^(slice / slices), solved for the slice
+    const float near = std::max(camera.Near, 1e-4f);
+    const float far  = std::max(camera.Far, near * 1.001f);
+    const float span = std::log(far / near);
+
+    ClusterParams params{};
+    params.View          = camera.View;
+    params.Projection[0] = camera.Projection.Columns[0].x;
+    params.Projection[1] = camera.Projection.Columns[1].y;
+    params.Projection[2] = near;
+    params.Projection[3] = far;
+    params.Screen[0]     = static_cast<float>(std::max(camera.Extent.width, 1u));
+    params.Screen[1]     = static_cast<float>(std::max(camera.Extent.height, 1u));
+    params.Screen[2]     = static_cast<float>(ClusterSlices) / span;
+    params.Screen[3]     = -static_cast<float>(ClusterSlices) * std::log(near) / span;
+    params.Grid[0]       = ClusterTilesX;
+    params.Grid[1]       = ClusterTilesY;
+    params.Grid[2]       = ClusterSlices;
+    params.Grid[3]       = m_PerCluster;
+    params.LightCount    = kept;
+    std::memcpy(mapped, &params, sizeof(params));
+
+    const ClusterReadback cleared{};
+    std::memcpy(mapped + m_StatsOffset, &cleared, sizeof(cleared));
+
+    slot.Lights  = kept;
+    slot.Dropped = count - kept;
+    slot.Updated = true;
+}
+
+const pipeline::Pipeline* ClusteredLighting::GetPipeline() SRK_NOEXCEPT
+{
+    pipeline::PipelineDesc desc;
+    desc.Shaders[0]  = m_Shaders.Get("LightCull.comp");
+    desc.ShaderCount = 1;
+    if (!desc.Shaders[0])
+        return nullptr;
+
+    return m_Pipelines.Get(desc);
+}
+
+bool ClusteredLighting::Record(const Frame& frame) SRK_NOEXCEPT
+{
+    Slot& slot = m_Slots[frame.Index];
+    if (!m_Valid || frame.CommandBuffer == VK_NULL_HANDLE)
+        return false;
+
+    VkCommandBuffer           cmd      = frame.CommandBuffer;
+    const pipeline::Pipeline* pipeline = slot.Updated ? GetPipeline() : nullptr;
+
+    VkDescriptorSet set{VK_NULL_HANDLE};
+    if (pipeline)
+    {
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool     = slot.Descriptors;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts        = &pipeline->Layout->SetLayouts[0];
+
+        VkResult result = vkAllocateDescriptorSets(m_Device, &allocateInfo, &set);
+        if (result != VK_SUCCESS)
+        {
+            SRK_CORE_ERROR("Clustered lighting descriptors could not be allocated with {}", result);
+            pipeline = nullptr;
+        }
+    }
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+    // nothing to bin with, empty clusters shade with the ambient term alone rather than garbage
+    if (!pipeline)
+    {
+        vkCmdFillBuffer(cmd, slot.Clusters.Buffer, 0, VkDeviceSize{ClusterCount} * sizeof(uint32_t), 0);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        return false;
+    }
+
+    const std::array<VkDescriptorBufferInfo, 4> shading = GetShadingBuffers(frame.Index);
+    const VkDescriptorBufferInfo                stats{slot.Upload.Buffer, m_StatsOffset, sizeof(ClusterReadback)};
+
+    std::array<VkWriteDescriptorSet, 5> writes{};
+    for (uint32_t binding{}; binding < writes.size(); ++binding)
+    {
+        writes[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet          = set;
+        writes[binding].dstBinding      = binding;
+        writes[binding].descriptorCount = 1;
+        writes[binding].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[binding].pBufferInfo     = binding < shading.size() ? &shading[binding] : &stats;
+    }
+    vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->Handle);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->Layout->Layout, 0, 1, &set, 0, nullptr);
+    vkCmdDispatch(cmd, (ClusterCount + cullGroupSize - 1) / cullGroupSize, 1, 1);
+
+    // the frame's fragment shaders read the clusters, BeginFrame reads the stats once the fence signaled
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+
+    slot.Binned = true;
+    return true;
+}
+
+std::array<VkDescriptorBufferInfo, 4> ClusteredLighting::GetShadingBuffers(uint32_t frameIndex) const SRK_NOEXCEPT
+{
+    const Slot& slot = m_Slots[frameIndex];
+
+    std::array<VkDescriptorBufferInfo, 4> buffers{};
+    buffers[0] = {slot.Upload.Buffer, 0, sizeof(ClusterParams)};
+    buffers[1] = {slot.Upload.Buffer, m_LightsOffset, VkDeviceSize{std::max(m_MaxLights, 1u)} * sizeof(PointLight)};
+    buffers[2] = {slot.Clusters.Buffer, 0, VkDeviceSize{ClusterCount} * sizeof(uint32_t)};
+    buffers[3] = {slot.Clusters.Buffer, m_IndicesOffset, VkDeviceSize{ClusterCount} * m_PerCluster * sizeof(uint32_t)};
+    return buffers;
+}
+
+} // namespace shrek::render
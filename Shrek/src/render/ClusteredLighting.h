@@ -0,0 +1,112 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "FrameContext.h"
+#include "base/math/Mat.h"
+#include "base/math/Vec.h"
+#include "helper/Memory.h"
+#include "pipeline/PipelineCache.h"
+#include "pipeline/ShaderLibrary.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace shrek::render {
+
+// the froxel grid, tiles across the render extent and exponential slices between the near and far plane
+constexpr uint32_t ClusterTilesX = 16;
+constexpr uint32_t ClusterTilesY = 9;
+constexpr uint32_t ClusterSlices = 24;
+constexpr uint32_t ClusterCount  = ClusterTilesX * ClusterTilesY * ClusterSlices;
+
+struct PointLight
+{
+    math::Vec3 Position; // world space
+    float      Radius{1.f};
+    math::Vec3 Color{1.f, 1.f, 1.f};
+    float      Intensity{1.f};
+};
+
+static_assert(sizeof(PointLight) == 32, "PointLight is uploaded as is and has to match the shader side layout");
+
+// the camera the lights are binned for, the same one the frame is shaded with
+struct ClusterCamera
+{
+    math::Mat4 View;
+    math::Mat4 Projection; // from math::Mat4::Perspective
+    float      Near{0.1f};
+    float      Far{1000.f};
+    VkExtent2D Extent{0, 0}; // what the scene renders at, DynamicResolution::GetRenderExtent
+};
+
+struct ClusterStats
+{
+    uint32_t Lights{0};     // uploaded, after the ones outside the view were dropped
+    uint32_t Dropped{0};    // outside the view or past maxLights
+    uint32_t Overflowed{0}; // light and cluster pairs that didn't fit render.lights.per_cluster
+    uint32_t Busiest{0};    // most lights that touched a single cluster
+};
+
+/*
+ *  Clustered forward lighting. Every frame Update uploads the point lights in view space, Record bins them
+ *  into a froxel grid on the gpu (LightCull.comp) and the fragment shaders of the frame look up their cluster
+ *  and only go over the lights in it (ClusteredForward.frag), so shading costs as many lights as are nearby
+ *  instead of all of them. Lights whose sphere is entirely outside the view are dropped on the cpu.
+ *  Everything lives in a buffer per frame in flight, a cluster has room for render.lights.per_cluster lights.
+ */
+class ClusteredLighting
+{
+public:
+    ClusteredLighting(VkPhysicalDevice gpu, VkDevice device, pipeline::ShaderLibrary& shaders, pipeline::PipelineCache& pipelines,
+                      uint32_t maxLights) SRK_NOEXCEPT;
+    ~ClusteredLighting() SRK_NOEXCEPT;
+
+    ClusteredLighting(const ClusteredLighting& other) = delete;
+    ClusteredLighting& operator=(const ClusteredLighting& other) = delete;
+
+    // after FrameContext::BeginFrame, reads back how full the clusters of the frame that last used the slot got
+    void BeginFrame(const Frame& frame) SRK_NOEXCEPT;
+
+    void Update(const Frame& frame, const PointLight* lights, uint32_t count, const ClusterCamera& camera) SRK_NOEXCEPT;
+    // outside a render pass and before anything shades with the clusters. false when the binning pipeline
+    // isn't compiled yet, every cluster is empty then
+    bool Record(const Frame& frame) SRK_NOEXCEPT;
+
+    // params, lights, counts and indices, bindings 0 to 3 of ClusteredForward.frag's set 1
+    std::array<VkDescriptorBufferInfo, 4> GetShadingBuffers(uint32_t frameIndex) const SRK_NOEXCEPT;
+
+    bool                IsValid() const SRK_NOEXCEPT { return m_Valid; }
+    const ClusterStats& GetStats() const SRK_NOEXCEPT { return m_Stats; }
+
+private:
+    struct Slot
+    {
+        helper::BufferAllocation Upload;   // host visible: params, lights and the stats the binning writes back
+        helper::BufferAllocation Clusters; // device local: counts and indices
+        VkDescriptorPool         Descriptors{VK_NULL_HANDLE};
+        uint32_t                 Lights{0};
+        uint32_t                 Dropped{0};
+        bool                     Updated{false};
+        bool                     Binned{false};
+    };
+
+    const pipeline::Pipeline* GetPipeline() SRK_NOEXCEPT;
+
+private:
+    VkDevice                 m_Device;
+    pipeline::ShaderLibrary& m_Shaders;
+    pipeline::PipelineCache& m_Pipelines;
+    uint32_t                 m_MaxLights;
+    uint32_t                 m_PerCluster;
+    bool                     m_Valid;
+
+    // offsets into every slot's buffers, each aligned for binding as a storage buffer
+    VkDeviceSize      m_LightsOffset;
+    VkDeviceSize      m_StatsOffset;
+    VkDeviceSize      m_IndicesOffset;
+    std::vector<Slot> m_Slots;
+    ClusterStats      m_Stats;
+};
+
+} // namespace shrek::render
@@ -0,0 +1,185 @@
+#include "pch.h"
+#include "DynamicResolution.h"
+
+#include "base/Config.h"
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace shrek::render {
+
+namespace {
+
+base::ConfigVar<bool>    enableDynamicResolution{"render.dynres.enabled", true, "scale the scene's resolution to hold render.dynres.target_ms"};
+base::ConfigVar<float>   targetMs{"render.dynres.target_ms", 16.6f, "gpu time a frame should take"};
+base::ConfigVar<float>   minScale{"render.dynres.min_scale", 0.5f, "smallest fraction of the output's width and height the scene renders at"};
+base::ConfigVar<float>   maxScale{"render.dynres.max_scale", 1.f, "largest fraction of the output's width and height the scene renders at"};
+base::ConfigVar<float>   hysteresis{"render.dynres.hysteresis", 0.1f, "fraction of the target the frame time has to be off by before the scale moves"};
+base::ConfigVar<int32_t> settleFrames{"render.dynres.settle_frames", 15, "frames a new scale is measured for before it may move again"};
+
+// of the new frame time in the smoothed one, low enough that a single spike doesn't move the scale
+constexpr double smoothing = 0.1;
+
+// changes smaller than this are not worth the blurrier or sharper frame flickering in
+constexpr float minStep = 0.02f;
+
+// render extents stay multiples of this so compute passes over them don't end in sliver groups
+constexpr uint32_t extentAlignment = 8;
+
+float clampScale(float scale) SRK_NOEXCEPT
+{
+    const float high = std::clamp(maxScale.Get(), 0.1f, 1.f);
+    const float low  = std::clamp(minScale.Get(), 0.1f, high);
+    return std::clamp(scale, low, high);
+}
+
+uint32_t scaleDimension(uint32_t dimension, float scale) SRK_NOEXCEPT
+{
+    const uint32_t scaled  = static_cast<uint32_t>(static_cast<float>(dimension) * scale);
+    const uint32_t aligned = (scaled + extentAlignment - 1) / extentAlignment * extentAlignment;
+    return std::clamp(aligned, 1u, std::max(dimension, 1u));
+}
+
+} // namespace
+
+DynamicResolution::DynamicResolution(VkPhysicalDevice gpu, VkDevice device, uint32_t queueFamily) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Slots(GetFramesInFlight()),
+    m_NanosecondsPerTick(0.0),
+    m_SinceChange(0),
+    m_Stats()
+{
+    m_Stats.Scale = clampScale(1.f);
+    if (!enableDynamicResolution)
+        return;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(gpu, &properties);
+
+    uint32_t familyCount{0};
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, families.data());
+
+    if (queueFamily >= familyCount || families[queueFamily].timestampValidBits == 0 || properties.limits.timestampPeriod <= 0.f)
+    {
+        SRK_CORE_WARN("No gpu timestamps on the graphics queue, dynamic resolution stays at a scale of {}", m_Stats.Scale);
+        return;
+    }
+
+    VkQueryPoolCreateInfo queryInfo{};
+    queryInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    queryInfo.queryCount = 2;
+
+    for (Slot& slot : m_Slots)
+    {
+        VkResult result = vkCreateQueryPool(m_Device, &queryInfo, nullptr, &slot.Timestamps);
+        if (result != VK_SUCCESS)
+        {
+            SRK_CORE_ERROR("Dynamic resolution timestamps could not be created with {}", result);
+            slot.Timestamps = VK_NULL_HANDLE;
+            return;
+        }
+    }
+
+    m_NanosecondsPerTick = properties.limits.timestampPeriod;
+}
+
+DynamicResolution::~DynamicResolution() SRK_NOEXCEPT
+{
+    // FrameContext is gone by now, nothing is still writing the queries
+    for (Slot& slot : m_Slots)
+    {
+        if (slot.Timestamps != VK_NULL_HANDLE)
+            vkDestroyQueryPool(m_Device, slot.Timestamps, nullptr);
+    }
+}
+
+void DynamicResolution::BeginFrame(const Frame& frame) SRK_NOEXCEPT
+{
+    if (!IsEnabled())
+        return;
+
+    Slot& slot = m_Slots[frame.Index];
+    if (slot.Written)
+    {
+        // the slot's fence was waited on, the results are there without waiting
+        uint64_t ticks[2]{};
+        if (vkGetQueryPoolResults(m_Device, slot.Timestamps, 0, 2, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+            Control(static_cast<double>(ticks[1] - ticks[0]) * m_NanosecondsPerTick / 1e6);
+    }
+
+    slot.Written = false;
+    if (frame.CommandBuffer == VK_NULL_HANDLE)
+        return;
+
+    vkCmdResetQueryPool(frame.CommandBuffer, slot.Timestamps, 0, 2);
+    vkCmdWriteTimestamp(frame.CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.Timestamps, 0);
+}
+
+void DynamicResolution::EndFrame(const Frame& frame) SRK_NOEXCEPT
+{
+    if (!IsEnabled() || frame.CommandBuffer == VK_NULL_HANDLE)
+        return;
+
+    Slot& slot = m_Slots[frame.Index];
+    vkCmdWriteTimestamp(frame.CommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot.Timestamps, 1);
+    slot.Written = true;
+}
+
+void DynamicResolution::Control(double gpuMs) SRK_NOEXCEPT
+{
+    m_Stats.GpuMs      = gpuMs;
+    m_Stats.SmoothedMs = m_Stats.SmoothedMs == 0.0 ? gpuMs : m_Stats.SmoothedMs + (gpuMs - m_Stats.SmoothedMs) * smoothing;
+
+    // the frames right after a change still carry the old scale in the smoothed time
+    if (++m_SinceChange < static_cast<uint32_t>(std::max<int32_t>(settleFrames, 1)))
+        return;
+
+    // inside the band nothing moves, which is what keeps it from going back and forth around the target
+    const double target = std::max(static_cast<double>(targetMs.Get()), 0.1);
+    const double band   = target * std::clamp(static_cast<double>(hysteresis.Get()), 0.0, 0.9);
+    if (m_Stats.SmoothedMs <= target + band && m_Stats.SmoothedMs >= target - band)
+        return;
+
+    // the time goes with the pixel count and that with the square of the scale
+    const float wanted = clampScale(m_Stats.Scale * static_cast<float>(std::sqrt(target / m_Stats.SmoothedMs)));
+    if (std::abs(wanted - m_Stats.Scale) < minStep)
+        return;
+
+    SRK_CORE_TRACE("Render scale {:.2f} -> {:.2f} at {:.2f}ms of {:.2f}ms", m_Stats.Scale, wanted, m_Stats.SmoothedMs, target);
+    m_Stats.Scale = wanted;
+    m_SinceChange = 0;
+    ++m_Stats.Changes;
+}
+
+VkExtent2D DynamicResolution::GetTargetExtent(VkExtent2D output) const SRK_NOEXCEPT
+{
+    const float scale = clampScale(1.f);
+    return {scaleDimension(output.width, scale), scaleDimension(output.height, scale)};
+}
+
+VkExtent2D DynamicResolution::GetRenderExtent(VkExtent2D output) const SRK_NOEXCEPT
+{
+    // the config may have moved under the current scale
+    const float scale = clampScale(m_Stats.Scale);
+    return {scaleDimension(output.width, scale), scaleDimension(output.height, scale)};
+}
+
+void DynamicResolution::Upscale(VkCommandBuffer cmd, VkImage target, VkExtent2D rendered, VkExtent2D output, VkImage outputImage) const SRK_NOEXCEPT
+{
+    VkImageBlit blit{};
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.layerCount = 1;
+    blit.srcOffsets[1]             = {static_cast<int32_t>(rendered.width), static_cast<int32_t>(rendered.height), 1};
+    blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.dstSubresource.layerCount = 1;
+    blit.dstOffsets[1]             = {static_cast<int32_t>(output.width), static_cast<int32_t>(output.height), 1};
+
+    vkCmdBlitImage(cmd, target, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, outputImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+}
+
+} // namespace shrek::render
@@ -0,0 +1,72 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "FrameContext.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace shrek::render {
+
+struct ResolutionStats
+{
+    float    Scale{1.f};      // of the output's width and height
+    double   GpuMs{0.0};      // of the last frame read back
+    double   SmoothedMs{0.0}; // what the controller goes by
+    uint64_t Changes{0};      // times the scale moved since startup
+};
+
+/*
+ *  Scales the resolution the scene renders at so the gpu frame time stays around render.dynres.target_ms.
+ *  The graphics command buffer of every frame is timestamped, the times are smoothed and the scale only moves
+ *  once they leave a band around the target and the last change has had a few frames to show up, otherwise
+ *  it chases its own noise. The scene renders into a target sized for the largest scale (GetTargetExtent)
+ *  with the viewport of the current one (GetRenderExtent), Upscale stretches that corner over the output.
+ *  Without timestamps the scale stays at its maximum.
+ */
+class DynamicResolution
+{
+public:
+    DynamicResolution(VkPhysicalDevice gpu, VkDevice device, uint32_t queueFamily) SRK_NOEXCEPT;
+    ~DynamicResolution() SRK_NOEXCEPT;
+
+    DynamicResolution(const DynamicResolution& other) = delete;
+    DynamicResolution& operator=(const DynamicResolution& other) = delete;
+
+    // right after FrameContext::BeginFrame, the frame that last used the slot is done so its time is read back
+    // and the scale updated before anything this frame is recorded with it
+    void BeginFrame(const Frame& frame) SRK_NOEXCEPT;
+    // the last thing recorded into the frame's command buffer
+    void EndFrame(const Frame& frame) SRK_NOEXCEPT;
+
+    // output is the swapchain extent, the target never has to be reallocated as the scale moves
+    VkExtent2D GetTargetExtent(VkExtent2D output) const SRK_NOEXCEPT;
+    VkExtent2D GetRenderExtent(VkExtent2D output) const SRK_NOEXCEPT;
+
+    // stretches the rendered corner of target over all of output with a linear filter. rendered is what
+    // GetRenderExtent was when target was drawn, which isn't this frame's for work that lags a frame behind.
+    // target has to be in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL and output in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    void Upscale(VkCommandBuffer cmd, VkImage target, VkExtent2D rendered, VkExtent2D output, VkImage outputImage) const SRK_NOEXCEPT;
+
+    bool                   IsEnabled() const SRK_NOEXCEPT { return m_NanosecondsPerTick > 0.0; }
+    float                  GetScale() const SRK_NOEXCEPT { return m_Stats.Scale; }
+    const ResolutionStats& GetStats() const SRK_NOEXCEPT { return m_Stats; }
+
+private:
+    struct Slot
+    {
+        VkQueryPool Timestamps{VK_NULL_HANDLE};
+        bool        Written{false}; // both timestamps were recorded by the frame that last used it
+    };
+
+    void Control(double gpuMs) SRK_NOEXCEPT;
+
+private:
+    VkDevice          m_Device;
+    std::vector<Slot> m_Slots;
+    double            m_NanosecondsPerTick; // 0 without timestamps on the queue
+    uint32_t          m_SinceChange;        // frames measured since the scale last moved
+    ResolutionStats   m_Stats;
+};
+
+} // namespace shrek::render
@@ -2,9 +2,10 @@
 #include "Engine.h"
 #include "vulkan_core.h"
 #include "helper/Debug.h"
+#include "base/Arena.h"
+#include "base/Config.h"
 #include "platform/Log.h"
 
-#include <GLFW/glfw3native.h>
 #include <GLFW/glfw3.h>
 
 namespace shrek::render {
@@ -36,10 +37,18 @@ struct QueueFamilyIndicesHelper
     }
 };
 
-constexpr bool        shouldPrintExtensions  = false;
-constexpr bool        enableValidationLayers = true;
-constexpr bool        shouldPrintDebugLogs   = true;
-constexpr const char* debugUtilsExtName      = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+#ifndef SRK_DIST
+constexpr bool validationByDefault = true;
+#else
+constexpr bool validationByDefault = false; // shipped builds only validate when asked to
+#endif
+
+base::ConfigVar<bool> shouldPrintExtensions{"render.print_extensions", false, "log every instance extension on startup"};
+base::ConfigVar<bool> enableValidationLayers{"render.validation", validationByDefault, "khronos validation layer and the debug messenger"};
+base::ConfigVar<bool> shouldPrintDebugLogs{"render.debug_logs", true, "trace gpu selection"};
+base::ConfigVar<bool> enableAsyncCompute{"render.async_compute", true, "use a compute only queue family when the gpu has one, compute passes run on the graphics queue otherwise"};
+
+constexpr const char* debugUtilsExtName = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
 
 constexpr std::array<const char*, 1> validationLayers = {
     "VK_LAYER_KHRONOS_validation"};
@@ -85,7 +94,7 @@ VkApplicationInfo createAppInfo() SRK_NOEXCEPT
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName        = "Shrek Engine";
         appInfo.engineVersion      = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion         = VK_API_VERSION_1_0; // following Vulkan tutorial
+        appInfo.apiVersion         = VK_API_VERSION_1_1; // vkGetPhysicalDeviceMemoryProperties2 for the memory budget
         appInfo.pNext              = NULL;               // caught this with validation layers
     }
     return appInfo;
@@ -96,8 +105,9 @@ bool validateSupportOnLayers(const char** glfwExtensions, uint32_t glfwExtension
     uint32_t extensionCount{};
     vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
 
-    // a vector here doesn't slow down the process as much because we don't need 60hz loading
-    std::vector<VkExtensionProperties> extensions(extensionCount);
+    // scratch memory so enumerating stays off the heap
+    base::ScratchScope                      scratch;
+    std::pmr::vector<VkExtensionProperties> extensions(extensionCount, scratch.Resource());
     vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
 
     if (shouldPrintExtensions)
@@ -146,7 +156,8 @@ bool checkValidationLayerSupport() SRK_NOEXCEPT
     uint32_t layerCount{};
     vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
 
-    std::vector<VkLayerProperties> layerProps(layerCount);
+    base::ScratchScope                  scratch;
+    std::pmr::vector<VkLayerProperties> layerProps(layerCount, scratch.Resource());
     vkEnumerateInstanceLayerProperties(&layerCount, layerProps.data());
 
     for (const auto& layerName : validationLayers)
@@ -162,7 +173,8 @@ bool checkValidationLayerSupport() SRK_NOEXCEPT
 }
 
 
-std::vector<const char*> getRequiredExtensions() SRK_NOEXCEPT
+// allocated from the caller's scratch scope
+std::pmr::vector<const char*> getRequiredExtensions(std::pmr::memory_resource* resource) SRK_NOEXCEPT
 {
     uint32_t     glfwExtensionCount{};
     const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
@@ -173,7 +185,7 @@ std::vector<const char*> getRequiredExtensions() SRK_NOEXCEPT
         std::exit(-1);
     }
 
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::pmr::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount, resource);
     if (enableValidationLayers)
     {
         extensions.emplace_back(debugUtilsExtName);
@@ -240,12 +252,13 @@ int32_t scorePhysicalDevice(VkPhysicalDevice device) SRK_NOEXCEPT
     return score;
 }
 
-QueueFamilyIndicesHelper findQueueFamilies(VkPhysicalDevice device) SRK_NOEXCEPT
+QueueFamilyIndicesHelper findQueueFamilies(VkInstance instance, VkPhysicalDevice device) SRK_NOEXCEPT
 {
     uint32_t queueFamilyCount{};
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
 
-    std::vector<VkQueueFamilyProperties> queueFamilyProps{queueFamilyCount};
+    base::ScratchScope                        scratch;
+    std::pmr::vector<VkQueueFamilyProperties> queueFamilyProps(queueFamilyCount, scratch.Resource());
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilyProps.data());
 
     QueueFamilyIndicesHelper indices{};
@@ -255,20 +268,28 @@ QueueFamilyIndicesHelper findQueueFamilies(VkPhysicalDevice device) SRK_NOEXCEPT
         if ((queueFamilyProp.queueFlags & VK_QUEUE_GRAPHICS_BIT) == VK_QUEUE_GRAPHICS_BIT)
         {
             indices.Graphics = idx;
-            if (vkGetPhysicalDeviceWin32PresentationSupportKHR(device, idx) == 0)
+            // glfw asks whichever of win32, x11 or wayland it runs on. only a hint, there's no surface yet to
+            // ask vkGetPhysicalDeviceSurfaceSupportKHR, render::Surface does that once the window has one
+            if (glfwGetPhysicalDevicePresentationSupport(instance, device, idx) == GLFW_FALSE)
                 SRK_CORE_WARN("idx doesn't support presentation but support graphics, {}", idx);
         }
+
+        // a family without graphics is usually its own hardware queue, what's submitted there overlaps the graphics work
+        const bool computeOnly = (queueFamilyProp.queueFlags & (VK_QUEUE_COMPUTE_BIT | VK_QUEUE_GRAPHICS_BIT)) == VK_QUEUE_COMPUTE_BIT;
+        if (computeOnly && enableAsyncCompute && !indices.Compute.has_value())
+            indices.Compute = idx;
         ++idx;
     }
     return indices;
 }
 
-bool isDeviceSuitable(VkPhysicalDevice device) SRK_NOEXCEPT
+bool isDeviceSuitable(VkInstance instance, VkPhysicalDevice device) SRK_NOEXCEPT
 {
     // check for extension support
     uint32_t extensionCount{};
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
-    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    base::ScratchScope                      scratch;
+    std::pmr::vector<VkExtensionProperties> availableExtensions(extensionCount, scratch.Resource());
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
     for (const auto& deviceExtension : deviceExtensions)
@@ -290,17 +311,40 @@ bool isDeviceSuitable(VkPhysicalDevice device) SRK_NOEXCEPT
         }
     }
 
-    QueueFamilyIndicesHelper indices = findQueueFamilies(device);
+    QueueFamilyIndicesHelper indices = findQueueFamilies(instance, device);
     return indices.Graphics.has_value();
 }
 
+// VK_EXT_memory_budget is queried through vkGetPhysicalDeviceMemoryProperties2 so the device has to be 1.1 as well
+bool supportsMemoryBudget(VkPhysicalDevice device) SRK_NOEXCEPT
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_1)
+        return false;
+
+    uint32_t extensionCount{};
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    base::ScratchScope                      scratch;
+    std::pmr::vector<VkExtensionProperties> availableExtensions(extensionCount, scratch.Resource());
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto& availableExtension : availableExtensions)
+    {
+        if (strcmp(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, availableExtension.extensionName) == 0)
+            return true;
+    }
+    return false;
+}
+
 
 VkPhysicalDevice pickPhysicalDevice(VkInstance instance) SRK_NOEXCEPT
 {
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
 
-    std::vector<VkPhysicalDevice> devices(deviceCount);
+    base::ScratchScope                 scratch;
+    std::pmr::vector<VkPhysicalDevice> devices(deviceCount, scratch.Resource());
     vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
 
     size_t  idx{}, highestScoreIdx{};
@@ -312,7 +356,7 @@ VkPhysicalDevice pickPhysicalDevice(VkInstance instance) SRK_NOEXCEPT
     bool foundSuitableDevice = false;
     for (const auto device : devices)
     {
-        if (isDeviceSuitable(device))
+        if (isDeviceSuitable(instance, device))
         {
             int32_t score = scorePhysicalDevice(device);
             if (score > highestScore)
@@ -348,28 +392,49 @@ VkPhysicalDevice pickPhysicalDevice(VkInstance instance) SRK_NOEXCEPT
     return VK_NULL_HANDLE;
 }
 
-VkResult createDevice(VkPhysicalDevice physicalDevice, QueueFamilyIndices indices, VkDevice& device) SRK_NOEXCEPT
+VkResult createDevice(VkPhysicalDevice physicalDevice, QueueFamilyIndices indices, bool memoryBudget, VkDevice& device) SRK_NOEXCEPT
 {
-    VkDeviceQueueCreateInfo queueCreateInfo{};
-    const float             queuePriorities{1.f};
+    std::array<VkDeviceQueueCreateInfo, 2> queueCreateInfos{};
+    uint32_t                               queueCreateInfoCount{1};
+    const float                            queuePriorities{1.f};
 
-    queueCreateInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queueCreateInfo.queueFamilyIndex = indices.Graphics;
-    queueCreateInfo.queueCount       = 1;
-    queueCreateInfo.pQueuePriorities = &queuePriorities;
+    queueCreateInfos[0].sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueCreateInfos[0].queueFamilyIndex = indices.Graphics;
+    queueCreateInfos[0].queueCount       = 1;
+    queueCreateInfos[0].pQueuePriorities = &queuePriorities;
+
+    if (indices.Compute.has_value())
+    {
+        queueCreateInfos[1]                  = queueCreateInfos[0];
+        queueCreateInfos[1].queueFamilyIndex = indices.Compute.value();
+        ++queueCreateInfoCount;
+    }
 
     // HACK: only leaving it as it is for now because we haven't found what to do with it.
     VkPhysicalDeviceFeatures features{};
 
+    // the scene's fragment shader writes texture streaming feedback, without it the streamer never sees a mip wanted
+    VkPhysicalDeviceFeatures supported{};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supported);
+    features.fragmentStoresAndAtomics = supported.fragmentStoresAndAtomics;
+    if (!supported.fragmentStoresAndAtomics)
+        SRK_CORE_ERROR("The gpu has no fragmentStoresAndAtomics, the scene's fragment shader can't write its texture feedback on it");
+
     VkDeviceCreateInfo createInfo{};
     createInfo.sType                = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    createInfo.pQueueCreateInfos    = &queueCreateInfo;
-    createInfo.queueCreateInfoCount = 1;
+    createInfo.pQueueCreateInfos    = queueCreateInfos.data();
+    createInfo.queueCreateInfoCount = queueCreateInfoCount;
     createInfo.pEnabledFeatures     = &features;
     createInfo.pNext                = nullptr;
 
-    createInfo.enabledExtensionCount   = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    // the required ones and whichever optional ones the gpu has
+    base::ScratchScope            scratch;
+    std::pmr::vector<const char*> extensions(deviceExtensions.begin(), deviceExtensions.end(), scratch.Resource());
+    if (memoryBudget)
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    createInfo.enabledExtensionCount   = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     if (enableValidationLayers)
     {
@@ -386,6 +451,7 @@ VkResult createDevice(VkPhysicalDevice physicalDevice, QueueFamilyIndices indice
 
 VkResult createInstance(VkInstance& instance) SRK_NOEXCEPT
 {
+    base::ScratchScope                 scratch;
     VkApplicationInfo                  appInfo{createAppInfo()};
     VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{populateDebugUtilsMessengerInfo()};
 
@@ -393,7 +459,7 @@ VkResult createInstance(VkInstance& instance) SRK_NOEXCEPT
     createInfo.sType            = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo = &appInfo;
 
-    const auto glfwExtensions          = getRequiredExtensions();
+    const auto glfwExtensions          = getRequiredExtensions(scratch.Resource());
     createInfo.enabledExtensionCount   = static_cast<uint32_t>(glfwExtensions.size());
     createInfo.ppEnabledExtensionNames = glfwExtensions.data();
     createInfo.pNext                   = enableValidationLayers ? &debugCreateInfo : nullptr;
@@ -425,7 +491,15 @@ Engine::Engine() SRK_NOEXCEPT :
     m_Instance(),
     m_Gpu(),
     m_LGpu(),
-    m_DebugHandler()
+    m_DebugHandler(),
+    m_QueueFamily(),
+    m_Queue(),
+    m_ComputeQueue(),
+    m_MemoryBudget(false)
+{
+}
+
+void Engine::CreateInstance() SRK_NOEXCEPT
 {
     int isVulkanSupported = glfwVulkanSupported();
     if (isVulkanSupported != GLFW_TRUE)
@@ -446,12 +520,19 @@ Engine::Engine() SRK_NOEXCEPT :
     // if validate warning is inside the debug messenger
     if (enableValidationLayers)
         m_DebugHandler = setUpDebugMessenger(m_Instance);
+}
 
+void Engine::CreateDevice() SRK_NOEXCEPT
+{
     m_Gpu = pickPhysicalDevice(m_Instance);
     // only when physical device is found can we look for the queue families
-    m_QueueFamily = findQueueFamilies(m_Gpu);
+    m_QueueFamily = findQueueFamilies(m_Instance, m_Gpu);
+
+    m_MemoryBudget = supportsMemoryBudget(m_Gpu);
+    if (!m_MemoryBudget)
+        SRK_CORE_WARN("VK_EXT_memory_budget is not supported, the memory budget is estimated from the heap sizes");
 
-    result = createDevice(m_Gpu, m_QueueFamily, m_LGpu);
+    VkResult result = createDevice(m_Gpu, m_QueueFamily, m_MemoryBudget, m_LGpu);
     if (result != VK_SUCCESS)
     {
         SRK_CORE_CRITICAL("Device cannot be created with error: {}", result);
@@ -459,16 +540,22 @@ Engine::Engine() SRK_NOEXCEPT :
     }
 
     vkGetDeviceQueue(m_LGpu, m_QueueFamily.Graphics, 0, &m_Queue);
+    if (m_QueueFamily.Compute.has_value())
+        vkGetDeviceQueue(m_LGpu, m_QueueFamily.Compute.value(), 0, &m_ComputeQueue);
+    else
+        SRK_CORE_WARN("No compute only queue family, compute passes share the graphics queue");
 }
 
 Engine::~Engine() SRK_NOEXCEPT
 {
-    vkDestroyDevice(m_LGpu, nullptr);
+    if (m_LGpu != VK_NULL_HANDLE)
+        vkDestroyDevice(m_LGpu, nullptr);
     // destroy in reverse order
     if (enableValidationLayers && m_DebugHandler != VK_NULL_HANDLE)
         DestroyDebugUtilsMessengerEXT(m_Instance, m_DebugHandler, nullptr);
 
-    vkDestroyInstance(m_Instance, nullptr);
+    if (m_Instance != VK_NULL_HANDLE)
+        vkDestroyInstance(m_Instance, nullptr);
 }
 
 } // namespace shrek::render
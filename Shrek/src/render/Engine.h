@@ -9,6 +9,11 @@
 namespace shrek::render {
 
 
+/*
+ *  Brought up in steps so the slow parts of startup can overlap with the rest: the constructor does nothing,
+ *  CreateInstance and then CreateDevice (which picks the gpu) can run on any thread, glfw only needs to be initialised.
+ *  Nothing is valid before CreateDevice has returned.
+ */
 class Engine : private base::Singleton<Engine>
 {
 public:
@@ -21,11 +26,17 @@ public:
     Engine(Engine&& other) SRK_NOEXCEPT                 = delete;
     Engine& operator=(Engine&& other) SRK_NOEXCEPT = delete;
 
+    void CreateInstance() SRK_NOEXCEPT;
+    void CreateDevice() SRK_NOEXCEPT;
+
     // Vulkan API
     inline VkInstance                        GetInstance() const SRK_NOEXCEPT { return m_Instance; };
     inline VkPhysicalDevice                  GetGpu() const SRK_NOEXCEPT { return m_Gpu; };
     inline VkDevice                          GetLogicalGpu() const SRK_NOEXCEPT { return m_LGpu; };
     inline const helper::QueueFamilyIndices& GetQueueFamilyIndices() const SRK_NOEXCEPT { return m_QueueFamily; }
+    inline VkQueue                           GetQueue() const SRK_NOEXCEPT { return m_Queue; }
+    inline VkQueue                           GetComputeQueue() const SRK_NOEXCEPT { return m_ComputeQueue; } // null without a compute only family
+    inline bool                              HasMemoryBudget() const SRK_NOEXCEPT { return m_MemoryBudget; } // VK_EXT_memory_budget is enabled
 
 private:
     VkInstance               m_Instance;
@@ -35,5 +46,7 @@ private:
 
     helper::QueueFamilyIndices m_QueueFamily;
     VkQueue                    m_Queue;
+    VkQueue                    m_ComputeQueue;
+    bool                       m_MemoryBudget;
 };
 } // namespace shrek::render
@@ -0,0 +1,355 @@
+#include "pch.h"
+#include "FrameCapture.h"
+
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+
+namespace shrek::render {
+
+namespace {
+
+constexpr VkDeviceSize bytesPerPixel = 4;
+
+// 8 bit four channel formats only, anything else would need a conversion per format on the writer
+bool capturable(VkFormat format, bool& swapRedBlue) SRK_NOEXCEPT
+{
+    switch (format)
+    {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            swapRedBlue = false;
+            return true;
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            swapRedBlue = true;
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+std::string_view ToString(CaptureFormat format) SRK_NOEXCEPT
+{
+#define TO_STRING(X)       \
+    case CaptureFormat::X: \
+        return #X
+    switch (format)
+    {
+        TO_STRING(Png);
+        TO_STRING(Y4m);
+        default:
+            return "UNKNOWN";
+    }
+#undef TO_STRING
+}
+
+FrameCapture::FrameCapture(VkPhysicalDevice gpu, VkDevice device, CaptureSettings settings) SRK_NOEXCEPT :
+    m_Gpu(gpu),
+    m_Device(device),
+    m_Settings(std::move(settings)),
+    m_Valid(true),
+    m_Slots(std::max(m_Settings.SlotCount, 1u)),
+    m_Recorded(),
+    m_Captured(0),
+    m_Mutex(),
+    m_Wake(),
+    m_Free(),
+    m_Queued(),
+    m_RequiredSize(VkDeviceSize{m_Settings.Extent.width} * m_Settings.Extent.height * bytesPerPixel),
+    m_Running(true),
+    m_Pixels(),
+    m_Video(),
+    m_Written(0),
+    m_Dropped(0),
+    m_Writer()
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_Settings.Directory, error);
+    if (error)
+    {
+        SRK_CORE_ERROR("Capture directory {} could not be created: {}", m_Settings.Directory, error.message());
+        m_Valid = false;
+        return;
+    }
+
+    for (uint32_t idx{}; idx < m_Slots.size(); ++idx)
+    {
+        // unsignaled, the only thing that signals it is the submit behind a copy
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        VkResult result = vkCreateFence(m_Device, &fenceInfo, nullptr, &m_Slots[idx].Fence);
+        if (result == VK_SUCCESS)
+            result = CreateReadback(m_Slots[idx], m_RequiredSize.load(std::memory_order_relaxed));
+
+        if (result != VK_SUCCESS)
+        {
+            SRK_CORE_ERROR("Capture readback buffers could not be created with {}", result);
+            m_Valid = false;
+            return;
+        }
+
+        m_Free.push_back(idx);
+    }
+
+    m_Recorded.reserve(m_Slots.size());
+    m_Writer = std::thread(&FrameCapture::WriterLoop, this);
+    SRK_CORE_INFO("Capturing frames as {} into {}", ToString(m_Settings.Format), m_Settings.Directory);
+}
+
+FrameCapture::~FrameCapture() SRK_NOEXCEPT
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Wake.notify_one();
+
+    // the writer finishes everything that was submitted before it stops
+    if (m_Writer.joinable())
+        m_Writer.join();
+
+    for (Slot& slot : m_Slots)
+    {
+        helper::DestroyBuffer(m_Device, slot.Buffer);
+        if (slot.Fence != VK_NULL_HANDLE)
+            vkDestroyFence(m_Device, slot.Fence, nullptr);
+    }
+}
+
+VkResult FrameCapture::CreateReadback(Slot& slot, VkDeviceSize size) SRK_NOEXCEPT
+{
+    helper::DestroyBuffer(m_Device, slot.Buffer);
+
+    // cached memory makes the cpu reads on the writer a lot faster, not every gpu has it coherent
+    VkResult result = helper::CreateBuffer(m_Gpu, m_Device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, slot.Buffer);
+    if (result != VK_SUCCESS)
+    {
+        result = helper::CreateBuffer(m_Gpu, m_Device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, slot.Buffer);
+    }
+
+    return result;
+}
+
+bool FrameCapture::Capture(VkCommandBuffer cmd, VkImage image, VkImageLayout layout, VkFormat format, VkExtent2D extent) SRK_NOEXCEPT
+{
+    bool swapRedBlue{false};
+    if (!m_Valid || cmd == VK_NULL_HANDLE || extent.width == 0 || extent.height == 0)
+        return false;
+
+    if (!capturable(format, swapRedBlue))
+    {
+        SRK_CORE_WARN("Images in format {} can not be captured", static_cast<uint32_t>(format));
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint32_t index{0};
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Free.empty())
+        {
+            // the writer is behind, waiting for it is exactly what this class is there to avoid
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        index = m_Free.back();
+        m_Free.pop_back();
+    }
+
+    Slot&              slot = m_Slots[index];
+    const VkDeviceSize size = VkDeviceSize{extent.width} * extent.height * bytesPerPixel;
+    if (slot.Buffer.Size < size)
+    {
+        // mapping new memory is left to the writer, this capture is lost but the next ones fit
+        VkDeviceSize required = m_RequiredSize.load(std::memory_order_relaxed);
+        while (required < size && !m_RequiredSize.compare_exchange_weak(required, size, std::memory_order_relaxed))
+        {
+        }
+
+        slot.Grow = true;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Queued.push_back(index);
+        }
+        m_Wake.notify_one();
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    slot.Extent      = extent;
+    slot.SwapRedBlue = swapRedBlue;
+    slot.Frame       = m_Captured++;
+
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask               = VK_ACCESS_MEMORY_WRITE_BIT;
+    toTransfer.dstAccessMask               = VK_ACCESS_TRANSFER_READ_BIT;
+    toTransfer.oldLayout                   = layout;
+    toTransfer.newLayout                   = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image                       = image;
+    toTransfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    toTransfer.subresourceRange.levelCount = 1;
+    toTransfer.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent                 = {extent.width, extent.height, 1};
+
+    vkCmdCopyImageToBuffer(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.Buffer.Buffer, 1, &region);
+
+    // the copy has to be visible to the host once the fence signals, and the image goes back to how it was
+    VkMemoryBarrier toHost{};
+    toHost.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+    VkImageMemoryBarrier toLayout = toTransfer;
+    toLayout.srcAccessMask        = 0;
+    toLayout.dstAccessMask        = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    toLayout.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toLayout.newLayout            = layout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : layout;
+
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &toHost, 0, nullptr, 0, nullptr);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &toLayout);
+
+    m_Recorded.push_back(index);
+    return true;
+}
+
+void FrameCapture::Submit(VkQueue queue) SRK_NOEXCEPT
+{
+    if (m_Recorded.empty())
+        return;
+
+    // an empty submit signals its fence once everything submitted before it is done, copies included
+    std::vector<uint32_t> submitted;
+    submitted.reserve(m_Recorded.size());
+    for (uint32_t index : m_Recorded)
+    {
+        VkResult result = vkQueueSubmit(queue, 0, nullptr, m_Slots[index].Fence);
+        if (result != VK_SUCCESS)
+        {
+            SRK_CORE_ERROR("Capture of frame {} could not be submitted with {}", m_Slots[index].Frame, result);
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            Release(index);
+            continue;
+        }
+
+        submitted.push_back(index);
+    }
+    m_Recorded.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Queued.insert(m_Queued.end(), submitted.begin(), submitted.end());
+    }
+    m_Wake.notify_one();
+}
+
+void FrameCapture::Release(uint32_t slot) SRK_NOEXCEPT
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Free.push_back(slot);
+}
+
+void FrameCapture::WriterLoop() SRK_NOEXCEPT
+{
+    for (;;)
+    {
+        uint32_t index{0};
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [this]() { return !m_Running || !m_Queued.empty(); });
+            if (m_Queued.empty())
+                return;
+
+            index = m_Queued.front();
+            m_Queued.pop_front();
+        }
+
+        Slot& slot = m_Slots[index];
+        if (!slot.Grow)
+        {
+            vkWaitForFences(m_Device, 1, &slot.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            vkResetFences(m_Device, 1, &slot.Fence);
+            Write(slot);
+        }
+
+        // every slot catches up with the largest capture seen so far the next time it passes through here
+        const VkDeviceSize required = m_RequiredSize.load(std::memory_order_relaxed);
+        if (slot.Buffer.Size < required)
+        {
+            VkResult result = CreateReadback(slot, required);
+            if (result != VK_SUCCESS)
+                SRK_CORE_ERROR("Capture readback buffer of {} bytes could not be created with {}", required, result);
+        }
+
+        slot.Grow = false;
+        Release(index);
+    }
+}
+
+void FrameCapture::Write(Slot& slot) SRK_NOEXCEPT
+{
+    const uint32_t width  = slot.Extent.width;
+    const uint32_t height = slot.Extent.height;
+    const size_t   size   = size_t{width} * height * bytesPerPixel;
+    const uint8_t* pixels = static_cast<const uint8_t*>(slot.Buffer.Mapped);
+
+    if (slot.SwapRedBlue)
+    {
+        m_Pixels.resize(size);
+        for (size_t idx{}; idx < size; idx += bytesPerPixel)
+        {
+            m_Pixels[idx + 0] = pixels[idx + 2];
+            m_Pixels[idx + 1] = pixels[idx + 1];
+            m_Pixels[idx + 2] = pixels[idx + 0];
+            m_Pixels[idx + 3] = pixels[idx + 3];
+        }
+        pixels = m_Pixels.data();
+    }
+
+    bool written{false};
+    switch (m_Settings.Format)
+    {
+        case CaptureFormat::Png:
+            written = asset::WritePng(fmt::format("{}/frame_{:06}.png", m_Settings.Directory, slot.Frame), pixels, width, height);
+            break;
+        case CaptureFormat::Y4m:
+            // a y4m stream has one size, a resize starts the next file
+            if (m_Video.IsOpen() && (m_Video.GetWidth() != width || m_Video.GetHeight() != height))
+                m_Video.Close();
+
+            if (!m_Video.IsOpen())
+            {
+                std::string path = slot.Frame == 0 ? fmt::format("{}/capture.y4m", m_Settings.Directory)
+                                                    : fmt::format("{}/capture_{:06}.y4m", m_Settings.Directory, slot.Frame);
+                m_Video.Open(path, width, height, m_Settings.FramesPerSecond);
+            }
+
+            written = m_Video.WriteFrame(pixels);
+            break;
+    }
+
+    if (written)
+        m_Written.fetch_add(1, std::memory_order_relaxed);
+    else
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace shrek::render
@@ -0,0 +1,104 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "helper/Memory.h"
+#include "asset/ImageFile.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace shrek::render {
+
+enum class CaptureFormat : uint32_t
+{
+    Png, // one file per frame, frame_000000.png and onwards
+    Y4m  // every frame appended to capture.y4m
+};
+
+std::string_view ToString(CaptureFormat format) SRK_NOEXCEPT;
+
+struct CaptureSettings
+{
+    std::string   Directory{"capture"};
+    CaptureFormat Format{CaptureFormat::Png};
+    uint32_t      SlotCount{3};        // readbacks that can be in flight before captures get dropped
+    VkExtent2D    Extent{1920, 1080};  // the size the readback buffers start at
+    uint32_t      FramesPerSecond{60}; // only written into the y4m header
+};
+
+/*
+ *  Copies rendered images into a pool of persistently mapped readback buffers and writes them out
+ *  on its own thread. The render thread only records the copy and submits a fence behind it, the
+ *  writer thread waits on that fence, converts the pixels and does the file i/o.
+ *  When every buffer is still queued for writing the capture is dropped rather than waited for.
+ */
+class FrameCapture
+{
+public:
+    FrameCapture(VkPhysicalDevice gpu, VkDevice device, CaptureSettings settings) SRK_NOEXCEPT;
+    ~FrameCapture() SRK_NOEXCEPT;
+
+    FrameCapture(const FrameCapture& other) = delete;
+    FrameCapture& operator=(const FrameCapture& other) = delete;
+
+    // records the copy into cmd, the image is moved to transfer src and back to layout around it.
+    // false when the capture was dropped. only 8 bit rgba and bgra formats can be captured
+    bool Capture(VkCommandBuffer cmd, VkImage image, VkImageLayout layout, VkFormat format, VkExtent2D extent) SRK_NOEXCEPT;
+
+    // call after the command buffers given to Capture were submitted to queue, hands the copies to the writer
+    void Submit(VkQueue queue) SRK_NOEXCEPT;
+
+    bool     IsValid() const SRK_NOEXCEPT { return m_Valid; }
+    uint64_t GetWrittenCount() const SRK_NOEXCEPT { return m_Written.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedCount() const SRK_NOEXCEPT { return m_Dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot
+    {
+        helper::BufferAllocation Buffer;
+        VkFence                  Fence{VK_NULL_HANDLE};
+        VkExtent2D               Extent{};
+        bool                     SwapRedBlue{false};
+        bool                     Grow{false}; // too small for the last capture, the writer makes it bigger instead of writing it
+        uint64_t                 Frame{0};
+    };
+
+    VkResult CreateReadback(Slot& slot, VkDeviceSize size) SRK_NOEXCEPT;
+    void     WriterLoop() SRK_NOEXCEPT;
+    void     Write(Slot& slot) SRK_NOEXCEPT;
+    void     Release(uint32_t slot) SRK_NOEXCEPT;
+
+private:
+    VkPhysicalDevice m_Gpu;
+    VkDevice         m_Device;
+    CaptureSettings  m_Settings;
+    bool             m_Valid;
+
+    std::vector<Slot>     m_Slots;
+    std::vector<uint32_t> m_Recorded; // render thread only, copied this frame and waiting for Submit
+    uint64_t              m_Captured; // frame numbers in the order Capture was called
+
+    std::mutex                m_Mutex;
+    std::condition_variable   m_Wake;
+    std::vector<uint32_t>     m_Free;
+    std::deque<uint32_t>      m_Queued;       // submitted, written in order
+    std::atomic<VkDeviceSize> m_RequiredSize; // bytes of the largest capture so far
+    bool                      m_Running;
+
+    // writer thread only
+    std::vector<uint8_t> m_Pixels;
+    asset::Y4mWriter     m_Video;
+
+    std::atomic<uint64_t> m_Written;
+    std::atomic<uint64_t> m_Dropped;
+    std::thread           m_Writer; // last, it starts once everything above is set up
+};
+
+} // namespace shrek::render
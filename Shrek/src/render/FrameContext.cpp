@@ -0,0 +1,177 @@
+#include "pch.h"
+#include "FrameContext.h"
+
+#include "base/Config.h"
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace shrek::render {
+
+namespace {
+
+base::ConfigVar<int32_t> framesInFlight{"render.frames_in_flight", 2, "frames the cpu may record ahead of the gpu, more hides stalls at the cost of latency"};
+
+} // namespace
+
+uint32_t GetFramesInFlight() SRK_NOEXCEPT
+{
+    return static_cast<uint32_t>(std::clamp<int32_t>(framesInFlight, 1, static_cast<int32_t>(MaxFramesInFlight)));
+}
+
+FrameContext::FrameContext(VkDevice device, VkQueue queue, uint32_t queueFamily) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Queue(queue),
+    m_Slots(GetFramesInFlight()),
+    m_Frame(),
+    m_Valid(true)
+{
+    for (Slot& slot : m_Slots)
+    {
+        // signaled so the first wait on every slot returns straight away
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        // the pool is reset as a whole every frame rather than each buffer on its own
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = queueFamily;
+
+        VkResult result = vkCreateFence(m_Device, &fenceInfo, nullptr, &slot.Fence);
+        if (result == VK_SUCCESS)
+            result = vkCreateCommandPool(m_Device, &poolInfo, nullptr, &slot.Pool);
+
+        if (result == VK_SUCCESS)
+        {
+            VkCommandBufferAllocateInfo allocateInfo{};
+            allocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocateInfo.commandPool        = slot.Pool;
+            allocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocateInfo.commandBufferCount = 1;
+
+            result = vkAllocateCommandBuffers(m_Device, &allocateInfo, &slot.CommandBuffer);
+        }
+
+        if (result != VK_SUCCESS)
+        {
+            SRK_CORE_ERROR("Frame resources could not be created with {}", result);
+            m_Valid = false;
+            return;
+        }
+    }
+}
+
+FrameContext::~FrameContext() SRK_NOEXCEPT
+{
+    Destroy();
+}
+
+void FrameContext::Destroy() SRK_NOEXCEPT
+{
+    for (Slot& slot : m_Slots)
+    {
+        // nothing may be destroyed while the gpu still uses it
+        if (slot.Fence != VK_NULL_HANDLE)
+        {
+            vkWaitForFences(m_Device, 1, &slot.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            vkDestroyFence(m_Device, slot.Fence, nullptr);
+        }
+
+        // destroying the pool frees its command buffers
+        if (slot.Pool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(m_Device, slot.Pool, nullptr);
+
+        slot = Slot{};
+    }
+}
+
+const Frame& FrameContext::BeginFrame() SRK_NOEXCEPT
+{
+    const uint32_t index = static_cast<uint32_t>(m_Frame.Number % m_Slots.size());
+    Slot&          slot  = m_Slots[index];
+
+    m_Frame.Index         = index;
+    m_Frame.CommandBuffer = VK_NULL_HANDLE;
+    if (!m_Valid)
+        return m_Frame;
+
+    vkWaitForFences(m_Device, 1, &slot.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    vkResetFences(m_Device, 1, &slot.Fence);
+    vkResetCommandPool(m_Device, slot.Pool, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkResult result = vkBeginCommandBuffer(slot.CommandBuffer, &beginInfo);
+    if (result != VK_SUCCESS)
+        SRK_CORE_ERROR("Frame {} command buffer could not be begun with {}", m_Frame.Number, result);
+    else
+        m_Frame.CommandBuffer = slot.CommandBuffer;
+
+    return m_Frame;
+}
+
+void FrameSubmit::AddWait(VkSemaphore semaphore, VkPipelineStageFlags stage) SRK_NOEXCEPT
+{
+    SRK_ASSERT(WaitCount < MaxSemaphores, "too many semaphores for one frame to wait on");
+    if (semaphore == VK_NULL_HANDLE || WaitCount == MaxSemaphores)
+        return;
+
+    Wait[WaitCount]       = semaphore;
+    WaitStages[WaitCount] = stage;
+    ++WaitCount;
+}
+
+void FrameSubmit::AddSignal(VkSemaphore semaphore) SRK_NOEXCEPT
+{
+    SRK_ASSERT(SignalCount < MaxSemaphores, "too many semaphores for one frame to signal");
+    if (semaphore == VK_NULL_HANDLE || SignalCount == MaxSemaphores)
+        return;
+
+    Signal[SignalCount++] = semaphore;
+}
+
+VkResult FrameContext::EndFrame(const FrameSubmit& submit) SRK_NOEXCEPT
+{
+    Slot& slot = m_Slots[m_Frame.Index];
+    ++m_Frame.Number;
+
+    if (!m_Valid || m_Frame.CommandBuffer == VK_NULL_HANDLE)
+        return VK_ERROR_INITIALIZATION_FAILED;
+
+    VkResult result = vkEndCommandBuffer(slot.CommandBuffer);
+    if (result != VK_SUCCESS)
+        return result;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &slot.CommandBuffer;
+
+    submitInfo.waitSemaphoreCount   = submit.WaitCount;
+    submitInfo.pWaitSemaphores      = submit.Wait.data();
+    submitInfo.pWaitDstStageMask    = submit.WaitStages.data();
+    submitInfo.signalSemaphoreCount = submit.SignalCount;
+    submitInfo.pSignalSemaphores    = submit.Signal.data();
+
+    result = vkQueueSubmit(m_Queue, 1, &submitInfo, slot.Fence);
+    if (result != VK_SUCCESS)
+    {
+        // the fence will never signal, put it back so the next wait on this slot doesn't hang
+        SRK_CORE_ERROR("Frame submit failed with {}", result);
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        vkDestroyFence(m_Device, slot.Fence, nullptr);
+        vkCreateFence(m_Device, &fenceInfo, nullptr, &slot.Fence);
+    }
+
+    return result;
+}
+
+} // namespace shrek::render
@@ -0,0 +1,78 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace shrek::render {
+
+// how many frames the cpu may record ahead of the gpu, every per frame resource is allocated this many times.
+// render.frames_in_flight, clamped to [1, MaxFramesInFlight]. fixed once the config is loaded
+constexpr uint32_t MaxFramesInFlight = 4;
+uint32_t           GetFramesInFlight() SRK_NOEXCEPT;
+
+struct Frame
+{
+    uint32_t        Index{0};  // the slot in [0, GetFramesInFlight()) whose resources this frame uses
+    uint64_t        Number{0}; // frames begun since startup
+    VkCommandBuffer CommandBuffer{VK_NULL_HANDLE};
+};
+
+// what a frame's submit waits on and signals besides the slot's fence, null semaphores are left out
+struct FrameSubmit
+{
+    static constexpr uint32_t MaxSemaphores = 4;
+
+    std::array<VkSemaphore, MaxSemaphores>          Wait{};
+    std::array<VkPipelineStageFlags, MaxSemaphores> WaitStages{};
+    uint32_t                                        WaitCount{0};
+    std::array<VkSemaphore, MaxSemaphores>          Signal{};
+    uint32_t                                        SignalCount{0};
+
+    void AddWait(VkSemaphore semaphore, VkPipelineStageFlags stage) SRK_NOEXCEPT;
+    void AddSignal(VkSemaphore semaphore) SRK_NOEXCEPT;
+};
+
+/*
+ *  Fences, command pools and command buffers for each frame in flight.
+ *  BeginFrame waits on the fence of the frame that last used the slot, so once it returns
+ *  everything that frame handed to the gpu (uniforms, command buffers) can be reused.
+ */
+class FrameContext
+{
+public:
+    FrameContext(VkDevice device, VkQueue queue, uint32_t queueFamily) SRK_NOEXCEPT;
+    ~FrameContext() SRK_NOEXCEPT;
+
+    FrameContext(const FrameContext& other) = delete;
+    FrameContext& operator=(const FrameContext& other) = delete;
+
+    // the command buffer is reset and begun
+    const Frame& BeginFrame() SRK_NOEXCEPT;
+    // ends and submits the command buffer, signalling the slot's fence and whatever submit asks for
+    VkResult EndFrame(const FrameSubmit& submit = {}) SRK_NOEXCEPT;
+
+    bool         IsValid() const SRK_NOEXCEPT { return m_Valid; }
+    const Frame& GetFrame() const SRK_NOEXCEPT { return m_Frame; }
+
+private:
+    struct Slot
+    {
+        VkFence         Fence{VK_NULL_HANDLE};
+        VkCommandPool   Pool{VK_NULL_HANDLE};
+        VkCommandBuffer CommandBuffer{VK_NULL_HANDLE};
+    };
+
+    void Destroy() SRK_NOEXCEPT;
+
+private:
+    VkDevice          m_Device;
+    VkQueue           m_Queue;
+    std::vector<Slot> m_Slots;
+    Frame             m_Frame;
+    bool              m_Valid;
+};
+
+} // namespace shrek::render
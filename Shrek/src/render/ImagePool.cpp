@@ -0,0 +1,143 @@
+#include "pch.h"
+#include "ImagePool.h"
+
+#include "FrameContext.h"
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+
+namespace shrek::render {
+
+namespace {
+
+// a resize leaves the old sizes behind, they go once they haven't been asked for in this long
+constexpr uint64_t evictFrames = 120;
+
+} // namespace
+
+ImagePool::ImagePool(VkPhysicalDevice gpu, VkDevice device, const helper::QueueFamilyIndices& families, const MemoryBudget& budget,
+                     ResidencyManager& residency) SRK_NOEXCEPT :
+    m_Gpu(gpu),
+    m_Device(device),
+    m_Budget(budget),
+    m_Residency(residency),
+    m_Families{families.Graphics},
+    m_Entries(),
+    m_Frame(0),
+    m_Size(0)
+{
+    if (families.Compute.has_value() && families.Compute.value() != families.Graphics)
+        m_Families.push_back(families.Compute.value());
+}
+
+ImagePool::~ImagePool() SRK_NOEXCEPT
+{
+    for (std::unique_ptr<Entry>& entry : m_Entries)
+    {
+        m_Residency.Unregister(entry->Residency);
+        helper::DestroyImage(m_Device, entry->Allocation);
+    }
+}
+
+void ImagePool::BeginFrame(uint64_t frame) SRK_NOEXCEPT
+{
+    m_Frame = frame;
+
+    // what the residency manager evicted goes along with what wasn't asked for
+    auto unused = [frame](const std::unique_ptr<Entry>& entry) { return entry->LastUsed + evictFrames <= frame || entry->Allocation.Image == VK_NULL_HANDLE; };
+    for (std::unique_ptr<Entry>& entry : m_Entries)
+    {
+        if (unused(entry))
+        {
+            m_Residency.Unregister(entry->Residency);
+            m_Size -= entry->Allocation.Size;
+            helper::DestroyImage(m_Device, entry->Allocation);
+        }
+    }
+    m_Entries.erase(std::remove_if(m_Entries.begin(), m_Entries.end(), unused), m_Entries.end());
+}
+
+void ImagePool::Keep(const PooledImage& image) SRK_NOEXCEPT
+{
+    for (std::unique_ptr<Entry>& entry : m_Entries)
+    {
+        if (&entry->Image == &image)
+        {
+            entry->LastUsed = std::max(entry->LastUsed, m_Frame);
+            m_Residency.Touch(entry->Residency, m_Frame);
+            return;
+        }
+    }
+}
+
+const PooledImage* ImagePool::Acquire(const PooledImageDesc& desc) SRK_NOEXCEPT
+{
+    // taken by this frame or one still in flight otherwise
+    const uint64_t inFlight = GetFramesInFlight();
+    for (std::unique_ptr<Entry>& entry : m_Entries)
+    {
+        const PooledImageDesc& other = entry->Desc;
+        if (entry->LastUsed + inFlight <= m_Frame && entry->Allocation.Image != VK_NULL_HANDLE && other.Extent.width == desc.Extent.width &&
+            other.Extent.height == desc.Extent.height && other.Format == desc.Format && other.Usage == desc.Usage)
+        {
+            entry->LastUsed = m_Frame;
+            m_Residency.Touch(entry->Residency, m_Frame);
+            return &entry->Image;
+        }
+    }
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType                 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType             = VK_IMAGE_TYPE_2D;
+    imageInfo.format                = desc.Format;
+    imageInfo.extent                = {desc.Extent.width, desc.Extent.height, 1};
+    imageInfo.mipLevels             = 1;
+    imageInfo.arrayLayers           = 1;
+    imageInfo.samples               = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling                = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage                 = desc.Usage;
+    imageInfo.sharingMode           = m_Families.size() > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(m_Families.size());
+    imageInfo.pQueueFamilyIndices   = m_Families.data();
+    imageInfo.initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    auto     entry  = std::make_unique<Entry>();
+    VkResult result = helper::CreateImage(m_Gpu, m_Device, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, entry->Allocation);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Pooled image of {}x{} could not be created with {}", desc.Extent.width, desc.Extent.height, result);
+        return nullptr;
+    }
+
+    entry->Desc     = desc;
+    entry->Image    = PooledImage{entry->Allocation.Image, entry->Allocation.View, desc.Extent, desc.Format};
+    entry->LastUsed = m_Frame;
+    m_Size += entry->Allocation.Size;
+
+    ResidencyDesc residencyDesc;
+    residencyDesc.Heap       = m_Budget.GetHeapOfType(entry->Allocation.MemoryType);
+    residencyDesc.LevelSizes = {entry->Allocation.Size, 0};
+    residencyDesc.SetLevel   = [this, raw = entry.get()](uint32_t level) { return SetLevel(*raw, level); };
+    entry->Residency         = m_Residency.Register(std::move(residencyDesc), m_Frame);
+
+    m_Entries.push_back(std::move(entry));
+    return &m_Entries.back()->Image;
+}
+
+bool ImagePool::SetLevel(Entry& entry, uint32_t level) SRK_NOEXCEPT
+{
+    // gone for good once evicted, BeginFrame drops the entry
+    if (level == 0)
+        return entry.Allocation.Image != VK_NULL_HANDLE;
+
+    // a frame still in flight may use it, the residency manager tries something else
+    if (entry.LastUsed + GetFramesInFlight() > m_Frame)
+        return false;
+
+    m_Size -= entry.Allocation.Size;
+    helper::DestroyImage(m_Device, entry.Allocation);
+    return true;
+}
+
+} // namespace shrek::render
@@ -0,0 +1,85 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "MemoryBudget.h"
+#include "Residency.h"
+#include "helper/Memory.h"
+#include "helper/QueueFamilyIndices.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace shrek::render {
+
+struct PooledImageDesc
+{
+    VkExtent2D        Extent{0, 0};
+    VkFormat          Format{VK_FORMAT_UNDEFINED};
+    VkImageUsageFlags Usage{0};
+};
+
+struct PooledImage
+{
+    VkImage     Image{VK_NULL_HANDLE};
+    VkImageView View{VK_NULL_HANDLE};
+    VkExtent2D  Extent{0, 0};
+    VkFormat    Format{VK_FORMAT_UNDEFINED};
+};
+
+/*
+ *  Transient images (render targets, the ping-pong images of compute passes) recycled between frames.
+ *  Acquire hands out an image of the same extent, format and usage nobody is using or makes one, it stays
+ *  taken until the frame that acquired it is out of flight. Images nobody asked for in a while are destroyed.
+ *  Contents are undefined every time so the first use transitions from VK_IMAGE_LAYOUT_UNDEFINED.
+ *  With a compute family of its own the images are shared concurrently with it, passes on either queue
+ *  can use them without ownership transfers.
+ *  Every image is registered with the ResidencyManager and touched whenever it's handed out, one it evicts is
+ *  destroyed on the spot (it's only picked once no frame in flight has it) and never brought back, Acquire makes
+ *  a new one when it's asked for again.
+ */
+class ImagePool
+{
+public:
+    ImagePool(VkPhysicalDevice gpu, VkDevice device, const helper::QueueFamilyIndices& families, const MemoryBudget& budget, ResidencyManager& residency) SRK_NOEXCEPT;
+    ~ImagePool() SRK_NOEXCEPT;
+
+    ImagePool(const ImagePool& other) = delete;
+    ImagePool& operator=(const ImagePool& other) = delete;
+
+    // once every queue is done with the frame that last used the slot, frees up what it acquired
+    void BeginFrame(uint64_t frame) SRK_NOEXCEPT;
+
+    // null when the image could not be created
+    const PooledImage* Acquire(const PooledImageDesc& desc) SRK_NOEXCEPT;
+    // an image an earlier frame acquired stays taken until this frame is out of flight as well
+    void Keep(const PooledImage& image) SRK_NOEXCEPT;
+
+    size_t       GetImageCount() const SRK_NOEXCEPT { return m_Entries.size(); }
+    VkDeviceSize GetSize() const SRK_NOEXCEPT { return m_Size; }
+
+private:
+    struct Entry
+    {
+        PooledImageDesc         Desc;
+        PooledImage             Image;
+        helper::ImageAllocation Allocation; // empty once evicted
+        uint64_t                LastUsed{0};
+        ResidencyId             Residency{InvalidResidencyId};
+    };
+
+    // ResidencyDesc::SetLevel of an entry
+    bool SetLevel(Entry& entry, uint32_t level) SRK_NOEXCEPT;
+
+private:
+    VkPhysicalDevice                    m_Gpu;
+    VkDevice                            m_Device;
+    const MemoryBudget&                 m_Budget;
+    ResidencyManager&                   m_Residency;
+    std::vector<uint32_t>               m_Families; // more than one means the images are shared concurrently
+    std::vector<std::unique_ptr<Entry>> m_Entries;  // boxed so the images handed out don't move
+    uint64_t                            m_Frame;
+    VkDeviceSize                        m_Size;
+};
+
+} // namespace shrek::render
@@ -0,0 +1,79 @@
+#include "pch.h"
+#include "MemoryBudget.h"
+
+#include "base/Config.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+
+namespace shrek::render {
+
+namespace {
+
+base::ConfigVar<int32_t> budgetLimitMb{"render.memory_budget_mb", 0, "caps the budget of every device local heap, 0 leaves it to the driver"};
+
+// without the extension, the rest of the heap is left to the os, the compositor and everyone else
+constexpr VkDeviceSize fallbackBudgetPercent = 80;
+
+} // namespace
+
+MemoryBudget::MemoryBudget(VkPhysicalDevice gpu, bool extension) SRK_NOEXCEPT :
+    m_Gpu(gpu),
+    m_Extension(extension),
+    m_Heaps(),
+    m_TypeHeaps()
+{
+    VkPhysicalDeviceMemoryProperties properties;
+    vkGetPhysicalDeviceMemoryProperties(m_Gpu, &properties);
+
+    m_Heaps.resize(properties.memoryHeapCount);
+    for (uint32_t idx{}; idx < properties.memoryHeapCount; ++idx)
+    {
+        m_Heaps[idx].Size        = properties.memoryHeaps[idx].size;
+        m_Heaps[idx].DeviceLocal = (properties.memoryHeaps[idx].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    }
+
+    m_TypeHeaps.resize(properties.memoryTypeCount);
+    for (uint32_t idx{}; idx < properties.memoryTypeCount; ++idx)
+        m_TypeHeaps[idx] = properties.memoryTypes[idx].heapIndex;
+
+    Update();
+}
+
+void MemoryBudget::Update() SRK_NOEXCEPT
+{
+    if (m_Extension)
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+        budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budget;
+
+        vkGetPhysicalDeviceMemoryProperties2(m_Gpu, &properties);
+        for (size_t idx{}; idx < m_Heaps.size(); ++idx)
+        {
+            m_Heaps[idx].Budget = budget.heapBudget[idx];
+            m_Heaps[idx].Usage  = budget.heapUsage[idx];
+        }
+    }
+    else
+    {
+        for (HeapBudget& heap : m_Heaps)
+            heap.Budget = heap.Size / 100 * fallbackBudgetPercent;
+    }
+
+    // for trying out eviction, or sharing the gpu with something the driver doesn't know about
+    if (budgetLimitMb > 0)
+    {
+        const VkDeviceSize limit = static_cast<VkDeviceSize>(budgetLimitMb.Get()) * 1024 * 1024;
+        for (HeapBudget& heap : m_Heaps)
+        {
+            if (heap.DeviceLocal)
+                heap.Budget = std::min(heap.Budget, limit);
+        }
+    }
+}
+
+} // namespace shrek::render
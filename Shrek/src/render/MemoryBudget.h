@@ -0,0 +1,51 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace shrek::render {
+
+struct HeapBudget
+{
+    VkDeviceSize Size{0};
+    VkDeviceSize Budget{0}; // what this process can use before the driver starts paging, shrinks as other processes take memory
+    VkDeviceSize Usage{0};  // of this process, 0 without VK_EXT_memory_budget
+    bool         DeviceLocal{false};
+
+    float GetPressure() const SRK_NOEXCEPT { return Budget > 0 ? static_cast<float>(Usage) / static_cast<float>(Budget) : 0.f; }
+};
+
+/*
+ *  Usage and budget of every memory heap, refreshed once a frame.
+ *  With VK_EXT_memory_budget both come from the driver and include everything the process allocated.
+ *  Without it the budget is a fixed part of the heap size and the usage is unknown, so whoever tracks
+ *  their own allocations (ResidencyManager) has to go by those instead.
+ */
+class MemoryBudget
+{
+public:
+    MemoryBudget(VkPhysicalDevice gpu, bool extension) SRK_NOEXCEPT;
+
+    MemoryBudget(const MemoryBudget& other) = delete;
+    MemoryBudget& operator=(const MemoryBudget& other) = delete;
+
+    void Update() SRK_NOEXCEPT;
+
+    bool                           HasUsage() const SRK_NOEXCEPT { return m_Extension; }
+    uint32_t                       GetHeapCount() const SRK_NOEXCEPT { return static_cast<uint32_t>(m_Heaps.size()); }
+    const HeapBudget&              GetHeap(uint32_t heap) const SRK_NOEXCEPT { return m_Heaps[heap]; }
+    const std::vector<HeapBudget>& GetHeaps() const SRK_NOEXCEPT { return m_Heaps; }
+
+    // the heap memory of this type comes out of
+    uint32_t GetHeapOfType(uint32_t memoryType) const SRK_NOEXCEPT { return m_TypeHeaps[memoryType]; }
+
+private:
+    VkPhysicalDevice        m_Gpu;
+    bool                    m_Extension;
+    std::vector<HeapBudget> m_Heaps;
+    std::vector<uint32_t>   m_TypeHeaps;
+};
+
+} // namespace shrek::render
@@ -0,0 +1,84 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "StagingBuffer.h"
+#include "base/math/Aabb.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace shrek::render {
+
+// every attribute lives in its own tightly packed stream
+enum VertexStream : uint32_t
+{
+    VertexStream_Position,
+    VertexStream_Normal,
+    VertexStream_Tangent,
+    VertexStream_TexCoord0,
+    VertexStream_Count
+};
+
+struct MeshStream
+{
+    StagingAllocation Data;
+    uint32_t          Stride{0};
+    VkFormat          Format{VK_FORMAT_UNDEFINED};
+
+    bool IsValid() const SRK_NOEXCEPT { return Data.IsValid(); }
+};
+
+// a range of the primitive's index buffer, Error is the simplification error relative to the mesh's extent
+struct MeshLod
+{
+    uint32_t FirstIndex{0};
+    uint32_t IndexCount{0};
+    float    Error{0.f};
+};
+
+// laid out for std430 so the array can be read by a task/compute shader as is
+struct Meshlet
+{
+    math::Vec3 Center;
+    float      Radius{0.f};
+    math::Vec3 ConeApex;
+    float      ConeCutoff{1.f}; // the meshlet is backfacing when dot(normalize(ConeApex - eye), ConeAxis) >= ConeCutoff
+    math::Vec3 ConeAxis;
+    uint32_t   VertexOffset{0};   // into MeshletVertices
+    uint32_t   TriangleOffset{0}; // byte offset into MeshletTriangles
+    uint32_t   VertexCount{0};
+    uint32_t   TriangleCount{0};
+    uint32_t   Padding{0};
+};
+
+static_assert(sizeof(Meshlet) == 64, "Meshlet has to match the shader side layout");
+
+struct MeshPrimitive
+{
+    std::array<MeshStream, VertexStream_Count> Streams;
+    StagingAllocation                          Indices; // every lod's indices back to back
+    VkIndexType                                IndexType{VK_INDEX_TYPE_UINT32};
+    uint32_t                                   VertexCount{0};
+    uint32_t                                   IndexCount{0}; // of lod 0
+    int32_t                                    Material{-1};
+    math::Aabb                                 Bounds;
+
+    // only filled in for optimized primitives, lod 0 is always the full mesh
+    std::vector<MeshLod> Lods;
+    StagingAllocation    Meshlets;         // Meshlet array, built from lod 0
+    StagingAllocation    MeshletVertices;  // uint32 vertex indices
+    StagingAllocation    MeshletTriangles; // 3 uint8 meshlet local indices per triangle, each meshlet starts 4 byte aligned
+    uint32_t             MeshletCount{0};
+};
+
+// cpu side description of a mesh whose data is sitting in a StagingBuffer waiting to be uploaded
+struct Mesh
+{
+    std::string                Name;
+    std::vector<MeshPrimitive> Primitives;
+    math::Aabb                 Bounds;
+};
+
+} // namespace shrek::render
@@ -0,0 +1,619 @@
+#include "pch.h"
+#include "OcclusionCuller.h"
+
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace shrek::render {
+
+namespace {
+
+// the shader side Object of OcclusionCull.comp
+struct CullObject
+{
+    float    Center[4];
+    float    Extents[4];
+    uint32_t Batch;
+    uint32_t Instance;
+    uint32_t Slot;
+    uint32_t Padding;
+};
+
+static_assert(sizeof(CullObject) == 48, "CullObject has to match the shader side layout");
+
+struct CullConstants
+{
+    math::Mat4 ViewProjection;
+    float      HiZSize[2];
+    uint32_t   ObjectCount;
+    uint32_t   Late;
+};
+
+struct HiZConstants
+{
+    int32_t SourceSize[2];
+};
+
+constexpr uint32_t noSlot = ~0u;
+
+constexpr uint32_t cullGroupSize = 64;
+constexpr uint32_t hiZGroupSize  = 8;
+
+// a pyramid down to 1x1 from the largest depth buffer vulkan guarantees and then some
+constexpr uint32_t maxPyramidLevels = 16;
+
+uint32_t floorPowerOfTwo(uint32_t value) SRK_NOEXCEPT
+{
+    uint32_t power = 1;
+    while (power * 2 <= value)
+        power *= 2;
+    return power;
+}
+
+uint32_t phaseIndex(CullPhase phase) SRK_NOEXCEPT
+{
+    return static_cast<uint32_t>(phase);
+}
+
+} // namespace
+
+std::string_view ToString(CullPhase phase) SRK_NOEXCEPT
+{
+#define TO_STRING(X)   \
+    case CullPhase::X: \
+        return #X
+    switch (phase)
+    {
+        TO_STRING(Early);
+        TO_STRING(Late);
+        default:
+            return "UNKNOWN";
+    }
+#undef TO_STRING
+}
+
+OcclusionCuller::OcclusionCuller(VkPhysicalDevice gpu, VkDevice device, pipeline::ShaderLibrary& shaders, pipeline::PipelineCache& pipelines,
+                                 uint32_t maxObjects) SRK_NOEXCEPT :
+    m_Gpu(gpu),
+    m_Device(device),
+    m_Shaders(shaders),
+    m_Pipelines(pipelines),
+    m_MaxObjects(maxObjects),
+    m_Valid(false),
+    m_ObjectsOffset(0),
+    m_DrawsOffset(),
+    m_InstancesOffset(),
+    m_Slots(GetFramesInFlight()),
+    m_Visibility(),
+    m_VisibilityCleared(false),
+    m_ViewProjection(),
+    m_Sampler(VK_NULL_HANDLE),
+    m_Pyramid(),
+    m_PyramidLevels(),
+    m_PyramidExtent{0, 0},
+    m_Retired(),
+    m_Stats()
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_Gpu, &properties);
+    const VkDeviceSize alignment = properties.limits.minStorageBufferOffsetAlignment;
+
+    // a batch has at least one instance so there are never more draws than objects
+    VkDeviceSize size = 0;
+    m_ObjectsOffset   = size;
+    size              = helper::AlignUp(size + VkDeviceSize{m_MaxObjects} * sizeof(CullObject), alignment);
+    for (uint32_t phase{}; phase < 2; ++phase)
+    {
+        m_DrawsOffset[phase] = size;
+        size                 = helper::AlignUp(size + VkDeviceSize{m_MaxObjects} * sizeof(VkDrawIndexedIndirectCommand), alignment);
+    }
+    for (uint32_t phase{}; phase < 2; ++phase)
+    {
+        m_InstancesOffset[phase] = size;
+        size                     = helper::AlignUp(size + VkDeviceSize{m_MaxObjects} * sizeof(uint32_t), alignment);
+    }
+
+    // a hi-z level set per pyramid level and a cull set per phase
+    std::array<VkDescriptorPoolSize, 3> poolSizes{};
+    poolSizes[0].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = maxPyramidLevels + 2;
+    poolSizes[1].type            = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[1].descriptorCount = maxPyramidLevels;
+    poolSizes[2].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[2].descriptorCount = 4 * 2;
+
+    VkDescriptorPoolCreateInfo descriptorInfo{};
+    descriptorInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorInfo.maxSets       = maxPyramidLevels + 2;
+    descriptorInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    descriptorInfo.pPoolSizes    = poolSizes.data();
+
+    // the pyramid is read with texelFetch and textureLod, nothing may be filtered
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter    = VK_FILTER_NEAREST;
+    samplerInfo.minFilter    = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod       = static_cast<float>(maxPyramidLevels);
+
+    VkResult result = vkCreateSampler(m_Device, &samplerInfo, nullptr, &m_Sampler);
+    if (result == VK_SUCCESS)
+        result = helper::CreateBuffer(m_Gpu, m_Device, VkDeviceSize{std::max(m_MaxObjects, 1u)} * sizeof(uint32_t),
+                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Visibility);
+
+    // small enough for host visible memory, which saves uploading the objects and lets the draws be read back
+    for (Slot& slot : m_Slots)
+    {
+        if (result != VK_SUCCESS)
+            break;
+
+        result = helper::CreateBuffer(m_Gpu, m_Device, std::max<VkDeviceSize>(size, 1), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, slot.Buffer);
+        if (result == VK_SUCCESS)
+            result = vkCreateDescriptorPool(m_Device, &descriptorInfo, nullptr, &slot.Descriptors);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Occlusion culling could not be created with {}", result);
+        return;
+    }
+
+    m_Valid = true;
+}
+
+OcclusionCuller::~OcclusionCuller() SRK_NOEXCEPT
+{
+    // FrameContext waited for the gpu before anything here goes
+    for (Slot& slot : m_Slots)
+    {
+        helper::DestroyBuffer(m_Device, slot.Buffer);
+        if (slot.Descriptors != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_Device, slot.Descriptors, nullptr);
+    }
+
+    for (Retired& retired : m_Retired)
+    {
+        for (VkImageView view : retired.Levels)
+            vkDestroyImageView(m_Device, view, nullptr);
+        helper::DestroyImage(m_Device, retired.Image);
+    }
+
+    for (VkImageView view : m_PyramidLevels)
+        vkDestroyImageView(m_Device, view, nullptr);
+    helper::DestroyImage(m_Device, m_Pyramid);
+    helper::DestroyBuffer(m_Device, m_Visibility);
+
+    if (m_Sampler != VK_NULL_HANDLE)
+        vkDestroySampler(m_Device, m_Sampler, nullptr);
+}
+
+void OcclusionCuller::BeginFrame(const Frame& frame) SRK_NOEXCEPT
+{
+    if (!m_Valid)
+        return;
+
+    // the slot's fence was waited on, what the late phase wrote is in the mapped buffer already
+    Slot& slot = m_Slots[frame.Index];
+    if (slot.Culled)
+    {
+        const std::byte* mapped = static_cast<const std::byte*>(slot.Buffer.Mapped);
+        OcclusionStats   stats;
+        stats.Objects = slot.ObjectCount;
+        for (uint32_t batch{}; batch < slot.BatchCount; ++batch)
+        {
+            VkDrawIndexedIndirectCommand early;
+            VkDrawIndexedIndirectCommand late;
+            std::memcpy(&early, mapped + m_DrawsOffset[0] + batch * sizeof(early), sizeof(early));
+            std::memcpy(&late, mapped + m_DrawsOffset[1] + batch * sizeof(late), sizeof(late));
+            stats.EarlyDrawn += early.instanceCount;
+            stats.LateDrawn += late.instanceCount;
+        }
+        stats.Occluded = stats.Objects - std::min(stats.Objects, stats.EarlyDrawn + stats.LateDrawn);
+        m_Stats        = stats;
+    }
+
+    vkResetDescriptorPool(m_Device, slot.Descriptors, 0);
+    slot.Prepared = false;
+    slot.Culled   = false;
+    slot.Fallback = false;
+    slot.HiZBuilt = false;
+
+    // pyramids left behind by a resize, once no frame in flight can still be reading them
+    const uint64_t inFlight = GetFramesInFlight();
+    auto           done     = [&frame, inFlight](const Retired& retired) { return retired.Frame + inFlight <= frame.Number; };
+    for (Retired& retired : m_Retired)
+    {
+        if (!done(retired))
+            continue;
+
+        for (VkImageView view : retired.Levels)
+            vkDestroyImageView(m_Device, view, nullptr);
+        helper::DestroyImage(m_Device, retired.Image);
+    }
+    m_Retired.erase(std::remove_if(m_Retired.begin(), m_Retired.end(), done), m_Retired.end());
+}
+
+const pipeline::Pipeline* OcclusionCuller::GetPipeline(const char* shader) SRK_NOEXCEPT
+{
+    pipeline::PipelineDesc desc;
+    desc.Shaders[0]  = m_Shaders.Get(shader);
+    desc.ShaderCount = 1;
+    if (!desc.Shaders[0])
+        return nullptr;
+
+    return m_Pipelines.Get(desc);
+}
+
+bool OcclusionCuller::Prepare(const Frame& frame, const RenderQueue& queue, const math::Aabb* bounds, const std::vector<IndirectMesh>& meshes,
+                              const math::Mat4& viewProjection) SRK_NOEXCEPT
+{
+    Slot& slot = m_Slots[frame.Index];
+    if (!m_Valid)
+        return false;
+
+    const std::pmr::vector<DrawBatch>& batches   = queue.GetBatches();
+    const std::pmr::vector<uint32_t>&  instances = queue.GetInstances();
+    if (instances.size() > m_MaxObjects)
+    {
+        SRK_CORE_ERROR("{} instances don't fit the {} occlusion culling has room for", instances.size(), m_MaxObjects);
+        return false;
+    }
+
+    // until both pipelines are there every instance goes into the early draws as is
+    slot.Fallback = !GetPipeline("OcclusionCull.comp") || !GetPipeline("HiZBuild.comp");
+
+    std::byte*                    mapped  = static_cast<std::byte*>(slot.Buffer.Mapped);
+    CullObject*                   objects = reinterpret_cast<CullObject*>(mapped + m_ObjectsOffset);
+    VkDrawIndexedIndirectCommand* early   = reinterpret_cast<VkDrawIndexedIndirectCommand*>(mapped + m_DrawsOffset[0]);
+    VkDrawIndexedIndirectCommand* late    = reinterpret_cast<VkDrawIndexedIndirectCommand*>(mapped + m_DrawsOffset[1]);
+    uint32_t*                     drawn   = reinterpret_cast<uint32_t*>(mapped + m_InstancesOffset[0]);
+
+    for (uint32_t batchIndex{}; batchIndex < batches.size(); ++batchIndex)
+    {
+        const DrawBatch&   batch = batches[batchIndex];
+        const IndirectMesh mesh  = batch.Mesh < meshes.size() ? meshes[batch.Mesh] : IndirectMesh{};
+
+        VkDrawIndexedIndirectCommand command{};
+        command.indexCount    = mesh.IndexCount;
+        command.instanceCount = 0;
+        command.firstIndex    = mesh.FirstIndex;
+        command.vertexOffset  = mesh.VertexOffset;
+        command.firstInstance = batch.FirstInstance;
+
+        late[batchIndex] = command;
+        if (slot.Fallback)
+            command.instanceCount = batch.InstanceCount;
+        early[batchIndex] = command;
+
+        for (uint32_t idx = batch.FirstInstance; idx < batch.FirstInstance + batch.InstanceCount; ++idx)
+        {
+            const math::Vec3 center  = bounds[idx].Center();
+            const math::Vec3 extents = bounds[idx].Extents();
+
+            // the history is keyed by the world's instance, the draws read per frame data at the queue position
+            const uint32_t history = instances[idx] < m_MaxObjects ? instances[idx] : noSlot;
+            objects[idx] = CullObject{{center.x, center.y, center.z, 0.f}, {extents.x, extents.y, extents.z, 0.f}, batchIndex, idx, history, 0};
+
+            if (slot.Fallback)
+                drawn[idx] = idx;
+        }
+    }
+
+    m_ViewProjection = viewProjection;
+    slot.ObjectCount = static_cast<uint32_t>(instances.size());
+    slot.BatchCount  = static_cast<uint32_t>(batches.size());
+    slot.Prepared    = true;
+    return true;
+}
+
+VkDescriptorSet OcclusionCuller::AllocateSet(Slot& slot, const pipeline::Pipeline& pipeline) SRK_NOEXCEPT
+{
+    VkDescriptorSetAllocateInfo allocateInfo{};
+    allocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.descriptorPool     = slot.Descriptors;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts        = &pipeline.Layout->SetLayouts[0];
+
+    VkDescriptorSet set{VK_NULL_HANDLE};
+    VkResult        result = vkAllocateDescriptorSets(m_Device, &allocateInfo, &set);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Occlusion culling descriptors could not be allocated with {}", result);
+        return VK_NULL_HANDLE;
+    }
+    return set;
+}
+
+bool OcclusionCuller::RecordCull(const Frame& frame, CullPhase phase) SRK_NOEXCEPT
+{
+    Slot& slot = m_Slots[frame.Index];
+    if (!m_Valid || !slot.Prepared || slot.Fallback || frame.CommandBuffer == VK_NULL_HANDLE)
+        return false;
+
+    const bool late = phase == CullPhase::Late;
+    if (late && !slot.HiZBuilt)
+    {
+        SRK_CORE_ERROR("The late occlusion cull needs RecordHiZ first");
+        return false;
+    }
+
+    const pipeline::Pipeline* cull = GetPipeline("OcclusionCull.comp");
+    if (!cull)
+        return false;
+
+    const VkDescriptorSet set = AllocateSet(slot, *cull);
+    if (set == VK_NULL_HANDLE)
+        return false;
+
+    VkCommandBuffer cmd = frame.CommandBuffer;
+
+    // nothing was visible before the first frame, and the early phase binds a pyramid before any was built.
+    // it never samples it, a 1x1 one in the right layout is enough until RecordHiZ replaces it
+    if (!m_VisibilityCleared)
+    {
+        vkCmdFillBuffer(cmd, m_Visibility.Buffer, 0, VK_WHOLE_SIZE, 0);
+        m_VisibilityCleared = true;
+    }
+    if (m_Pyramid.Image == VK_NULL_HANDLE)
+    {
+        if (!EnsurePyramid({1, 1}, frame.Number))
+            return false;
+
+        VkImageMemoryBarrier placeholder{};
+        placeholder.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        placeholder.dstAccessMask               = VK_ACCESS_SHADER_READ_BIT;
+        placeholder.oldLayout                   = VK_IMAGE_LAYOUT_UNDEFINED;
+        placeholder.newLayout                   = VK_IMAGE_LAYOUT_GENERAL;
+        placeholder.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        placeholder.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        placeholder.image                       = m_Pyramid.Image;
+        placeholder.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        placeholder.subresourceRange.levelCount = 1;
+        placeholder.subresourceRange.layerCount = 1;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &placeholder);
+    }
+
+    // the last frame's late phase (or the clear) wrote the history this reads, the early phase's draws are
+    // done reading what this phase's instances share a buffer with
+    VkMemoryBarrier before{};
+    before.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    before.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    before.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &before,
+                         0, nullptr, 0, nullptr);
+
+    const uint32_t index = phaseIndex(phase);
+
+    std::array<VkDescriptorBufferInfo, 4> bufferInfos{};
+    bufferInfos[0] = {slot.Buffer.Buffer, m_ObjectsOffset, VkDeviceSize{std::max(slot.ObjectCount, 1u)} * sizeof(CullObject)};
+    bufferInfos[1] = {m_Visibility.Buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[2] = {slot.Buffer.Buffer, m_DrawsOffset[index], VkDeviceSize{std::max(slot.BatchCount, 1u)} * sizeof(VkDrawIndexedIndirectCommand)};
+    bufferInfos[3] = GetInstances(frame.Index, phase);
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler     = m_Sampler;
+    imageInfo.imageView   = m_Pyramid.View;
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    std::array<VkWriteDescriptorSet, 5> writes{};
+    for (uint32_t binding{}; binding < writes.size(); ++binding)
+    {
+        writes[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet          = set;
+        writes[binding].dstBinding      = binding;
+        writes[binding].descriptorCount = 1;
+        writes[binding].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[binding].pBufferInfo     = binding < bufferInfos.size() ? &bufferInfos[binding] : nullptr;
+    }
+    writes[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[4].pImageInfo     = &imageInfo;
+
+    vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    CullConstants constants{};
+    constants.ViewProjection = m_ViewProjection;
+    constants.HiZSize[0]     = static_cast<float>(m_PyramidExtent.width);
+    constants.HiZSize[1]     = static_cast<float>(m_PyramidExtent.height);
+    constants.ObjectCount    = slot.ObjectCount;
+    constants.Late           = late ? 1 : 0;
+
+    const VkPipelineLayout layout = cull->Layout->Layout;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cull->Handle);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(cmd, layout, cull->Layout->PushConstants.stageFlags, 0, sizeof(constants), &constants);
+    if (slot.ObjectCount > 0)
+        vkCmdDispatch(cmd, (slot.ObjectCount + cullGroupSize - 1) / cullGroupSize, 1, 1);
+
+    // the instance counts feed the indirect draws and the instances the vertex shaders
+    VkMemoryBarrier after{};
+    after.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    after.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    after.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &after,
+                         0, nullptr, 0, nullptr);
+
+    if (late)
+        slot.Culled = true;
+    return true;
+}
+
+bool OcclusionCuller::EnsurePyramid(VkExtent2D depthExtent, uint64_t frame) SRK_NOEXCEPT
+{
+    // level 0 is the depth buffer rounded down to a power of two, so every level halves evenly
+    const VkExtent2D extent{floorPowerOfTwo(std::max(depthExtent.width, 1u)), floorPowerOfTwo(std::max(depthExtent.height, 1u))};
+    if (m_Pyramid.Image != VK_NULL_HANDLE && extent.width == m_PyramidExtent.width && extent.height == m_PyramidExtent.height)
+        return true;
+
+    if (m_Pyramid.Image != VK_NULL_HANDLE)
+    {
+        m_Retired.push_back(Retired{m_Pyramid, std::move(m_PyramidLevels), frame});
+        m_Pyramid = helper::ImageAllocation{};
+        m_PyramidLevels.clear();
+    }
+
+    uint32_t levels = 1;
+    while (levels < maxPyramidLevels && (std::max(extent.width, extent.height) >> levels) > 0)
+        ++levels;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.format        = VK_FORMAT_R32_SFLOAT;
+    imageInfo.extent        = {extent.width, extent.height, 1};
+    imageInfo.mipLevels     = levels;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage         = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkResult result = helper::CreateImage(m_Gpu, m_Device, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Pyramid);
+
+    // a view per level to write it through, the allocation's own view covers all of them for the culling
+    m_PyramidLevels.resize(levels, VK_NULL_HANDLE);
+    for (uint32_t level{}; level < levels && result == VK_SUCCESS; ++level)
+    {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType                         = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image                         = m_Pyramid.Image;
+        viewInfo.viewType                      = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format                        = imageInfo.format;
+        viewInfo.subresourceRange.aspectMask   = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = level;
+        viewInfo.subresourceRange.levelCount   = 1;
+        viewInfo.subresourceRange.layerCount   = 1;
+
+        result = vkCreateImageView(m_Device, &viewInfo, nullptr, &m_PyramidLevels[level]);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Hi-z pyramid of {}x{} could not be created with {}", extent.width, extent.height, result);
+        for (VkImageView view : m_PyramidLevels)
+        {
+            if (view != VK_NULL_HANDLE)
+                vkDestroyImageView(m_Device, view, nullptr);
+        }
+        m_PyramidLevels.clear();
+        helper::DestroyImage(m_Device, m_Pyramid);
+        m_PyramidExtent = {0, 0};
+        return false;
+    }
+
+    m_PyramidExtent = extent;
+    return true;
+}
+
+bool OcclusionCuller::RecordHiZ(const Frame& frame, VkImageView depth, VkImageLayout depthLayout, VkExtent2D extent) SRK_NOEXCEPT
+{
+    Slot& slot = m_Slots[frame.Index];
+    if (!m_Valid || !slot.Prepared || slot.Fallback || frame.CommandBuffer == VK_NULL_HANDLE)
+        return false;
+
+    const pipeline::Pipeline* build = GetPipeline("HiZBuild.comp");
+    if (!build || !EnsurePyramid(extent, frame.Number))
+        return false;
+
+    VkCommandBuffer cmd = frame.CommandBuffer;
+
+    // the depth writes of the early phase have to land, the last frame's culling is done with the pyramid
+    VkImageMemoryBarrier pyramidBarrier{};
+    pyramidBarrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    pyramidBarrier.srcAccessMask               = VK_ACCESS_SHADER_READ_BIT;
+    pyramidBarrier.dstAccessMask               = VK_ACCESS_SHADER_WRITE_BIT;
+    pyramidBarrier.oldLayout                   = VK_IMAGE_LAYOUT_UNDEFINED;
+    pyramidBarrier.newLayout                   = VK_IMAGE_LAYOUT_GENERAL;
+    pyramidBarrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    pyramidBarrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    pyramidBarrier.image                       = m_Pyramid.Image;
+    pyramidBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    pyramidBarrier.subresourceRange.levelCount = static_cast<uint32_t>(m_PyramidLevels.size());
+    pyramidBarrier.subresourceRange.layerCount = 1;
+
+    VkMemoryBarrier depthBarrier{};
+    depthBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    depthBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    depthBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                         &depthBarrier, 0, nullptr, 1, &pyramidBarrier);
+
+    const VkPipelineLayout layout = build->Layout->Layout;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, build->Handle);
+
+    for (uint32_t level{}; level < m_PyramidLevels.size(); ++level)
+    {
+        const VkDescriptorSet set = AllocateSet(slot, *build);
+        if (set == VK_NULL_HANDLE)
+            return false;
+
+        std::array<VkDescriptorImageInfo, 2> imageInfos{};
+        imageInfos[0].sampler     = m_Sampler;
+        imageInfos[0].imageView   = level == 0 ? depth : m_PyramidLevels[level - 1];
+        imageInfos[0].imageLayout = level == 0 ? depthLayout : VK_IMAGE_LAYOUT_GENERAL;
+        imageInfos[1].imageView   = m_PyramidLevels[level];
+        imageInfos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        for (uint32_t binding{}; binding < writes.size(); ++binding)
+        {
+            writes[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[binding].dstSet          = set;
+            writes[binding].dstBinding      = binding;
+            writes[binding].descriptorCount = 1;
+            writes[binding].descriptorType  = binding == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[binding].pImageInfo      = &imageInfos[binding];
+        }
+        vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        const uint32_t width  = std::max(m_PyramidExtent.width >> level, 1u);
+        const uint32_t height = std::max(m_PyramidExtent.height >> level, 1u);
+
+        // level 0 reads only the rendered corner of the depth buffer, every level after all of the one above
+        HiZConstants constants{};
+        constants.SourceSize[0] = static_cast<int32_t>(level == 0 ? extent.width : std::max(m_PyramidExtent.width >> (level - 1), 1u));
+        constants.SourceSize[1] = static_cast<int32_t>(level == 0 ? extent.height : std::max(m_PyramidExtent.height >> (level - 1), 1u));
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+        vkCmdPushConstants(cmd, layout, build->Layout->PushConstants.stageFlags, 0, sizeof(constants), &constants);
+        vkCmdDispatch(cmd, (width + hiZGroupSize - 1) / hiZGroupSize, (height + hiZGroupSize - 1) / hiZGroupSize, 1);
+
+        // the next level reads this one, the late cull all of them
+        VkImageMemoryBarrier levelBarrier          = pyramidBarrier;
+        levelBarrier.srcAccessMask                 = VK_ACCESS_SHADER_WRITE_BIT;
+        levelBarrier.dstAccessMask                 = VK_ACCESS_SHADER_READ_BIT;
+        levelBarrier.oldLayout                     = VK_IMAGE_LAYOUT_GENERAL;
+        levelBarrier.subresourceRange.baseMipLevel = level;
+        levelBarrier.subresourceRange.levelCount   = 1;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+    }
+
+    slot.HiZBuilt = true;
+    return true;
+}
+
+void OcclusionCuller::Draw(const Frame& frame, CullPhase phase, uint32_t batch) const SRK_NOEXCEPT
+{
+    const Slot& slot = m_Slots[frame.Index];
+    if (!slot.Prepared || batch >= slot.BatchCount)
+        return;
+
+    // one draw at a time, multiDrawIndirect is not enabled on the device
+    const VkDeviceSize offset = m_DrawsOffset[phaseIndex(phase)] + VkDeviceSize{batch} * sizeof(VkDrawIndexedIndirectCommand);
+    vkCmdDrawIndexedIndirect(frame.CommandBuffer, slot.Buffer.Buffer, offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+VkDescriptorBufferInfo OcclusionCuller::GetInstances(uint32_t frameIndex, CullPhase phase) const SRK_NOEXCEPT
+{
+    const Slot& slot = m_Slots[frameIndex];
+    return {slot.Buffer.Buffer, m_InstancesOffset[phaseIndex(phase)], VkDeviceSize{std::max(m_MaxObjects, 1u)} * sizeof(uint32_t)};
+}
+
+} // namespace shrek::render
@@ -0,0 +1,136 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "FrameContext.h"
+#include "RenderQueue.h"
+#include "base/math/Aabb.h"
+#include "base/math/Mat.h"
+#include "helper/Memory.h"
+#include "pipeline/PipelineCache.h"
+#include "pipeline/ShaderLibrary.h"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace shrek::render {
+
+// what a batch's indirect draw needs of its mesh, indexed by DrawBatch::Mesh
+struct IndirectMesh
+{
+    uint32_t    IndexCount{0};
+    uint32_t    FirstIndex{0}; // in indices of IndexType from the start of the index buffer
+    int32_t     VertexOffset{0};
+    VkIndexType IndexType{VK_INDEX_TYPE_UINT32};
+};
+
+enum class CullPhase : uint32_t
+{
+    Early, // whatever was visible last frame, untested
+    Late   // everything else that passes the hi-z test
+};
+
+std::string_view ToString(CullPhase phase) SRK_NOEXCEPT;
+
+struct OcclusionStats
+{
+    uint32_t Objects{0};    // that went into the cull, the frustum already took out the rest
+    uint32_t EarlyDrawn{0}; // were visible last frame
+    uint32_t LateDrawn{0};  // were hidden last frame and showed up again
+    uint32_t Occluded{0};   // cost neither vertex nor fragment work
+};
+
+/*
+ *  Hi-z occlusion culling on the gpu for whatever the frustum cull put in a RenderQueue, turning every batch
+ *  into an indirect draw whose instance count the culling writes. A frame goes through it in two phases:
+ *
+ *      Prepare                                          (the queue's objects and draws into this frame's buffer)
+ *      RecordCull(Early), Draw(Early, batch) per batch  (what was visible last frame, untested)
+ *      RecordHiZ                                        (the max depth pyramid of what the early phase drew)
+ *      RecordCull(Late), Draw(Late, batch) per batch    (the rest that the pyramid doesn't hide)
+ *
+ *  The late cull also remembers what was visible for the next frame's early phase, keyed by the queue's
+ *  instance index, objects past maxObjects have no history and are always drawn early. Draws read
+ *  instances[gl_InstanceIndex] from GetInstances, which holds the queue positions of the survivors, so per
+ *  instance data laid out like queue.GetInstances() is found at the position.
+ *  Until the culling pipelines are compiled every instance is drawn in the early phase.
+ */
+class OcclusionCuller
+{
+public:
+    OcclusionCuller(VkPhysicalDevice gpu, VkDevice device, pipeline::ShaderLibrary& shaders, pipeline::PipelineCache& pipelines, uint32_t maxObjects) SRK_NOEXCEPT;
+    ~OcclusionCuller() SRK_NOEXCEPT;
+
+    OcclusionCuller(const OcclusionCuller& other) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller& other) = delete;
+
+    // after FrameContext::BeginFrame, reads back how many instances the frame that last used the slot drew
+    void BeginFrame(const Frame& frame) SRK_NOEXCEPT;
+
+    // bounds are world space, one per queue.GetInstances() entry. false when the queue doesn't fit, nothing is drawn then
+    bool Prepare(const Frame& frame, const RenderQueue& queue, const math::Aabb* bounds, const std::vector<IndirectMesh>& meshes,
+                 const math::Mat4& viewProjection) SRK_NOEXCEPT;
+
+    // outside a render pass. false when it didn't run, the phase draws nothing new then
+    bool RecordCull(const Frame& frame, CullPhase phase) SRK_NOEXCEPT;
+    // outside a render pass, with the early phase's depth readable through depth in depthLayout. extent is the
+    // corner of it that was rendered, the viewport the cull projects into
+    bool RecordHiZ(const Frame& frame, VkImageView depth, VkImageLayout depthLayout, VkExtent2D extent) SRK_NOEXCEPT;
+
+    // inside the render pass, once whatever the batch's DrawBatch::Changes asked for is bound
+    void                   Draw(const Frame& frame, CullPhase phase, uint32_t batch) const SRK_NOEXCEPT;
+    VkDescriptorBufferInfo GetInstances(uint32_t frameIndex, CullPhase phase) const SRK_NOEXCEPT;
+
+    bool                  IsValid() const SRK_NOEXCEPT { return m_Valid; }
+    const OcclusionStats& GetStats() const SRK_NOEXCEPT { return m_Stats; }
+
+private:
+    struct Slot
+    {
+        helper::BufferAllocation Buffer; // host visible, the ranges below one after another
+        VkDescriptorPool         Descriptors{VK_NULL_HANDLE};
+        uint32_t                 ObjectCount{0};
+        uint32_t                 BatchCount{0};
+        bool                     Prepared{false};
+        bool                     Culled{false};   // the late phase ran, the draws are worth reading back
+        bool                     Fallback{false}; // everything went into the early draws on the cpu
+        bool                     HiZBuilt{false};
+    };
+
+    struct Retired
+    {
+        helper::ImageAllocation  Image;
+        std::vector<VkImageView> Levels;
+        uint64_t                 Frame{0};
+    };
+
+    const pipeline::Pipeline* GetPipeline(const char* shader) SRK_NOEXCEPT;
+    bool                      EnsurePyramid(VkExtent2D depthExtent, uint64_t frame) SRK_NOEXCEPT;
+    VkDescriptorSet           AllocateSet(Slot& slot, const pipeline::Pipeline& pipeline) SRK_NOEXCEPT;
+
+private:
+    VkPhysicalDevice         m_Gpu;
+    VkDevice                 m_Device;
+    pipeline::ShaderLibrary& m_Shaders;
+    pipeline::PipelineCache& m_Pipelines;
+    uint32_t                 m_MaxObjects;
+    bool                     m_Valid;
+
+    // offsets into every slot's buffer, each aligned for binding as a storage buffer
+    VkDeviceSize                m_ObjectsOffset;
+    std::array<VkDeviceSize, 2> m_DrawsOffset;
+    std::array<VkDeviceSize, 2> m_InstancesOffset;
+    std::vector<Slot>           m_Slots;
+    helper::BufferAllocation    m_Visibility; // device local, a uint per history slot
+    bool                        m_VisibilityCleared;
+    math::Mat4                  m_ViewProjection;
+    VkSampler                   m_Sampler;
+    helper::ImageAllocation     m_Pyramid;
+    std::vector<VkImageView>    m_PyramidLevels;
+    VkExtent2D                  m_PyramidExtent;
+    std::vector<Retired>        m_Retired;
+    OcclusionStats              m_Stats;
+};
+
+} // namespace shrek::render
@@ -0,0 +1,564 @@
+#include "pch.h"
+#include "PostChain.h"
+
+#include "base/Config.h"
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace shrek::render {
+
+namespace {
+
+base::ConfigVar<int32_t> bloomLevels{"render.post.bloom_levels", 5, "mips of the bloom pyramid, each one spreads the glow twice as far"};
+base::ConfigVar<float>   bloomThreshold{"render.post.bloom_threshold", 1.f, "brightness the scene has to go over to bloom"};
+base::ConfigVar<float>   bloomStrength{"render.post.bloom_strength", 0.05f, "how much of the bloom is added onto the scene"};
+base::ConfigVar<float>   exposure{"render.post.exposure", 1.f, "scene color is scaled by this before tonemapping"};
+
+constexpr VkFormat hdrFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+constexpr VkFormat ldrFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+// local size of every post shader
+constexpr uint32_t groupSize = 8;
+
+constexpr std::array<std::string_view, MaxBloomLevels> downsampleNames{"bloom.down0", "bloom.down1", "bloom.down2", "bloom.down3",
+                                                                       "bloom.down4", "bloom.down5", "bloom.down6", "bloom.down7"};
+constexpr std::array<std::string_view, MaxBloomLevels> upsampleNames{"bloom.up0", "bloom.up1", "bloom.up2", "bloom.up3",
+                                                                     "bloom.up4", "bloom.up5", "bloom.up6", "bloom.up7"};
+
+// push constants, laid out as in the shaders
+struct DownsampleConstants
+{
+    float    Threshold;
+    uint32_t Prefilter;
+};
+
+struct TonemapConstants
+{
+    float Exposure;
+    float BloomStrength;
+};
+
+bool hasTimestamps(const std::vector<VkQueueFamilyProperties>& families, uint32_t family) SRK_NOEXCEPT
+{
+    return family < families.size() && families[family].timestampValidBits != 0;
+}
+
+} // namespace
+
+PostChain::PostChain(VkPhysicalDevice gpu, VkDevice device, const helper::QueueFamilyIndices& families, VkQueue graphicsQueue, VkQueue computeQueue,
+                     pipeline::ShaderLibrary& shaders, pipeline::PipelineCache& pipelines, ImagePool& images) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Queue(computeQueue != VK_NULL_HANDLE ? computeQueue : graphicsQueue),
+    m_Async(computeQueue != VK_NULL_HANDLE && families.Compute.has_value()),
+    m_Shaders(shaders),
+    m_Pipelines(pipelines),
+    m_Images(images),
+    m_Sampler(VK_NULL_HANDLE),
+    m_Slots(GetFramesInFlight()),
+    m_Current(0),
+    m_Pending(false),
+    m_Output(),
+    m_Valid(false),
+    m_NanosecondsPerTick(0.f),
+    m_Unfinished(),
+    m_ChainBegin(0.0),
+    m_ChainEnd(0.0),
+    m_HasUnfinished(false),
+    m_Timings()
+{
+    const uint32_t family = m_Async ? families.Compute.value() : families.Graphics;
+
+    // the overlap can only be measured with timestamps on both queues
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(gpu, &properties);
+
+    uint32_t familyCount{0};
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> familyProperties(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, familyProperties.data());
+
+    const bool timestamps = hasTimestamps(familyProperties, family) && hasTimestamps(familyProperties, families.Graphics) && properties.limits.timestampPeriod > 0.f;
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter    = VK_FILTER_LINEAR;
+    samplerInfo.minFilter    = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod       = 0.f;
+
+    VkResult result = vkCreateSampler(m_Device, &samplerInfo, nullptr, &m_Sampler);
+
+    // every pass allocates one set, reading up to two images and writing one
+    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = MaxPostPasses * 2;
+    poolSizes[1].type            = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[1].descriptorCount = MaxPostPasses;
+
+    for (Slot& slot : m_Slots)
+    {
+        if (result != VK_SUCCESS)
+            break;
+
+        // signaled so the first wait on every slot returns straight away
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = family;
+
+        VkDescriptorPoolCreateInfo descriptorInfo{};
+        descriptorInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorInfo.maxSets       = MaxPostPasses;
+        descriptorInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        descriptorInfo.pPoolSizes    = poolSizes.data();
+
+        result = vkCreateFence(m_Device, &fenceInfo, nullptr, &slot.Fence);
+        if (result == VK_SUCCESS)
+            result = vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &slot.GraphicsDone);
+        if (result == VK_SUCCESS)
+            result = vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &slot.ComputeDone);
+        if (result == VK_SUCCESS)
+            result = vkCreateCommandPool(m_Device, &poolInfo, nullptr, &slot.Pool);
+        if (result == VK_SUCCESS)
+            result = vkCreateDescriptorPool(m_Device, &descriptorInfo, nullptr, &slot.Descriptors);
+
+        if (result == VK_SUCCESS)
+        {
+            VkCommandBufferAllocateInfo allocateInfo{};
+            allocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocateInfo.commandPool        = slot.Pool;
+            allocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocateInfo.commandBufferCount = 1;
+
+            result = vkAllocateCommandBuffers(m_Device, &allocateInfo, &slot.CommandBuffer);
+        }
+
+        if (result == VK_SUCCESS && timestamps)
+        {
+            VkQueryPoolCreateInfo queryInfo{};
+            queryInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+            queryInfo.queryCount = MaxPostPasses * 2;
+
+            result = vkCreateQueryPool(m_Device, &queryInfo, nullptr, &slot.PassTimestamps);
+            if (result == VK_SUCCESS)
+            {
+                queryInfo.queryCount = 2;
+                result               = vkCreateQueryPool(m_Device, &queryInfo, nullptr, &slot.GraphicsTimestamps);
+            }
+        }
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Post chain could not be created with {}", result);
+        Destroy();
+        return;
+    }
+
+    if (timestamps)
+        m_NanosecondsPerTick = properties.limits.timestampPeriod;
+    else
+        SRK_CORE_WARN("No gpu timestamps on the graphics and compute queues, post timings stay empty");
+
+    SRK_CORE_INFO("Post processing runs on the {} queue", m_Async ? "compute" : "graphics");
+    m_Valid = true;
+}
+
+PostChain::~PostChain() SRK_NOEXCEPT
+{
+    Destroy();
+}
+
+void PostChain::Destroy() SRK_NOEXCEPT
+{
+    for (Slot& slot : m_Slots)
+    {
+        // nothing may be destroyed while the gpu still uses it
+        if (slot.Fence != VK_NULL_HANDLE)
+        {
+            vkWaitForFences(m_Device, 1, &slot.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            vkDestroyFence(m_Device, slot.Fence, nullptr);
+        }
+
+        if (slot.GraphicsDone != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_Device, slot.GraphicsDone, nullptr);
+        if (slot.ComputeDone != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_Device, slot.ComputeDone, nullptr);
+        if (slot.Pool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(m_Device, slot.Pool, nullptr);
+        if (slot.Descriptors != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_Device, slot.Descriptors, nullptr);
+        if (slot.PassTimestamps != VK_NULL_HANDLE)
+            vkDestroyQueryPool(m_Device, slot.PassTimestamps, nullptr);
+        if (slot.GraphicsTimestamps != VK_NULL_HANDLE)
+            vkDestroyQueryPool(m_Device, slot.GraphicsTimestamps, nullptr);
+
+        slot = Slot{};
+    }
+
+    if (m_Sampler != VK_NULL_HANDLE)
+        vkDestroySampler(m_Device, m_Sampler, nullptr);
+
+    m_Sampler = VK_NULL_HANDLE;
+    m_Valid   = false;
+}
+
+void PostChain::BeginFrame(const Frame& frame) SRK_NOEXCEPT
+{
+    m_Current = frame.Index;
+    m_Pending = false;
+    if (!m_Valid)
+        return;
+
+    // the graphics side of the slot was already waited on by FrameContext, the compute side is only done once this signals
+    Slot& slot = m_Slots[frame.Index];
+    vkWaitForFences(m_Device, 1, &slot.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    ReadTimings(slot);
+
+    vkResetDescriptorPool(m_Device, slot.Descriptors, 0);
+    slot.Output    = nullptr;
+    slot.PassCount = 0;
+    slot.Frame     = frame.Number;
+    slot.Recorded  = false;
+    slot.Timed     = false;
+
+    if (m_NanosecondsPerTick > 0.f && frame.CommandBuffer != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(frame.CommandBuffer, slot.GraphicsTimestamps, 0, 2);
+        vkCmdWriteTimestamp(frame.CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.GraphicsTimestamps, 0);
+        slot.Timed = true;
+    }
+}
+
+const pipeline::Pipeline* PostChain::GetPipeline(const char* shader) SRK_NOEXCEPT
+{
+    pipeline::PipelineDesc desc;
+    desc.Shaders[0]  = m_Shaders.Get(shader);
+    desc.ShaderCount = 1;
+    if (!desc.Shaders[0])
+        return nullptr;
+
+    return m_Pipelines.Get(desc);
+}
+
+bool PostChain::Record(const Frame& frame, const PostInput& input) SRK_NOEXCEPT
+{
+    Slot& slot = m_Slots[frame.Index];
+    if (!m_Valid || slot.Recorded || !input.Color)
+        return false;
+
+    const pipeline::Pipeline* downsample = GetPipeline("BloomDownsample.comp");
+    const pipeline::Pipeline* upsample   = GetPipeline("BloomUpsample.comp");
+    const pipeline::Pipeline* tonemap    = GetPipeline("Tonemap.comp");
+    if (!downsample || !upsample || !tonemap)
+        return false;
+
+    // the pyramid stops once the next level would be smaller than a pixel
+    const VkExtent2D extent = input.Color->Extent;
+    uint32_t         levels = static_cast<uint32_t>(std::clamp<int32_t>(bloomLevels, 1, static_cast<int32_t>(MaxBloomLevels)));
+    while (levels > 1 && (std::min(extent.width, extent.height) >> levels) == 0)
+        --levels;
+
+    // down[i] is half of down[i - 1], up[i] the same size as down[i] with everything below it added on
+    const VkImageUsageFlags usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    std::array<const PooledImage*, MaxBloomLevels> down{};
+    std::array<const PooledImage*, MaxBloomLevels> up{};
+    std::array<VkImage, MaxBloomLevels * 2 + 1>    images{};
+    uint32_t                                       imageCount{0};
+
+    for (uint32_t level{}; level < levels; ++level)
+    {
+        const VkExtent2D size{std::max(extent.width >> (level + 1), 1u), std::max(extent.height >> (level + 1), 1u)};
+        down[level] = m_Images.Acquire({size, hdrFormat, usage});
+        up[level]   = level + 1 < levels ? m_Images.Acquire({size, hdrFormat, usage}) : down[level];
+        if (!down[level] || !up[level])
+            return false;
+
+        images[imageCount++] = down[level]->Image;
+        if (up[level] != down[level])
+            images[imageCount++] = up[level]->Image;
+    }
+
+    const PooledImage* output = m_Images.Acquire({extent, ldrFormat, usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT});
+    if (!output)
+        return false;
+    images[imageCount++] = output->Image;
+
+    vkResetCommandPool(m_Device, slot.Pool, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkResult result = vkBeginCommandBuffer(slot.CommandBuffer, &beginInfo);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Post chain command buffer could not be begun with {}", result);
+        return false;
+    }
+
+    if (slot.PassTimestamps != VK_NULL_HANDLE)
+        vkCmdResetQueryPool(slot.CommandBuffer, slot.PassTimestamps, 0, MaxPostPasses * 2);
+
+    // pooled images come undefined, everything is written and read in general from here on
+    std::array<VkImageMemoryBarrier, MaxBloomLevels * 2 + 1> barriers{};
+    for (uint32_t idx{}; idx < imageCount; ++idx)
+    {
+        VkImageMemoryBarrier& barrier       = barriers[idx];
+        barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask               = 0;
+        barrier.dstAccessMask               = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout                   = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout                   = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image                       = images[idx];
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+    }
+    vkCmdPipelineBarrier(slot.CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                         imageCount, barriers.data());
+
+    // only the first downsample thresholds the scene, the rest just filter
+    for (uint32_t level{}; level < levels; ++level)
+    {
+        const Binding             source    = level == 0 ? Binding{0, input.Color->View, input.Layout} : Binding{0, down[level - 1]->View};
+        const DownsampleConstants constants = {bloomThreshold, level == 0 ? 1u : 0u};
+        RecordPass(slot, downsampleNames[level], *downsample, *down[level], &source, 1, &constants, sizeof(constants));
+    }
+
+    for (uint32_t level = levels - 1; level-- > 0;)
+    {
+        const std::array<Binding, 2> sources = {Binding{0, up[level + 1]->View}, Binding{2, down[level]->View}};
+        RecordPass(slot, upsampleNames[level], *upsample, *up[level], sources.data(), static_cast<uint32_t>(sources.size()), nullptr, 0);
+    }
+
+    const std::array<Binding, 2> sources   = {Binding{0, input.Color->View, input.Layout}, Binding{2, up[0]->View}};
+    const TonemapConstants       constants = {exposure, bloomStrength};
+    RecordPass(slot, "tonemap", *tonemap, *output, sources.data(), static_cast<uint32_t>(sources.size()), &constants, sizeof(constants));
+
+    result = vkEndCommandBuffer(slot.CommandBuffer);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Post chain command buffer could not be ended with {}", result);
+        return false;
+    }
+
+    slot.Output   = output;
+    slot.Rendered = input.Rendered;
+    slot.Recorded = true;
+    m_Pending     = true;
+    return true;
+}
+
+void PostChain::RecordPass(Slot& slot, std::string_view name, const pipeline::Pipeline& pipeline, const PooledImage& output, const Binding* sampled,
+                           uint32_t sampledCount, const void* constants, uint32_t constantsSize) SRK_NOEXCEPT
+{
+    const uint32_t pass = slot.PassCount++;
+
+    slot.PassNames[pass] = name;
+
+    if (slot.PassTimestamps != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(slot.CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.PassTimestamps, pass * 2);
+
+    VkDescriptorSetAllocateInfo allocateInfo{};
+    allocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.descriptorPool     = slot.Descriptors;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts        = &pipeline.Layout->SetLayouts[0];
+
+    VkDescriptorSet set{VK_NULL_HANDLE};
+    VkResult        result = vkAllocateDescriptorSets(m_Device, &allocateInfo, &set);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Post pass {} descriptors could not be allocated with {}", name, result);
+        return;
+    }
+
+    // the output is always binding 1
+    std::array<VkDescriptorImageInfo, 3> imageInfos{};
+    std::array<VkWriteDescriptorSet, 3>  writes{};
+    const uint32_t                       writeCount = std::min(sampledCount, 2u) + 1;
+    for (uint32_t idx{}; idx < writeCount; ++idx)
+    {
+        const bool isOutput = idx == writeCount - 1;
+
+        imageInfos[idx].sampler     = isOutput ? VK_NULL_HANDLE : m_Sampler;
+        imageInfos[idx].imageView   = isOutput ? output.View : sampled[idx].View;
+        imageInfos[idx].imageLayout = isOutput ? VK_IMAGE_LAYOUT_GENERAL : sampled[idx].Layout;
+
+        writes[idx].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[idx].dstSet          = set;
+        writes[idx].dstBinding      = isOutput ? 1 : sampled[idx].Index;
+        writes[idx].descriptorCount = 1;
+        writes[idx].descriptorType  = isOutput ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[idx].pImageInfo      = &imageInfos[idx];
+    }
+    vkUpdateDescriptorSets(m_Device, writeCount, writes.data(), 0, nullptr);
+
+    const VkPipelineLayout layout = pipeline.Layout->Layout;
+    vkCmdBindPipeline(slot.CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Handle);
+    vkCmdBindDescriptorSets(slot.CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+    if (constants && pipeline.Layout->PushConstants.size >= constantsSize)
+        vkCmdPushConstants(slot.CommandBuffer, layout, pipeline.Layout->PushConstants.stageFlags, 0, constantsSize, constants);
+
+    vkCmdDispatch(slot.CommandBuffer, (output.Extent.width + groupSize - 1) / groupSize, (output.Extent.height + groupSize - 1) / groupSize, 1);
+
+    // the next pass samples what this one wrote
+    VkImageMemoryBarrier barrier{};
+    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask               = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask               = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout                   = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout                   = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                       = output.Image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(slot.CommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                         &barrier);
+
+    if (slot.PassTimestamps != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(slot.CommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot.PassTimestamps, pass * 2 + 1);
+}
+
+VkSemaphore PostChain::EndFrame(const Frame& frame) SRK_NOEXCEPT
+{
+    Slot& slot = m_Slots[frame.Index];
+    if (!m_Valid)
+        return VK_NULL_HANDLE;
+
+    if (slot.Timed && frame.CommandBuffer != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(frame.CommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot.GraphicsTimestamps, 1);
+
+    return m_Pending ? slot.GraphicsDone : VK_NULL_HANDLE;
+}
+
+VkResult PostChain::Submit(bool graphicsSubmitted) SRK_NOEXCEPT
+{
+    if (!m_Pending)
+        return VK_SUCCESS;
+
+    Slot& slot = m_Slots[m_Current];
+    m_Pending  = false;
+
+    // the graphics timestamps were never written either
+    if (!graphicsSubmitted)
+    {
+        slot.Output   = nullptr;
+        slot.Recorded = false;
+        slot.Timed    = false;
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // only the passes wait, the compute queue is free to finish the previous frame's chain in the meantime.
+    // an output nobody took is waited on here instead, so its semaphore is unsignaled before it's used again
+    const std::array<VkPipelineStageFlags, 2> waitStages{VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+    const std::array<VkSemaphore, 2>          waits{slot.GraphicsDone, m_Output.Done};
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount   = m_Output.Done != VK_NULL_HANDLE ? 2 : 1;
+    submitInfo.pWaitSemaphores      = waits.data();
+    submitInfo.pWaitDstStageMask    = waitStages.data();
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.pCommandBuffers      = &slot.CommandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &slot.ComputeDone;
+
+    vkResetFences(m_Device, 1, &slot.Fence);
+    VkResult result = vkQueueSubmit(m_Queue, 1, &submitInfo, slot.Fence);
+    if (result != VK_SUCCESS)
+    {
+        // the fence will never signal, put it back so the next wait on this slot doesn't hang
+        SRK_CORE_ERROR("Post chain submit failed with {}", result);
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        vkDestroyFence(m_Device, slot.Fence, nullptr);
+        vkCreateFence(m_Device, &fenceInfo, nullptr, &slot.Fence);
+
+        slot.Output   = nullptr;
+        slot.Recorded = false;
+        return result;
+    }
+
+    m_Output = PostOutput{slot.Output, slot.ComputeDone, slot.Rendered};
+    return result;
+}
+
+PostOutput PostChain::TakeOutput() SRK_NOEXCEPT
+{
+    const PostOutput output = m_Output;
+    m_Output                = PostOutput{};
+    if (output.Image)
+        m_Images.Keep(*output.Image);
+    return output;
+}
+
+void PostChain::ReadTimings(Slot& slot) SRK_NOEXCEPT
+{
+    if (!slot.Timed)
+        return;
+
+    // both fences of the slot were waited on, nothing here has to wait
+    auto toMs = [this](uint64_t ticks) { return static_cast<double>(ticks) * m_NanosecondsPerTick / 1e6; };
+
+    std::array<uint64_t, 2> graphics{};
+    if (vkGetQueryPoolResults(m_Device, slot.GraphicsTimestamps, 0, 2, sizeof(graphics), graphics.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        return;
+
+    const double graphicsBegin = toMs(graphics[0]);
+    const double graphicsEnd   = toMs(graphics[1]);
+
+    // the chain of the frame before was meant to run during this frame's graphics work
+    if (m_HasUnfinished)
+    {
+        if (m_Unfinished.Frame + 1 == slot.Frame)
+        {
+            m_Unfinished.GraphicsMs = graphicsEnd - graphicsBegin;
+            m_Unfinished.OverlapMs  = std::max(0.0, std::min(m_ChainEnd, graphicsEnd) - std::max(m_ChainBegin, graphicsBegin));
+        }
+        m_Timings       = m_Unfinished;
+        m_HasUnfinished = false;
+    }
+
+    if (!slot.Recorded || slot.PassCount == 0)
+        return;
+
+    std::array<uint64_t, MaxPostPasses * 2> passes{};
+    if (vkGetQueryPoolResults(m_Device, slot.PassTimestamps, 0, slot.PassCount * 2, slot.PassCount * 2 * sizeof(uint64_t), passes.data(),
+                              sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        return;
+
+    m_Unfinished           = PostTimings{};
+    m_Unfinished.PassCount = slot.PassCount;
+    m_Unfinished.Frame     = slot.Frame;
+    for (uint32_t pass{}; pass < slot.PassCount; ++pass)
+        m_Unfinished.Passes[pass] = PostPassTiming{slot.PassNames[pass], toMs(passes[pass * 2 + 1]) - toMs(passes[pass * 2])};
+
+    m_ChainBegin         = toMs(passes[0]);
+    m_ChainEnd           = toMs(passes[slot.PassCount * 2 - 1]);
+    m_Unfinished.ChainMs = m_ChainEnd - m_ChainBegin;
+    m_HasUnfinished      = true;
+}
+
+} // namespace shrek::render
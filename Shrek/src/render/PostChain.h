@@ -0,0 +1,155 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "FrameContext.h"
+#include "ImagePool.h"
+#include "helper/QueueFamilyIndices.h"
+#include "pipeline/PipelineCache.h"
+#include "pipeline/ShaderLibrary.h"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace shrek::render {
+
+constexpr uint32_t MaxBloomLevels = 8;
+// a downsample per level, an upsample per level but the last and the tonemap
+constexpr uint32_t MaxPostPasses = MaxBloomLevels * 2;
+
+// the hdr color a frame rendered, handed to the post chain once the graphics work writing it is recorded
+struct PostInput
+{
+    const PooledImage* Color{nullptr};                               // from the ImagePool so it's shared with the compute queue
+    VkImageLayout      Layout{VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}; // what the graphics work left it in, sampled as is
+    VkExtent2D         Rendered{0, 0};                                // the top left corner of Color the scene drew into
+};
+
+// the ldr result of a chain, for whatever puts it on the screen in the frame after
+struct PostOutput
+{
+    const PooledImage* Image{nullptr};       // in VK_IMAGE_LAYOUT_GENERAL
+    VkSemaphore        Done{VK_NULL_HANDLE}; // signaled by the chain's submit, the reading submit has to wait on it
+    VkExtent2D         Rendered{0, 0};       // of the input, the same corner of Image holds the result
+};
+
+struct PostPassTiming
+{
+    std::string_view Name;
+    double           GpuMs{0.0};
+};
+
+struct PostTimings
+{
+    std::array<PostPassTiming, MaxPostPasses> Passes{};
+    uint32_t                                  PassCount{0};
+    uint64_t                                  Frame{0};
+    double                                    ChainMs{0.0};    // from the first pass starting to the last one finishing
+    double                                    GraphicsMs{0.0}; // of the frame after, which the chain should be overlapping
+    double                                    OverlapMs{0.0};  // how long both ran at once, 0 means the chain ran on its own
+};
+
+/*
+ *  Bloom (a 13 tap downsample pyramid and a tent filtered upsample back up it) and tonemapping as compute
+ *  passes on the compute only queue family, so a frame's post processing runs while the graphics queue is
+ *  already on the next one. Without such a family everything goes to the graphics queue in order.
+ *  The graphics submit signals a semaphore the compute submit waits on, the compute side has a fence per
+ *  frame in flight that BeginFrame waits on before the slot's command buffer, descriptors or timestamps are reused.
+ *  Every image in between comes from the ImagePool. Each pass is timestamped along with the graphics
+ *  work of every frame, which is how GetTimings tells whether the two actually overlapped.
+ *  A frame's chain only finishes while the next frame records, so TakeOutput hands the next frame what to
+ *  present along with the semaphore its compute submit signals.
+ */
+class PostChain
+{
+public:
+    // computeQueue is null without a compute only family
+    PostChain(VkPhysicalDevice gpu, VkDevice device, const helper::QueueFamilyIndices& families, VkQueue graphicsQueue, VkQueue computeQueue,
+              pipeline::ShaderLibrary& shaders, pipeline::PipelineCache& pipelines, ImagePool& images) SRK_NOEXCEPT;
+    ~PostChain() SRK_NOEXCEPT;
+
+    PostChain(const PostChain& other) = delete;
+    PostChain& operator=(const PostChain& other) = delete;
+
+    // right after FrameContext::BeginFrame, before the pool's. waits for the slot's post processing and
+    // reads back the timestamps of the frame that last used it
+    void BeginFrame(const Frame& frame) SRK_NOEXCEPT;
+
+    // records the whole chain, false when it can't run this frame (pipelines still compiling)
+    bool Record(const Frame& frame, const PostInput& input) SRK_NOEXCEPT;
+
+    // what FrameContext::EndFrame has to signal, null when nothing was recorded this frame
+    VkSemaphore EndFrame(const Frame& frame) SRK_NOEXCEPT;
+    // after FrameContext::EndFrame, waits on the graphics work on the gpu and not here. when the graphics
+    // submit failed nothing is going to signal the semaphore and the chain is dropped instead
+    VkResult Submit(bool graphicsSubmitted) SRK_NOEXCEPT;
+
+    // after the pool's BeginFrame, the output of the last chain submitted, which stays taken through this
+    // frame. handed out once so Done is waited on exactly once, empty when no chain finished since
+    PostOutput TakeOutput() SRK_NOEXCEPT;
+
+    bool               IsValid() const SRK_NOEXCEPT { return m_Valid; }
+    bool               IsAsync() const SRK_NOEXCEPT { return m_Async; }
+    const PooledImage* GetOutput(uint32_t frameIndex) const SRK_NOEXCEPT { return m_Slots[frameIndex].Output; } // ldr, in VK_IMAGE_LAYOUT_GENERAL
+    const PostTimings& GetTimings() const SRK_NOEXCEPT { return m_Timings; }
+
+private:
+    struct Slot
+    {
+        VkFence          Fence{VK_NULL_HANDLE};
+        VkSemaphore      GraphicsDone{VK_NULL_HANDLE};
+        VkSemaphore      ComputeDone{VK_NULL_HANDLE};
+        VkCommandPool    Pool{VK_NULL_HANDLE};
+        VkCommandBuffer  CommandBuffer{VK_NULL_HANDLE};
+        VkDescriptorPool Descriptors{VK_NULL_HANDLE};
+        VkQueryPool      PassTimestamps{VK_NULL_HANDLE};     // on the compute queue, a begin and end per pass
+        VkQueryPool      GraphicsTimestamps{VK_NULL_HANDLE}; // around the frame's graphics command buffer
+
+        const PooledImage*                          Output{nullptr};
+        VkExtent2D                                  Rendered{0, 0};
+        std::array<std::string_view, MaxPostPasses> PassNames{};
+        uint32_t                                    PassCount{0};
+        uint64_t                                    Frame{0};
+        bool                                        Recorded{false}; // the chain was recorded for Frame
+        bool                                        Timed{false};    // the graphics timestamps were written for Frame
+    };
+
+    struct Binding
+    {
+        uint32_t      Index{0};
+        VkImageView   View{VK_NULL_HANDLE};
+        VkImageLayout Layout{VK_IMAGE_LAYOUT_GENERAL};
+    };
+
+    // one dispatch over output, reading the sampled bindings. the output is readable by the next pass once it returns
+    void RecordPass(Slot& slot, std::string_view name, const pipeline::Pipeline& pipeline, const PooledImage& output, const Binding* sampled,
+                    uint32_t sampledCount, const void* constants, uint32_t constantsSize) SRK_NOEXCEPT;
+    const pipeline::Pipeline* GetPipeline(const char* shader) SRK_NOEXCEPT;
+    void                      ReadTimings(Slot& slot) SRK_NOEXCEPT;
+    void                      Destroy() SRK_NOEXCEPT;
+
+private:
+    VkDevice                 m_Device;
+    VkQueue                  m_Queue;
+    bool                     m_Async;
+    pipeline::ShaderLibrary& m_Shaders;
+    pipeline::PipelineCache& m_Pipelines;
+    ImagePool&               m_Images;
+    VkSampler                m_Sampler;
+    std::vector<Slot>        m_Slots;
+    uint32_t                 m_Current;
+    bool                     m_Pending; // recorded this frame and waiting for Submit
+    PostOutput               m_Output;  // of the last submit, until TakeOutput
+    bool                     m_Valid;
+
+    // a frame's timings are only complete once the next frame's graphics work has been read back as well
+    float       m_NanosecondsPerTick; // 0 without timestamps on both queues
+    PostTimings m_Unfinished;
+    double      m_ChainBegin; // of m_Unfinished, in ms on the gpu clock
+    double      m_ChainEnd;
+    bool        m_HasUnfinished;
+    PostTimings m_Timings;
+};
+
+} // namespace shrek::render
@@ -0,0 +1,539 @@
+#include "pch.h"
+#include "Regression.h"
+
+#include "base/Json.h"
+#include "helper/Debug.h"
+#include "platform/Log.h"
+#include "platform/MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+
+namespace shrek::render {
+
+namespace {
+
+// largest possible yiq distance, between black and white
+constexpr float maxYiqDelta = 35215.f;
+
+float yiqDelta(const uint8_t* lhs, const uint8_t* rhs) SRK_NOEXCEPT
+{
+    const float r = static_cast<float>(lhs[0]) - rhs[0];
+    const float g = static_cast<float>(lhs[1]) - rhs[1];
+    const float b = static_cast<float>(lhs[2]) - rhs[2];
+
+    const float y = r * 0.29889531f + g * 0.58662247f + b * 0.11448223f;
+    const float i = r * 0.59597799f - g * 0.27417610f - b * 0.32180189f;
+    const float q = r * 0.21147017f - g * 0.52261711f + b * 0.31114694f;
+    return 0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q;
+}
+
+double median(std::vector<double>& values) SRK_NOEXCEPT
+{
+    if (values.empty())
+        return 0.0;
+
+    auto middle = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+} // namespace
+
+std::string_view ToString(RegressionStatus status) SRK_NOEXCEPT
+{
+#define TO_STRING(X)          \
+    case RegressionStatus::X: \
+        return #X
+    switch (status)
+    {
+        TO_STRING(Passed);
+        TO_STRING(Updated);
+        TO_STRING(NoGolden);
+        TO_STRING(ImageMismatch);
+        TO_STRING(OverBudget);
+        TO_STRING(Failed);
+        default:
+            return "UNKNOWN";
+    }
+#undef TO_STRING
+}
+
+ImageDifference CompareImages(const asset::Image& expected, const asset::Image& actual, float threshold, std::vector<uint8_t>* diff) SRK_NOEXCEPT
+{
+    ImageDifference difference;
+    if (expected.Width != actual.Width || expected.Height != actual.Height)
+    {
+        difference.DifferentPixels = std::max(expected.Width * expected.Height, actual.Width * actual.Height);
+        difference.MaxDifference   = 1.f;
+        return difference;
+    }
+
+    const size_t pixelCount = size_t{expected.Width} * expected.Height;
+    const float  limit      = maxYiqDelta * threshold * threshold;
+    if (diff)
+        diff->resize(pixelCount * 4);
+
+    float maxDelta{0.f};
+    for (size_t idx{}; idx < pixelCount; ++idx)
+    {
+        const uint8_t* lhs   = expected.Pixels.data() + idx * 4;
+        const uint8_t* rhs   = actual.Pixels.data() + idx * 4;
+        const float    delta = yiqDelta(lhs, rhs);
+        maxDelta             = std::max(maxDelta, delta);
+
+        const bool different = delta > limit;
+        if (different)
+            ++difference.DifferentPixels;
+
+        if (diff)
+        {
+            uint8_t* pixel = diff->data() + idx * 4;
+            if (different)
+            {
+                pixel[0] = 255;
+                pixel[1] = 0;
+                pixel[2] = 0;
+            }
+            else
+            {
+                // the expected image as faded gray, enough to see where the red is
+                const uint8_t gray = static_cast<uint8_t>(255 - (255 - (lhs[0] * 77 + lhs[1] * 150 + lhs[2] * 29) / 256) / 4);
+                pixel[0]           = gray;
+                pixel[1]           = gray;
+                pixel[2]           = gray;
+            }
+            pixel[3] = 255;
+        }
+    }
+
+    difference.MaxDifference = std::sqrt(maxDelta / maxYiqDelta);
+    return difference;
+}
+
+RegressionRunner::RegressionRunner(VkPhysicalDevice gpu, VkDevice device, VkQueue queue, uint32_t queueFamily, RegressionSettings settings) SRK_NOEXCEPT :
+    m_Gpu(gpu),
+    m_Device(device),
+    m_Queue(queue),
+    m_Settings(std::move(settings)),
+    m_Valid(false),
+    m_RenderPass(VK_NULL_HANDLE),
+    m_Pool(VK_NULL_HANDLE),
+    m_CommandBuffer(VK_NULL_HANDLE),
+    m_Fence(VK_NULL_HANDLE),
+    m_Timestamps(VK_NULL_HANDLE),
+    m_NanosecondsPerTick(0.0),
+    m_Target(),
+    m_Results()
+{
+    // cleared on load and left ready to be copied out
+    VkAttachmentDescription color{};
+    color.format         = TargetFormat;
+    color.samples        = VK_SAMPLE_COUNT_1_BIT;
+    color.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+    color.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    color.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+    color.finalLayout    = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentReference colorReference{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments    = &colorReference;
+
+    // the copy after the pass waits for the color writes
+    VkSubpassDependency dependency{};
+    dependency.srcSubpass    = 0;
+    dependency.dstSubpass    = VK_SUBPASS_EXTERNAL;
+    dependency.srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments    = &color;
+    renderPassInfo.subpassCount    = 1;
+    renderPassInfo.pSubpasses      = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies   = &dependency;
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = queueFamily;
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkResult result = vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &m_RenderPass);
+    if (result == VK_SUCCESS)
+        result = vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_Pool);
+    if (result == VK_SUCCESS)
+        result = vkCreateFence(m_Device, &fenceInfo, nullptr, &m_Fence);
+
+    if (result == VK_SUCCESS)
+    {
+        VkCommandBufferAllocateInfo allocateInfo{};
+        allocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.commandPool        = m_Pool;
+        allocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = 1;
+
+        result = vkAllocateCommandBuffers(m_Device, &allocateInfo, &m_CommandBuffer);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Regression runner could not be created with {}", result);
+        return;
+    }
+
+    // timestamps are optional, the gpu budgets are skipped without them
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_Gpu, &properties);
+
+    uint32_t familyCount{0};
+    vkGetPhysicalDeviceQueueFamilyProperties(m_Gpu, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_Gpu, &familyCount, families.data());
+
+    if (queueFamily < familyCount && families[queueFamily].timestampValidBits != 0 && properties.limits.timestampPeriod > 0.f)
+    {
+        VkQueryPoolCreateInfo queryInfo{};
+        queryInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = 2;
+
+        if (vkCreateQueryPool(m_Device, &queryInfo, nullptr, &m_Timestamps) == VK_SUCCESS)
+            m_NanosecondsPerTick = properties.limits.timestampPeriod;
+        else
+            m_Timestamps = VK_NULL_HANDLE;
+    }
+
+    if (m_Timestamps == VK_NULL_HANDLE)
+        SRK_CORE_WARN("No gpu timestamps on this queue, only cpu budgets are checked");
+
+    m_Valid = true;
+}
+
+RegressionRunner::~RegressionRunner() SRK_NOEXCEPT
+{
+    DestroyTarget();
+
+    if (m_Timestamps != VK_NULL_HANDLE)
+        vkDestroyQueryPool(m_Device, m_Timestamps, nullptr);
+    if (m_Fence != VK_NULL_HANDLE)
+        vkDestroyFence(m_Device, m_Fence, nullptr);
+    if (m_Pool != VK_NULL_HANDLE)
+        vkDestroyCommandPool(m_Device, m_Pool, nullptr);
+    if (m_RenderPass != VK_NULL_HANDLE)
+        vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+}
+
+VkResult RegressionRunner::CreateTarget(VkExtent2D extent) SRK_NOEXCEPT
+{
+    if (m_Target.Image != VK_NULL_HANDLE && m_Target.Extent.width == extent.width && m_Target.Extent.height == extent.height)
+        return VK_SUCCESS;
+
+    DestroyTarget();
+    m_Target.Extent = extent;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.format        = TargetFormat;
+    imageInfo.extent        = {extent.width, extent.height, 1};
+    imageInfo.mipLevels     = 1;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage         = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkResult result = vkCreateImage(m_Device, &imageInfo, nullptr, &m_Target.Image);
+    if (result != VK_SUCCESS)
+        return result;
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(m_Device, m_Target.Image, &requirements);
+
+    auto memoryType = helper::FindMemoryType(m_Gpu, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (!memoryType)
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = requirements.size;
+    allocateInfo.memoryTypeIndex = *memoryType;
+
+    result = vkAllocateMemory(m_Device, &allocateInfo, nullptr, &m_Target.Memory);
+    if (result == VK_SUCCESS)
+        result = vkBindImageMemory(m_Device, m_Target.Image, m_Target.Memory, 0);
+    if (result != VK_SUCCESS)
+        return result;
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                       = m_Target.Image;
+    viewInfo.viewType                    = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                      = TargetFormat;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    result = vkCreateImageView(m_Device, &viewInfo, nullptr, &m_Target.View);
+    if (result != VK_SUCCESS)
+        return result;
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass      = m_RenderPass;
+    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.pAttachments    = &m_Target.View;
+    framebufferInfo.width           = extent.width;
+    framebufferInfo.height          = extent.height;
+    framebufferInfo.layers          = 1;
+
+    result = vkCreateFramebuffer(m_Device, &framebufferInfo, nullptr, &m_Target.Framebuffer);
+    if (result != VK_SUCCESS)
+        return result;
+
+    return helper::CreateBuffer(m_Gpu, m_Device, VkDeviceSize{extent.width} * extent.height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Target.Readback);
+}
+
+void RegressionRunner::DestroyTarget() SRK_NOEXCEPT
+{
+    helper::DestroyBuffer(m_Device, m_Target.Readback);
+
+    if (m_Target.Framebuffer != VK_NULL_HANDLE)
+        vkDestroyFramebuffer(m_Device, m_Target.Framebuffer, nullptr);
+    if (m_Target.View != VK_NULL_HANDLE)
+        vkDestroyImageView(m_Device, m_Target.View, nullptr);
+    if (m_Target.Image != VK_NULL_HANDLE)
+        vkDestroyImage(m_Device, m_Target.Image, nullptr);
+    if (m_Target.Memory != VK_NULL_HANDLE)
+        vkFreeMemory(m_Device, m_Target.Memory, nullptr);
+
+    m_Target = Target{};
+}
+
+bool RegressionRunner::Run(const std::vector<RegressionScene>& scenes) SRK_NOEXCEPT
+{
+    m_Results.clear();
+    if (!m_Valid)
+        return false;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_Settings.OutputDirectory, error);
+    if (m_Settings.UpdateGoldens)
+        std::filesystem::create_directories(m_Settings.GoldenDirectory, error);
+
+    // the document points into the file so both have to stay around while the budgets are read
+    MappedFile         budgetFile(m_Settings.BudgetFile);
+    base::JsonDocument budgets;
+    if (!budgetFile.IsValid() || !budgets.Parse(budgetFile.AsString()))
+        SRK_CORE_WARN("No budgets read from {}, only the images are checked", m_Settings.BudgetFile);
+
+    bool     passed{true};
+    uint32_t skipped{0};
+    for (const RegressionScene& scene : scenes)
+    {
+        RegressionResult result = RunScene(scene);
+
+        // a negative budget means the scene has none
+        const base::JsonValue budget = budgets.Root()["scenes"][scene.Name];
+        const double          cpuMs  = budget["cpu_ms"].AsNumber(-1.0);
+        const double          gpuMs  = budget["gpu_ms"].AsNumber(-1.0);
+        if (result.Status == RegressionStatus::Passed && ((cpuMs >= 0.0 && result.CpuMs > cpuMs) || (m_Timestamps != VK_NULL_HANDLE && gpuMs >= 0.0 && result.GpuMs > gpuMs)))
+            result.Status = RegressionStatus::OverBudget;
+
+        const bool skip   = result.Status == RegressionStatus::NoGolden && !m_Settings.RequireGoldens;
+        const bool failed = result.Status != RegressionStatus::Passed && result.Status != RegressionStatus::Updated && !skip;
+        passed            = passed && !failed;
+        skipped += skip ? 1 : 0;
+
+        if (skip)
+            SRK_CORE_WARN("{:<24} {:<14} skipped, cpu {:8.3f} ms (budget {:.3f}) gpu {:8.3f} ms (budget {:.3f})", result.Name, ToString(result.Status), result.CpuMs, cpuMs, result.GpuMs, gpuMs);
+        else if (failed)
+            SRK_CORE_ERROR("{:<24} {:<14} cpu {:8.3f} ms (budget {:.3f}) gpu {:8.3f} ms (budget {:.3f}) {} pixels differ", result.Name, ToString(result.Status), result.CpuMs, cpuMs, result.GpuMs, gpuMs, result.DifferentPixels);
+        else
+            SRK_CORE_INFO("{:<24} {:<14} cpu {:8.3f} ms (budget {:.3f}) gpu {:8.3f} ms (budget {:.3f})", result.Name, ToString(result.Status), result.CpuMs, cpuMs, result.GpuMs, gpuMs);
+
+        m_Results.push_back(std::move(result));
+    }
+
+    if (skipped != 0)
+        SRK_CORE_WARN("{} of {} scenes had no golden in {} and were skipped, --regression.update_goldens writes them", skipped, scenes.size(), m_Settings.GoldenDirectory);
+
+    DestroyTarget();
+    return passed;
+}
+
+RegressionResult RegressionRunner::RunScene(const RegressionScene& scene) SRK_NOEXCEPT
+{
+    RegressionResult result;
+    result.Name = scene.Name;
+
+    VkResult vkResult = CreateTarget(scene.Extent);
+    if (vkResult != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Render target for {} could not be created with {}", scene.Name, vkResult);
+        DestroyTarget();
+        return result;
+    }
+
+    const uint32_t      frameCount = m_Settings.WarmupFrames + std::max(m_Settings.MeasuredFrames, 1u);
+    std::vector<double> cpuTimes;
+    std::vector<double> gpuTimes;
+    for (uint32_t frame{}; frame < frameCount; ++frame)
+    {
+        double cpuMs{0.0};
+        vkResult = RecordAndSubmit(scene, frame + 1 == frameCount, cpuMs);
+        if (vkResult == VK_SUCCESS)
+            vkResult = vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        if (vkResult != VK_SUCCESS)
+        {
+            SRK_CORE_ERROR("Frame {} of {} failed with {}", frame, scene.Name, vkResult);
+            return result;
+        }
+        vkResetFences(m_Device, 1, &m_Fence);
+
+        if (frame < m_Settings.WarmupFrames)
+            continue;
+
+        cpuTimes.push_back(cpuMs);
+        if (m_Timestamps != VK_NULL_HANDLE)
+        {
+            uint64_t ticks[2]{};
+            if (vkGetQueryPoolResults(m_Device, m_Timestamps, 0, 2, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) == VK_SUCCESS)
+                gpuTimes.push_back(static_cast<double>(ticks[1] - ticks[0]) * m_NanosecondsPerTick / 1e6);
+        }
+    }
+
+    result.CpuMs = median(cpuTimes);
+    result.GpuMs = median(gpuTimes);
+
+    asset::Image actual;
+    actual.Width  = scene.Extent.width;
+    actual.Height = scene.Extent.height;
+    const uint8_t* pixels = static_cast<const uint8_t*>(m_Target.Readback.Mapped);
+    actual.Pixels.assign(pixels, pixels + size_t{actual.Width} * actual.Height * 4);
+
+    const std::string goldenPath = m_Settings.GoldenDirectory + "/" + scene.Name + ".png";
+    const std::string outputPath = m_Settings.OutputDirectory + "/" + scene.Name;
+    asset::WritePng(outputPath + ".png", actual.Pixels.data(), actual.Width, actual.Height);
+
+    if (m_Settings.UpdateGoldens)
+    {
+        result.Status = asset::WritePng(goldenPath, actual.Pixels.data(), actual.Width, actual.Height) ? RegressionStatus::Updated : RegressionStatus::Failed;
+        return result;
+    }
+
+    asset::Image golden;
+    if (!asset::ReadPng(goldenPath, golden))
+    {
+        if (m_Settings.RequireGoldens)
+            SRK_CORE_ERROR("No golden image for {} at {}, --regression.update_goldens writes it", scene.Name, goldenPath);
+        result.Status = RegressionStatus::NoGolden;
+        return result;
+    }
+
+    std::vector<uint8_t>  diff;
+    const ImageDifference difference = CompareImages(golden, actual, m_Settings.Threshold, &diff);
+    const double          allowed    = static_cast<double>(actual.Width) * actual.Height * m_Settings.MaxDifferentRatio;
+
+    result.DifferentPixels = difference.DifferentPixels;
+    result.Status          = difference.DifferentPixels > allowed ? RegressionStatus::ImageMismatch : RegressionStatus::Passed;
+    if (result.Status == RegressionStatus::ImageMismatch && !diff.empty())
+        asset::WritePng(outputPath + "_diff.png", diff.data(), actual.Width, actual.Height);
+
+    return result;
+}
+
+VkResult RegressionRunner::RecordAndSubmit(const RegressionScene& scene, bool readback, double& cpuMs) SRK_NOEXCEPT
+{
+    const auto begin = std::chrono::steady_clock::now();
+
+    vkResetCommandPool(m_Device, m_Pool, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkResult result = vkBeginCommandBuffer(m_CommandBuffer, &beginInfo);
+    if (result != VK_SUCCESS)
+        return result;
+
+    if (m_Timestamps != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(m_CommandBuffer, m_Timestamps, 0, 2);
+        vkCmdWriteTimestamp(m_CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_Timestamps, 0);
+    }
+
+    VkClearValue clear{};
+    clear.color = scene.ClearColor;
+
+    VkRenderPassBeginInfo passInfo{};
+    passInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    passInfo.renderPass        = m_RenderPass;
+    passInfo.framebuffer       = m_Target.Framebuffer;
+    passInfo.renderArea.extent = scene.Extent;
+    passInfo.clearValueCount   = 1;
+    passInfo.pClearValues      = &clear;
+
+    vkCmdBeginRenderPass(m_CommandBuffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport viewport{0.f, 0.f, static_cast<float>(scene.Extent.width), static_cast<float>(scene.Extent.height), 0.f, 1.f};
+    VkRect2D   scissor{{0, 0}, scene.Extent};
+    vkCmdSetViewport(m_CommandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(m_CommandBuffer, 0, 1, &scissor);
+
+    if (scene.Record)
+        scene.Record(m_CommandBuffer, RegressionTarget{m_RenderPass, TargetFormat, scene.Extent});
+
+    vkCmdEndRenderPass(m_CommandBuffer);
+
+    if (m_Timestamps != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(m_CommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_Timestamps, 1);
+
+    // after the timestamp so the readback is not part of the measured time
+    if (readback)
+    {
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent                 = {scene.Extent.width, scene.Extent.height, 1};
+        vkCmdCopyImageToBuffer(m_CommandBuffer, m_Target.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_Target.Readback.Buffer, 1, &region);
+
+        VkMemoryBarrier toHost{};
+        toHost.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &toHost, 0, nullptr, 0, nullptr);
+    }
+
+    result = vkEndCommandBuffer(m_CommandBuffer);
+    if (result != VK_SUCCESS)
+        return result;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &m_CommandBuffer;
+
+    result = vkQueueSubmit(m_Queue, 1, &submitInfo, m_Fence);
+    cpuMs  = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    return result;
+}
+
+} // namespace shrek::render
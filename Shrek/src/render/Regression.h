@@ -0,0 +1,135 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "helper/Memory.h"
+#include "asset/ImageFile.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace shrek::render {
+
+// what a scene renders into, RenderPass is what its pipelines have to be compatible with
+struct RegressionTarget
+{
+    VkRenderPass RenderPass{VK_NULL_HANDLE};
+    VkFormat     Format{VK_FORMAT_UNDEFINED};
+    VkExtent2D   Extent{};
+};
+
+struct RegressionScene
+{
+    std::string       Name; // golden image and budget are looked up by it
+    VkExtent2D        Extent{256, 256};
+    VkClearColorValue ClearColor{};
+
+    // recorded inside the render pass every frame with viewport and scissor set, may be empty
+    std::function<void(VkCommandBuffer cmd, const RegressionTarget& target)> Record;
+};
+
+struct RegressionSettings
+{
+    std::string GoldenDirectory{"assets/regression/golden"};
+    std::string BudgetFile{"assets/regression/budgets.json"};
+    std::string OutputDirectory{"regression"}; // what was rendered, and a diff for every mismatch
+    float       Threshold{0.1f};               // perceptual difference in [0, 1] past which a pixel counts as different
+    float       MaxDifferentRatio{0.001f};     // part of the pixels allowed to differ, covers rasterizer differences
+    uint32_t    WarmupFrames{3};               // pipelines are compiled and caches warmed here, not timed
+    uint32_t    MeasuredFrames{15};            // the median of these is what is compared against the budget
+    bool        UpdateGoldens{false};          // writes the goldens instead of comparing against them
+    bool        RequireGoldens{true};          // a scene without a golden fails instead of being skipped
+};
+
+enum class RegressionStatus : uint32_t
+{
+    Passed,
+    Updated,
+    NoGolden, // a failure unless regression.require_goldens is turned off, the image is still written to the output directory
+    ImageMismatch,
+    OverBudget,
+    Failed
+};
+
+std::string_view ToString(RegressionStatus status) SRK_NOEXCEPT;
+
+struct RegressionResult
+{
+    std::string      Name;
+    RegressionStatus Status{RegressionStatus::Failed};
+    double           CpuMs{0.0}; // recording and submitting a frame
+    double           GpuMs{0.0}; // between the timestamps around the render pass, 0 without timestamp support
+    uint32_t         DifferentPixels{0};
+};
+
+struct ImageDifference
+{
+    uint32_t DifferentPixels{0};
+    float    MaxDifference{0.f}; // in [0, 1]
+};
+
+// yiq weighted distance per pixel which follows what the eye notices more closely than rgb does.
+// diff (if given) is filled with the different pixels in red over a faded expected image
+ImageDifference CompareImages(const asset::Image& expected, const asset::Image& actual, float threshold, std::vector<uint8_t>* diff = nullptr) SRK_NOEXCEPT;
+
+/*
+ *  Renders each scene offscreen (no window or swapchain), reads the last frame back and compares it
+ *  against its golden image, and times the frames on the cpu and with gpu timestamps.
+ *  A scene fails on a mismatch or when its median frame time is over the budget stored for it. One without a golden
+ *  is skipped (and logged as such) so a fresh checkout runs clean, --regression.update_goldens writes them.
+ *  Meant to run on a software icd as well, blocking on the gpu is fine here.
+ */
+class RegressionRunner
+{
+public:
+    RegressionRunner(VkPhysicalDevice gpu, VkDevice device, VkQueue queue, uint32_t queueFamily, RegressionSettings settings) SRK_NOEXCEPT;
+    ~RegressionRunner() SRK_NOEXCEPT;
+
+    RegressionRunner(const RegressionRunner& other) = delete;
+    RegressionRunner& operator=(const RegressionRunner& other) = delete;
+
+    // false when any scene failed, every result is logged
+    bool Run(const std::vector<RegressionScene>& scenes) SRK_NOEXCEPT;
+
+    bool                                 IsValid() const SRK_NOEXCEPT { return m_Valid; }
+    const std::vector<RegressionResult>& GetResults() const SRK_NOEXCEPT { return m_Results; }
+
+    static constexpr VkFormat TargetFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+private:
+    struct Target
+    {
+        VkImage                  Image{VK_NULL_HANDLE};
+        VkDeviceMemory           Memory{VK_NULL_HANDLE};
+        VkImageView              View{VK_NULL_HANDLE};
+        VkFramebuffer            Framebuffer{VK_NULL_HANDLE};
+        helper::BufferAllocation Readback;
+        VkExtent2D               Extent{};
+    };
+
+    VkResult         CreateTarget(VkExtent2D extent) SRK_NOEXCEPT;
+    void             DestroyTarget() SRK_NOEXCEPT;
+    RegressionResult RunScene(const RegressionScene& scene) SRK_NOEXCEPT;
+    VkResult         RecordAndSubmit(const RegressionScene& scene, bool readback, double& cpuMs) SRK_NOEXCEPT;
+
+private:
+    VkPhysicalDevice   m_Gpu;
+    VkDevice           m_Device;
+    VkQueue            m_Queue;
+    RegressionSettings m_Settings;
+    bool               m_Valid;
+
+    VkRenderPass    m_RenderPass;
+    VkCommandPool   m_Pool;
+    VkCommandBuffer m_CommandBuffer;
+    VkFence         m_Fence;
+    VkQueryPool     m_Timestamps; // null when the queue has no timestamps
+    double          m_NanosecondsPerTick;
+    Target          m_Target;
+
+    std::vector<RegressionResult> m_Results;
+};
+
+} // namespace shrek::render
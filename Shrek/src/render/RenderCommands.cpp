@@ -0,0 +1,282 @@
+#include "pch.h"
+#include "RenderCommands.h"
+
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace shrek::render {
+
+namespace {
+
+// commands taken out of the queue at once, a full queue is drained in a few of these
+constexpr size_t drainBatchSize = 256;
+
+} // namespace
+
+std::string_view ToString(RenderCommandType type) SRK_NOEXCEPT
+{
+#define TO_STRING(X)           \
+    case RenderCommandType::X: \
+        return #X
+    switch (type)
+    {
+        TO_STRING(None);
+        TO_STRING(Upload);
+        TO_STRING(Copy);
+        TO_STRING(DestroyBuffer);
+        TO_STRING(DestroyImage);
+        TO_STRING(Call);
+        default:
+            return "UNKNOWN";
+    }
+#undef TO_STRING
+}
+
+RenderCommandQueue::RenderCommandQueue(VkPhysicalDevice gpu, VkDevice device, uint32_t capacity, VkDeviceSize stagingBytesPerFrame) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Queue(capacity),
+    m_Staging(),
+    m_Batch(drainBatchSize),
+    m_Deferred(),
+    m_Redrain(),
+    m_Retired(),
+    m_Uploaded(false),
+    m_Stats(),
+    m_Rejected(0)
+{
+    m_Staging.reserve(GetFramesInFlight());
+    for (uint32_t idx{}; idx < GetFramesInFlight(); ++idx)
+        m_Staging.push_back(std::make_unique<StagingBuffer>(gpu, device, stagingBytesPerFrame));
+}
+
+RenderCommandQueue::~RenderCommandQueue() SRK_NOEXCEPT
+{
+    // FrameContext waited for the gpu, whatever is retired or still queued can go right away
+    for (Retired& retired : m_Retired)
+        Release(retired);
+
+    size_t popped = 0;
+    while ((popped = m_Queue.PopBulk(m_Batch.data(), m_Batch.size())) > 0)
+    {
+        for (size_t idx{}; idx < popped; ++idx)
+        {
+            Retired retired{m_Batch[idx].Buffer, m_Batch[idx].Image, 0};
+            Release(retired);
+        }
+    }
+}
+
+bool RenderCommandQueue::Push(RenderCommand&& command) SRK_NOEXCEPT
+{
+    if (m_Queue.Push(std::move(command)))
+        return true;
+
+    // the queue is sized so this doesn't happen in steady state, count it so it shows when it does
+    if (m_Rejected.fetch_add(1, std::memory_order_relaxed) == 0)
+        SRK_CORE_WARN("Render command queue is full at {} commands, {} was rejected", m_Queue.GetCapacity(), ToString(command.Type));
+    return false;
+}
+
+bool RenderCommandQueue::Upload(VkBuffer destination, VkDeviceSize offset, std::vector<std::byte>&& data) SRK_NOEXCEPT
+{
+    if (destination == VK_NULL_HANDLE || data.empty())
+        return false;
+
+    RenderCommand command;
+    command.Type        = RenderCommandType::Upload;
+    command.Data        = std::move(data);
+    command.Destination = destination;
+    command.Offset      = offset;
+    if (Push(std::move(command)))
+        return true;
+
+    // Push leaves the command alone when it fails, the caller gets its data back
+    data = std::move(command.Data);
+    return false;
+}
+
+bool RenderCommandQueue::Copy(const StagingBuffer& staging, const StagingAllocation& source, VkBuffer destination, VkDeviceSize offset) SRK_NOEXCEPT
+{
+    if (destination == VK_NULL_HANDLE || !staging.IsValid() || !source.IsValid())
+        return false;
+
+    RenderCommand command;
+    command.Type         = RenderCommandType::Copy;
+    command.Destination  = destination;
+    command.Offset       = offset;
+    command.Source       = staging.GetBuffer();
+    command.SourceOffset = source.Offset;
+    command.Size         = source.Size;
+    return Push(std::move(command));
+}
+
+bool RenderCommandQueue::Destroy(helper::BufferAllocation& buffer) SRK_NOEXCEPT
+{
+    RenderCommand command;
+    command.Type   = RenderCommandType::DestroyBuffer;
+    command.Buffer = buffer;
+    if (!Push(std::move(command)))
+        return false;
+
+    buffer = helper::BufferAllocation{};
+    return true;
+}
+
+bool RenderCommandQueue::Destroy(helper::ImageAllocation& image) SRK_NOEXCEPT
+{
+    RenderCommand command;
+    command.Type  = RenderCommandType::DestroyImage;
+    command.Image = image;
+    if (!Push(std::move(command)))
+        return false;
+
+    image = helper::ImageAllocation{};
+    return true;
+}
+
+bool RenderCommandQueue::Call(std::function<void(const Frame&)> function) SRK_NOEXCEPT
+{
+    RenderCommand command;
+    command.Type     = RenderCommandType::Call;
+    command.Function = std::move(function);
+    return Push(std::move(command));
+}
+
+void RenderCommandQueue::Drain(const Frame& frame) SRK_NOEXCEPT
+{
+    // the slot's fence was waited on, its staging is free again
+    m_Staging[frame.Index]->Reset();
+    m_Uploaded       = false;
+    m_Stats.Drained  = 0;
+    m_Stats.Uploaded = 0;
+
+    // resources retired by the frames that are done by now
+    const uint64_t inFlight = GetFramesInFlight();
+    auto           done     = [&frame, inFlight](const Retired& retired) { return retired.Frame + inFlight <= frame.Number; };
+    for (Retired& retired : m_Retired)
+    {
+        if (done(retired))
+            Release(retired);
+    }
+    m_Retired.erase(std::remove_if(m_Retired.begin(), m_Retired.end(), done), m_Retired.end());
+
+    // what didn't fit last frame goes first so everything stays in the order it was pushed
+    // swapped with a member so neither list gives its capacity back to the heap
+    m_Redrain.swap(m_Deferred);
+    for (RenderCommand& command : m_Redrain)
+        Execute(frame, command);
+    m_Redrain.clear();
+
+    // only what was published when the drain started, producers pushing meanwhile wait for the next frame
+    size_t remaining = m_Queue.GetSizeApprox();
+    m_Stats.Queued   = static_cast<uint32_t>(remaining);
+    while (remaining > 0)
+    {
+        const size_t popped = m_Queue.PopBulk(m_Batch.data(), std::min(remaining, m_Batch.size()));
+        if (popped == 0)
+            break;
+
+        for (size_t idx{}; idx < popped; ++idx)
+            Execute(frame, m_Batch[idx]);
+        m_Stats.Drained += static_cast<uint32_t>(popped);
+        remaining -= popped;
+    }
+    m_Stats.Deferred = static_cast<uint32_t>(m_Deferred.size());
+
+    // one barrier for every copy, whatever reads the buffers next may be anywhere in the pipeline
+    if (m_Uploaded && frame.CommandBuffer != VK_NULL_HANDLE)
+    {
+        VkMemoryBarrier barrier{};
+        barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(frame.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                             nullptr);
+    }
+}
+
+void RenderCommandQueue::Execute(const Frame& frame, RenderCommand& command) SRK_NOEXCEPT
+{
+    // once one command waits for the next frame everything after it does too, a destroy or another upload
+    // must never overtake an upload to the same buffer
+    if (!m_Deferred.empty())
+    {
+        m_Deferred.push_back(std::move(command));
+        return;
+    }
+
+    switch (command.Type)
+    {
+        case RenderCommandType::Upload:
+        {
+            StagingBuffer&          staging    = *m_Staging[frame.Index];
+            const StagingAllocation allocation = staging.IsValid() ? staging.Allocate(command.Data.size()) : StagingAllocation{};
+            if (!allocation.IsValid() || frame.CommandBuffer == VK_NULL_HANDLE)
+            {
+                // bigger than a whole frame's staging, it would never fit
+                if (!staging.IsValid() || command.Data.size() > staging.GetCapacity())
+                {
+                    SRK_CORE_ERROR("Upload of {} bytes doesn't fit the {} bytes of staging a frame has", command.Data.size(), staging.GetCapacity());
+                    break;
+                }
+
+                m_Deferred.push_back(std::move(command));
+                return;
+            }
+
+            std::memcpy(allocation.Data, command.Data.data(), command.Data.size());
+            staging.RecordCopy(frame.CommandBuffer, allocation, command.Destination, command.Offset);
+            m_Stats.Uploaded += allocation.Size;
+            m_Uploaded = true;
+            break;
+        }
+        case RenderCommandType::Copy:
+        {
+            if (frame.CommandBuffer == VK_NULL_HANDLE)
+            {
+                m_Deferred.push_back(std::move(command));
+                return;
+            }
+
+            VkBufferCopy region{};
+            region.srcOffset = command.SourceOffset;
+            region.dstOffset = command.Offset;
+            region.size      = command.Size;
+            vkCmdCopyBuffer(frame.CommandBuffer, command.Source, command.Destination, 1, &region);
+            m_Stats.Uploaded += command.Size;
+            m_Uploaded = true;
+            break;
+        }
+        case RenderCommandType::DestroyBuffer:
+        case RenderCommandType::DestroyImage:
+            m_Retired.push_back(Retired{command.Buffer, command.Image, frame.Number});
+            break;
+        case RenderCommandType::Call:
+            if (command.Function)
+                command.Function(frame);
+            break;
+        default:
+            break;
+    }
+
+    ++m_Stats.Executed;
+    command = RenderCommand{};
+}
+
+void RenderCommandQueue::Release(Retired& retired) SRK_NOEXCEPT
+{
+    helper::DestroyBuffer(m_Device, retired.Buffer);
+    helper::DestroyImage(m_Device, retired.Image);
+}
+
+RenderCommandStats RenderCommandQueue::GetStats() const SRK_NOEXCEPT
+{
+    RenderCommandStats stats = m_Stats;
+    stats.Rejected           = m_Rejected.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace shrek::render
@@ -0,0 +1,113 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "FrameContext.h"
+#include "StagingBuffer.h"
+#include "base/MpscQueue.h"
+#include "helper/Memory.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace shrek::render {
+
+enum class RenderCommandType : uint32_t
+{
+    None,
+    Upload,        // Data into Destination at Offset
+    Copy,          // Size bytes of Source at SourceOffset into Destination at Offset
+    DestroyBuffer, // once no frame in flight can still use it
+    DestroyImage,
+    Call           // Function on the render thread with the frame being recorded, for whatever isn't one of the above
+};
+
+std::string_view ToString(RenderCommandType type) SRK_NOEXCEPT;
+
+struct RenderCommand
+{
+    RenderCommandType                 Type{RenderCommandType::None};
+    std::vector<std::byte>            Data;
+    VkBuffer                          Destination{VK_NULL_HANDLE};
+    VkDeviceSize                      Offset{0};
+    VkBuffer                          Source{VK_NULL_HANDLE};
+    VkDeviceSize                      SourceOffset{0};
+    VkDeviceSize                      Size{0};
+    helper::BufferAllocation          Buffer;
+    helper::ImageAllocation           Image;
+    std::function<void(const Frame&)> Function;
+};
+
+struct RenderCommandStats
+{
+    uint64_t     Executed{0}; // since startup
+    uint32_t     Queued{0};   // when the last Drain started
+    uint32_t     Drained{0};  // by the last Drain
+    uint32_t     Deferred{0}; // uploads that didn't fit the last frame's staging and wait for the next one
+    uint64_t     Rejected{0}; // pushes that found the queue full
+    VkDeviceSize Uploaded{0}; // bytes, by the last Drain
+};
+
+/*
+ *  Where worker threads and gameplay code hand resource work to the renderer. Every call pushes a command
+ *  into a lock free MPSC queue and returns, the render thread drains the whole queue once per frame right
+ *  after FrameContext::BeginFrame: uploads are copied through a staging buffer of the frame's own and made
+ *  visible with a single barrier, destroys wait until no frame in flight can still use the resource. A push
+ *  fails when the queue is full, the caller keeps whatever it passed in then. Commands run in the order they
+ *  were pushed, an upload that doesn't fit the frame's staging holds back everything after it until the next frame.
+ */
+class RenderCommandQueue
+{
+public:
+    RenderCommandQueue(VkPhysicalDevice gpu, VkDevice device, uint32_t capacity, VkDeviceSize stagingBytesPerFrame) SRK_NOEXCEPT;
+    ~RenderCommandQueue() SRK_NOEXCEPT;
+
+    RenderCommandQueue(const RenderCommandQueue& other) = delete;
+    RenderCommandQueue& operator=(const RenderCommandQueue& other) = delete;
+
+    // any thread. the destination has to outlive the frame the upload is recorded in, data is only taken on success
+    bool Upload(VkBuffer destination, VkDeviceSize offset, std::vector<std::byte>&& data) SRK_NOEXCEPT;
+    // any thread, for data that already sits in a staging buffer of the caller's like what the loaders hand out.
+    // no extra copy on the cpu, but the caller's staging has to stay untouched until the frame that records it is done
+    bool Copy(const StagingBuffer& staging, const StagingAllocation& source, VkBuffer destination, VkDeviceSize offset) SRK_NOEXCEPT;
+    // any thread, the allocation is cleared once the command is queued
+    bool Destroy(helper::BufferAllocation& buffer) SRK_NOEXCEPT;
+    bool Destroy(helper::ImageAllocation& image) SRK_NOEXCEPT;
+    bool Call(std::function<void(const Frame&)> function) SRK_NOEXCEPT;
+
+    // render thread only, before anything that reads what was uploaded is recorded
+    void Drain(const Frame& frame) SRK_NOEXCEPT;
+
+    // render thread only, like Drain
+    RenderCommandStats GetStats() const SRK_NOEXCEPT;
+
+private:
+    struct Retired
+    {
+        helper::BufferAllocation Buffer;
+        helper::ImageAllocation  Image;
+        uint64_t                 Frame{0};
+    };
+
+    bool Push(RenderCommand&& command) SRK_NOEXCEPT;
+    void Execute(const Frame& frame, RenderCommand& command) SRK_NOEXCEPT;
+    void Release(Retired& retired) SRK_NOEXCEPT;
+
+private:
+    VkDevice                                    m_Device;
+    base::MpscQueue<RenderCommand>              m_Queue;
+    std::vector<std::unique_ptr<StagingBuffer>> m_Staging; // one per frame in flight
+    std::vector<RenderCommand>                  m_Batch;   // what one PopBulk takes out of the queue
+    std::vector<RenderCommand>                  m_Deferred;
+    std::vector<RenderCommand>                  m_Redrain; // last frame's deferred commands while they execute
+    std::vector<Retired>                        m_Retired;
+    bool                                        m_Uploaded; // copies were recorded this frame, they need the barrier
+    RenderCommandStats                          m_Stats;
+    std::atomic<uint64_t>                       m_Rejected;
+};
+
+} // namespace shrek::render
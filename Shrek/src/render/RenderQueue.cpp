@@ -0,0 +1,180 @@
+#include "pch.h"
+#include "RenderQueue.h"
+
+#include "base/Arena.h"
+
+#include <algorithm>
+
+namespace shrek::render {
+
+namespace {
+
+constexpr uint32_t radixBits    = 8;
+constexpr uint32_t radixBuckets = 1 << radixBits;
+constexpr uint32_t meshPasses   = 32 / radixBits;
+constexpr uint32_t keyPasses    = 64 / radixBits;
+constexpr uint32_t radixPasses  = meshPasses + keyPasses;
+
+// small queues are faster with a comparison sort than with 8 histogram passes
+constexpr size_t radixThreshold = 64;
+
+// the mesh is the least significant part of the sort so equal keys end up grouped by mesh, which is what lets them merge into instances
+inline uint32_t digitOf(const DrawItem& item, uint32_t pass) SRK_NOEXCEPT
+{
+    if (pass < meshPasses)
+        return (item.Mesh >> (pass * radixBits)) & (radixBuckets - 1);
+
+    return static_cast<uint32_t>(item.Key >> ((pass - meshPasses) * radixBits)) & (radixBuckets - 1);
+}
+
+inline bool lessThan(const DrawItem& lhs, const DrawItem& rhs) SRK_NOEXCEPT
+{
+    return lhs.Key != rhs.Key ? lhs.Key < rhs.Key : lhs.Mesh < rhs.Mesh;
+}
+
+} // namespace
+
+uint32_t DrawKey::QuantizeDepth(float viewDepth, float nearZ, float farZ, bool backToFront) SRK_NOEXCEPT
+{
+    const float range = farZ - nearZ;
+    float       t     = range > 0.f ? (viewDepth - nearZ) / range : 0.f;
+    t                 = std::clamp(t, 0.f, 1.f);
+
+    const uint32_t maxDepth = Mask(DepthBits);
+    uint32_t       depth    = static_cast<uint32_t>(t * static_cast<float>(maxDepth));
+
+    return backToFront ? maxDepth - depth : depth;
+}
+
+RenderQueue::RenderQueue(std::pmr::memory_resource* memory) SRK_NOEXCEPT :
+    m_Items(memory),
+    m_Scratch(memory),
+    m_Batches(memory),
+    m_Instances(memory)
+{
+}
+
+void RenderQueue::Reserve(size_t count) SRK_NOEXCEPT
+{
+    m_Items.reserve(count);
+    m_Scratch.reserve(count);
+    m_Batches.reserve(count);
+    m_Instances.reserve(count);
+}
+
+void RenderQueue::Clear() SRK_NOEXCEPT
+{
+    // clear keeps the capacity so the next frame does not allocate
+    m_Items.clear();
+    m_Batches.clear();
+    m_Instances.clear();
+}
+
+void RenderQueue::Release() SRK_NOEXCEPT
+{
+    base::Release(m_Items);
+    base::Release(m_Scratch);
+    base::Release(m_Batches);
+    base::Release(m_Instances);
+}
+
+void RenderQueue::Push(uint64_t key, uint32_t mesh, uint32_t instance) SRK_NOEXCEPT
+{
+    m_Items.push_back(DrawItem{key, mesh, instance});
+}
+
+void RenderQueue::Build() SRK_NOEXCEPT
+{
+    Sort();
+    Batch();
+}
+
+// LSD radix sort on (key, mesh), all histograms are built in one read of the keys and passes where every key shares the digit are skipped.
+// most frames only have a few passes and pipelines so the top digits are usually skipped.
+void RenderQueue::Sort() SRK_NOEXCEPT
+{
+    const size_t count = m_Items.size();
+    if (count < radixThreshold)
+    {
+        std::stable_sort(m_Items.begin(), m_Items.end(), lessThan);
+        return;
+    }
+
+    std::array<std::array<uint32_t, radixBuckets>, radixPasses> histograms{};
+    for (const auto& item : m_Items)
+    {
+        for (uint32_t pass{}; pass < radixPasses; ++pass)
+            ++histograms[pass][digitOf(item, pass)];
+    }
+
+    m_Scratch.resize(count);
+
+    DrawItem* src = m_Items.data();
+    DrawItem* dst = m_Scratch.data();
+
+    for (uint32_t pass{}; pass < radixPasses; ++pass)
+    {
+        auto& histogram = histograms[pass];
+
+        // every key falls in the same bucket, nothing to do for this digit
+        if (histogram[digitOf(src[0], pass)] == count)
+            continue;
+
+        uint32_t offset{};
+        for (auto& bucket : histogram)
+        {
+            uint32_t bucketCount = bucket;
+            bucket               = offset;
+            offset += bucketCount;
+        }
+
+        for (size_t idx{}; idx < count; ++idx)
+            dst[histogram[digitOf(src[idx], pass)]++] = src[idx];
+
+        std::swap(src, dst);
+    }
+
+    // odd number of executed passes leaves the result in the scratch buffer
+    if (src != m_Items.data())
+        m_Items.swap(m_Scratch);
+}
+
+// adjacent items with the same state and mesh become one instanced draw.
+void RenderQueue::Batch() SRK_NOEXCEPT
+{
+    m_Batches.clear();
+    m_Instances.clear();
+
+    uint64_t previousState = 0;
+    uint32_t previousMesh  = 0;
+    bool     first         = true;
+
+    for (const auto& item : m_Items)
+    {
+        const uint64_t state = item.Key & DrawKey::StateMask;
+
+        if (first || state != previousState || item.Mesh != previousMesh)
+        {
+            uint32_t changes = DrawStateChange_None;
+            if (first || DrawKey::Pass(state) != DrawKey::Pass(previousState))
+                changes |= DrawStateChange_Pass;
+            if (first || DrawKey::Pipeline(state) != DrawKey::Pipeline(previousState))
+                changes |= DrawStateChange_Pipeline;
+            if (first || DrawKey::Material(state) != DrawKey::Material(previousState))
+                changes |= DrawStateChange_Material;
+            if (first || item.Mesh != previousMesh)
+                changes |= DrawStateChange_Mesh;
+
+            m_Batches.push_back(DrawBatch{item.Key, item.Mesh, static_cast<uint32_t>(m_Instances.size()), 0, changes});
+
+            previousState = state;
+            previousMesh  = item.Mesh;
+            first         = false;
+        }
+
+        m_Instances.push_back(item.Instance);
+        ++m_Batches.back().InstanceCount;
+    }
+}
+
+} // namespace shrek::render
@@ -0,0 +1,128 @@
+#pragma once
+#include "defs.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace shrek::render {
+
+/*
+ *  Every draw gets reduced to a single 64 bit key so that sorting the queue also groups the draws by state.
+ *  From msb to lsb:
+ *
+ *  | pass (4) | pipeline (16) | material (20) | depth (24) |
+ *
+ *  so the most expensive state change (pass) is the one that changes the least after sorting.
+ *  Draws only merge into instances when they end up adjacent, so opaque draws only keep the top CoarseDepthBits
+ *  of their depth (CoarsenDepth): a rough front to back order that still leaves equal meshes next to each other.
+ */
+struct DrawKey
+{
+    static constexpr uint32_t PassBits     = 4;
+    static constexpr uint32_t PipelineBits = 16;
+    static constexpr uint32_t MaterialBits = 20;
+    static constexpr uint32_t DepthBits    = 24;
+
+    static constexpr uint32_t DepthShift    = 0;
+    static constexpr uint32_t MaterialShift = DepthShift + DepthBits;
+    static constexpr uint32_t PipelineShift = MaterialShift + MaterialBits;
+    static constexpr uint32_t PassShift     = PipelineShift + PipelineBits;
+
+    static_assert(PassShift + PassBits == 64, "DrawKey fields must fill up the whole 64 bits");
+
+    // everything above the depth, draws that share these bits can share bindings
+    static constexpr uint64_t StateMask = ~((uint64_t{1} << MaterialShift) - 1);
+
+    // buckets of depth opaque draws are sorted into, the meshes of a bucket batch together
+    static constexpr uint32_t CoarseDepthBits = 4;
+    static constexpr uint32_t CoarseDepthMask = ((uint32_t{1} << CoarseDepthBits) - 1) << (DepthBits - CoarseDepthBits);
+
+    static constexpr uint64_t Pack(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth) SRK_NOEXCEPT
+    {
+        return (static_cast<uint64_t>(pass & Mask(PassBits)) << PassShift) |
+               (static_cast<uint64_t>(pipeline & Mask(PipelineBits)) << PipelineShift) |
+               (static_cast<uint64_t>(material & Mask(MaterialBits)) << MaterialShift) |
+               (static_cast<uint64_t>(depth & Mask(DepthBits)) << DepthShift);
+    }
+
+    static constexpr uint32_t Pass(uint64_t key) SRK_NOEXCEPT { return static_cast<uint32_t>(key >> PassShift) & Mask(PassBits); }
+    static constexpr uint32_t Pipeline(uint64_t key) SRK_NOEXCEPT { return static_cast<uint32_t>(key >> PipelineShift) & Mask(PipelineBits); }
+    static constexpr uint32_t Material(uint64_t key) SRK_NOEXCEPT { return static_cast<uint32_t>(key >> MaterialShift) & Mask(MaterialBits); }
+    static constexpr uint32_t Depth(uint64_t key) SRK_NOEXCEPT { return static_cast<uint32_t>(key >> DepthShift) & Mask(DepthBits); }
+
+    // maps view depth into the depth bits. back to front is for transparent passes.
+    static uint32_t QuantizeDepth(float viewDepth, float nearZ, float farZ, bool backToFront = false) SRK_NOEXCEPT;
+    // only the top CoarseDepthBits of a quantized depth, for opaque draws
+    static constexpr uint32_t CoarsenDepth(uint32_t depth) SRK_NOEXCEPT { return depth & CoarseDepthMask; }
+
+private:
+    static constexpr uint32_t Mask(uint32_t bits) SRK_NOEXCEPT { return static_cast<uint32_t>((uint64_t{1} << bits) - 1); }
+};
+
+struct DrawItem
+{
+    uint64_t Key;
+    uint32_t Mesh;
+    uint32_t Instance; // index into the per instance data (transforms etc.)
+};
+
+enum DrawStateChange : uint32_t
+{
+    DrawStateChange_None     = 0,
+    DrawStateChange_Pass     = 1 << 0,
+    DrawStateChange_Pipeline = 1 << 1,
+    DrawStateChange_Material = 1 << 2,
+    DrawStateChange_Mesh     = 1 << 3,
+};
+
+// a run of draws that can be issued as one instanced draw.
+struct DrawBatch
+{
+    uint64_t Key;
+    uint32_t Mesh;
+    uint32_t FirstInstance; // offset into RenderQueue::GetInstances()
+    uint32_t InstanceCount;
+    uint32_t Changes; // DrawStateChange bits compared to the previous batch, so we only rebind what is needed
+};
+
+/*
+ *  Filled every frame, sorted with a radix sort on the key and then merged into instanced batches.
+ *  Memory is kept across frames so nothing gets allocated once the queue has warmed up.
+ *  Not thread safe, use one queue per recording thread.
+ */
+class RenderQueue
+{
+public:
+    // everything the queue keeps comes from memory, FramePacket hands it its arena
+    explicit RenderQueue(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) SRK_NOEXCEPT;
+
+    void Reserve(size_t count) SRK_NOEXCEPT;
+    void Clear() SRK_NOEXCEPT;
+    // like Clear but gives the memory back as well, before the arena behind it is reset
+    void Release() SRK_NOEXCEPT;
+
+    void Push(uint64_t key, uint32_t mesh, uint32_t instance) SRK_NOEXCEPT;
+
+    // sorts the items by key then mesh and rebuilds batches and instances
+    void Build() SRK_NOEXCEPT;
+
+    size_t Size() const SRK_NOEXCEPT { return m_Items.size(); }
+    bool   Empty() const SRK_NOEXCEPT { return m_Items.empty(); }
+
+    const std::pmr::vector<DrawItem>&  GetItems() const SRK_NOEXCEPT { return m_Items; }
+    const std::pmr::vector<DrawBatch>& GetBatches() const SRK_NOEXCEPT { return m_Batches; }
+    const std::pmr::vector<uint32_t>&  GetInstances() const SRK_NOEXCEPT { return m_Instances; }
+
+private:
+    void Sort() SRK_NOEXCEPT;
+    void Batch() SRK_NOEXCEPT;
+
+private:
+    std::pmr::vector<DrawItem>  m_Items;
+    std::pmr::vector<DrawItem>  m_Scratch;
+    std::pmr::vector<DrawBatch> m_Batches;
+    std::pmr::vector<uint32_t>  m_Instances;
+};
+
+} // namespace shrek::render
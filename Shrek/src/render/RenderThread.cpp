@@ -0,0 +1,160 @@
+#include "pch.h"
+#include "RenderThread.h"
+
+#include "base/Config.h"
+#include "platform/Log.h"
+
+#include <chrono>
+
+namespace shrek::render {
+
+namespace {
+
+base::ConfigVar<bool> enableRenderThread{"render.thread", true, "render on a thread of its own a frame behind the main thread, off renders on the main thread"};
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) SRK_NOEXCEPT
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+void FramePacket::Recycle() SRK_NOEXCEPT
+{
+    const size_t draws  = Queue.Size();
+    const size_t bounds = Bounds.size();
+    const size_t lights = Lights.size();
+
+    Queue.Release();
+    base::Release(Bounds);
+    base::Release(Transforms);
+    base::Release(Lights);
+    Arena.Reset();
+
+    // about what the next frame builds again, so the lists don't grow through every size on the way up
+    Queue.Reserve(draws);
+    Bounds.reserve(bounds);
+    Transforms.reserve(bounds);
+    Lights.reserve(lights);
+}
+
+RenderThread::RenderThread(RenderFunction render) SRK_NOEXCEPT :
+    m_Render(std::move(render)),
+    m_Packets(),
+    m_Produced(0),
+    m_Consumed(0),
+    m_Running(true),
+    m_Stats(),
+    m_Mutex(),
+    m_Published(),
+    m_Rendered(),
+    m_Thread()
+{
+    if (!enableRenderThread)
+    {
+        SRK_CORE_TRACE("Rendering on the main thread");
+        return;
+    }
+
+    m_Thread = std::thread([this]() { Loop(); });
+}
+
+RenderThread::~RenderThread() SRK_NOEXCEPT
+{
+    Stop();
+}
+
+FramePacket& RenderThread::BeginPacket() SRK_NOEXCEPT
+{
+    // the packet about to be overwritten is the one published two frames ago, which has to be rendered by now
+    const Clock::time_point      start = Clock::now();
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Rendered.wait(lock, [this]() { return m_Produced - m_Consumed < m_Packets.size(); });
+    m_Stats.ProduceWaitMs = millisecondsSince(start);
+
+    // the render thread is done with it, nothing points into its arena anymore
+    FramePacket& packet = m_Packets[m_Produced % m_Packets.size()];
+    packet.Recycle();
+    packet.Number = m_Produced;
+    return packet;
+}
+
+void RenderThread::Publish() SRK_NOEXCEPT
+{
+    if (!IsThreaded())
+    {
+        // nothing else touches the packets, no need for the lock
+        m_Render(m_Packets[m_Produced % m_Packets.size()]);
+        ++m_Produced;
+        ++m_Consumed;
+        ++m_Stats.Rendered;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_Running)
+            return;
+        ++m_Produced;
+    }
+    m_Published.notify_one();
+}
+
+void RenderThread::Flush() SRK_NOEXCEPT
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Rendered.wait(lock, [this]() { return m_Consumed == m_Produced; });
+}
+
+void RenderThread::Stop() SRK_NOEXCEPT
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_Published.notify_one();
+
+    if (m_Thread.joinable())
+        m_Thread.join();
+}
+
+RenderThreadStats RenderThread::GetStats() SRK_NOEXCEPT
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+void RenderThread::Loop() SRK_NOEXCEPT
+{
+    SRK_CORE_TRACE("Render thread started");
+
+    for (;;)
+    {
+        const Clock::time_point      start = Clock::now();
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Published.wait(lock, [this]() { return m_Consumed < m_Produced || !m_Running; });
+
+        // stopping still renders whatever was published before it
+        if (m_Consumed == m_Produced)
+            break;
+
+        m_Stats.ConsumeWaitMs     = millisecondsSince(start);
+        const FramePacket& packet = m_Packets[m_Consumed % m_Packets.size()];
+        lock.unlock();
+
+        // the main thread is filling the other packet meanwhile, never this one
+        m_Render(packet);
+
+        lock.lock();
+        ++m_Consumed;
+        ++m_Stats.Rendered;
+        lock.unlock();
+        m_Rendered.notify_all();
+    }
+
+    SRK_CORE_TRACE("Render thread stopped after {} frames", m_Stats.Rendered);
+}
+
+} // namespace shrek::render
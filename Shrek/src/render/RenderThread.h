@@ -0,0 +1,107 @@
+#pragma once
+#include "defs.h"
+#include "ClusteredLighting.h"
+#include "RenderQueue.h"
+#include "base/Arena.h"
+#include "base/math/Aabb.h"
+#include "base/math/Mat.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace shrek::render {
+
+class Surface;
+
+struct FrameCamera
+{
+    math::Mat4 View;
+    math::Mat4 Projection; // from math::Mat4::Perspective
+    math::Vec3 Eye;
+    float      Near{0.1f};
+    float      Far{1000.f};
+};
+
+/*
+ *  Everything the render thread needs of a frame, filled by the main thread and not touched by it again
+ *  until the render thread is done with it. The lists and the queue allocate from the packet's arena, which
+ *  BeginPacket resets when it recycles the packet. After a few frames the arena is one block as big as a
+ *  frame needs, so a steady state frame doesn't go to the heap.
+ *  Only one thread at a time may allocate from it: the cull job of the view that records into Queue, then
+ *  the main thread.
+ */
+struct FramePacket
+{
+    // drops what the packet held and starts the arena over, reserving what the last frame used
+    void Recycle() SRK_NOEXCEPT;
+
+    base::Arena                  Arena; // first, everything below allocates from it
+    uint64_t                     Number{0};         // frames produced since startup
+    double                       DeltaSeconds{0.0}; // simulated since the last packet
+    FrameCamera                  Camera;
+    RenderQueue                  Queue{&Arena};      // built
+    std::pmr::vector<math::Aabb> Bounds{&Arena};     // one per Queue.GetInstances() entry, for OcclusionCuller::Prepare
+    std::pmr::vector<math::Mat4> Transforms{&Arena}; // one per Queue.GetInstances() entry, world space
+    std::pmr::vector<PointLight> Lights{&Arena};
+    Surface*                     Output{nullptr}; // what the frame is presented to, the main thread flushes before it goes away
+};
+
+struct RenderThreadStats
+{
+    double   ProduceWaitMs{0.0}; // the main thread waited for a free packet, it's ahead of the render thread
+    double   ConsumeWaitMs{0.0}; // the render thread waited for a packet, the main thread is the slow one
+    uint64_t Rendered{0};
+};
+
+/*
+ *  Runs the renderer on its own thread, a frame behind the main thread. There are two packets: while the
+ *  main thread fills one (BeginPacket, Publish) the render thread renders the other, and BeginPacket waits
+ *  for the render thread to be done with the packet it's about to overwrite. So the main thread is at most
+ *  one frame ahead, and the input of a frame is never more than two frames old when it's shown.
+ *  Everything glfw stays on the main thread. With render.thread off Publish renders right away instead.
+ */
+class RenderThread
+{
+public:
+    using RenderFunction = std::function<void(const FramePacket& packet)>;
+
+    explicit RenderThread(RenderFunction render) SRK_NOEXCEPT;
+    ~RenderThread() SRK_NOEXCEPT;
+
+    RenderThread(const RenderThread& other) = delete;
+    RenderThread& operator=(const RenderThread& other) = delete;
+
+    // main thread only
+    FramePacket& BeginPacket() SRK_NOEXCEPT;
+    void         Publish() SRK_NOEXCEPT;
+    // waits until everything published was rendered, for when the main thread has to touch what the render thread uses
+    void Flush() SRK_NOEXCEPT;
+    // renders what's still published and joins, nothing can be published after
+    void Stop() SRK_NOEXCEPT;
+
+    bool              IsThreaded() const SRK_NOEXCEPT { return m_Thread.joinable(); }
+    RenderThreadStats GetStats() SRK_NOEXCEPT;
+
+private:
+    void Loop() SRK_NOEXCEPT;
+
+private:
+    RenderFunction             m_Render;
+    std::array<FramePacket, 2> m_Packets;
+    uint64_t                   m_Produced; // published, the next one goes to m_Packets[m_Produced % 2]
+    uint64_t                   m_Consumed; // rendered
+    bool                       m_Running;
+    RenderThreadStats          m_Stats;
+    std::mutex                 m_Mutex; // guards the counters, m_Running and m_Stats
+    std::condition_variable    m_Published;
+    std::condition_variable    m_Rendered;
+    std::thread                m_Thread;
+};
+
+} // namespace shrek::render
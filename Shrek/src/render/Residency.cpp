@@ -0,0 +1,233 @@
+#include "pch.h"
+#include "Residency.h"
+
+#include "FrameContext.h"
+#include "base/Config.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+
+namespace shrek::render {
+
+namespace {
+
+base::ConfigVar<float>   highWatermark{"render.residency.high_watermark", 0.95f, "part of a heap's budget past which resources start getting reduced"};
+base::ConfigVar<float>   lowWatermark{"render.residency.low_watermark", 0.85f, "reducing stops under this part of the budget, and restoring only goes up to it"};
+base::ConfigVar<int32_t> restoreMbPerFrame{"render.residency.restore_mb_per_frame", 32, "how much is brought back each frame once there is headroom again"};
+
+// nobody is waiting on something that has not been drawn for this long, it's left reduced
+constexpr uint64_t restoreWindowFrames = 120;
+
+} // namespace
+
+ResidencyManager::ResidencyManager(uint32_t heapCount) SRK_NOEXCEPT :
+    m_Resources(),
+    m_Free(),
+    m_Resident(heapCount, 0),
+    m_Stats(),
+    m_Candidates()
+{
+}
+
+ResidencyId ResidencyManager::Register(ResidencyDesc desc, uint64_t frame) SRK_NOEXCEPT
+{
+    if (desc.Heap >= m_Resident.size() || desc.LevelSizes.empty() || !desc.SetLevel)
+    {
+        SRK_CORE_ERROR("Resource can't be registered for residency, it needs a valid heap, its level sizes and SetLevel");
+        return InvalidResidencyId;
+    }
+
+    ResidencyId id;
+    if (!m_Free.empty())
+    {
+        id = m_Free.back();
+        m_Free.pop_back();
+    }
+    else
+    {
+        id = static_cast<ResidencyId>(m_Resources.size());
+        m_Resources.push_back(std::make_unique<Resource>());
+    }
+
+    Resource& resource = *m_Resources[id];
+    resource.Desc      = std::move(desc);
+    resource.Level     = 0;
+    resource.Size      = resource.Desc.Streamed ? 0 : resource.Desc.LevelSizes[0];
+    resource.LastUsed.store(frame, std::memory_order_relaxed);
+    resource.Registered = true;
+
+    m_Resident[resource.Desc.Heap] += resource.Size;
+    return id;
+}
+
+void ResidencyManager::Unregister(ResidencyId id) SRK_NOEXCEPT
+{
+    if (id >= m_Resources.size() || !m_Resources[id]->Registered)
+        return;
+
+    Resource& resource = *m_Resources[id];
+    m_Resident[resource.Desc.Heap] -= resource.Size;
+    if (resource.Level > 0)
+        --m_Stats.Reduced;
+
+    resource.Desc       = ResidencyDesc{};
+    resource.Size       = 0;
+    resource.Registered = false;
+    m_Free.push_back(id);
+}
+
+void ResidencyManager::Touch(ResidencyId id, uint64_t frame) SRK_NOEXCEPT
+{
+    if (id >= m_Resources.size())
+        return;
+
+    // frames only go forward, a racing older frame losing is fine
+    std::atomic<uint64_t>& lastUsed = m_Resources[id]->LastUsed;
+    uint64_t               previous = lastUsed.load(std::memory_order_relaxed);
+    while (previous < frame && !lastUsed.compare_exchange_weak(previous, frame, std::memory_order_relaxed))
+    {
+    }
+}
+
+void ResidencyManager::Resize(ResidencyId id, VkDeviceSize size) SRK_NOEXCEPT
+{
+    if (id >= m_Resources.size() || !m_Resources[id]->Registered)
+        return;
+
+    Resource& resource             = *m_Resources[id];
+    m_Resident[resource.Desc.Heap] = m_Resident[resource.Desc.Heap] - resource.Size + size;
+    resource.Size                  = size;
+}
+
+bool ResidencyManager::SetLevel(Resource& resource, uint32_t level) SRK_NOEXCEPT
+{
+    if (!resource.Desc.SetLevel(level))
+        return false;
+
+    // a streamed resource lets go of what's over its new level by itself, a higher one only allows it more
+    const VkDeviceSize size        = resource.Desc.Streamed ? std::min(resource.Size, resource.Desc.LevelSizes[level]) : resource.Desc.LevelSizes[level];
+    m_Resident[resource.Desc.Heap] = m_Resident[resource.Desc.Heap] - resource.Size + size;
+    resource.Size                  = size;
+
+    if (level > resource.Level)
+        m_Stats.Demoted += level - resource.Level;
+    else
+        m_Stats.Promoted += resource.Level - level;
+
+    if (resource.Level == 0 && level > 0)
+        ++m_Stats.Reduced;
+    else if (resource.Level > 0 && level == 0)
+        --m_Stats.Reduced;
+
+    resource.Level = level;
+    return true;
+}
+
+void ResidencyManager::Update(uint64_t frame, const MemoryBudget& budget) SRK_NOEXCEPT
+{
+    const uint32_t heapCount = std::min(budget.GetHeapCount(), static_cast<uint32_t>(m_Resident.size()));
+    for (uint32_t heap{}; heap < heapCount; ++heap)
+    {
+        const HeapBudget& heapBudget = budget.GetHeap(heap);
+        if (heapBudget.Budget == 0)
+            continue;
+
+        // the driver's usage lags a frame behind what was just freed or allocated here, and is missing without the extension
+        const VkDeviceSize usage = budget.HasUsage() ? std::max(heapBudget.Usage, m_Resident[heap]) : m_Resident[heap];
+        const VkDeviceSize high  = static_cast<VkDeviceSize>(static_cast<double>(heapBudget.Budget) * highWatermark.Get());
+        const VkDeviceSize low   = static_cast<VkDeviceSize>(static_cast<double>(heapBudget.Budget) * std::min(lowWatermark.Get(), highWatermark.Get()));
+
+        if (usage > high)
+            Reduce(heap, frame, usage, low);
+        else if (usage < low && m_Stats.Reduced > 0)
+            Restore(heap, frame, usage, low);
+    }
+}
+
+void ResidencyManager::Reduce(uint32_t heap, uint64_t frame, VkDeviceSize usage, VkDeviceSize target) SRK_NOEXCEPT
+{
+    // anything a frame in flight may still read is left alone
+    const uint64_t inFlight = GetFramesInFlight();
+
+    m_Candidates.clear();
+    for (ResidencyId id{}; id < m_Resources.size(); ++id)
+    {
+        const Resource& resource = *m_Resources[id];
+        if (resource.Registered && resource.Desc.Heap == heap && resource.Level + 1 < resource.Desc.LevelSizes.size() &&
+            resource.LastUsed.load(std::memory_order_relaxed) + inFlight <= frame)
+            m_Candidates.push_back(id);
+    }
+
+    std::sort(m_Candidates.begin(), m_Candidates.end(), [this](ResidencyId lhs, ResidencyId rhs) {
+        return m_Resources[lhs]->LastUsed.load(std::memory_order_relaxed) < m_Resources[rhs]->LastUsed.load(std::memory_order_relaxed);
+    });
+
+    // a level off each in turn rather than evicting the oldest outright, dropping the top mip of many textures
+    // frees most of their memory and is far less visible than one of them going missing
+    const VkDeviceSize before   = usage;
+    bool               progress = true;
+    while (usage > target && progress)
+    {
+        progress = false;
+        for (ResidencyId id : m_Candidates)
+        {
+            Resource& resource = *m_Resources[id];
+            if (resource.Level + 1 >= resource.Desc.LevelSizes.size())
+                continue;
+
+            // a streamed texture that never got as fine as the next level has nothing to give
+            const VkDeviceSize held = resource.Size;
+            if (held <= resource.Desc.LevelSizes[resource.Level + 1] || !SetLevel(resource, resource.Level + 1))
+                continue;
+
+            const VkDeviceSize freed = held - resource.Size;
+            usage                    = usage > freed ? usage - freed : 0;
+            progress                 = true;
+            if (usage <= target)
+                break;
+        }
+    }
+
+    if (usage == before)
+        return;
+
+    SRK_CORE_TRACE("Heap {} over budget, freed {} bytes out of {} idle resources", heap, before - usage, m_Candidates.size());
+    if (usage > target)
+        SRK_CORE_WARN("Heap {} is still {} bytes over budget with nothing idle left to reduce", heap, usage - target);
+}
+
+void ResidencyManager::Restore(uint32_t heap, uint64_t frame, VkDeviceSize usage, VkDeviceSize target) SRK_NOEXCEPT
+{
+    m_Candidates.clear();
+    for (ResidencyId id{}; id < m_Resources.size(); ++id)
+    {
+        const Resource& resource = *m_Resources[id];
+        if (resource.Registered && resource.Desc.Heap == heap && resource.Level > 0 &&
+            resource.LastUsed.load(std::memory_order_relaxed) + restoreWindowFrames > frame)
+            m_Candidates.push_back(id);
+    }
+
+    // what was drawn last is what is most likely on screen
+    std::sort(m_Candidates.begin(), m_Candidates.end(), [this](ResidencyId lhs, ResidencyId rhs) {
+        return m_Resources[lhs]->LastUsed.load(std::memory_order_relaxed) > m_Resources[rhs]->LastUsed.load(std::memory_order_relaxed);
+    });
+
+    // spread over frames so bringing everything back doesn't hitch
+    VkDeviceSize allowance = static_cast<VkDeviceSize>(std::max(restoreMbPerFrame.Get(), 1)) * 1024 * 1024;
+    for (ResidencyId id : m_Candidates)
+    {
+        Resource& resource = *m_Resources[id];
+        while (resource.Level > 0)
+        {
+            // streamed ones only get allowed more, the streamer checks the budget itself before it loads anything
+            const VkDeviceSize needed = resource.Desc.Streamed ? 0 : resource.Desc.LevelSizes[resource.Level - 1] - resource.Desc.LevelSizes[resource.Level];
+            if (usage + needed > target || needed > allowance || !SetLevel(resource, resource.Level - 1))
+                return;
+
+            usage += needed;
+            allowance -= needed;
+        }
+    }
+}
+
+} // namespace shrek::render
@@ -0,0 +1,95 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "MemoryBudget.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace shrek::render {
+
+using ResidencyId = uint32_t;
+
+constexpr ResidencyId InvalidResidencyId = ~0u;
+
+/*
+ *  A texture or buffer the residency manager may shrink. Level 0 is fully resident, every level after
+ *  holds less (a texture drops its top mip per level) and the last one is evicted. A buffer has two levels.
+ *  A streamed texture only holds what was sampled, its levels are the most it may hold and it reports what it
+ *  actually does with ResidencyManager::Resize.
+ */
+struct ResidencyDesc
+{
+    uint32_t                  Heap{0};
+    std::vector<VkDeviceSize> LevelSizes; // bytes resident at each level, decreasing, the last is usually 0
+
+    // frees or brings back memory to match the level, false when it could not (the level stays as it was).
+    // runs inside Update, whatever the frames in flight may still read has to be destroyed once they are done
+    std::function<bool(uint32_t level)> SetLevel;
+
+    bool Streamed{false}; // starts out holding nothing, grows and shrinks on its own below its level's size
+};
+
+struct ResidencyStats
+{
+    uint64_t Demoted{0};  // levels dropped since startup
+    uint64_t Promoted{0}; // levels brought back
+    uint32_t Reduced{0};  // resources currently below level 0
+};
+
+/*
+ *  Keeps every heap inside its budget by shrinking what was used least recently. Past the high watermark
+ *  the least recently used resources drop a level each (oldest first) until usage is back under the low
+ *  watermark, below it the most recently used reduced resources get their levels back a few megabytes a frame.
+ *  The gap between the watermarks keeps it from evicting and restoring the same thing every other frame.
+ *  Register, Unregister and Update are render thread only, Touch may be called from any thread in between.
+ */
+class ResidencyManager
+{
+public:
+    explicit ResidencyManager(uint32_t heapCount) SRK_NOEXCEPT;
+
+    ResidencyManager(const ResidencyManager& other) = delete;
+    ResidencyManager& operator=(const ResidencyManager& other) = delete;
+
+    // resident at level 0, already allocated by the caller
+    ResidencyId Register(ResidencyDesc desc, uint64_t frame) SRK_NOEXCEPT;
+    void        Unregister(ResidencyId id) SRK_NOEXCEPT;
+
+    // marks the resource as used by this frame, which keeps it from being reduced while the frame is in flight
+    void Touch(ResidencyId id, uint64_t frame) SRK_NOEXCEPT;
+    // render thread, what a streamed resource holds right now
+    void Resize(ResidencyId id, VkDeviceSize size) SRK_NOEXCEPT;
+
+    void Update(uint64_t frame, const MemoryBudget& budget) SRK_NOEXCEPT;
+
+    uint32_t       GetLevel(ResidencyId id) const SRK_NOEXCEPT { return m_Resources[id]->Level; }
+    VkDeviceSize   GetResident(uint32_t heap) const SRK_NOEXCEPT { return m_Resident[heap]; }
+    ResidencyStats GetStats() const SRK_NOEXCEPT { return m_Stats; }
+
+private:
+    struct Resource
+    {
+        ResidencyDesc         Desc;
+        uint32_t              Level{0};
+        VkDeviceSize          Size{0}; // bytes held right now, LevelSizes[Level] unless it's streamed
+        std::atomic<uint64_t> LastUsed{0};
+        bool                  Registered{false};
+    };
+
+    bool SetLevel(Resource& resource, uint32_t level) SRK_NOEXCEPT;
+    void Reduce(uint32_t heap, uint64_t frame, VkDeviceSize usage, VkDeviceSize target) SRK_NOEXCEPT;
+    void Restore(uint32_t heap, uint64_t frame, VkDeviceSize usage, VkDeviceSize target) SRK_NOEXCEPT;
+
+private:
+    std::vector<std::unique_ptr<Resource>> m_Resources; // boxed since the atomic can't be moved
+    std::vector<ResidencyId>               m_Free;
+    std::vector<VkDeviceSize>              m_Resident; // per heap, what the registered resources hold right now
+    ResidencyStats                         m_Stats;
+    std::vector<ResidencyId>               m_Candidates; // scratch for Update
+};
+
+} // namespace shrek::render
@@ -0,0 +1,821 @@
+#include "pch.h"
+#include "SceneRenderer.h"
+
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace shrek::render {
+
+namespace {
+
+constexpr VkFormat colorFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+constexpr VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
+
+// the post chain samples the color, the hi-z build the depth
+constexpr VkImageUsageFlags colorUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+constexpr VkImageUsageFlags depthUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+// what the hi-z build samples the early pass's depth in, until the late pass writes to it again
+constexpr VkImageLayout hiZDepthLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+// descriptor sets of materials a frame has room for, the batches of any more draw nothing
+constexpr uint32_t maxMaterialSets = 256;
+
+// the shader side Camera of Forward.vert
+struct SceneCamera
+{
+    math::Mat4 ViewProjection;
+};
+
+// the push constants of ClusteredForward.frag, the fallback has no feedback slot
+struct SceneMaterial
+{
+    uint32_t Texture{InvalidStreamedTextureId};
+    uint32_t ResidentMip{0};
+};
+
+// a vertex stream the pipeline reads, bound at its index in sceneStreams. these are the formats the mesh
+// optimizer quantizes to, primitives with a stream in another format are turned away by AddMesh rather than
+// converted. a stream the primitive doesn't have at all is zeroed unless it's Required
+struct SceneStream
+{
+    VertexStream Stream;
+    VkFormat     Format;
+    uint32_t     Stride;
+    bool         Required;
+};
+
+constexpr std::array<SceneStream, 3> sceneStreams{{
+    {VertexStream_Position, VK_FORMAT_R32G32B32_SFLOAT, 12, true},
+    {VertexStream_Normal, VK_FORMAT_R8G8B8A8_SNORM, 4, false},
+    {VertexStream_TexCoord0, VK_FORMAT_R16G16_SFLOAT, 4, false},
+}};
+
+uint32_t indexSize(VkIndexType type) SRK_NOEXCEPT
+{
+    return type == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+}
+
+// the early pass clears and leaves the depth readable for the hi-z build, the late pass draws on top of both
+// and leaves the color for the passes that read it after
+VkResult createRenderPass(VkDevice device, CullPhase phase, VkRenderPass& renderPass) SRK_NOEXCEPT
+{
+    const bool late = phase == CullPhase::Late;
+
+    std::array<VkAttachmentDescription, 2> attachments{};
+    attachments[0].format         = colorFormat;
+    attachments[0].samples        = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp         = late ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout  = late ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout    = late ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    attachments[1].format         = depthFormat;
+    attachments[1].samples        = VK_SAMPLE_COUNT_1_BIT;
+    attachments[1].loadOp         = late ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].storeOp        = late ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[1].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout  = late ? hiZDepthLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[1].finalLayout    = late ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : hiZDepthLayout;
+
+    VkAttachmentReference colorReference{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkAttachmentReference depthReference{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount    = 1;
+    subpass.pColorAttachments       = &colorReference;
+    subpass.pDepthStencilAttachment = &depthReference;
+
+    // pooled images were last written by an earlier frame, the late pass also waits for the hi-z build to be
+    // done reading the depth. the early pass hands its depth to the hi-z build, the late pass its color to
+    // whatever reads it after
+    std::array<VkSubpassDependency, 2> dependencies{};
+    dependencies[0].srcSubpass    = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass    = 0;
+    dependencies[0].srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    if (late)
+        dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    if (late)
+    {
+        dependencies[1].srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].dstStageMask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    }
+    else
+    {
+        dependencies[1].srcStageMask  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[1].dstStageMask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    }
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments    = attachments.data();
+    renderPassInfo.subpassCount    = 1;
+    renderPassInfo.pSubpasses      = &subpass;
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies   = dependencies.data();
+
+    return vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass);
+}
+
+} // namespace
+
+SceneRenderer::SceneRenderer(VkPhysicalDevice gpu, VkDevice device, pipeline::ShaderLibrary& shaders, pipeline::PipelineCache& pipelines, UniformRing& uniforms,
+                             OcclusionCuller& occlusion, ClusteredLighting& lighting, ImagePool& images, RenderCommandQueue& commands, const MemoryBudget& budget,
+                             ResidencyManager& residency, TextureStreamer& streamer, uint32_t maxVertices, uint32_t maxIndices, uint32_t maxObjects) SRK_NOEXCEPT :
+    m_Gpu(gpu),
+    m_Device(device),
+    m_Shaders(shaders),
+    m_Pipelines(pipelines),
+    m_Uniforms(uniforms),
+    m_Occlusion(occlusion),
+    m_Lighting(lighting),
+    m_Images(images),
+    m_Commands(commands),
+    m_Residency(residency),
+    m_Streamer(streamer),
+    m_MaxVertices(maxVertices),
+    m_MaxIndices(maxIndices),
+    m_MaxObjects(maxObjects),
+    m_Valid(false),
+    m_Geometry(),
+    m_StreamOffsets{},
+    m_IndicesOffset(0),
+    m_IndexCapacity(VkDeviceSize{maxIndices} * sizeof(uint32_t)),
+    m_RenderPasses{VK_NULL_HANDLE, VK_NULL_HANDLE},
+    m_Slots(GetFramesInFlight()),
+    m_Sampler(VK_NULL_HANDLE),
+    m_Fallback(),
+    m_FallbackReady(false),
+    m_Mutex(),
+    m_VertexCount(0),
+    m_IndexBytes(0),
+    m_MeshCount(0),
+    m_MaterialCount(0),
+    m_Meshes(),
+    m_Copies(),
+    m_Materials(),
+    m_GeometryResidency(InvalidResidencyId),
+    m_GeometryReady(true)
+{
+    // every stream gets room for all of the vertices, the indices go after the last one
+    for (const SceneStream& stream : sceneStreams)
+    {
+        m_StreamOffsets[stream.Stream] = m_IndicesOffset;
+        m_IndicesOffset += VkDeviceSize{maxVertices} * stream.Stride;
+    }
+
+    // a set per phase, each with the camera, the objects and the phase's instances, the clusters both share and
+    // the materials, each with its albedo and the feedback
+    std::array<VkDescriptorPoolSize, 3> poolSizes{};
+    poolSizes[0].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[0].descriptorCount = 2;
+    poolSizes[1].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = 2 * 2 + 4 + maxMaterialSets;
+    poolSizes[2].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[2].descriptorCount = maxMaterialSets;
+
+    VkDescriptorPoolCreateInfo descriptorInfo{};
+    descriptorInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorInfo.maxSets       = 2 + 1 + maxMaterialSets;
+    descriptorInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    descriptorInfo.pPoolSizes    = poolSizes.data();
+
+    // streamed images only hold their resident mips, the lod is clamped by the image rather than the sampler
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter    = VK_FILTER_LINEAR;
+    samplerInfo.minFilter    = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.maxLod       = VK_LOD_CLAMP_NONE;
+
+    VkImageCreateInfo fallbackInfo{};
+    fallbackInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    fallbackInfo.imageType     = VK_IMAGE_TYPE_2D;
+    fallbackInfo.format        = VK_FORMAT_R8G8B8A8_UNORM;
+    fallbackInfo.extent        = {1, 1, 1};
+    fallbackInfo.mipLevels     = 1;
+    fallbackInfo.arrayLayers   = 1;
+    fallbackInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    fallbackInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    fallbackInfo.usage         = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    fallbackInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    fallbackInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkResult result = createRenderPass(m_Device, CullPhase::Early, m_RenderPasses[0]);
+    if (result == VK_SUCCESS)
+        result = createRenderPass(m_Device, CullPhase::Late, m_RenderPasses[1]);
+    if (result == VK_SUCCESS)
+        result = CreateGeometry();
+    if (result == VK_SUCCESS)
+        result = vkCreateSampler(m_Device, &samplerInfo, nullptr, &m_Sampler);
+    if (result == VK_SUCCESS)
+        result = helper::CreateImage(m_Gpu, m_Device, fallbackInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Fallback);
+
+    for (Slot& slot : m_Slots)
+    {
+        if (result != VK_SUCCESS)
+            break;
+
+        result = vkCreateDescriptorPool(m_Device, &descriptorInfo, nullptr, &slot.Descriptors);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Scene renderer could not be created with {}", result);
+        return;
+    }
+
+    // nothing renders yet, registering from here doesn't race the render thread
+    ResidencyDesc residencyDesc;
+    residencyDesc.Heap       = budget.GetHeapOfType(m_Geometry.MemoryType);
+    residencyDesc.LevelSizes = {m_Geometry.Size, 0};
+    residencyDesc.SetLevel   = [this](uint32_t level) { return SetGeometryLevel(level); };
+    m_GeometryResidency      = m_Residency.Register(std::move(residencyDesc), 0);
+
+    m_Valid = true;
+}
+
+SceneRenderer::~SceneRenderer() SRK_NOEXCEPT
+{
+    // FrameContext waited for the gpu before anything here goes
+    for (Slot& slot : m_Slots)
+    {
+        for (VkFramebuffer framebuffer : slot.Framebuffers)
+            vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
+        if (slot.Descriptors != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(m_Device, slot.Descriptors, nullptr);
+    }
+
+    m_Residency.Unregister(m_GeometryResidency);
+    helper::DestroyBuffer(m_Device, m_Geometry);
+    helper::DestroyImage(m_Device, m_Fallback);
+    if (m_Sampler != VK_NULL_HANDLE)
+        vkDestroySampler(m_Device, m_Sampler, nullptr);
+    for (VkRenderPass renderPass : m_RenderPasses)
+    {
+        if (renderPass != VK_NULL_HANDLE)
+            vkDestroyRenderPass(m_Device, renderPass, nullptr);
+    }
+}
+
+uint32_t SceneRenderer::AddMesh(const MeshPrimitive& primitive, const StagingBuffer& staging) SRK_NOEXCEPT
+{
+    // non indexed primitives would need a draw of their own, the indirect draws are all indexed
+    if (!m_Valid || primitive.VertexCount == 0 || primitive.IndexCount == 0 || !primitive.Indices.IsValid())
+        return NoSceneMesh;
+
+    for (const SceneStream& stream : sceneStreams)
+    {
+        const MeshStream& data = primitive.Streams[stream.Stream];
+        if (!data.IsValid() && !stream.Required)
+            continue;
+
+        if (!data.IsValid() || data.Format != stream.Format || data.Data.Size != VkDeviceSize{primitive.VertexCount} * stream.Stride)
+        {
+            SRK_CORE_ERROR("Vertex stream {} of a mesh is missing or not in format {}, the scene can't draw it", static_cast<uint32_t>(stream.Stream),
+                           static_cast<uint32_t>(stream.Format));
+            return NoSceneMesh;
+        }
+    }
+
+    // 16 and 32 bit indices share the region, a mesh starts at a multiple of its own index size so FirstIndex
+    // counts from the region's start whichever type it is bound with
+    const uint32_t     indexBytes  = indexSize(primitive.IndexType);
+    const VkDeviceSize indicesSize = primitive.Indices.Size;
+
+    // an unoptimized primitive is its own only lod
+    std::vector<MeshLod> lods = primitive.Lods;
+    if (lods.empty())
+        lods.push_back(MeshLod{0, primitive.IndexCount, 0.f});
+
+    IndirectMesh mesh;
+    VkDeviceSize indexOffset = 0;
+    uint32_t     id          = NoSceneMesh;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        indexOffset = (m_IndexBytes + indexBytes - 1) / indexBytes * indexBytes;
+        if (m_VertexCount + uint64_t{primitive.VertexCount} > m_MaxVertices || indexOffset + indicesSize > m_IndexCapacity)
+        {
+            SRK_CORE_ERROR("A mesh of {} vertices and {} indices doesn't fit the scene's geometry anymore", primitive.VertexCount, primitive.IndexCount);
+            return NoSceneMesh;
+        }
+
+        mesh.FirstIndex   = static_cast<uint32_t>(indexOffset / indexBytes);
+        mesh.VertexOffset = static_cast<int32_t>(m_VertexCount);
+        mesh.IndexType    = primitive.IndexType;
+        m_VertexCount += primitive.VertexCount;
+        m_IndexBytes = indexOffset + indicesSize;
+        id           = m_MeshCount;
+        m_MeshCount += static_cast<uint32_t>(lods.size());
+    }
+
+    // every lod draws a range of the same indices with the same vertices
+    std::vector<IndirectMesh> meshes(lods.size(), mesh);
+    for (size_t lod{}; lod < lods.size(); ++lod)
+    {
+        meshes[lod].IndexCount = lods[lod].IndexCount;
+        meshes[lod].FirstIndex += lods[lod].FirstIndex;
+    }
+
+    std::vector<GeometryCopy> copies;
+    for (const SceneStream& stream : sceneStreams)
+    {
+        const MeshStream&  data   = primitive.Streams[stream.Stream];
+        const VkDeviceSize offset = m_StreamOffsets[stream.Stream] + VkDeviceSize{static_cast<uint32_t>(mesh.VertexOffset)} * stream.Stride;
+        copies.push_back(GeometryCopy{data.IsValid() ? &staging : nullptr, data.Data, offset, VkDeviceSize{primitive.VertexCount} * stream.Stride});
+    }
+    copies.push_back(GeometryCopy{&staging, primitive.Indices, m_IndicesOffset + indexOffset, indicesSize});
+
+    // the geometry buffer is only looked at on the render thread, where it may have been evicted. the copies are
+    // queued from there against whatever buffer there is, an evicted one gets them once it's restored. the meshes
+    // are filled in behind them so they only draw after the copies were drained.
+    // the range stays taken when the queue was full, nothing else would fit in it anyway
+    const bool queued = m_Commands.Call([this, id, copies = std::move(copies), meshes = std::move(meshes)](const Frame&) {
+        m_Copies.insert(m_Copies.end(), copies.begin(), copies.end());
+
+        auto fill = [this, id, meshes](const Frame&) {
+            if (m_Meshes.size() < id + meshes.size())
+                m_Meshes.resize(id + meshes.size());
+            std::copy(meshes.begin(), meshes.end(), m_Meshes.begin() + id);
+        };
+
+        const bool copied = m_Geometry.Buffer == VK_NULL_HANDLE || QueueCopies(copies);
+        if (!copied || !m_Commands.Call(std::move(fill)))
+            SRK_CORE_ERROR("The copies of mesh {} could not be queued, it will never draw", id);
+    });
+    if (!queued)
+    {
+        SRK_CORE_ERROR("Mesh {} could not be queued for upload, it will never draw", id);
+        return NoSceneMesh;
+    }
+
+    return id;
+}
+
+uint32_t SceneRenderer::AddMaterial(StreamedTextureDesc albedo) SRK_NOEXCEPT
+{
+    uint32_t material = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        material = m_MaterialCount++;
+    }
+
+    // the streamer is render thread only. a material that never makes it there samples the fallback, as do
+    // the ones whose tail isn't in yet
+    const bool queued = m_Commands.Call([this, material, albedo = std::move(albedo)](const Frame&) mutable {
+        if (m_Materials.size() <= material)
+            m_Materials.resize(material + 1, InvalidStreamedTextureId);
+        m_Materials[material] = m_Streamer.Register(std::move(albedo));
+        if (m_Materials[material] == InvalidStreamedTextureId)
+            SRK_CORE_ERROR("The albedo of material {} could not be streamed, it stays white", material);
+    });
+    if (!queued)
+        SRK_CORE_ERROR("Material {} could not be queued, it stays white", material);
+
+    return material;
+}
+
+VkResult SceneRenderer::CreateGeometry() SRK_NOEXCEPT
+{
+    return helper::CreateBuffer(m_Gpu, m_Device, std::max<VkDeviceSize>(m_IndicesOffset + m_IndexCapacity, 1),
+                                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Geometry);
+}
+
+bool SceneRenderer::QueueCopies(const std::vector<GeometryCopy>& copies) SRK_NOEXCEPT
+{
+    for (const GeometryCopy& copy : copies)
+    {
+        const bool queued = copy.Staging ? m_Commands.Copy(*copy.Staging, copy.Source, m_Geometry.Buffer, copy.Offset)
+                                         : m_Commands.Upload(m_Geometry.Buffer, copy.Offset, std::vector<std::byte>(copy.Size));
+        if (!queued)
+            return false;
+    }
+    return true;
+}
+
+bool SceneRenderer::SetGeometryLevel(uint32_t level) SRK_NOEXCEPT
+{
+    // the frames in flight may still draw from it, the queue destroys it once they are done
+    if (level > 0)
+    {
+        if (!m_Commands.Destroy(m_Geometry))
+            return false;
+
+        m_GeometryReady = false;
+        return true;
+    }
+
+    if (m_Geometry.Buffer != VK_NULL_HANDLE)
+        return true;
+
+    const VkResult result = CreateGeometry();
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("The scene's geometry could not be made again with {}", result);
+        return false;
+    }
+
+    // nothing draws from it until everything was copied out of the staging again
+    if (!QueueCopies(m_Copies) || !m_Commands.Call([this](const Frame&) { m_GeometryReady = true; }))
+    {
+        SRK_CORE_ERROR("The scene's geometry could not be queued for restoring, it stays evicted");
+        m_Commands.Destroy(m_Geometry);
+        return false;
+    }
+    return true;
+}
+
+void SceneRenderer::BeginFrame(const Frame& frame) SRK_NOEXCEPT
+{
+    if (!m_Valid)
+        return;
+
+    // the slot's fence was waited on, nothing uses its framebuffers or descriptors anymore
+    Slot& slot = m_Slots[frame.Index];
+    for (VkFramebuffer framebuffer : slot.Framebuffers)
+        vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
+    slot.Framebuffers.clear();
+    slot.Materials.clear();
+    vkResetDescriptorPool(m_Device, slot.Descriptors, 0);
+}
+
+const pipeline::Pipeline* SceneRenderer::GetPipeline() SRK_NOEXCEPT
+{
+    pipeline::PipelineDesc desc;
+    desc.Shaders[0]  = m_Shaders.Get("Forward.vert");
+    desc.Shaders[1]  = m_Shaders.Get("ClusteredForward.frag");
+    desc.ShaderCount = 2;
+    if (!desc.Shaders[0] || !desc.Shaders[1])
+        return nullptr;
+
+    // a binding and an attribute per stream, in the formats AddMesh let in
+    for (uint32_t idx{}; idx < sceneStreams.size(); ++idx)
+    {
+        desc.Vertex.Bindings[idx]   = pipeline::VertexBinding{idx, sceneStreams[idx].Stride, VK_VERTEX_INPUT_RATE_VERTEX};
+        desc.Vertex.Attributes[idx] = pipeline::VertexAttribute{idx, idx, sceneStreams[idx].Format, 0};
+    }
+    desc.Vertex.BindingCount     = static_cast<uint32_t>(sceneStreams.size());
+    desc.Vertex.AttributeCount   = static_cast<uint32_t>(sceneStreams.size());
+    desc.Targets.ColorFormats[0] = colorFormat;
+    desc.Targets.ColorCount      = 1;
+    desc.Targets.DepthFormat     = depthFormat;
+    desc.RenderPass              = m_RenderPasses[0];
+
+    return m_Pipelines.Get(desc);
+}
+
+VkDescriptorSet SceneRenderer::AllocateSet(Slot& slot, const pipeline::Pipeline& pipeline, const UniformAllocation& camera, const UniformAllocation& objects,
+                                           const VkDescriptorBufferInfo& instances) SRK_NOEXCEPT
+{
+    VkDescriptorSetAllocateInfo allocateInfo{};
+    allocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.descriptorPool     = slot.Descriptors;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts        = &pipeline.Layout->SetLayouts[0];
+
+    VkDescriptorSet set{VK_NULL_HANDLE};
+    VkResult        result = vkAllocateDescriptorSets(m_Device, &allocateInfo, &set);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Scene descriptors could not be allocated with {}", result);
+        return VK_NULL_HANDLE;
+    }
+
+    // the allocations' offsets are absolute, the ring's buffer is bound at them like any other buffer
+    std::array<VkDescriptorBufferInfo, 3> buffers{};
+    buffers[0] = VkDescriptorBufferInfo{m_Uniforms.GetBuffer(), camera.Offset, camera.Size};
+    buffers[1] = VkDescriptorBufferInfo{m_Uniforms.GetBuffer(), objects.Offset, objects.Size};
+    buffers[2] = instances;
+
+    std::array<VkWriteDescriptorSet, 3> writes{};
+    for (uint32_t binding{}; binding < writes.size(); ++binding)
+    {
+        writes[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet          = set;
+        writes[binding].dstBinding      = binding;
+        writes[binding].descriptorCount = 1;
+        writes[binding].descriptorType  = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[binding].pBufferInfo     = &buffers[binding];
+    }
+    vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    return set;
+}
+
+VkDescriptorSet SceneRenderer::AllocateClusterSet(const Frame& frame, Slot& slot, const pipeline::Pipeline& pipeline) SRK_NOEXCEPT
+{
+    VkDescriptorSetAllocateInfo allocateInfo{};
+    allocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.descriptorPool     = slot.Descriptors;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts        = &pipeline.Layout->SetLayouts[1];
+
+    VkDescriptorSet set{VK_NULL_HANDLE};
+    VkResult        result = vkAllocateDescriptorSets(m_Device, &allocateInfo, &set);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Scene cluster descriptors could not be allocated with {}", result);
+        return VK_NULL_HANDLE;
+    }
+
+    const std::array<VkDescriptorBufferInfo, 4> buffers = m_Lighting.GetShadingBuffers(frame.Index);
+
+    std::array<VkWriteDescriptorSet, 4> writes{};
+    for (uint32_t binding{}; binding < writes.size(); ++binding)
+    {
+        writes[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet          = set;
+        writes[binding].dstBinding      = binding;
+        writes[binding].descriptorCount = 1;
+        writes[binding].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[binding].pBufferInfo     = &buffers[binding];
+    }
+    vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    return set;
+}
+
+VkDescriptorSet SceneRenderer::GetMaterialSet(const Frame& frame, Slot& slot, const pipeline::Pipeline& pipeline, uint32_t material) SRK_NOEXCEPT
+{
+    // views change as the textures stream, the sets are written anew every frame
+    const uint32_t count = static_cast<uint32_t>(m_Materials.size());
+    material             = std::min(material, count);
+    if (slot.Materials.size() <= count)
+        slot.Materials.resize(count + 1, VK_NULL_HANDLE);
+    if (slot.Materials[material] != VK_NULL_HANDLE)
+        return slot.Materials[material];
+
+    VkDescriptorSetAllocateInfo allocateInfo{};
+    allocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.descriptorPool     = slot.Descriptors;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts        = &pipeline.Layout->SetLayouts[2];
+
+    VkDescriptorSet set{VK_NULL_HANDLE};
+    VkResult        result = vkAllocateDescriptorSets(m_Device, &allocateInfo, &set);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Material descriptors could not be allocated with {}", result);
+        return VK_NULL_HANDLE;
+    }
+
+    const StreamedTextureId texture = material < count ? m_Materials[material] : InvalidStreamedTextureId;
+    const VkImageView       view    = texture != InvalidStreamedTextureId ? m_Streamer.GetView(texture) : VK_NULL_HANDLE;
+
+    VkDescriptorImageInfo  image{m_Sampler, view != VK_NULL_HANDLE ? view : m_Fallback.View, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkDescriptorBufferInfo feedback{m_Streamer.GetFeedbackBuffer(frame.Index), 0, m_Streamer.GetFeedbackSize()};
+
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    for (uint32_t binding{}; binding < writes.size(); ++binding)
+    {
+        writes[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet          = set;
+        writes[binding].dstBinding      = binding;
+        writes[binding].descriptorCount = 1;
+    }
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].pImageInfo     = &image;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[1].pBufferInfo    = &feedback;
+    vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    slot.Materials[material] = set;
+    return set;
+}
+
+void SceneRenderer::PrepareFallback(VkCommandBuffer cmd) SRK_NOEXCEPT
+{
+    if (m_FallbackReady)
+        return;
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask               = 0;
+    barrier.dstAccessMask               = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout                   = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout                   = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                       = m_Fallback.Image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    const VkClearColorValue white{{1.f, 1.f, 1.f, 1.f}};
+    vkCmdClearColorImage(cmd, m_Fallback.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &white, 1, &barrier.subresourceRange);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    m_FallbackReady = true;
+}
+
+VkFramebuffer SceneRenderer::CreateFramebuffer(Slot& slot, const PooledImage& color, const PooledImage& depth) SRK_NOEXCEPT
+{
+    std::array<VkImageView, 2> views{color.View, depth.View};
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass      = m_RenderPasses[0]; // the late pass is compatible with it
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+    framebufferInfo.pAttachments    = views.data();
+    framebufferInfo.width           = color.Extent.width;
+    framebufferInfo.height          = color.Extent.height;
+    framebufferInfo.layers          = 1;
+
+    VkFramebuffer framebuffer{VK_NULL_HANDLE};
+    VkResult      result = vkCreateFramebuffer(m_Device, &framebufferInfo, nullptr, &framebuffer);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Scene framebuffer could not be created with {}", result);
+        return VK_NULL_HANDLE;
+    }
+
+    slot.Framebuffers.push_back(framebuffer);
+    return framebuffer;
+}
+
+bool SceneRenderer::Record(const Frame& frame, const FramePacket& packet, VkExtent2D targetExtent, VkExtent2D renderExtent,
+                           SceneTarget& target) SRK_NOEXCEPT
+{
+    Slot& slot = m_Slots[frame.Index];
+    if (!m_Valid || frame.CommandBuffer == VK_NULL_HANDLE || renderExtent.width == 0 || renderExtent.height == 0 ||
+        renderExtent.width > targetExtent.width || renderExtent.height > targetExtent.height)
+        return false;
+
+    const PooledImage* color = m_Images.Acquire({targetExtent, colorFormat, colorUsage});
+    const PooledImage* depth = m_Images.Acquire({targetExtent, depthFormat, depthUsage});
+    if (!color || !depth)
+        return false;
+
+    const VkFramebuffer framebuffer = CreateFramebuffer(slot, *color, *depth);
+    if (framebuffer == VK_NULL_HANDLE)
+        return false;
+
+    PrepareFallback(frame.CommandBuffer);
+
+    const std::pmr::vector<DrawBatch>& batches   = packet.Queue.GetBatches();
+    const size_t                       instances = packet.Queue.GetInstances().size();
+
+    // a queue that doesn't fit is cleared to nothing rather than drawn in part, as is everything while the
+    // geometry is evicted. it's still touched so it's what comes back first
+    bool draw = instances > 0 && packet.Transforms.size() == instances;
+    if (draw)
+        m_Residency.Touch(m_GeometryResidency, frame.Number);
+    draw = draw && m_GeometryReady;
+    if (instances > m_MaxObjects)
+    {
+        SRK_CORE_ERROR("{} instances don't fit the {} the scene has room for", instances, m_MaxObjects);
+        draw = false;
+    }
+
+    // both live as long as the frame, the ring's region is only reused once the slot's fence signaled. a queue
+    // the culling has no room for draws nothing either
+    const pipeline::Pipeline*      pipeline = draw ? GetPipeline() : nullptr;
+    std::array<VkDescriptorSet, 2> sets{VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkDescriptorSet                clusters{VK_NULL_HANDLE};
+    if (pipeline)
+        clusters = AllocateClusterSet(frame, slot, *pipeline);
+    if (clusters != VK_NULL_HANDLE)
+    {
+        const math::Mat4        viewProjection = packet.Camera.Projection * packet.Camera.View;
+        const UniformAllocation camera         = m_Uniforms.Push(SceneCamera{viewProjection});
+        const UniformAllocation objects        = m_Uniforms.Allocate(VkDeviceSize{instances} * sizeof(math::Mat4));
+        if (!camera.IsValid() || !objects.IsValid())
+        {
+            SRK_CORE_ERROR("The uniform ring has no room left for the camera and {} instances this frame", instances);
+        }
+        else if (packet.Bounds.size() == instances && m_Occlusion.Prepare(frame, packet.Queue, packet.Bounds.data(), m_Meshes, viewProjection))
+        {
+            std::memcpy(objects.Data, packet.Transforms.data(), instances * sizeof(math::Mat4));
+            for (uint32_t phase{}; phase < sets.size(); ++phase)
+                sets[phase] = AllocateSet(slot, *pipeline, camera, objects, m_Occlusion.GetInstances(frame.Index, static_cast<CullPhase>(phase)));
+        }
+    }
+
+    // the lights are binned for the camera the frame shades with, before either pass reads the clusters
+    const ClusterCamera lightCamera{packet.Camera.View, packet.Camera.Projection, packet.Camera.Near, packet.Camera.Far, renderExtent};
+    m_Lighting.Update(frame, packet.Lights.data(), static_cast<uint32_t>(packet.Lights.size()), lightCamera);
+    m_Lighting.Record(frame);
+
+    target = SceneTarget{color, depth, renderExtent};
+
+    // the early phase draws what was visible last frame, the pyramid of its depth decides what the late phase adds
+    m_Occlusion.RecordCull(frame, CullPhase::Early);
+    RecordPass(frame, CullPhase::Early, framebuffer, target, pipeline, {sets[0], clusters}, batches);
+    m_Occlusion.RecordHiZ(frame, depth->View, hiZDepthLayout, renderExtent);
+    m_Occlusion.RecordCull(frame, CullPhase::Late);
+    RecordPass(frame, CullPhase::Late, framebuffer, target, pipeline, {sets[1], clusters}, batches);
+    return true;
+}
+
+void SceneRenderer::RecordPass(const Frame& frame, CullPhase phase, VkFramebuffer framebuffer, const SceneTarget& target, const pipeline::Pipeline* pipeline,
+                               const std::array<VkDescriptorSet, 2>& sets, const std::pmr::vector<DrawBatch>& batches) SRK_NOEXCEPT
+{
+    // the early pass clears all of the images, whatever samples them past the rendered corner reads black
+    const VkExtent2D extent = target.Extent;
+
+    VkCommandBuffer cmd = frame.CommandBuffer;
+
+    std::array<VkClearValue, 2> clears{};
+    clears[0].color        = {{0.f, 0.f, 0.f, 1.f}};
+    clears[1].depthStencil = {1.f, 0};
+
+    VkRenderPassBeginInfo passInfo{};
+    passInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    passInfo.renderPass        = m_RenderPasses[static_cast<uint32_t>(phase)];
+    passInfo.framebuffer       = framebuffer;
+    passInfo.renderArea.extent = phase == CullPhase::Early ? target.Color->Extent : extent;
+    passInfo.clearValueCount   = static_cast<uint32_t>(clears.size());
+    passInfo.pClearValues      = clears.data();
+
+    vkCmdBeginRenderPass(cmd, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    if (sets[0] != VK_NULL_HANDLE)
+    {
+        VkViewport viewport{0.f, 0.f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.f, 1.f};
+        VkRect2D   scissor{{0, 0}, extent};
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+        std::array<VkBuffer, sceneStreams.size()>     buffers{};
+        std::array<VkDeviceSize, sceneStreams.size()> offsets{};
+        for (uint32_t idx{}; idx < sceneStreams.size(); ++idx)
+        {
+            buffers[idx] = m_Geometry.Buffer;
+            offsets[idx] = m_StreamOffsets[sceneStreams[idx].Stream];
+        }
+
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->Handle);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->Layout->Layout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+        vkCmdBindVertexBuffers(cmd, 0, static_cast<uint32_t>(buffers.size()), buffers.data(), offsets.data());
+        vkCmdBindIndexBuffer(cmd, m_Geometry.Buffer, m_IndicesOffset, indexType);
+
+        // one pipeline for the whole queue for now, so only the mesh and the material change between batches and
+        // with the mesh at most the index type. the queue is sorted by material, each is bound once a pass. the
+        // culling wrote the instance counts, a batch without a mesh yet has no indices to draw
+        Slot&    slot     = m_Slots[frame.Index];
+        uint32_t material = ~0u;
+        bool     bound    = false;
+        for (uint32_t batch{}; batch < batches.size(); ++batch)
+        {
+            const uint32_t mesh = batches[batch].Mesh;
+            if (mesh < m_Meshes.size() && m_Meshes[mesh].IndexType != indexType)
+            {
+                indexType = m_Meshes[mesh].IndexType;
+                vkCmdBindIndexBuffer(cmd, m_Geometry.Buffer, m_IndicesOffset, indexType);
+            }
+
+            if (DrawKey::Material(batches[batch].Key) != material)
+            {
+                material                  = DrawKey::Material(batches[batch].Key);
+                const VkDescriptorSet set = GetMaterialSet(frame, slot, *pipeline, material);
+                bound                     = set != VK_NULL_HANDLE;
+                if (bound)
+                {
+                    // the feedback only goes to textures whose image is what the set samples
+                    SceneMaterial constants;
+                    const StreamedTextureId texture = material < m_Materials.size() ? m_Materials[material] : InvalidStreamedTextureId;
+                    if (texture != InvalidStreamedTextureId && m_Streamer.GetView(texture) != VK_NULL_HANDLE)
+                        constants = SceneMaterial{texture, m_Streamer.GetResidentMip(texture)};
+
+                    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->Layout->Layout, 2, 1, &set, 0, nullptr);
+                    vkCmdPushConstants(cmd, pipeline->Layout->Layout, pipeline->Layout->PushConstants.stageFlags, 0, sizeof(constants), &constants);
+                }
+            }
+            if (bound)
+                m_Occlusion.Draw(frame, phase, batch);
+        }
+    }
+
+    vkCmdEndRenderPass(cmd);
+}
+
+} // namespace shrek::render
@@ -0,0 +1,162 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "ClusteredLighting.h"
+#include "FrameContext.h"
+#include "ImagePool.h"
+#include "MemoryBudget.h"
+#include "Mesh.h"
+#include "OcclusionCuller.h"
+#include "RenderCommands.h"
+#include "RenderThread.h"
+#include "Residency.h"
+#include "StagingBuffer.h"
+#include "TextureStreamer.h"
+#include "UniformRing.h"
+#include "base/math/Vec.h"
+#include "helper/Memory.h"
+#include "pipeline/PipelineCache.h"
+#include "pipeline/ShaderLibrary.h"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace shrek::render {
+
+constexpr uint32_t NoSceneMesh = ~0u;
+
+// what the scene was rendered into, for whatever puts it on the screen
+struct SceneTarget
+{
+    const PooledImage* Color{nullptr}; // hdr, in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL once Record is done
+    const PooledImage* Depth{nullptr};
+    VkExtent2D         Extent{0, 0}; // what was rendered, the top left corner of the images, nothing past it is drawn
+};
+
+/*
+ *  Draws the render queue of a FramePacket with clustered forward shading into hdr color and depth images of
+ *  the pool, the packet's Lights are binned by ClusteredLighting before the passes and bound as set 1.
+ *  Meshes live in one device local buffer, every vertex stream the pipeline reads in its own region in the
+ *  formats the mesh optimizer quantizes to and the indices of either type in one after them. AddMesh copies a primitive the loaders wrote into a StagingBuffer
+ *  straight out of it through the render command queue, from any thread, and returns the index
+ *  scene::Renderable::Mesh refers to. The mesh draws nothing until the frame that drains the copies.
+ *  The geometry buffer is registered with the ResidencyManager and touched by every frame that draws from it,
+ *  once evicted nothing is drawn until it was made again and every copy so far was replayed out of the staging.
+ *  Materials are an albedo texture each, streamed by the TextureStreamer and bound as set 2 with the frame's feedback
+ *  buffer the fragment shader writes the mips it sampled into. A material samples a white fallback until its tail
+ *  is in, as does every renderable whose Material wasn't added.
+ *  The camera and the packet's Transforms go into the frame's region of the UniformRing. The queue is drawn
+ *  in the two phases of the OcclusionCuller, every batch an indirect draw per phase whose instance count the
+ *  culling wrote, an instance reads its transform at instances[gl_InstanceIndex] of the phase's survivors.
+ */
+class SceneRenderer
+{
+public:
+    SceneRenderer(VkPhysicalDevice gpu, VkDevice device, pipeline::ShaderLibrary& shaders, pipeline::PipelineCache& pipelines, UniformRing& uniforms,
+                  OcclusionCuller& occlusion, ClusteredLighting& lighting, ImagePool& images, RenderCommandQueue& commands, const MemoryBudget& budget,
+                  ResidencyManager& residency, TextureStreamer& streamer, uint32_t maxVertices, uint32_t maxIndices, uint32_t maxObjects) SRK_NOEXCEPT;
+    ~SceneRenderer() SRK_NOEXCEPT;
+
+    SceneRenderer(const SceneRenderer& other) = delete;
+    SceneRenderer& operator=(const SceneRenderer& other) = delete;
+
+    // any thread. the staging the primitive was loaded into has to stay untouched for as long as the scene renderer
+    // is around, evicted geometry is copied out of it again. every lod of the primitive is a mesh of its own, lod n is the returned id + n. NoSceneMesh
+    // when its streams aren't in the formats drawn, the buffer is full or the copies couldn't be queued
+    uint32_t AddMesh(const MeshPrimitive& primitive, const StagingBuffer& staging) SRK_NOEXCEPT;
+    // any thread. the albedo is registered with the streamer on the render thread, LoadMip has to stay callable for as
+    // long as the scene renderer is around. the index scene::Renderable::Material refers to
+    uint32_t AddMaterial(StreamedTextureDesc albedo) SRK_NOEXCEPT;
+
+    // after FrameContext::BeginFrame, destroys what the frame that last used the slot made
+    void BeginFrame(const Frame& frame) SRK_NOEXCEPT;
+
+    // outside a render pass, after the command queue was drained and the BeginFrame of the UniformRing, the
+    // OcclusionCuller and ClusteredLighting. false when there was nothing to render into
+    // the images are targetExtent so they outlive scale changes, the scene is drawn into the renderExtent corner
+    bool Record(const Frame& frame, const FramePacket& packet, VkExtent2D targetExtent, VkExtent2D renderExtent, SceneTarget& target) SRK_NOEXCEPT;
+
+    bool IsValid() const SRK_NOEXCEPT { return m_Valid; }
+    // render thread, indexed by DrawBatch::Mesh
+    const std::vector<IndirectMesh>& GetMeshes() const SRK_NOEXCEPT { return m_Meshes; }
+
+private:
+    struct Slot
+    {
+        VkDescriptorPool             Descriptors{VK_NULL_HANDLE};
+        std::vector<VkFramebuffer>   Framebuffers;
+        std::vector<VkDescriptorSet> Materials; // allocated by the first batch of the frame using them, the fallback's last
+    };
+
+    // a range of the geometry buffer and where it comes from, zeroes without a staging
+    struct GeometryCopy
+    {
+        const StagingBuffer* Staging{nullptr};
+        StagingAllocation    Source;
+        VkDeviceSize         Offset{0};
+        VkDeviceSize         Size{0};
+    };
+
+    VkResult CreateGeometry() SRK_NOEXCEPT;
+    // render thread, copies into the current geometry buffer through the command queue
+    bool QueueCopies(const std::vector<GeometryCopy>& copies) SRK_NOEXCEPT;
+    // ResidencyDesc::SetLevel of the geometry buffer
+    bool SetGeometryLevel(uint32_t level) SRK_NOEXCEPT;
+
+    const pipeline::Pipeline* GetPipeline() SRK_NOEXCEPT;
+    VkDescriptorSet           AllocateSet(Slot& slot, const pipeline::Pipeline& pipeline, const UniformAllocation& camera, const UniformAllocation& objects,
+                                          const VkDescriptorBufferInfo& instances) SRK_NOEXCEPT;
+    VkDescriptorSet           AllocateClusterSet(const Frame& frame, Slot& slot, const pipeline::Pipeline& pipeline) SRK_NOEXCEPT;
+    // set 2 of the material, materials that weren't added get the fallback's. null when the pool ran out
+    VkDescriptorSet           GetMaterialSet(const Frame& frame, Slot& slot, const pipeline::Pipeline& pipeline, uint32_t material) SRK_NOEXCEPT;
+    // clears the fallback to white the first time anything records
+    void                      PrepareFallback(VkCommandBuffer cmd) SRK_NOEXCEPT;
+    // sets 0 and 1, nothing is drawn without set 0
+    void RecordPass(const Frame& frame, CullPhase phase, VkFramebuffer framebuffer, const SceneTarget& target, const pipeline::Pipeline* pipeline,
+                    const std::array<VkDescriptorSet, 2>& sets, const std::pmr::vector<DrawBatch>& batches) SRK_NOEXCEPT;
+    VkFramebuffer             CreateFramebuffer(Slot& slot, const PooledImage& color, const PooledImage& depth) SRK_NOEXCEPT;
+
+private:
+    VkPhysicalDevice         m_Gpu;
+    VkDevice                 m_Device;
+    pipeline::ShaderLibrary& m_Shaders;
+    pipeline::PipelineCache& m_Pipelines;
+    UniformRing&             m_Uniforms;
+    OcclusionCuller&         m_Occlusion;
+    ClusteredLighting&       m_Lighting;
+    ImagePool&               m_Images;
+    RenderCommandQueue&      m_Commands;
+    ResidencyManager&        m_Residency;
+    TextureStreamer&         m_Streamer;
+    uint32_t                 m_MaxVertices;
+    uint32_t                 m_MaxIndices;
+    uint32_t                 m_MaxObjects;
+    bool                     m_Valid;
+
+    helper::BufferAllocation                     m_Geometry; // the vertex streams, then indices. render thread, it goes and comes back with its residency
+    std::array<VkDeviceSize, VertexStream_Count> m_StreamOffsets; // of the streams the pipeline reads
+    VkDeviceSize                                 m_IndicesOffset;
+    VkDeviceSize                                 m_IndexCapacity; // bytes, room for maxIndices 32 bit indices
+    std::array<VkRenderPass, 2>                  m_RenderPasses; // indexed by CullPhase
+    std::vector<Slot>                            m_Slots;
+    VkSampler                                    m_Sampler;
+    helper::ImageAllocation                      m_Fallback; // 1x1 white
+    bool                                         m_FallbackReady;
+
+    std::mutex   m_Mutex; // guards the four below, AddMesh and AddMaterial hand out ranges and indices from any thread
+    uint32_t     m_VertexCount;
+    VkDeviceSize m_IndexBytes;
+    uint32_t     m_MeshCount;
+    uint32_t     m_MaterialCount;
+
+    // render thread, filled in as the copies are drained
+    std::vector<IndirectMesh>      m_Meshes;
+    std::vector<GeometryCopy>      m_Copies; // every one so far, replayed when the geometry comes back
+    std::vector<StreamedTextureId> m_Materials; // the albedo of each material, InvalidStreamedTextureId until it was registered
+    ResidencyId                    m_GeometryResidency;
+    bool                           m_GeometryReady; // false from eviction until the replayed copies were drained
+};
+
+} // namespace shrek::render
@@ -0,0 +1,58 @@
+#include "pch.h"
+#include "StagingBuffer.h"
+
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+namespace shrek::render {
+
+StagingBuffer::StagingBuffer(VkPhysicalDevice gpu, VkDevice device, VkDeviceSize capacity) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Buffer(),
+    m_Offset(0)
+{
+    // coherent so that nothing has to be flushed before the copy is submitted
+    VkResult result = helper::CreateBuffer(gpu, device, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Buffer);
+    if (result != VK_SUCCESS)
+        SRK_CORE_ERROR("Staging buffer of {} bytes could not be created with {}", capacity, result);
+}
+
+StagingBuffer::~StagingBuffer() SRK_NOEXCEPT
+{
+    helper::DestroyBuffer(m_Device, m_Buffer);
+}
+
+StagingAllocation StagingBuffer::Allocate(VkDeviceSize size, VkDeviceSize alignment) SRK_NOEXCEPT
+{
+    if (!IsValid())
+        return {};
+
+    VkDeviceSize offset = m_Offset.load(std::memory_order_relaxed);
+    VkDeviceSize aligned{};
+    do
+    {
+        aligned = helper::AlignUp(offset, alignment);
+        if (aligned + size > m_Buffer.Size)
+            return {};
+    } while (!m_Offset.compare_exchange_weak(offset, aligned + size, std::memory_order_relaxed));
+
+    return StagingAllocation{static_cast<std::byte*>(m_Buffer.Mapped) + aligned, aligned, size};
+}
+
+void StagingBuffer::Reset() SRK_NOEXCEPT
+{
+    m_Offset.store(0, std::memory_order_relaxed);
+}
+
+void StagingBuffer::RecordCopy(VkCommandBuffer commandBuffer, const StagingAllocation& allocation, VkBuffer dst, VkDeviceSize dstOffset) const SRK_NOEXCEPT
+{
+    VkBufferCopy region{};
+    region.srcOffset = allocation.Offset;
+    region.dstOffset = dstOffset;
+    region.size      = allocation.Size;
+
+    vkCmdCopyBuffer(commandBuffer, m_Buffer.Buffer, dst, 1, &region);
+}
+
+} // namespace shrek::render
@@ -0,0 +1,52 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "helper/Memory.h"
+
+#include <atomic>
+#include <cstddef>
+
+namespace shrek::render {
+
+struct StagingAllocation
+{
+    std::byte*   Data{nullptr}; // points into the mapped buffer, write straight into it
+    VkDeviceSize Offset{0};
+    VkDeviceSize Size{0};
+
+    bool IsValid() const SRK_NOEXCEPT { return Data != nullptr; }
+};
+
+/*
+ *  Host visible, persistently mapped buffer that uploads are written into before being copied to device memory.
+ *  Allocating is a lock free bump of an offset so loaders on several threads can fill it at once.
+ *  Reset only once the copies reading from it have finished on the gpu.
+ */
+class StagingBuffer
+{
+public:
+    StagingBuffer(VkPhysicalDevice gpu, VkDevice device, VkDeviceSize capacity) SRK_NOEXCEPT;
+    ~StagingBuffer() SRK_NOEXCEPT;
+
+    StagingBuffer(const StagingBuffer& other) = delete;
+    StagingBuffer& operator=(const StagingBuffer& other) = delete;
+
+    // returns an invalid allocation when the buffer is full
+    StagingAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment = 16) SRK_NOEXCEPT;
+    void              Reset() SRK_NOEXCEPT;
+
+    // copies the allocation into dst, the caller takes care of barriers
+    void RecordCopy(VkCommandBuffer commandBuffer, const StagingAllocation& allocation, VkBuffer dst, VkDeviceSize dstOffset) const SRK_NOEXCEPT;
+
+    bool         IsValid() const SRK_NOEXCEPT { return m_Buffer.Mapped != nullptr; }
+    VkBuffer     GetBuffer() const SRK_NOEXCEPT { return m_Buffer.Buffer; }
+    VkDeviceSize GetCapacity() const SRK_NOEXCEPT { return m_Buffer.Size; }
+    VkDeviceSize GetUsed() const SRK_NOEXCEPT { return m_Offset.load(std::memory_order_relaxed); }
+
+private:
+    VkDevice                  m_Device;
+    helper::BufferAllocation  m_Buffer;
+    std::atomic<VkDeviceSize> m_Offset;
+};
+
+} // namespace shrek::render
@@ -1,12 +1,12 @@
 #include "pch.h"
 #include "Surface.h"
 
+#include "base/Config.h"
 #include "platform/Log.h"
 #include "platform/WindowsWindow.h"
 
 #include "helper/Debug.h"
 #include "vulkan_core.h"
-#include "vulkan_win32.h"
 #include <GLFW/glfw3.h>
 
 namespace shrek::render {
@@ -15,46 +15,43 @@ using helper::QueueFamilyIndices;
 
 namespace {
 
-// Vulkan tutorial says to use this but for pc we probably don't need to use this to check for device support
-SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
+// Vulkan tutorial says to use this but for pc we probably don't need to use this to check for device support.
+// fills details in place so asking again reuses the lists it already has
+void querySwapchainSupport(VkPhysicalDevice device, VkSurfaceKHR surface, SwapchainSupportDetails& details) SRK_NOEXCEPT
 {
-    SwapchainSupportDetails details{};
-
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.Capabilities);
 
-    uint32_t formatCount;
+    uint32_t formatCount{};
     vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
-
+    details.Formats.resize(formatCount);
     if (formatCount != 0)
-    {
-        details.Formats.resize(formatCount);
         vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.Formats.data());
-    }
 
-    uint32_t presentModeCount;
+    uint32_t presentModeCount{};
     vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
-
+    details.PresentModes.resize(presentModeCount);
     if (presentModeCount != 0)
-    {
-        details.PresentModes.resize(presentModeCount);
         vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.PresentModes.data());
-    }
-
-    return details;
 }
 
+// UNORM on purpose, the tonemap encodes sRGB itself and an *_SRGB swapchain would encode the blit a second time
 VkSurfaceFormatKHR chooseRightSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& surfaceFormats) SRK_NOEXCEPT
 {
-    for (const auto& format : surfaceFormats)
+    for (VkFormat wanted : {VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM})
     {
-        if (format.format == VK_FORMAT_B8G8R8_SRGB && format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
-            return format;
+        for (const auto& format : surfaceFormats)
+        {
+            if (format.format == wanted && format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+                return format;
+        }
     }
 
+    SRK_CORE_WARN("Surface has no 8 bit UNORM format, using {} and colors will be off", surfaceFormats.front().format);
     return surfaceFormats.front();
 }
 
-VkExtent2D chooseSwapExtent(GLFWwindow* window, const VkSurfaceCapabilitiesKHR& capabilities)
+// the framebuffer size is what the callback last reported, glfw can't be asked from the render thread
+VkExtent2D chooseSwapExtent(VkExtent2D framebuffer, const VkSurfaceCapabilitiesKHR& capabilities)
 {
     if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
     {
@@ -62,11 +59,7 @@ VkExtent2D chooseSwapExtent(GLFWwindow* window, const VkSurfaceCapabilitiesKHR&
     }
     else
     {
-        int width{};
-        int height{};
-        glfwGetFramebufferSize(window, &width, &height);
-
-        VkExtent2D actualExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        VkExtent2D actualExtent = framebuffer;
         actualExtent.width      = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
         actualExtent.height     = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
 
@@ -75,27 +68,50 @@ VkExtent2D chooseSwapExtent(GLFWwindow* window, const VkSurfaceCapabilitiesKHR&
 }
 
 
+base::ConfigVar<std::string> presentModeName{"render.present_mode", "mailbox", "mailbox, fifo, fifo_relaxed or immediate, fifo when the surface can't do it"};
+
 VkPresentModeKHR chooseSwapchainPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) SRK_NOEXCEPT
 {
+    const std::string_view name = presentModeName.Get();
+
+    VkPresentModeKHR wanted = VK_PRESENT_MODE_FIFO_KHR;
+    if (name == "mailbox")
+        wanted = VK_PRESENT_MODE_MAILBOX_KHR;
+    else if (name == "fifo_relaxed")
+        wanted = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    else if (name == "immediate")
+        wanted = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    else if (name != "fifo")
+        SRK_CORE_WARN("Unknown present mode {}, using fifo", name);
+
     for (const auto& presentMode : availablePresentModes)
     {
-        if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        if (presentMode == wanted)
             return presentMode;
     }
+
+    // fifo is the only one every surface has to support
+    if (wanted != VK_PRESENT_MODE_FIFO_KHR)
+        SRK_CORE_WARN("Present mode {} is not supported by the surface, using fifo", name);
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
-VkResult createSwapchain(VkSwapchainKHR& swapChain, VkSurfaceKHR surface, SwapchainSupportDetails swapChainSupportDetails, VkDevice gpu, GLFWwindow* window, VkFormat& surfaceFormat, VkExtent2D& extent) SRK_NOEXCEPT
+VkResult createSwapchain(VkSwapchainKHR& swapChain, VkSurfaceKHR surface, const SwapchainSupportDetails& swapChainSupportDetails, VkDevice gpu, VkExtent2D extent, VkFormat& surfaceFormat) SRK_NOEXCEPT
 {
     VkSurfaceFormatKHR format      = chooseRightSurfaceFormat(swapChainSupportDetails.Formats);
     VkPresentModeKHR   presentMode = chooseSwapchainPresentMode(swapChainSupportDetails.PresentModes);
-    extent                         = chooseSwapExtent(window, swapChainSupportDetails.Capabilities);
-    uint32_t imageCount            = swapChainSupportDetails.Capabilities.minImageCount + 1;
+    uint32_t           imageCount  = swapChainSupportDetails.Capabilities.minImageCount + 1;
     surfaceFormat                  = format.format;
 
     if (swapChainSupportDetails.Capabilities.maxImageCount > 0 && imageCount > swapChainSupportDetails.Capabilities.maxImageCount)
         imageCount = swapChainSupportDetails.Capabilities.maxImageCount;
 
+    // transfer dst is what the compose blits and clears into, the surface was checked for it on creation.
+    // transfer src lets FrameCapture copy the presented images out
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (swapChainSupportDetails.Capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
     VkSwapchainCreateInfoKHR createInfo{};
     // TODO: completely populate swap chain create info struct
     {
@@ -106,7 +122,7 @@ VkResult createSwapchain(VkSwapchainKHR& swapChain, VkSurfaceKHR surface, Swapch
         createInfo.imageColorSpace       = format.colorSpace;
         createInfo.imageExtent           = extent;
         createInfo.imageArrayLayers      = 1; // specifically for 3d type of rendering will only be using 1
-        createInfo.imageUsage            = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        createInfo.imageUsage            = usage;
         createInfo.imageSharingMode      = VK_SHARING_MODE_EXCLUSIVE;
         createInfo.queueFamilyIndexCount = 0;
         createInfo.pQueueFamilyIndices   = nullptr;
@@ -117,9 +133,37 @@ VkResult createSwapchain(VkSwapchainKHR& swapChain, VkSurfaceKHR surface, Swapch
         createInfo.oldSwapchain          = swapChain; // doesn't need to check for VK_NULL_HANDLE because it probably is at the first run...
     }
 
+    // the old swapchain is retired by this but still has to be destroyed by the caller
+    swapChain = VK_NULL_HANDLE;
+
     return vkCreateSwapchainKHR(gpu, &createInfo, nullptr, &swapChain);
 }
 
+VkResult createSemaphores(VkDevice device, std::vector<VkSemaphore>& semaphores, size_t count) SRK_NOEXCEPT
+{
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    semaphores.resize(count, VK_NULL_HANDLE);
+    for (VkSemaphore& semaphore : semaphores)
+    {
+        VkResult result = vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore);
+        if (result != VK_SUCCESS)
+            return result;
+    }
+    return VK_SUCCESS;
+}
+
+void destroySemaphores(VkDevice device, std::vector<VkSemaphore>& semaphores) SRK_NOEXCEPT
+{
+    for (VkSemaphore semaphore : semaphores)
+    {
+        if (semaphore != VK_NULL_HANDLE)
+            vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    semaphores.clear();
+}
+
 VkResult acquireSwapchainImages(VkDevice device, VkSwapchainKHR swapChain, std::vector<VkImage>& images)
 {
     images.clear();
@@ -138,13 +182,28 @@ VkResult acquireSwapchainImages(VkDevice device, VkSwapchainKHR swapChain, std::
 
 Surface::Surface(VkInstance instance, VkPhysicalDevice gpu, VkDevice lGpu, GLFWwindow* window, const QueueFamilyIndices& indices) SRK_NOEXCEPT :
     m_Instance(instance),
+    m_PhysicalGpu(gpu),
     m_Gpu(lGpu),
     m_Surface(VK_NULL_HANDLE),
     m_Swapchain(VK_NULL_HANDLE),
     m_Window(window),
     m_Images(),
-    m_Views()
+    m_Views(),
+    m_Acquired(),
+    m_Rendered(),
+    m_Format(VK_FORMAT_UNDEFINED),
+    m_Extent{0, 0},
+    m_FramebufferWidth(0),
+    m_FramebufferHeight(0),
+    m_OutOfDate(false)
 {
+    int width{};
+    int height{};
+    if (window)
+        glfwGetFramebufferSize(window, &width, &height);
+    m_FramebufferWidth  = static_cast<uint32_t>(width);
+    m_FramebufferHeight = static_cast<uint32_t>(height);
+
     VkResult result = glfwCreateWindowSurface(instance, window, nullptr, &m_Surface);
     if (result != VK_SUCCESS)
     {
@@ -155,7 +214,7 @@ Surface::Surface(VkInstance instance, VkPhysicalDevice gpu, VkDevice lGpu, GLFWw
     }
     else
     {
-        m_SwapchainSupportDetails = querySwapchainSupport(gpu, m_Surface);
+        querySwapchainSupport(gpu, m_Surface, m_SwapchainSupportDetails);
 
         // TODO: assert this
         VkBool32 presentSupport{};
@@ -171,6 +230,20 @@ Surface::Surface(VkInstance instance, VkPhysicalDevice gpu, VkDevice lGpu, GLFWw
             std::exit(-1);
         }
 
+        // every frame is blitted or cleared into the swapchain image, nothing draws to it directly
+        if ((m_SwapchainSupportDetails.Capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) == 0)
+        {
+            SRK_CORE_CRITICAL("Surface images can't be transfer destinations, frames have no way onto the screen");
+            std::exit(-1);
+        }
+
+        result = createSemaphores(m_Gpu, m_Acquired, GetFramesInFlight());
+        if (result != VK_SUCCESS)
+        {
+            SRK_CORE_CRITICAL("Surface semaphores were unable to be created with err : {}!", result);
+            return;
+        }
+
         // used to recreate and create initially
         RecreateSwapchain();
     }
@@ -184,14 +257,33 @@ void Surface::Cleanup() SRK_NOEXCEPT
     }
 
     m_Views.clear();
+    destroySemaphores(m_Gpu, m_Rendered);
 }
 
 // decided to put this here because this will likely be using all the resources from the render::Surface
 void Surface::RecreateSwapchain() SRK_NOEXCEPT
 {
+    // the extent and transform move with the window
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_PhysicalGpu, m_Surface, &m_SwapchainSupportDetails.Capabilities);
+
+    const VkExtent2D extent = chooseSwapExtent({m_FramebufferWidth.load(), m_FramebufferHeight.load()}, m_SwapchainSupportDetails.Capabilities);
+    if (extent.width == 0 || extent.height == 0)
+    {
+        // minimized, the swapchain there is stays until the window has an area again
+        m_OutOfDate = true;
+        return;
+    }
+
     Cleanup();
 
-    VkResult result = createSwapchain(m_Swapchain, m_Surface, m_SwapchainSupportDetails, m_Gpu, m_Window, m_Format, m_Extent);
+    VkSwapchainKHR old    = m_Swapchain;
+    VkResult       result = createSwapchain(m_Swapchain, m_Surface, m_SwapchainSupportDetails, m_Gpu, extent, m_Format);
+    m_Extent              = extent;
+
+    // retired by the new one, nothing on the gpu uses it anymore
+    if (old != VK_NULL_HANDLE)
+        vkDestroySwapchainKHR(m_Gpu, old, nullptr);
+
     if (result != VK_SUCCESS)
     {
         SRK_CORE_CRITICAL("Swapchain was unable to be created with err : {}!", result);
@@ -240,17 +332,35 @@ void Surface::RecreateSwapchain() SRK_NOEXCEPT
                 break; // leaves this early.
             }
         }
+
+        if (m_Swapchain != VK_NULL_HANDLE)
+        {
+            result = createSemaphores(m_Gpu, m_Rendered, m_Images.size());
+            if (result != VK_SUCCESS)
+            {
+                SRK_CORE_CRITICAL("Swapchain semaphores were unable to be created with err : {}!", result);
+                Invalidate();
+            }
+        }
     }
 }
 
 Surface::Surface() :
     m_Instance(VK_NULL_HANDLE),
+    m_PhysicalGpu(VK_NULL_HANDLE),
     m_Gpu(VK_NULL_HANDLE),
     m_Surface(VK_NULL_HANDLE),
     m_Swapchain(VK_NULL_HANDLE),
     m_Window(nullptr),
     m_Images(),
-    m_Views()
+    m_Views(),
+    m_Acquired(),
+    m_Rendered(),
+    m_Format(VK_FORMAT_UNDEFINED),
+    m_Extent{0, 0},
+    m_FramebufferWidth(0),
+    m_FramebufferHeight(0),
+    m_OutOfDate(false)
 {
 }
 
@@ -262,6 +372,7 @@ Surface::~Surface() SRK_NOEXCEPT
 void Surface::Exit() SRK_NOEXCEPT
 {
     Invalidate(); // invalidate the swapchain 1st
+    destroySemaphores(m_Gpu, m_Acquired);
 
     if (m_Instance != VK_NULL_HANDLE && m_Surface != VK_NULL_HANDLE)
     {
@@ -302,6 +413,54 @@ bool Surface::IsValid() const SRK_NOEXCEPT
 }
 
 
+void Surface::Resize(uint32_t width, uint32_t height) SRK_NOEXCEPT
+{
+    m_FramebufferWidth  = width;
+    m_FramebufferHeight = height;
+    m_OutOfDate         = true;
+}
+
+bool Surface::NeedsRecreate() const SRK_NOEXCEPT
+{
+    if (m_Surface == VK_NULL_HANDLE || m_FramebufferWidth == 0 || m_FramebufferHeight == 0)
+        return false;
+    return m_OutOfDate || m_Swapchain == VK_NULL_HANDLE;
+}
+
+void Surface::Recreate() SRK_NOEXCEPT
+{
+    m_OutOfDate = false;
+    RecreateSwapchain();
+}
+
+VkResult Surface::AcquireImage(const Frame& frame, uint32_t& image) SRK_NOEXCEPT
+{
+    if (!IsValid() || m_Rendered.empty())
+        return VK_ERROR_OUT_OF_DATE_KHR;
+
+    VkResult result = vkAcquireNextImageKHR(m_Gpu, m_Swapchain, std::numeric_limits<uint64_t>::max(), m_Acquired[frame.Index], VK_NULL_HANDLE, &image);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        m_OutOfDate = true;
+    return result;
+}
+
+VkResult Surface::Present(VkQueue queue, uint32_t image) SRK_NOEXCEPT
+{
+    VkPresentInfoKHR presentInfo{};
+    presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores    = &m_Rendered[image];
+    presentInfo.swapchainCount     = 1;
+    presentInfo.pSwapchains        = &m_Swapchain;
+    presentInfo.pImageIndices      = &image;
+
+    // suboptimal still presented, the swapchain is only recreated at the start of the next frame
+    VkResult result = vkQueuePresentKHR(queue, &presentInfo);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+        m_OutOfDate = true;
+    return result;
+}
+
 GLFWwindow* Surface::GetWindow() const SRK_NOEXCEPT
 {
     return m_Window;
@@ -3,9 +3,12 @@
 #include "vulkan.h"
 
 #include <GLFW/glfw3.h>
+#include "FrameContext.h"
 #include "helper/QueueFamilyIndices.h"
 #include "vulkan_core.h"
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 namespace shrek::render {
@@ -17,6 +20,11 @@ struct SwapchainSupportDetails
     std::vector<VkPresentModeKHR>   PresentModes;
 };
 
+/*
+ *  The window's surface and swapchain. Made and destroyed on the main thread like the window, everything
+ *  in between (acquiring, presenting and recreating the swapchain) belongs to the render thread. The main
+ *  thread only tells it about resizes, the swapchain is recreated at the start of the next frame rendered.
+ */
 class Surface
 {
 public:
@@ -25,20 +33,42 @@ public:
 
     ~Surface() SRK_NOEXCEPT;
 
+    Surface(const Surface& other) = delete;
+    Surface& operator=(const Surface& other) = delete;
+
          operator bool() const SRK_NOEXCEPT;
     bool IsValid() const SRK_NOEXCEPT;
 
     void Invalidate() SRK_NOEXCEPT;
     void Exit() SRK_NOEXCEPT;
 
+    // main thread, from the framebuffer size callback
+    void Resize(uint32_t width, uint32_t height) SRK_NOEXCEPT;
+
+    // render thread. a resize or an out of date swapchain asks for Recreate, which needs the device idle.
+    // never while the window has no area, there is nothing to make a swapchain of then
+    bool NeedsRecreate() const SRK_NOEXCEPT;
+    void Recreate() SRK_NOEXCEPT;
+
+    // render thread. the frame's submit has to wait on GetAcquired(frame.Index) before writing the image and
+    // signal GetRendered(image) for Present. anything but VK_SUCCESS and VK_SUBOPTIMAL_KHR acquired nothing
+    VkResult AcquireImage(const Frame& frame, uint32_t& image) SRK_NOEXCEPT;
+    VkResult Present(VkQueue queue, uint32_t image) SRK_NOEXCEPT;
+
     GLFWwindow* GetWindow() const SRK_NOEXCEPT;
+    VkExtent2D  GetExtent() const SRK_NOEXCEPT { return m_Extent; } // what chooseSwapExtent picked, the output of dynamic resolution
+    VkFormat    GetFormat() const SRK_NOEXCEPT { return m_Format; }
+    VkImage     GetImage(uint32_t image) const SRK_NOEXCEPT { return m_Images[image]; }
+    VkSemaphore GetAcquired(uint32_t frameIndex) const SRK_NOEXCEPT { return m_Acquired[frameIndex]; }
+    VkSemaphore GetRendered(uint32_t image) const SRK_NOEXCEPT { return m_Rendered[image]; }
 
 private:
     void RecreateSwapchain() SRK_NOEXCEPT;
     void Cleanup() SRK_NOEXCEPT;
 
-    VkInstance m_Instance;
-    VkDevice   m_Gpu;
+    VkInstance       m_Instance;
+    VkPhysicalDevice m_PhysicalGpu;
+    VkDevice         m_Gpu;
 
     VkSurfaceKHR   m_Surface;
     VkSwapchainKHR m_Swapchain;
@@ -48,8 +78,15 @@ private:
 
     std::vector<VkImage>     m_Images;
     std::vector<VkImageView> m_Views;
+    std::vector<VkSemaphore> m_Acquired; // one per frame in flight, a slot's fence covers its last wait
+    std::vector<VkSemaphore> m_Rendered; // one per image, free again once the image is acquired again
     VkFormat                 m_Format;
     VkExtent2D               m_Extent;
+
+    // written by the main thread, read by the render thread
+    std::atomic<uint32_t> m_FramebufferWidth;
+    std::atomic<uint32_t> m_FramebufferHeight;
+    std::atomic<bool>     m_OutOfDate;
 };
 
 } // namespace shrek::render
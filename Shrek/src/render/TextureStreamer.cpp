@@ -0,0 +1,516 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+
+#include "base/Config.h"
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace shrek::render {
+
+namespace {
+
+base::ConfigVar<int32_t> tailSize{"render.streaming.tail_size", 64, "mips this big and smaller are loaded with the texture and never released"};
+base::ConfigVar<int32_t> poolMb{"render.streaming.pool_mb", 1024, "streamed textures stop getting finer mips once they take this much"};
+base::ConfigVar<int32_t> uploadMbPerFrame{"render.streaming.upload_mb_per_frame", 32, "staging of each frame in flight, a mip bigger than this is never streamed in"};
+base::ConfigVar<int32_t> releaseFrames{"render.streaming.release_frames", 60, "frames a mip is kept after nothing sampled it anymore"};
+
+// a 32k texture, anything bigger isn't something that gets sampled
+constexpr uint32_t maxMips = 16;
+
+// every stage that might be sampling a streamed texture
+constexpr VkPipelineStageFlags shaderStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+uint32_t mipExtent(uint32_t extent, uint32_t mip) SRK_NOEXCEPT
+{
+    return std::max(extent >> mip, 1u);
+}
+
+VkImageMemoryBarrier imageBarrier(VkImage image, uint32_t mipCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess) SRK_NOEXCEPT
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask               = srcAccess;
+    barrier.dstAccessMask               = dstAccess;
+    barrier.oldLayout                   = oldLayout;
+    barrier.newLayout                   = newLayout;
+    barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                       = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = mipCount;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+} // namespace
+
+TextureStreamer::TextureStreamer(VkPhysicalDevice gpu, VkDevice device, base::JobSystem& jobs, ResidencyManager& residency, uint32_t maxTextures) SRK_NOEXCEPT :
+    m_Gpu(gpu),
+    m_Device(device),
+    m_Jobs(jobs),
+    m_Residency(residency),
+    m_MaxTextures(maxTextures),
+    m_Valid(true),
+    m_Textures(),
+    m_Free(),
+    m_Feedback(GetFramesInFlight()),
+    m_Staging(),
+    m_Retired(),
+    m_Stats(),
+    m_Candidates(),
+    m_Aggregate(),
+    m_FeedbackCopy(maxTextures, NoFeedback),
+    m_Requested(maxTextures, NoFeedback),
+    m_RequestedFrame(maxTextures, 0)
+{
+    const VkDeviceSize stagingSize = static_cast<VkDeviceSize>(std::max(uploadMbPerFrame.Get(), 1)) * 1024 * 1024;
+
+    for (helper::BufferAllocation& feedback : m_Feedback)
+    {
+        VkResult result = helper::CreateBuffer(m_Gpu, m_Device, GetFeedbackSize(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, feedback);
+        if (result != VK_SUCCESS)
+        {
+            SRK_CORE_ERROR("Texture feedback buffer could not be created with {}", result);
+            m_Valid = false;
+            return;
+        }
+        std::memset(feedback.Mapped, 0xff, GetFeedbackSize());
+
+        m_Staging.push_back(std::make_unique<StagingBuffer>(m_Gpu, m_Device, stagingSize));
+        m_Valid = m_Valid && m_Staging.back()->IsValid();
+    }
+}
+
+TextureStreamer::~TextureStreamer() SRK_NOEXCEPT
+{
+    // the gpu is idle by now, only the jobs may still be running
+    m_Jobs.Wait(m_Aggregate);
+
+    for (std::unique_ptr<Texture>& texture : m_Textures)
+    {
+        m_Jobs.Wait(texture->Load);
+        helper::DestroyImage(m_Device, texture->Image);
+    }
+
+    for (Retired& retired : m_Retired)
+        helper::DestroyImage(m_Device, retired.Image);
+
+    for (helper::BufferAllocation& feedback : m_Feedback)
+        helper::DestroyBuffer(m_Device, feedback);
+}
+
+StreamedTextureId TextureStreamer::Register(StreamedTextureDesc desc) SRK_NOEXCEPT
+{
+    const uint32_t largest = std::max(desc.Width, desc.Height);
+    if (!m_Valid || largest == 0 || desc.MipCount == 0 || desc.MipCount > maxMips || (largest >> (desc.MipCount - 1)) == 0 || !desc.LoadMip)
+    {
+        SRK_CORE_ERROR("Texture of {}x{} with {} mips can't be streamed", desc.Width, desc.Height, desc.MipCount);
+        return InvalidStreamedTextureId;
+    }
+
+    // copies out of the staging buffer have to be aligned to the texel
+    if (desc.BytesPerPixel == 0 || desc.BytesPerPixel > 16 || (desc.BytesPerPixel & (desc.BytesPerPixel - 1)) != 0)
+    {
+        SRK_CORE_ERROR("Streamed textures need a power of two texel size, not {}", desc.BytesPerPixel);
+        return InvalidStreamedTextureId;
+    }
+
+    StreamedTextureId id;
+    if (!m_Free.empty())
+    {
+        id = m_Free.back();
+        m_Free.pop_back();
+
+        // whatever was asked for the last texture in this slot is not wanted for this one
+        m_Jobs.Wait(m_Aggregate);
+        m_Requested[id]      = NoFeedback;
+        m_RequestedFrame[id] = 0;
+    }
+    else if (m_Textures.size() < m_MaxTextures)
+    {
+        id = static_cast<StreamedTextureId>(m_Textures.size());
+        m_Textures.push_back(std::make_unique<Texture>());
+    }
+    else
+    {
+        SRK_CORE_ERROR("Every one of the {} streamed texture slots is taken", m_MaxTextures);
+        return InvalidStreamedTextureId;
+    }
+
+    Texture& texture   = *m_Textures[id];
+    texture.Desc       = std::move(desc);
+    texture.Resident   = texture.Desc.MipCount;
+    texture.Registered = true;
+
+    const uint32_t tail = static_cast<uint32_t>(std::max(tailSize.Get(), 1));
+    texture.Tail        = texture.Desc.MipCount - 1;
+    while (texture.Tail > 0 && std::max(mipExtent(texture.Desc.Width, texture.Tail - 1), mipExtent(texture.Desc.Height, texture.Tail - 1)) <= tail)
+        --texture.Tail;
+
+    const VkDeviceSize staging = m_Staging[0]->GetCapacity();
+    texture.Finest             = 0;
+    while (texture.Finest < texture.Tail && GetMipSize(texture, texture.Finest) > staging)
+        ++texture.Finest;
+
+    StartLoad(texture, texture.Tail, texture.Desc.MipCount);
+    return id;
+}
+
+void TextureStreamer::Unregister(StreamedTextureId id, uint64_t frame) SRK_NOEXCEPT
+{
+    if (id >= m_Textures.size() || !m_Textures[id]->Registered)
+        return;
+
+    Texture& texture = *m_Textures[id];
+    m_Jobs.Wait(texture.Load);
+
+    m_Stats.Resident -= texture.Image.Size;
+    Retire(texture.Image, frame);
+    m_Residency.Unregister(texture.Residency);
+
+    texture.Desc       = StreamedTextureDesc{};
+    texture.Resident   = 0;
+    texture.Limit      = 0;
+    texture.Residency  = InvalidResidencyId;
+    texture.LoadBegin  = 0;
+    texture.LoadEnd    = 0;
+    texture.Loaded     = std::vector<std::byte>();
+    texture.Registered = false;
+    m_Free.push_back(id);
+}
+
+VkDeviceSize TextureStreamer::GetMipSize(const Texture& texture, uint32_t mip) const SRK_NOEXCEPT
+{
+    return VkDeviceSize{mipExtent(texture.Desc.Width, mip)} * mipExtent(texture.Desc.Height, mip) * texture.Desc.BytesPerPixel;
+}
+
+uint32_t TextureStreamer::GetWantedMip(StreamedTextureId id) const SRK_NOEXCEPT
+{
+    const Texture& texture = *m_Textures[id];
+    if (m_Requested[id] == NoFeedback)
+        return texture.Tail;
+
+    return std::clamp(m_Requested[id], std::max(texture.Finest, texture.Limit), texture.Tail);
+}
+
+void TextureStreamer::Track(Texture& texture, const MemoryBudget& budget, uint64_t frame) SRK_NOEXCEPT
+{
+    // level n leaves it Finest + n, the last one only the tail
+    ResidencyDesc desc;
+    desc.Heap     = budget.GetHeapOfType(texture.Image.MemoryType);
+    desc.Streamed = true;
+    desc.LevelSizes.resize(texture.Tail - texture.Finest + 1, 0);
+
+    VkDeviceSize size = 0;
+    for (uint32_t mip = texture.Desc.MipCount; mip-- > texture.Finest;)
+    {
+        size += GetMipSize(texture, mip);
+        if (mip <= texture.Tail)
+            desc.LevelSizes[mip - texture.Finest] = size;
+    }
+
+    // what's over the limit is dropped by the next Update, the frames in flight keep the old image until they're done
+    desc.SetLevel = [&texture, finest = texture.Finest](uint32_t level) {
+        texture.Limit = finest + level;
+        return true;
+    };
+
+    texture.Residency = m_Residency.Register(std::move(desc), frame);
+    m_Residency.Resize(texture.Residency, texture.Image.Size);
+}
+
+void TextureStreamer::Update(const Frame& frame, const MemoryBudget& budget) SRK_NOEXCEPT
+{
+    if (!m_Valid)
+        return;
+
+    const uint64_t inFlight = GetFramesInFlight();
+    auto           expired  = [&frame, inFlight](const Retired& retired) { return retired.Frame + inFlight <= frame.Number; };
+    for (Retired& retired : m_Retired)
+    {
+        if (expired(retired))
+            helper::DestroyImage(m_Device, retired.Image);
+    }
+    m_Retired.erase(std::remove_if(m_Retired.begin(), m_Retired.end(), expired), m_Retired.end());
+
+    // BeginFrame waited for the last frame that copied out of it
+    m_Staging[frame.Index]->Reset();
+
+    // loaded mips go in as long as they still line up with what's resident
+    for (std::unique_ptr<Texture>& pointer : m_Textures)
+    {
+        Texture& texture = *pointer;
+        if (!texture.Registered || texture.LoadBegin == texture.LoadEnd || !texture.Load.Done())
+            continue;
+
+        if (texture.LoadFailed)
+        {
+            // not asked for again, the source is not going to get any better
+            SRK_CORE_WARN("Mips {} to {} of a streamed texture failed to load", texture.LoadBegin, texture.LoadEnd - 1);
+            texture.Finest = std::min(std::max(texture.Finest, texture.LoadEnd), texture.Tail);
+        }
+        else if (texture.LoadEnd == texture.Resident && texture.LoadBegin >= texture.Limit && !Rebuild(texture, texture.LoadBegin, frame))
+        {
+            // the staging buffer of this frame is full, next frame's gets it
+            continue;
+        }
+
+        if (texture.Residency == InvalidResidencyId && texture.Image.Image != VK_NULL_HANDLE)
+            Track(texture, budget, frame.Number);
+
+        texture.LoadBegin = 0;
+        texture.LoadEnd   = 0;
+        texture.Loaded    = std::vector<std::byte>();
+    }
+
+    // the feedback is still being gone through, nothing new is decided until it's done
+    if (!m_Aggregate.Done())
+        return;
+
+    m_Candidates.clear();
+    for (StreamedTextureId id{}; id < m_Textures.size(); ++id)
+    {
+        Texture& texture = *m_Textures[id];
+        if (!texture.Registered || texture.LoadBegin != texture.LoadEnd || texture.Resident == texture.Desc.MipCount)
+            continue;
+
+        // dropping mips only copies what's left into a smaller image, there's nothing to wait for
+        const uint32_t wanted = GetWantedMip(id);
+        if (wanted > texture.Resident)
+            Rebuild(texture, wanted, frame);
+        else if (wanted < texture.Resident)
+            m_Candidates.push_back(id);
+    }
+
+    // the ones furthest from what's on screen first
+    std::sort(m_Candidates.begin(), m_Candidates.end(), [this](StreamedTextureId lhs, StreamedTextureId rhs) {
+        return m_Textures[lhs]->Resident - GetWantedMip(lhs) > m_Textures[rhs]->Resident - GetWantedMip(rhs);
+    });
+
+    const VkDeviceSize pool      = static_cast<VkDeviceSize>(std::max(poolMb.Get(), 0)) * 1024 * 1024;
+    VkDeviceSize       allowance = m_Staging[frame.Index]->GetCapacity();
+    VkDeviceSize       resident  = m_Stats.Resident;
+    for (StreamedTextureId id : m_Candidates)
+    {
+        Texture&           texture = *m_Textures[id];
+        const VkDeviceSize size    = GetMipSize(texture, texture.Resident - 1);
+        if (resident + size > pool)
+            break;
+        if (size > allowance)
+            continue;
+
+        // the driver knows about everything else in the heap, the pool only about textures
+        const HeapBudget& heap = budget.GetHeap(budget.GetHeapOfType(texture.Image.MemoryType));
+        if (budget.HasUsage() && heap.Usage + size > heap.Budget)
+            break;
+
+        StartLoad(texture, texture.Resident - 1, texture.Resident);
+        allowance -= size;
+        resident += size;
+    }
+
+    ReadFeedback(frame);
+}
+
+void TextureStreamer::EndFrame(const Frame& frame) SRK_NOEXCEPT
+{
+    if (!m_Valid)
+        return;
+
+    VkMemoryBarrier barrier{};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+    vkCmdPipelineBarrier(frame.CommandBuffer, shaderStages, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void TextureStreamer::ReadFeedback(const Frame& frame) SRK_NOEXCEPT
+{
+    // what the frame that last used this slot wrote, reset for this one. when the last aggregation is still
+    // running the slot is left as is and the next frame adds its own on top
+    void* feedback = m_Feedback[frame.Index].Mapped;
+    std::memcpy(m_FeedbackCopy.data(), feedback, GetFeedbackSize());
+    std::memset(feedback, 0xff, GetFeedbackSize());
+
+    const size_t   count  = m_Textures.size();
+    const uint64_t number = frame.Number;
+
+    // the feedback is the draws' record of what they sampled, whatever wrote into a slot keeps the texture
+    // from being reduced as if it had been drawn by the frame that wrote it
+    const uint64_t inFlight = GetFramesInFlight();
+    const uint64_t sampled  = number > inFlight ? number - inFlight : 0;
+    for (StreamedTextureId id{}; id < count; ++id)
+    {
+        if (m_FeedbackCopy[id] != NoFeedback)
+            m_Residency.Touch(m_Textures[id]->Residency, sampled);
+    }
+    m_Jobs.Submit(
+        [this, count, number]() {
+            const uint64_t keep = static_cast<uint64_t>(std::max(releaseFrames.Get(), 0));
+            for (size_t id{}; id < count; ++id)
+            {
+                // finer mips are taken right away, coarser ones (NoFeedback being the coarsest) only once nothing
+                // asked for the finer one for a while so a texture doesn't flicker between two mips
+                const uint32_t mip = m_FeedbackCopy[id];
+                if (mip <= m_Requested[id] || m_RequestedFrame[id] + keep <= number)
+                {
+                    m_Requested[id]      = mip;
+                    m_RequestedFrame[id] = number;
+                }
+            }
+        },
+        &m_Aggregate);
+}
+
+void TextureStreamer::StartLoad(Texture& texture, uint32_t begin, uint32_t end) SRK_NOEXCEPT
+{
+    VkDeviceSize size = 0;
+    for (uint32_t mip = begin; mip < end; ++mip)
+        size += GetMipSize(texture, mip);
+
+    texture.LoadBegin  = begin;
+    texture.LoadEnd    = end;
+    texture.LoadFailed = false;
+    texture.Loaded.resize(static_cast<size_t>(size));
+
+    m_Jobs.Submit(
+        [this, &texture]() {
+            std::byte* data = texture.Loaded.data();
+            for (uint32_t mip = texture.LoadBegin; mip < texture.LoadEnd; ++mip)
+            {
+                const size_t size = static_cast<size_t>(GetMipSize(texture, mip));
+                if (!texture.Desc.LoadMip(mip, data, size))
+                {
+                    texture.LoadFailed = true;
+                    return;
+                }
+                data += size;
+            }
+        },
+        &texture.Load);
+}
+
+bool TextureStreamer::Rebuild(Texture& texture, uint32_t resident, const Frame& frame) SRK_NOEXCEPT
+{
+    const StreamedTextureDesc& desc     = texture.Desc;
+    const uint32_t             previous = texture.Resident;
+
+    // new mips first, there's nothing to undo if the staging buffer is full
+    StagingBuffer&    staging = *m_Staging[frame.Index];
+    StagingAllocation upload;
+    if (resident < previous)
+    {
+        upload = staging.Allocate(texture.Loaded.size(), 16);
+        if (!upload.IsValid())
+            return false;
+        std::memcpy(upload.Data, texture.Loaded.data(), texture.Loaded.size());
+    }
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.format        = desc.Format;
+    imageInfo.extent        = {mipExtent(desc.Width, resident), mipExtent(desc.Height, resident), 1};
+    imageInfo.mipLevels     = desc.MipCount - resident;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage         = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    helper::ImageAllocation image;
+    VkResult                result = helper::CreateImage(m_Gpu, m_Device, imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Streamed texture of {}x{} could not be created with {}", imageInfo.extent.width, imageInfo.extent.height, result);
+        return false;
+    }
+
+    VkCommandBuffer cmd = frame.CommandBuffer;
+
+    // the old image goes from being sampled to being copied from, on the same queue that sampled it
+    std::array<VkImageMemoryBarrier, 2> barriers{};
+    uint32_t                            barrierCount = 0;
+
+    barriers[barrierCount++] = imageBarrier(image.Image, imageInfo.mipLevels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    if (texture.Image.Image != VK_NULL_HANDLE)
+        barriers[barrierCount++] = imageBarrier(texture.Image.Image, desc.MipCount - previous, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                                VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    vkCmdPipelineBarrier(cmd, shaderStages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, barrierCount, barriers.data());
+
+    if (texture.Image.Image != VK_NULL_HANDLE)
+    {
+        std::array<VkImageCopy, maxMips> copies{};
+        uint32_t                         copyCount = 0;
+        for (uint32_t mip = std::max(resident, previous); mip < desc.MipCount; ++mip)
+        {
+            VkImageCopy& copy              = copies[copyCount++];
+            copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copy.srcSubresource.mipLevel   = mip - previous;
+            copy.srcSubresource.layerCount = 1;
+            copy.dstSubresource            = copy.srcSubresource;
+            copy.dstSubresource.mipLevel   = mip - resident;
+            copy.extent                    = {mipExtent(desc.Width, mip), mipExtent(desc.Height, mip), 1};
+        }
+        vkCmdCopyImage(cmd, texture.Image.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copyCount, copies.data());
+    }
+
+    if (upload.IsValid())
+    {
+        std::array<VkBufferImageCopy, maxMips> regions{};
+        uint32_t                               regionCount = 0;
+        VkDeviceSize                           offset      = upload.Offset;
+        for (uint32_t mip = resident; mip < previous; ++mip)
+        {
+            VkBufferImageCopy& region          = regions[regionCount++];
+            region.bufferOffset                = offset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel   = mip - resident;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent                 = {mipExtent(desc.Width, mip), mipExtent(desc.Height, mip), 1};
+
+            offset += GetMipSize(texture, mip);
+        }
+        vkCmdCopyBufferToImage(cmd, staging.GetBuffer(), image.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regionCount, regions.data());
+    }
+
+    VkImageMemoryBarrier ready = imageBarrier(image.Image, imageInfo.mipLevels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                              VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, shaderStages, 0, 0, nullptr, 0, nullptr, 1, &ready);
+
+    if (resident < previous)
+    {
+        m_Stats.StreamedIn += previous - resident;
+        m_Stats.Uploaded += upload.Size;
+    }
+    else
+    {
+        m_Stats.StreamedOut += resident - previous;
+    }
+    m_Stats.Resident = m_Stats.Resident - texture.Image.Size + image.Size;
+
+    Retire(texture.Image, frame.Number);
+    texture.Image    = image;
+    texture.Resident = resident;
+    if (texture.Residency != InvalidResidencyId)
+        m_Residency.Resize(texture.Residency, image.Size);
+    return true;
+}
+
+void TextureStreamer::Retire(helper::ImageAllocation& image, uint64_t frame) SRK_NOEXCEPT
+{
+    if (image.Image == VK_NULL_HANDLE)
+        return;
+
+    m_Retired.push_back(Retired{image, frame});
+    image = helper::ImageAllocation{};
+}
+
+} // namespace shrek::render
@@ -0,0 +1,154 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "FrameContext.h"
+#include "MemoryBudget.h"
+#include "Residency.h"
+#include "StagingBuffer.h"
+#include "base/JobSystem.h"
+#include "helper/Memory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace shrek::render {
+
+using StreamedTextureId = uint32_t;
+
+constexpr StreamedTextureId InvalidStreamedTextureId = ~0u;
+
+// what a feedback slot holds when no shader sampled the texture that frame
+constexpr uint32_t NoFeedback = ~0u;
+
+struct StreamedTextureDesc
+{
+    uint32_t Width{0}; // of mip 0
+    uint32_t Height{0};
+    uint32_t MipCount{1};
+    VkFormat Format{VK_FORMAT_R8G8B8A8_UNORM}; // uncompressed, BytesPerPixel a texel
+    uint32_t BytesPerPixel{4};
+
+    // writes the mip into dst, tightly packed rows top row first, dst being exactly its size. runs on a job
+    // thread, false when it could not in which case the texture keeps what it has
+    std::function<bool(uint32_t mip, std::byte* dst, size_t size)> LoadMip;
+};
+
+struct StreamingStats
+{
+    VkDeviceSize Resident{0};    // memory of every streamed texture right now
+    VkDeviceSize Uploaded{0};    // since startup
+    uint64_t     StreamedIn{0};  // mip levels
+    uint64_t     StreamedOut{0}; // mip levels
+};
+
+/*
+ *  Keeps each texture's mips down to what the shaders actually sampled. Every shader sampling a streamed
+ *  texture writes the finest mip it wanted into the texture's slot of the frame's feedback buffer:
+ *
+ *      layout(set = x, binding = y) buffer Feedback { uint Mips[]; } feedback;
+ *      atomicMin(feedback.Mips[id], uint(max(textureQueryLod(tex, uv).y, 0.0)) + residentMip);
+ *
+ *  with residentMip being GetResidentMip(id), as the image it samples only starts at that mip.
+ *  Once the frame is done on the gpu the slots are copied out and aggregated on a job, textures seen
+ *  wanting finer mips get them loaded (also on jobs) one at a time and uploaded through the staging
+ *  buffer, and the mips nobody asked for in a while are released. The smallest mips (the tail) always stay.
+ *  An image only ever holds its resident mips so changing them makes a new one, the mips both share get copied
+ *  over and the old image is retired until the frames in flight are done with it. Views change with that,
+ *  descriptors have to be written with GetView every frame.
+ *  Once its tail is in a texture is registered with the ResidencyManager, each of its levels takes away the
+ *  finest mip it may stream in and the textures the feedback says were sampled are touched with the frame
+ *  that sampled them, so an over budget heap takes mips off the textures that went unseen the longest.
+ *  Everything but the LoadMip callbacks runs on the render thread.
+ */
+class TextureStreamer
+{
+public:
+    TextureStreamer(VkPhysicalDevice gpu, VkDevice device, base::JobSystem& jobs, ResidencyManager& residency, uint32_t maxTextures) SRK_NOEXCEPT;
+    ~TextureStreamer() SRK_NOEXCEPT;
+
+    TextureStreamer(const TextureStreamer& other) = delete;
+    TextureStreamer& operator=(const TextureStreamer& other) = delete;
+
+    // starts loading the tail, until it's in GetView is null and whoever draws needs a fallback
+    StreamedTextureId Register(StreamedTextureDesc desc) SRK_NOEXCEPT;
+    void              Unregister(StreamedTextureId id, uint64_t frame) SRK_NOEXCEPT;
+
+    // after FrameContext::BeginFrame and ResidencyManager::Update, reads the feedback the frame that used this
+    // slot left and records uploads and copies into the frame's command buffer, which has to run before
+    // anything samples
+    void Update(const Frame& frame, const MemoryBudget& budget) SRK_NOEXCEPT;
+    // right before the frame is submitted, makes the feedback written by shaders visible to the cpu
+    void EndFrame(const Frame& frame) SRK_NOEXCEPT;
+
+    bool         IsValid() const SRK_NOEXCEPT { return m_Valid; }
+    VkBuffer     GetFeedbackBuffer(uint32_t frameIndex) const SRK_NOEXCEPT { return m_Feedback[frameIndex].Buffer; }
+    VkDeviceSize GetFeedbackSize() const SRK_NOEXCEPT { return VkDeviceSize{m_MaxTextures} * sizeof(uint32_t); }
+
+    VkImageView    GetView(StreamedTextureId id) const SRK_NOEXCEPT { return m_Textures[id]->Image.View; }
+    uint32_t       GetResidentMip(StreamedTextureId id) const SRK_NOEXCEPT { return m_Textures[id]->Resident; }
+    StreamingStats GetStats() const SRK_NOEXCEPT { return m_Stats; }
+
+private:
+    struct Texture
+    {
+        StreamedTextureDesc     Desc;
+        helper::ImageAllocation Image;
+        uint32_t                Resident{0}; // finest mip the image holds, MipCount while it holds nothing
+        uint32_t                Tail{0};     // coarsest mip it's ever reduced to
+        uint32_t                Finest{0};   // finest mip that fits the staging buffer
+        uint32_t                Limit{0};    // finest mip the residency manager leaves it
+        ResidencyId             Residency{InvalidResidencyId};
+
+        // mips [LoadBegin, LoadEnd) being loaded into Loaded, packed one after another
+        base::JobCounter       Load;
+        uint32_t               LoadBegin{0};
+        uint32_t               LoadEnd{0};
+        bool                   LoadFailed{false};
+        std::vector<std::byte> Loaded;
+
+        bool Registered{false};
+    };
+
+    struct Retired
+    {
+        helper::ImageAllocation Image;
+        uint64_t                Frame{0};
+    };
+
+    VkDeviceSize GetMipSize(const Texture& texture, uint32_t mip) const SRK_NOEXCEPT;
+    uint32_t     GetWantedMip(StreamedTextureId id) const SRK_NOEXCEPT;
+
+    // registers the texture with the residency manager once its tail is in
+    void Track(Texture& texture, const MemoryBudget& budget, uint64_t frame) SRK_NOEXCEPT;
+    void ReadFeedback(const Frame& frame) SRK_NOEXCEPT;
+    void StartLoad(Texture& texture, uint32_t begin, uint32_t end) SRK_NOEXCEPT;
+    // remakes the image to hold [resident, MipCount), the mips finer than it had come from Loaded
+    bool Rebuild(Texture& texture, uint32_t resident, const Frame& frame) SRK_NOEXCEPT;
+    void Retire(helper::ImageAllocation& image, uint64_t frame) SRK_NOEXCEPT;
+
+private:
+    VkPhysicalDevice                            m_Gpu;
+    VkDevice                                    m_Device;
+    base::JobSystem&                            m_Jobs;
+    ResidencyManager&                           m_Residency;
+    uint32_t                                    m_MaxTextures;
+    bool                                        m_Valid;
+    std::vector<std::unique_ptr<Texture>>       m_Textures; // boxed since the counters can't be moved
+    std::vector<StreamedTextureId>              m_Free;
+    std::vector<helper::BufferAllocation>       m_Feedback; // one per frame in flight, host visible
+    std::vector<std::unique_ptr<StagingBuffer>> m_Staging;  // one per frame in flight
+    std::vector<Retired>                        m_Retired;
+    StreamingStats                              m_Stats;
+    std::vector<StreamedTextureId>              m_Candidates; // scratch for Update
+
+    // owned by the aggregation job while it runs, everything else only touches them once it's done
+    base::JobCounter      m_Aggregate;
+    std::vector<uint32_t> m_FeedbackCopy;
+    std::vector<uint32_t> m_Requested;      // finest mip asked for lately per slot, NoFeedback when nobody did
+    std::vector<uint64_t> m_RequestedFrame; // when that was last asked for
+};
+
+} // namespace shrek::render
@@ -0,0 +1,67 @@
+#include "pch.h"
+#include "UniformRing.h"
+
+#include "helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+
+namespace shrek::render {
+
+UniformRing::UniformRing(VkPhysicalDevice gpu, VkDevice device, VkDeviceSize bytesPerFrame) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Buffer(),
+    m_Alignment(0),
+    m_RegionSize(0),
+    m_RegionBegin(0),
+    m_Used(0)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(gpu, &properties);
+
+    // storage buffers may be bound out of it as well so both alignments have to hold
+    m_Alignment  = std::max(properties.limits.minUniformBufferOffsetAlignment, properties.limits.minStorageBufferOffsetAlignment);
+    m_RegionSize = helper::AlignUp(bytesPerFrame, m_Alignment);
+
+    constexpr VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+    // device local and host visible (resizable bar) saves the gpu a trip over pcie on every read, not every gpu has it
+    VkResult result = helper::CreateBuffer(gpu, device, m_RegionSize * GetFramesInFlight(), usage,
+                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Buffer);
+    if (result != VK_SUCCESS)
+    {
+        result = helper::CreateBuffer(gpu, device, m_RegionSize * GetFramesInFlight(), usage,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Buffer);
+    }
+
+    if (result != VK_SUCCESS)
+        SRK_CORE_ERROR("Uniform ring of {} bytes per frame could not be created with {}", bytesPerFrame, result);
+}
+
+UniformRing::~UniformRing() SRK_NOEXCEPT
+{
+    helper::DestroyBuffer(m_Device, m_Buffer);
+}
+
+void UniformRing::BeginFrame(uint32_t frameIndex) SRK_NOEXCEPT
+{
+    m_RegionBegin = m_RegionSize * frameIndex;
+    m_Used.store(0, std::memory_order_relaxed);
+}
+
+UniformAllocation UniformRing::Allocate(VkDeviceSize size) SRK_NOEXCEPT
+{
+    if (!IsValid())
+        return {};
+
+    // every allocation starts aligned, so rounding the size keeps the next one aligned without a cas loop
+    const VkDeviceSize aligned = helper::AlignUp(size, m_Alignment);
+    const VkDeviceSize offset  = m_Used.fetch_add(aligned, std::memory_order_relaxed);
+    if (offset + aligned > m_RegionSize)
+        return {};
+
+    const VkDeviceSize absolute = m_RegionBegin + offset;
+    return UniformAllocation{static_cast<std::byte*>(m_Buffer.Mapped) + absolute, static_cast<uint32_t>(absolute), size};
+}
+
+} // namespace shrek::render
@@ -0,0 +1,67 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "FrameContext.h"
+#include "helper/Memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+namespace shrek::render {
+
+struct UniformAllocation
+{
+    std::byte*   Data{nullptr}; // points into the mapped buffer, write straight into it
+    uint32_t     Offset{0};     // from the start of GetBuffer(), what the descriptor's buffer info starts at
+    VkDeviceSize Size{0};
+
+    bool IsValid() const SRK_NOEXCEPT { return Data != nullptr; }
+};
+
+/*
+ *  Per draw constants for the frames in flight, a persistently mapped buffer split into one region per frame.
+ *  Allocating is a lock free bump inside the current frame's region, addressed by writing GetBuffer() with the
+ *  allocation's offset and size into the descriptor of a frame's set. A region is reset as a whole by BeginFrame, which is
+ *  only safe once the fence of the frame that last used it has signaled, FrameContext::BeginFrame waits for that.
+ */
+class UniformRing
+{
+public:
+    UniformRing(VkPhysicalDevice gpu, VkDevice device, VkDeviceSize bytesPerFrame) SRK_NOEXCEPT;
+    ~UniformRing() SRK_NOEXCEPT;
+
+    UniformRing(const UniformRing& other) = delete;
+    UniformRing& operator=(const UniformRing& other) = delete;
+
+    void BeginFrame(uint32_t frameIndex) SRK_NOEXCEPT;
+
+    // invalid when this frame's region is full
+    UniformAllocation Allocate(VkDeviceSize size) SRK_NOEXCEPT;
+
+    template<typename T>
+    UniformAllocation Push(const T& value) SRK_NOEXCEPT
+    {
+        UniformAllocation allocation = Allocate(sizeof(T));
+        if (allocation.IsValid())
+            std::memcpy(allocation.Data, &value, sizeof(T));
+        return allocation;
+    }
+
+    bool         IsValid() const SRK_NOEXCEPT { return m_Buffer.Mapped != nullptr; }
+    VkBuffer     GetBuffer() const SRK_NOEXCEPT { return m_Buffer.Buffer; }
+    VkDeviceSize GetRegionSize() const SRK_NOEXCEPT { return m_RegionSize; }
+    VkDeviceSize GetAlignment() const SRK_NOEXCEPT { return m_Alignment; }
+    VkDeviceSize GetUsed() const SRK_NOEXCEPT { return std::min(m_Used.load(std::memory_order_relaxed), m_RegionSize); }
+
+private:
+    VkDevice                  m_Device;
+    helper::BufferAllocation  m_Buffer;
+    VkDeviceSize              m_Alignment;
+    VkDeviceSize              m_RegionSize;
+    VkDeviceSize              m_RegionBegin;
+    std::atomic<VkDeviceSize> m_Used; // inside the current region
+};
+
+} // namespace shrek::render
@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "Memory.h"
+
+#include "Debug.h"
+#include "platform/Log.h"
+
+namespace shrek::render::helper {
+
+std::optional<uint32_t> FindMemoryType(VkPhysicalDevice gpu, uint32_t typeBits, VkMemoryPropertyFlags properties) SRK_NOEXCEPT
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(gpu, &memoryProperties);
+
+    for (uint32_t idx{}; idx < memoryProperties.memoryTypeCount; ++idx)
+    {
+        if ((typeBits & (1u << idx)) && (memoryProperties.memoryTypes[idx].propertyFlags & properties) == properties)
+            return idx;
+    }
+
+    return std::nullopt;
+}
+
+VkImageAspectFlags GetImageAspect(VkFormat format) SRK_NOEXCEPT
+{
+    switch (format)
+    {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_S8_UINT:
+            return VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+VkResult CreateBuffer(VkPhysicalDevice gpu, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, BufferAllocation& buffer) SRK_NOEXCEPT
+{
+    VkBufferCreateInfo createInfo{};
+    createInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    createInfo.size        = size;
+    createInfo.usage       = usage;
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkResult result = vkCreateBuffer(device, &createInfo, nullptr, &buffer.Buffer);
+    if (result != VK_SUCCESS)
+        return result;
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, buffer.Buffer, &requirements);
+
+    std::optional<uint32_t> memoryType = FindMemoryType(gpu, requirements.memoryTypeBits, properties);
+    if (!memoryType.has_value())
+    {
+        SRK_CORE_ERROR("No memory type supports the buffer with properties {:#x}", properties);
+        DestroyBuffer(device, buffer);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = requirements.size;
+    allocateInfo.memoryTypeIndex = memoryType.value();
+
+    result = vkAllocateMemory(device, &allocateInfo, nullptr, &buffer.Memory);
+    if (result != VK_SUCCESS)
+    {
+        DestroyBuffer(device, buffer);
+        return result;
+    }
+
+    vkBindBufferMemory(device, buffer.Buffer, buffer.Memory, 0);
+    buffer.Size       = size;
+    buffer.MemoryType = memoryType.value();
+
+    if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        result = vkMapMemory(device, buffer.Memory, 0, VK_WHOLE_SIZE, 0, &buffer.Mapped);
+        if (result != VK_SUCCESS)
+        {
+            DestroyBuffer(device, buffer);
+            return result;
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+void DestroyBuffer(VkDevice device, BufferAllocation& buffer) SRK_NOEXCEPT
+{
+    // freeing the memory unmaps it as well
+    if (buffer.Buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(device, buffer.Buffer, nullptr);
+    if (buffer.Memory != VK_NULL_HANDLE)
+        vkFreeMemory(device, buffer.Memory, nullptr);
+
+    buffer = BufferAllocation{};
+}
+
+VkResult CreateImage(VkPhysicalDevice gpu, VkDevice device, const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags properties, ImageAllocation& image) SRK_NOEXCEPT
+{
+    VkResult result = vkCreateImage(device, &createInfo, nullptr, &image.Image);
+    if (result != VK_SUCCESS)
+        return result;
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, image.Image, &requirements);
+
+    std::optional<uint32_t> memoryType = FindMemoryType(gpu, requirements.memoryTypeBits, properties);
+    if (!memoryType.has_value())
+    {
+        SRK_CORE_ERROR("No memory type supports the image with properties {:#x}", properties);
+        DestroyImage(device, image);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = requirements.size;
+    allocateInfo.memoryTypeIndex = memoryType.value();
+
+    result = vkAllocateMemory(device, &allocateInfo, nullptr, &image.Memory);
+    if (result != VK_SUCCESS)
+    {
+        DestroyImage(device, image);
+        return result;
+    }
+
+    vkBindImageMemory(device, image.Image, image.Memory, 0);
+    image.Size       = requirements.size;
+    image.MemoryType = memoryType.value();
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                       = image.Image;
+    viewInfo.viewType                    = createInfo.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                      = createInfo.format;
+    viewInfo.subresourceRange.aspectMask = GetImageAspect(createInfo.format);
+    viewInfo.subresourceRange.levelCount = createInfo.mipLevels;
+    viewInfo.subresourceRange.layerCount = createInfo.arrayLayers;
+
+    result = vkCreateImageView(device, &viewInfo, nullptr, &image.View);
+    if (result != VK_SUCCESS)
+        DestroyImage(device, image);
+
+    return result;
+}
+
+void DestroyImage(VkDevice device, ImageAllocation& image) SRK_NOEXCEPT
+{
+    if (image.View != VK_NULL_HANDLE)
+        vkDestroyImageView(device, image.View, nullptr);
+    if (image.Image != VK_NULL_HANDLE)
+        vkDestroyImage(device, image.Image, nullptr);
+    if (image.Memory != VK_NULL_HANDLE)
+        vkFreeMemory(device, image.Memory, nullptr);
+
+    image = ImageAllocation{};
+}
+
+} // namespace shrek::render::helper
@@ -0,0 +1,46 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+
+#include <cstdint>
+#include <optional>
+
+namespace shrek::render::helper {
+
+struct BufferAllocation
+{
+    VkBuffer       Buffer{VK_NULL_HANDLE};
+    VkDeviceMemory Memory{VK_NULL_HANDLE};
+    VkDeviceSize   Size{0};
+    void*          Mapped{nullptr}; // only set for host visible memory, stays mapped until destroyed
+    uint32_t       MemoryType{0};
+};
+
+struct ImageAllocation
+{
+    VkImage        Image{VK_NULL_HANDLE};
+    VkDeviceMemory Memory{VK_NULL_HANDLE};
+    VkImageView    View{VK_NULL_HANDLE}; // of every mip and layer
+    VkDeviceSize   Size{0};              // of the memory, padding included
+    uint32_t       MemoryType{0};
+};
+
+std::optional<uint32_t> FindMemoryType(VkPhysicalDevice gpu, uint32_t typeBits, VkMemoryPropertyFlags properties) SRK_NOEXCEPT;
+
+// one dedicated allocation per buffer, host visible buffers get mapped persistently
+VkResult CreateBuffer(VkPhysicalDevice gpu, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, BufferAllocation& buffer) SRK_NOEXCEPT;
+void     DestroyBuffer(VkDevice device, BufferAllocation& buffer) SRK_NOEXCEPT;
+
+// depth for depth formats, with stencil it's only the depth a view can sample. color for everything else
+VkImageAspectFlags GetImageAspect(VkFormat format) SRK_NOEXCEPT;
+
+// one dedicated allocation per image as well, the view is 2d (or 2d array with more than one layer)
+VkResult CreateImage(VkPhysicalDevice gpu, VkDevice device, const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags properties, ImageAllocation& image) SRK_NOEXCEPT;
+void     DestroyImage(VkDevice device, ImageAllocation& image) SRK_NOEXCEPT;
+
+constexpr VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) SRK_NOEXCEPT
+{
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+} // namespace shrek::render::helper
@@ -8,7 +8,7 @@ namespace shrek::render::helper {
 struct QueueFamilyIndices
 {
     uint32_t                Graphics;
-    std::optional<uint32_t> Compute;
+    std::optional<uint32_t> Compute; // a family with compute and no graphics, for work that overlaps the graphics queue
 };
 
 } // namespace shrek::render::helper
@@ -0,0 +1,206 @@
+#include "pch.h"
+#include "LayoutCache.h"
+
+#include "base/Hash.h"
+#include "render/helper/Debug.h"
+#include "platform/Log.h"
+
+#include <algorithm>
+
+namespace shrek::render::pipeline {
+
+namespace {
+
+// the Set member is left out so the same bindings in different sets share a layout
+uint64_t hashBindings(const DescriptorBinding* bindings, uint32_t count) SRK_NOEXCEPT
+{
+    uint64_t hash = base::HashValue(count);
+    for (uint32_t idx{}; idx < count; ++idx)
+    {
+        hash = base::HashValue(bindings[idx].Binding, hash);
+        hash = base::HashValue(bindings[idx].Type, hash);
+        hash = base::HashValue(bindings[idx].Count, hash);
+        hash = base::HashValue(bindings[idx].Stages, hash);
+    }
+    return hash;
+}
+
+bool sameBindings(const std::vector<DescriptorBinding>& lhs, const DescriptorBinding* rhs, uint32_t count) SRK_NOEXCEPT
+{
+    return lhs.size() == count && std::equal(lhs.begin(), lhs.end(), rhs, [](const DescriptorBinding& a, const DescriptorBinding& b) {
+               return a.Binding == b.Binding && a.Type == b.Type && a.Count == b.Count && a.Stages == b.Stages;
+           });
+}
+
+bool samePipelineLayout(const PipelineLayout& lhs, const PipelineLayout& rhs) SRK_NOEXCEPT
+{
+    return lhs.SetCount == rhs.SetCount && std::equal(lhs.SetLayouts.begin(), lhs.SetLayouts.begin() + lhs.SetCount, rhs.SetLayouts.begin()) &&
+           lhs.PushConstants.stageFlags == rhs.PushConstants.stageFlags && lhs.PushConstants.offset == rhs.PushConstants.offset &&
+           lhs.PushConstants.size == rhs.PushConstants.size;
+}
+
+} // namespace
+
+LayoutCache::LayoutCache(VkDevice device) SRK_NOEXCEPT : m_Device(device) {}
+
+LayoutCache::~LayoutCache() SRK_NOEXCEPT
+{
+    for (auto& [hash, layout] : m_PipelineLayouts)
+        vkDestroyPipelineLayout(m_Device, layout->Layout, nullptr);
+
+    for (auto& [hash, layout] : m_SetLayouts)
+        vkDestroyDescriptorSetLayout(m_Device, layout.Layout, nullptr);
+}
+
+VkDescriptorSetLayout LayoutCache::GetSetLayout(const DescriptorBinding* bindings, uint32_t count) SRK_NOEXCEPT
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return FindOrCreateSetLayout(bindings, count);
+}
+
+VkDescriptorSetLayout LayoutCache::FindOrCreateSetLayout(const DescriptorBinding* bindings, uint32_t count) SRK_NOEXCEPT
+{
+    const uint64_t hash = hashBindings(bindings, count);
+    auto [first, last]  = m_SetLayouts.equal_range(hash);
+    for (auto it = first; it != last; ++it)
+    {
+        if (sameBindings(it->second.Bindings, bindings, count))
+            return it->second.Layout;
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings(count);
+    for (uint32_t idx{}; idx < count; ++idx)
+    {
+        layoutBindings[idx].binding         = bindings[idx].Binding;
+        layoutBindings[idx].descriptorType  = bindings[idx].Type;
+        layoutBindings[idx].descriptorCount = bindings[idx].Count;
+        layoutBindings[idx].stageFlags      = bindings[idx].Stages;
+    }
+
+    VkDescriptorSetLayoutCreateInfo createInfo{};
+    createInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.bindingCount = count;
+    createInfo.pBindings    = layoutBindings.data();
+
+    VkDescriptorSetLayout layout{VK_NULL_HANDLE};
+    VkResult              result = vkCreateDescriptorSetLayout(m_Device, &createInfo, nullptr, &layout);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Descriptor set layout could not be created with {}", result);
+        return VK_NULL_HANDLE;
+    }
+
+    m_SetLayouts.emplace(hash, SetLayout{std::vector<DescriptorBinding>(bindings, bindings + count), layout});
+    return layout;
+}
+
+const PipelineLayout* LayoutCache::GetPipelineLayout(const ShaderRef* shaders, uint32_t count) SRK_NOEXCEPT
+{
+    std::vector<DescriptorBinding> bindings;
+    PipelineLayout                 pipelineLayout;
+    uint32_t                       pushConstantEnd{0};
+
+    for (uint32_t idx{}; idx < count; ++idx)
+    {
+        const ShaderReflection& reflection = shaders[idx]->GetReflection();
+        bindings.insert(bindings.end(), reflection.Bindings.begin(), reflection.Bindings.end());
+
+        if (reflection.PushConstantSize == 0)
+            continue;
+
+        // one range for every stage keeps vkCmdPushConstants calls simple
+        VkPushConstantRange& range = pipelineLayout.PushConstants;
+        range.offset               = range.stageFlags != 0 ? std::min(range.offset, reflection.PushConstantOffset) : reflection.PushConstantOffset;
+        range.stageFlags          |= shaders[idx]->GetStage();
+        pushConstantEnd            = std::max(pushConstantEnd, reflection.PushConstantOffset + reflection.PushConstantSize);
+    }
+    pipelineLayout.PushConstants.size = pushConstantEnd - pipelineLayout.PushConstants.offset;
+
+    std::sort(bindings.begin(), bindings.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+        return a.Set != b.Set ? a.Set < b.Set : a.Binding < b.Binding;
+    });
+
+    // the same binding seen from several stages becomes one binding visible to all of them
+    size_t merged{0};
+    for (size_t idx{}; idx < bindings.size(); ++idx)
+    {
+        if (merged != 0 && bindings[merged - 1].Set == bindings[idx].Set && bindings[merged - 1].Binding == bindings[idx].Binding)
+        {
+            DescriptorBinding& previous = bindings[merged - 1];
+            if (previous.Type != bindings[idx].Type || previous.Count != bindings[idx].Count)
+            {
+                SRK_CORE_ERROR("Stages disagree on set {} binding {}", previous.Set, previous.Binding);
+                return nullptr;
+            }
+
+            previous.Stages |= bindings[idx].Stages;
+            continue;
+        }
+
+        bindings[merged++] = bindings[idx];
+    }
+    bindings.resize(merged);
+
+    if (!bindings.empty() && bindings.back().Set >= MaxDescriptorSets)
+    {
+        SRK_CORE_ERROR("Descriptor set {} is past the {} sets the engine supports", bindings.back().Set, MaxDescriptorSets);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    pipelineLayout.SetCount = bindings.empty() ? 0 : bindings.back().Set + 1;
+    auto first              = bindings.begin();
+    for (uint32_t set{}; set < pipelineLayout.SetCount; ++set)
+    {
+        // sets skipped by the shaders still need a layout, an empty one
+        auto last = std::find_if(first, bindings.end(), [set](const DescriptorBinding& binding) { return binding.Set != set; });
+
+        pipelineLayout.SetLayouts[set] = FindOrCreateSetLayout(bindings.data() + (first - bindings.begin()), static_cast<uint32_t>(last - first));
+        if (pipelineLayout.SetLayouts[set] == VK_NULL_HANDLE)
+            return nullptr;
+
+        first = last;
+    }
+
+    pipelineLayout.Hash = base::HashBytes(pipelineLayout.SetLayouts.data(), pipelineLayout.SetCount * sizeof(VkDescriptorSetLayout));
+    pipelineLayout.Hash = base::HashValue(pipelineLayout.PushConstants, pipelineLayout.Hash);
+
+    auto [begin, end] = m_PipelineLayouts.equal_range(pipelineLayout.Hash);
+    for (auto it = begin; it != end; ++it)
+    {
+        if (samePipelineLayout(*it->second, pipelineLayout))
+            return it->second.get();
+    }
+
+    VkPipelineLayoutCreateInfo createInfo{};
+    createInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    createInfo.setLayoutCount         = pipelineLayout.SetCount;
+    createInfo.pSetLayouts            = pipelineLayout.SetLayouts.data();
+    createInfo.pushConstantRangeCount = pipelineLayout.PushConstants.size != 0 ? 1 : 0;
+    createInfo.pPushConstantRanges    = &pipelineLayout.PushConstants;
+
+    VkResult result = vkCreatePipelineLayout(m_Device, &createInfo, nullptr, &pipelineLayout.Layout);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Pipeline layout could not be created with {}", result);
+        return nullptr;
+    }
+
+    auto it = m_PipelineLayouts.emplace(pipelineLayout.Hash, std::make_unique<PipelineLayout>(pipelineLayout));
+    return it->second.get();
+}
+
+size_t LayoutCache::GetSetLayoutCount() const SRK_NOEXCEPT
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_SetLayouts.size();
+}
+
+size_t LayoutCache::GetPipelineLayoutCount() const SRK_NOEXCEPT
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_PipelineLayouts.size();
+}
+
+} // namespace shrek::render::pipeline
@@ -0,0 +1,66 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "Shader.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace shrek::render::pipeline {
+
+constexpr uint32_t MaxDescriptorSets = 4;
+
+struct PipelineLayout
+{
+    VkPipelineLayout                                     Layout{VK_NULL_HANDLE};
+    std::array<VkDescriptorSetLayout, MaxDescriptorSets> SetLayouts{};
+    uint32_t                                             SetCount{0};
+    VkPushConstantRange                                  PushConstants{}; // size 0 without push constants
+    uint64_t                                             Hash{0};
+};
+
+/*
+ *  Builds descriptor set and pipeline layouts from shader reflection and hands out the same
+ *  handle for equal layouts, so pipelines built from different shaders can share descriptor sets.
+ *  Everything lives as long as the cache, which makes the pointers and handles safe to keep around.
+ *  Thread safe so pipelines can be built on the job system.
+ */
+class LayoutCache
+{
+public:
+    explicit LayoutCache(VkDevice device) SRK_NOEXCEPT;
+    ~LayoutCache() SRK_NOEXCEPT;
+
+    LayoutCache(const LayoutCache& other) = delete;
+    LayoutCache& operator=(const LayoutCache& other) = delete;
+
+    // bindings of a single set, the Set member is ignored
+    VkDescriptorSetLayout GetSetLayout(const DescriptorBinding* bindings, uint32_t count) SRK_NOEXCEPT;
+
+    // merges what every stage binds, null when the stages disagree about a binding
+    const PipelineLayout* GetPipelineLayout(const ShaderRef* shaders, uint32_t count) SRK_NOEXCEPT;
+
+    size_t GetSetLayoutCount() const SRK_NOEXCEPT;
+    size_t GetPipelineLayoutCount() const SRK_NOEXCEPT;
+
+private:
+    struct SetLayout
+    {
+        std::vector<DescriptorBinding> Bindings;
+        VkDescriptorSetLayout          Layout;
+    };
+
+    VkDescriptorSetLayout FindOrCreateSetLayout(const DescriptorBinding* bindings, uint32_t count) SRK_NOEXCEPT;
+
+private:
+    VkDevice m_Device;
+
+    mutable std::mutex                                                   m_Mutex;
+    std::unordered_multimap<uint64_t, SetLayout>                         m_SetLayouts;
+    std::unordered_multimap<uint64_t, std::unique_ptr<PipelineLayout>> m_PipelineLayouts;
+};
+
+} // namespace shrek::render::pipeline
@@ -0,0 +1,463 @@
+#include "pch.h"
+#include "PipelineCache.h"
+
+#include "base/Hash.h"
+#include "render/helper/Debug.h"
+#include "platform/Log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+namespace shrek::render::pipeline {
+
+namespace {
+
+bool sameDesc(const PipelineDesc& lhs, const PipelineDesc& rhs) SRK_NOEXCEPT
+{
+    if (lhs.ShaderCount != rhs.ShaderCount)
+        return false;
+
+    for (uint32_t idx{}; idx < lhs.ShaderCount; ++idx)
+    {
+        if (lhs.Shaders[idx]->GetStage() != rhs.Shaders[idx]->GetStage() || lhs.Shaders[idx]->GetHash() != rhs.Shaders[idx]->GetHash())
+            return false;
+    }
+
+    return std::memcmp(&lhs.Vertex, &rhs.Vertex, sizeof(VertexLayout)) == 0 &&
+           std::memcmp(&lhs.Targets, &rhs.Targets, sizeof(RenderTargetLayout)) == 0 &&
+           std::memcmp(&lhs.State, &rhs.State, sizeof(FixedFunctionState)) == 0;
+}
+
+} // namespace
+
+std::string_view ToString(PipelineStatus status) SRK_NOEXCEPT
+{
+#define TO_STRING(X)        \
+    case PipelineStatus::X: \
+        return #X
+    switch (status)
+    {
+        TO_STRING(Pending);
+        TO_STRING(Ready);
+        TO_STRING(Failed);
+        default:
+            return "UNKNOWN";
+    }
+#undef TO_STRING
+}
+
+uint64_t HashPipelineDesc(const PipelineDesc& desc) SRK_NOEXCEPT
+{
+    // the spirv hash rather than the module handle so a reload that changes nothing still hits
+    uint64_t hash = base::HashValue(desc.ShaderCount);
+    for (uint32_t idx{}; idx < desc.ShaderCount; ++idx)
+    {
+        hash = base::HashCombine(hash, desc.Shaders[idx]->GetHash());
+        hash = base::HashValue(desc.Shaders[idx]->GetStage(), hash);
+    }
+
+    hash = base::HashValue(desc.Vertex, hash);
+    hash = base::HashValue(desc.Targets, hash);
+    hash = base::HashValue(desc.State, hash);
+    return hash;
+}
+
+MappedFile PipelineCache::ReadCacheFile(const std::string& cachePath) SRK_NOEXCEPT
+{
+    std::error_code error;
+    if (cachePath.empty() || !std::filesystem::exists(cachePath, error))
+        return MappedFile();
+    return MappedFile(cachePath);
+}
+
+PipelineCache::PipelineCache(VkDevice device, base::JobSystem& jobs, LayoutCache& layouts, std::string cachePath, const MappedFile& saved) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Jobs(jobs),
+    m_Layouts(layouts),
+    m_DriverCache(VK_NULL_HANDLE),
+    m_CachePath(std::move(cachePath)),
+    m_Retired(),
+    m_Frame(0)
+{
+    // lets the driver skip work for pipelines that share stages, it's internally synchronized. the driver checks the
+    // header of what the last run saved itself and ignores data from another gpu or driver
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = saved.Size();
+    createInfo.pInitialData    = saved.Data();
+
+    VkResult result = vkCreatePipelineCache(m_Device, &createInfo, nullptr, &m_DriverCache);
+    if (result != VK_SUCCESS && saved.IsValid())
+    {
+        SRK_CORE_WARN("Pipeline cache {} was rejected with {}, starting empty", m_CachePath, result);
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData    = nullptr;
+        result                     = vkCreatePipelineCache(m_Device, &createInfo, nullptr, &m_DriverCache);
+    }
+    else if (saved.IsValid())
+    {
+        SRK_CORE_TRACE("Pipeline cache loaded {} bytes from {}", saved.Size(), m_CachePath);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_WARN("Pipeline cache could not be created with {}, pipelines compile without it", result);
+        m_DriverCache = VK_NULL_HANDLE;
+    }
+}
+
+PipelineCache::~PipelineCache() SRK_NOEXCEPT
+{
+    m_Jobs.Wait(m_InFlight);
+
+    for (auto& [hash, entry] : m_Entries)
+    {
+        if (entry->Result.Handle != VK_NULL_HANDLE)
+            vkDestroyPipeline(m_Device, entry->Result.Handle, nullptr);
+    }
+
+    // FrameContext waited for the gpu, whatever was retired can go right away
+    for (Retired& retired : m_Retired)
+    {
+        if (retired.Item->Result.Handle != VK_NULL_HANDLE)
+            vkDestroyPipeline(m_Device, retired.Item->Result.Handle, nullptr);
+    }
+
+    if (m_DriverCache != VK_NULL_HANDLE)
+    {
+        SaveDriverCache();
+        vkDestroyPipelineCache(m_Device, m_DriverCache, nullptr);
+    }
+}
+
+void PipelineCache::SaveDriverCache() const SRK_NOEXCEPT
+{
+    if (m_CachePath.empty())
+        return;
+
+    size_t size{0};
+    if (vkGetPipelineCacheData(m_Device, m_DriverCache, &size, nullptr) != VK_SUCCESS || size == 0)
+        return;
+
+    std::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(m_Device, m_DriverCache, &size, data.data()) != VK_SUCCESS)
+        return;
+
+    std::error_code       error;
+    std::filesystem::path path(m_CachePath);
+    if (path.has_parent_path())
+        std::filesystem::create_directories(path.parent_path(), error);
+
+    // written next to it and renamed over it so a crash halfway never leaves a torn cache behind
+    const std::string temporary = m_CachePath + ".tmp";
+    std::FILE*        file      = std::fopen(temporary.c_str(), "wb");
+    if (!file)
+    {
+        SRK_CORE_WARN("Pipeline cache could not be written to {}", temporary);
+        return;
+    }
+
+    const bool written = std::fwrite(data.data(), 1, size, file) == size;
+    std::fclose(file);
+
+    std::filesystem::rename(temporary, path, error);
+    if (!written || error)
+        SRK_CORE_WARN("Pipeline cache could not be saved to {}", m_CachePath);
+    else
+        SRK_CORE_TRACE("Pipeline cache saved {} bytes to {}", size, m_CachePath);
+}
+
+std::pair<PipelineCache::Entry*, bool> PipelineCache::FindOrInsert(const PipelineDesc& desc) SRK_NOEXCEPT
+{
+    const uint64_t hash = HashPipelineDesc(desc);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto [first, last] = m_Entries.equal_range(hash);
+    for (auto it = first; it != last; ++it)
+    {
+        if (sameDesc(it->second->Desc, desc))
+            return {it->second.get(), false};
+    }
+
+    auto it = m_Entries.emplace(hash, std::make_unique<Entry>());
+
+    it->second->Desc        = desc;
+    it->second->Result.Hash = hash;
+    it->second->Building.Pending.store(1, std::memory_order_relaxed);
+    return {it->second.get(), true};
+}
+
+const Pipeline* PipelineCache::Get(const PipelineDesc& desc, const Pipeline* fallback) SRK_NOEXCEPT
+{
+    auto [entry, inserted] = FindOrInsert(desc);
+    if (inserted)
+    {
+        m_Jobs.Submit([this, entry = entry]() { Build(*entry); }, &m_InFlight);
+        return fallback;
+    }
+
+    return entry->Status.load(std::memory_order_acquire) == PipelineStatus::Ready ? &entry->Result : fallback;
+}
+
+const Pipeline* PipelineCache::GetBlocking(const PipelineDesc& desc) SRK_NOEXCEPT
+{
+    auto [entry, inserted] = FindOrInsert(desc);
+    if (inserted)
+        Build(*entry);
+
+    // someone else is compiling it, when it's still queued this thread may well be the one that ends up running it
+    m_Jobs.Wait(entry->Building);
+
+    return entry->Status.load(std::memory_order_acquire) == PipelineStatus::Ready ? &entry->Result : nullptr;
+}
+
+void PipelineCache::Rebuild(const ShaderRef& shader) SRK_NOEXCEPT
+{
+    std::vector<PipelineDesc> rebuilds;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const auto& [hash, entry] : m_Entries)
+        {
+            if (entry->Status.load(std::memory_order_acquire) != PipelineStatus::Ready)
+                continue;
+
+            for (uint32_t idx{}; idx < entry->Desc.ShaderCount; ++idx)
+            {
+                const ShaderRef& previous = entry->Desc.Shaders[idx];
+                if (previous->GetStage() == shader->GetStage() && previous->GetName() == shader->GetName() && previous->GetHash() != shader->GetHash())
+                {
+                    rebuilds.push_back(entry->Desc);
+                    rebuilds.back().Shaders[idx] = shader;
+                    break;
+                }
+            }
+        }
+    }
+
+    // already on a worker, no point in going through the queue again
+    for (const PipelineDesc& desc : rebuilds)
+    {
+        auto [entry, inserted] = FindOrInsert(desc);
+        if (inserted)
+            Build(*entry);
+    }
+}
+
+void PipelineCache::Commit(const ShaderRef& shader) SRK_NOEXCEPT
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto it = m_Entries.begin(); it != m_Entries.end();)
+    {
+        // only finished ones, a pending entry is still being built by someone who holds on to it
+        const Entry& entry      = *it->second;
+        bool         superseded = false;
+        if (entry.Status.load(std::memory_order_acquire) != PipelineStatus::Pending)
+        {
+            for (uint32_t idx{}; idx < entry.Desc.ShaderCount; ++idx)
+            {
+                const ShaderRef& previous = entry.Desc.Shaders[idx];
+                if (previous->GetStage() == shader->GetStage() && previous->GetName() == shader->GetName() && previous->GetHash() != shader->GetHash())
+                {
+                    superseded = true;
+                    break;
+                }
+            }
+        }
+
+        if (!superseded)
+        {
+            ++it;
+            continue;
+        }
+
+        // the last frame begun may have drawn with it
+        m_Retired.push_back(Retired{std::move(it->second), m_Frame});
+        it = m_Entries.erase(it);
+    }
+}
+
+void PipelineCache::BeginFrame(const Frame& frame) SRK_NOEXCEPT
+{
+    m_Frame = frame.Number;
+
+    const uint64_t inFlight = GetFramesInFlight();
+    auto           done     = [&frame, inFlight](const Retired& retired) { return retired.Frame + inFlight <= frame.Number; };
+    for (Retired& retired : m_Retired)
+    {
+        if (done(retired) && retired.Item->Result.Handle != VK_NULL_HANDLE)
+            vkDestroyPipeline(m_Device, retired.Item->Result.Handle, nullptr);
+    }
+    m_Retired.erase(std::remove_if(m_Retired.begin(), m_Retired.end(), done), m_Retired.end());
+}
+
+size_t PipelineCache::GetPipelineCount() const SRK_NOEXCEPT
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Entries.size();
+}
+
+void PipelineCache::Build(Entry& entry) SRK_NOEXCEPT
+{
+    Create(entry);
+
+    // the status is stored by now, whoever waits in GetBlocking sees it
+    entry.Building.Pending.fetch_sub(1, std::memory_order_release);
+}
+
+void PipelineCache::Create(Entry& entry) SRK_NOEXCEPT
+{
+    const PipelineDesc& desc = entry.Desc;
+
+    entry.Result.Layout = m_Layouts.GetPipelineLayout(desc.Shaders.data(), desc.ShaderCount);
+    if (!entry.Result.Layout)
+    {
+        entry.Status.store(PipelineStatus::Failed, std::memory_order_release);
+        return;
+    }
+
+    // a lone compute shader is a compute pipeline, nothing else in the desc applies to it
+    if (desc.ShaderCount == 1 && desc.Shaders[0]->GetStage() == VK_SHADER_STAGE_COMPUTE_BIT)
+    {
+        CreateCompute(entry);
+        return;
+    }
+
+    std::array<VkPipelineShaderStageCreateInfo, MaxShaderStages> stages{};
+    for (uint32_t idx{}; idx < desc.ShaderCount; ++idx)
+    {
+        stages[idx].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[idx].stage  = desc.Shaders[idx]->GetStage();
+        stages[idx].module = desc.Shaders[idx]->GetModule();
+        stages[idx].pName  = "main";
+    }
+
+    std::array<VkVertexInputBindingDescription, MaxVertexBindings> vertexBindings{};
+    for (uint32_t idx{}; idx < desc.Vertex.BindingCount; ++idx)
+    {
+        vertexBindings[idx].binding   = desc.Vertex.Bindings[idx].Binding;
+        vertexBindings[idx].stride    = desc.Vertex.Bindings[idx].Stride;
+        vertexBindings[idx].inputRate = desc.Vertex.Bindings[idx].InputRate;
+    }
+
+    std::array<VkVertexInputAttributeDescription, MaxVertexAttributes> vertexAttributes{};
+    for (uint32_t idx{}; idx < desc.Vertex.AttributeCount; ++idx)
+    {
+        vertexAttributes[idx].location = desc.Vertex.Attributes[idx].Location;
+        vertexAttributes[idx].binding  = desc.Vertex.Attributes[idx].Binding;
+        vertexAttributes[idx].format   = desc.Vertex.Attributes[idx].Format;
+        vertexAttributes[idx].offset   = desc.Vertex.Attributes[idx].Offset;
+    }
+
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    vertexInput.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount   = desc.Vertex.BindingCount;
+    vertexInput.pVertexBindingDescriptions      = vertexBindings.data();
+    vertexInput.vertexAttributeDescriptionCount = desc.Vertex.AttributeCount;
+    vertexInput.pVertexAttributeDescriptions    = vertexAttributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = desc.State.Topology;
+
+    VkPipelineViewportStateCreateInfo viewport{};
+    viewport.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport.viewportCount = 1;
+    viewport.scissorCount  = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterization{};
+    rasterization.sType       = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = desc.State.PolygonMode;
+    rasterization.cullMode    = desc.State.CullMode;
+    rasterization.frontFace   = desc.State.FrontFace;
+    rasterization.lineWidth   = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample{};
+    multisample.sType                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = desc.Targets.Samples;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType            = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable  = desc.Targets.DepthFormat != VK_FORMAT_UNDEFINED ? desc.State.DepthTest : VK_FALSE;
+    depthStencil.depthWriteEnable = desc.Targets.DepthFormat != VK_FORMAT_UNDEFINED ? desc.State.DepthWrite : VK_FALSE;
+    depthStencil.depthCompareOp   = desc.State.DepthCompare;
+
+    std::array<VkPipelineColorBlendAttachmentState, MaxColorTargets> blendAttachments{};
+    for (uint32_t idx{}; idx < desc.Targets.ColorCount; ++idx)
+    {
+        blendAttachments[idx].blendEnable         = desc.State.BlendEnable;
+        blendAttachments[idx].srcColorBlendFactor = desc.State.SrcColorBlend;
+        blendAttachments[idx].dstColorBlendFactor = desc.State.DstColorBlend;
+        blendAttachments[idx].colorBlendOp        = desc.State.ColorBlendOp;
+        blendAttachments[idx].srcAlphaBlendFactor = desc.State.SrcAlphaBlend;
+        blendAttachments[idx].dstAlphaBlendFactor = desc.State.DstAlphaBlend;
+        blendAttachments[idx].alphaBlendOp        = desc.State.AlphaBlendOp;
+        blendAttachments[idx].colorWriteMask      = desc.State.WriteMask;
+    }
+
+    VkPipelineColorBlendStateCreateInfo colorBlend{};
+    colorBlend.sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = desc.Targets.ColorCount;
+    colorBlend.pAttachments    = blendAttachments.data();
+
+    const VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+    VkPipelineDynamicStateCreateInfo dynamic{};
+    dynamic.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic.dynamicStateCount = static_cast<uint32_t>(std::size(dynamicStates));
+    dynamic.pDynamicStates    = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo createInfo{};
+    createInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    createInfo.stageCount          = desc.ShaderCount;
+    createInfo.pStages             = stages.data();
+    createInfo.pVertexInputState   = &vertexInput;
+    createInfo.pInputAssemblyState = &inputAssembly;
+    createInfo.pViewportState      = &viewport;
+    createInfo.pRasterizationState = &rasterization;
+    createInfo.pMultisampleState   = &multisample;
+    createInfo.pDepthStencilState  = &depthStencil;
+    createInfo.pColorBlendState    = &colorBlend;
+    createInfo.pDynamicState       = &dynamic;
+    createInfo.layout              = entry.Result.Layout->Layout;
+    createInfo.renderPass          = desc.RenderPass;
+    createInfo.subpass             = desc.Subpass;
+
+    VkResult result = vkCreateGraphicsPipelines(m_Device, m_DriverCache, 1, &createInfo, nullptr, &entry.Result.Handle);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Pipeline {} could not be created with {}", desc.Shaders[0]->GetName(), result);
+        entry.Result.Handle = VK_NULL_HANDLE;
+        entry.Status.store(PipelineStatus::Failed, std::memory_order_release);
+        return;
+    }
+
+    entry.Status.store(PipelineStatus::Ready, std::memory_order_release);
+}
+
+void PipelineCache::CreateCompute(Entry& entry) SRK_NOEXCEPT
+{
+    const PipelineDesc& desc = entry.Desc;
+
+    VkComputePipelineCreateInfo createInfo{};
+    createInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    createInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    createInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    createInfo.stage.module = desc.Shaders[0]->GetModule();
+    createInfo.stage.pName  = "main";
+    createInfo.layout       = entry.Result.Layout->Layout;
+
+    VkResult result = vkCreateComputePipelines(m_Device, m_DriverCache, 1, &createInfo, nullptr, &entry.Result.Handle);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Compute pipeline {} could not be created with {}", desc.Shaders[0]->GetName(), result);
+        entry.Result.Handle = VK_NULL_HANDLE;
+        entry.Status.store(PipelineStatus::Failed, std::memory_order_release);
+        return;
+    }
+
+    entry.Status.store(PipelineStatus::Ready, std::memory_order_release);
+}
+
+} // namespace shrek::render::pipeline
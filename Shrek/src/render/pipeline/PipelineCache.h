@@ -0,0 +1,187 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "LayoutCache.h"
+#include "Shader.h"
+#include "base/JobSystem.h"
+#include "render/FrameContext.h"
+#include "platform/MappedFile.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace shrek::render::pipeline {
+
+constexpr uint32_t MaxShaderStages     = 5;
+constexpr uint32_t MaxColorTargets     = 4;
+constexpr uint32_t MaxVertexBindings   = 4;
+constexpr uint32_t MaxVertexAttributes = 8;
+
+// everything below is made of 4 byte members only so it can be hashed as raw bytes
+
+struct VertexBinding
+{
+    uint32_t          Binding{0};
+    uint32_t          Stride{0};
+    VkVertexInputRate InputRate{VK_VERTEX_INPUT_RATE_VERTEX};
+};
+
+struct VertexAttribute
+{
+    uint32_t Location{0};
+    uint32_t Binding{0};
+    VkFormat Format{VK_FORMAT_UNDEFINED};
+    uint32_t Offset{0};
+};
+
+struct VertexLayout
+{
+    std::array<VertexBinding, MaxVertexBindings>     Bindings{};
+    uint32_t                                         BindingCount{0};
+    std::array<VertexAttribute, MaxVertexAttributes> Attributes{};
+    uint32_t                                         AttributeCount{0};
+};
+
+// the formats decide render pass compatibility, so they are what the pipeline is keyed on
+struct RenderTargetLayout
+{
+    std::array<VkFormat, MaxColorTargets> ColorFormats{};
+    uint32_t                              ColorCount{0};
+    VkFormat                              DepthFormat{VK_FORMAT_UNDEFINED};
+    VkSampleCountFlagBits                 Samples{VK_SAMPLE_COUNT_1_BIT};
+};
+
+// viewport and scissor are dynamic so resizing never makes a new pipeline
+struct FixedFunctionState
+{
+    VkPrimitiveTopology   Topology{VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
+    VkPolygonMode         PolygonMode{VK_POLYGON_MODE_FILL};
+    VkCullModeFlags       CullMode{VK_CULL_MODE_BACK_BIT};
+    VkFrontFace           FrontFace{VK_FRONT_FACE_COUNTER_CLOCKWISE};
+    VkBool32              DepthTest{VK_TRUE};
+    VkBool32              DepthWrite{VK_TRUE};
+    VkCompareOp           DepthCompare{VK_COMPARE_OP_LESS_OR_EQUAL};
+    VkBool32              BlendEnable{VK_FALSE};
+    VkBlendFactor         SrcColorBlend{VK_BLEND_FACTOR_SRC_ALPHA};
+    VkBlendFactor         DstColorBlend{VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA};
+    VkBlendOp             ColorBlendOp{VK_BLEND_OP_ADD};
+    VkBlendFactor         SrcAlphaBlend{VK_BLEND_FACTOR_ONE};
+    VkBlendFactor         DstAlphaBlend{VK_BLEND_FACTOR_ZERO};
+    VkBlendOp             AlphaBlendOp{VK_BLEND_OP_ADD};
+    VkColorComponentFlags WriteMask{VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT};
+};
+
+struct PipelineDesc
+{
+    std::array<ShaderRef, MaxShaderStages> Shaders;
+    uint32_t                               ShaderCount{0};
+    VertexLayout                           Vertex;
+    RenderTargetLayout                     Targets;
+    FixedFunctionState                     State;
+    VkRenderPass                           RenderPass{VK_NULL_HANDLE}; // any pass compatible with Targets, not part of the key
+    uint32_t                               Subpass{0};
+};
+
+struct Pipeline
+{
+    VkPipeline            Handle{VK_NULL_HANDLE};
+    const PipelineLayout* Layout{nullptr};
+    uint64_t              Hash{0};
+};
+
+enum class PipelineStatus : uint32_t
+{
+    Pending,
+    Ready,
+    Failed
+};
+
+std::string_view ToString(PipelineStatus status) SRK_NOEXCEPT;
+
+uint64_t HashPipelineDesc(const PipelineDesc& desc) SRK_NOEXCEPT;
+
+/*
+ *  Graphics pipelines keyed by a hash of their shaders, vertex layout, render target formats and fixed function state.
+ *  A desc with nothing but a compute shader makes a compute pipeline, the rest of it is left at its defaults.
+ *  A miss never blocks the frame, the pipeline is compiled on the job system and the caller gets its fallback
+ *  (or null, meaning skip the draw) until it is done. The pointers handed out stay valid until a reload replaces the
+ *  pipeline, Commit retires what the new shader superseded and BeginFrame destroys it once no frame in flight can use it.
+ *  So a pointer is only good for the frame it was fetched in.
+ */
+class PipelineCache
+{
+public:
+    // the driver cache starts out with saved (see ReadCacheFile) and is written back to cachePath on destruction,
+    // nothing is kept on disk when it's empty
+    PipelineCache(VkDevice device, base::JobSystem& jobs, LayoutCache& layouts, std::string cachePath = {}, const MappedFile& saved = {}) SRK_NOEXCEPT;
+    ~PipelineCache() SRK_NOEXCEPT;
+
+    // any thread, what the last run saved to cachePath. invalid when there is nothing there yet
+    static MappedFile ReadCacheFile(const std::string& cachePath) SRK_NOEXCEPT;
+
+    PipelineCache(const PipelineCache& other) = delete;
+    PipelineCache& operator=(const PipelineCache& other) = delete;
+
+    // never waits, fallback until the pipeline is compiled or when it failed to compile
+    const Pipeline* Get(const PipelineDesc& desc, const Pipeline* fallback = nullptr) SRK_NOEXCEPT;
+
+    // compiles on the calling thread when missing, for load time and fallbacks. null when compiling failed.
+    // when a worker is already compiling it this runs other jobs until it's done
+    const Pipeline* GetBlocking(const PipelineDesc& desc) SRK_NOEXCEPT;
+
+    // hook for ShaderLibrary reload handlers, runs on the reloading worker and compiles every
+    // cached pipeline again with the new shader swapped in so the first frame after the reload hits
+    void Rebuild(const ShaderRef& shader) SRK_NOEXCEPT;
+    // hook for the reload handler's commit, at the frame boundary. the pipelines built with the shader this one
+    // replaced are retired, nothing asks for them again now that the library hands out the new one
+    void Commit(const ShaderRef& shader) SRK_NOEXCEPT;
+
+    // render thread, after FrameContext::BeginFrame. destroys what was retired by frames that are done by now
+    void BeginFrame(const Frame& frame) SRK_NOEXCEPT;
+
+    size_t   GetPipelineCount() const SRK_NOEXCEPT;
+    uint32_t GetPendingCount() const SRK_NOEXCEPT { return m_InFlight.Pending.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry
+    {
+        PipelineDesc                Desc;
+        Pipeline                    Result;
+        std::atomic<PipelineStatus> Status{PipelineStatus::Pending};
+        base::JobCounter            Building; // 1 until Build is done, GetBlocking waits on it
+    };
+
+    struct Retired
+    {
+        std::unique_ptr<Entry> Item;
+        uint64_t               Frame{0};
+    };
+
+    // true when the entry was just inserted and the caller has to build it
+    std::pair<Entry*, bool> FindOrInsert(const PipelineDesc& desc) SRK_NOEXCEPT;
+    void                    Build(Entry& entry) SRK_NOEXCEPT;
+    void                    Create(Entry& entry) SRK_NOEXCEPT;
+    void                    CreateCompute(Entry& entry) SRK_NOEXCEPT;
+    void                    SaveDriverCache() const SRK_NOEXCEPT;
+
+private:
+    VkDevice         m_Device;
+    base::JobSystem& m_Jobs;
+    LayoutCache&     m_Layouts;
+    VkPipelineCache  m_DriverCache;
+    std::string      m_CachePath;
+
+    mutable std::mutex                                        m_Mutex;
+    std::unordered_multimap<uint64_t, std::unique_ptr<Entry>> m_Entries;
+    base::JobCounter                                          m_InFlight;
+    std::vector<Retired>                                      m_Retired; // render thread only, like Commit and BeginFrame
+    uint64_t                                                  m_Frame;   // the last one begun
+};
+
+} // namespace shrek::render::pipeline
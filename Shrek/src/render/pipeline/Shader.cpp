@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "Shader.h"
+
+#include "base/Hash.h"
+#include "render/helper/Debug.h"
+#include "platform/Log.h"
+
+namespace shrek::render::pipeline {
+
+Shader::Shader(VkDevice device, std::string name, VkShaderStageFlagBits stage, std::vector<uint32_t> spirv) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Name(std::move(name)),
+    m_Stage(stage),
+    m_Spirv(std::move(spirv)),
+    m_Hash(base::HashBytes(m_Spirv.data(), m_Spirv.size() * sizeof(uint32_t))),
+    m_Reflection(),
+    m_Module(VK_NULL_HANDLE)
+{
+    std::string log;
+    if (!ReflectSpirv(m_Spirv, m_Stage, m_Reflection, log))
+    {
+        // the layout can't be built from it so the module is no use either
+        SRK_CORE_ERROR("Shader {} could not be reflected: {}", m_Name, log);
+        return;
+    }
+
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = m_Spirv.size() * sizeof(uint32_t);
+    createInfo.pCode    = m_Spirv.data();
+
+    VkResult result = vkCreateShaderModule(m_Device, &createInfo, nullptr, &m_Module);
+    if (result != VK_SUCCESS)
+    {
+        SRK_CORE_ERROR("Shader module for {} could not be created with {}", m_Name, result);
+        m_Module = VK_NULL_HANDLE;
+    }
+}
+
+Shader::~Shader() SRK_NOEXCEPT
+{
+    if (m_Module != VK_NULL_HANDLE)
+        vkDestroyShaderModule(m_Device, m_Module, nullptr);
+}
+
+} // namespace shrek::render::pipeline
@@ -1,11 +1,47 @@
 #pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "ShaderReflection.h"
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace shrek::render::pipeline {
 
+/*
+ *  Compiled SPIR-V of one stage, the module made from it and what the module binds.
+ *  Never changes once created, a reload makes a new Shader instead so it can be shared between threads freely.
+ */
 class Shader
 {
 public:
+    Shader(VkDevice device, std::string name, VkShaderStageFlagBits stage, std::vector<uint32_t> spirv) SRK_NOEXCEPT;
+    ~Shader() SRK_NOEXCEPT;
+
+    Shader(const Shader& other) = delete;
+    Shader& operator=(const Shader& other) = delete;
+
+    bool IsValid() const SRK_NOEXCEPT { return m_Module != VK_NULL_HANDLE; }
+
+    const std::string&           GetName() const SRK_NOEXCEPT { return m_Name; }
+    VkShaderStageFlagBits        GetStage() const SRK_NOEXCEPT { return m_Stage; }
+    VkShaderModule               GetModule() const SRK_NOEXCEPT { return m_Module; }
+    const std::vector<uint32_t>& GetSpirv() const SRK_NOEXCEPT { return m_Spirv; }
+    uint64_t                     GetHash() const SRK_NOEXCEPT { return m_Hash; } // of the spirv
+    const ShaderReflection&      GetReflection() const SRK_NOEXCEPT { return m_Reflection; }
+
 private:
+    VkDevice              m_Device;
+    std::string           m_Name;
+    VkShaderStageFlagBits m_Stage;
+    std::vector<uint32_t> m_Spirv;
+    uint64_t              m_Hash;
+    ShaderReflection      m_Reflection;
+    VkShaderModule        m_Module;
 };
+
+using ShaderRef = std::shared_ptr<const Shader>;
+
 } // namespace shrek::render::pipeline
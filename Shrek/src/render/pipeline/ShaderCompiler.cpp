@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "ShaderCompiler.h"
+
+#ifdef _MSC_VER
+#    pragma warning(push, 0)
+#endif
+#include "Public/ResourceLimits.h"
+#include "Public/ShaderLang.h"
+#include "SPIRV/GlslangToSpv.h"
+#ifdef _MSC_VER
+#    pragma warning(pop)
+#endif
+
+namespace shrek::render::pipeline {
+
+namespace {
+
+constexpr int glslVersion = 450;
+
+// glslang keeps process wide tables, they live until the program exits
+struct GlslangProcess
+{
+    GlslangProcess() SRK_NOEXCEPT { glslang::InitializeProcess(); }
+    ~GlslangProcess() SRK_NOEXCEPT { glslang::FinalizeProcess(); }
+};
+
+void initializeGlslang() SRK_NOEXCEPT
+{
+    static GlslangProcess process;
+}
+
+EShLanguage toLanguage(VkShaderStageFlagBits stage) SRK_NOEXCEPT
+{
+    switch (stage)
+    {
+        case VK_SHADER_STAGE_VERTEX_BIT:
+            return EShLangVertex;
+        case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+            return EShLangTessControl;
+        case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+            return EShLangTessEvaluation;
+        case VK_SHADER_STAGE_GEOMETRY_BIT:
+            return EShLangGeometry;
+        case VK_SHADER_STAGE_COMPUTE_BIT:
+            return EShLangCompute;
+        case VK_SHADER_STAGE_FRAGMENT_BIT:
+        default:
+            return EShLangFragment;
+    }
+}
+
+} // namespace
+
+std::optional<VkShaderStageFlagBits> StageFromPath(std::string_view path) SRK_NOEXCEPT
+{
+    static constexpr std::pair<std::string_view, VkShaderStageFlagBits> extensions[] = {
+        {".vert", VK_SHADER_STAGE_VERTEX_BIT},
+        {".frag", VK_SHADER_STAGE_FRAGMENT_BIT},
+        {".comp", VK_SHADER_STAGE_COMPUTE_BIT},
+        {".geom", VK_SHADER_STAGE_GEOMETRY_BIT},
+        {".tesc", VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT},
+        {".tese", VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT}};
+
+    const size_t dot = path.rfind('.');
+    if (dot == std::string_view::npos)
+        return std::nullopt;
+
+    for (const auto& [extension, stage] : extensions)
+    {
+        if (path.substr(dot) == extension)
+            return stage;
+    }
+
+    return std::nullopt;
+}
+
+bool CompileGlsl(std::string_view source, const std::string& name, VkShaderStageFlagBits stage, std::vector<uint32_t>& spirv, std::string& log) SRK_NOEXCEPT
+{
+    initializeGlslang();
+
+    const EShLanguage language = toLanguage(stage);
+    const EShMessages messages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
+
+    const char* sources[] = {source.data()};
+    const int   lengths[] = {static_cast<int>(source.size())};
+    const char* names[]   = {name.c_str()};
+
+    glslang::TShader shader(language);
+    shader.setStringsWithLengthsAndNames(sources, lengths, names, 1);
+    shader.setEnvInput(glslang::EShSourceGlsl, language, glslang::EShClientVulkan, 100);
+    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+    shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_0);
+
+    if (!shader.parse(GetDefaultResources(), glslVersion, false, messages))
+    {
+        log = shader.getInfoLog();
+        return false;
+    }
+
+    glslang::TProgram program;
+    program.addShader(&shader);
+    if (!program.link(messages))
+    {
+        log = program.getInfoLog();
+        return false;
+    }
+
+    glslang::SpvOptions options;
+#ifdef SRK_DIST
+    options.disableOptimizer = false;
+#else
+    // keeps names around for debuggers and the validation layers
+    options.generateDebugInfo = true;
+#endif
+
+    spirv.clear();
+    glslang::GlslangToSpv(*program.getIntermediate(language), spirv, &options);
+    return !spirv.empty();
+}
+
+} // namespace shrek::render::pipeline
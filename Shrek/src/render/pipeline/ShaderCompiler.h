@@ -0,0 +1,19 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace shrek::render::pipeline {
+
+// from the file extension, .vert .frag .comp .geom .tesc .tese
+std::optional<VkShaderStageFlagBits> StageFromPath(std::string_view path) SRK_NOEXCEPT;
+
+// glsl to SPIR-V through glslang, safe to call from several threads at once. log is filled on failure
+bool CompileGlsl(std::string_view source, const std::string& name, VkShaderStageFlagBits stage, std::vector<uint32_t>& spirv, std::string& log) SRK_NOEXCEPT;
+
+} // namespace shrek::render::pipeline
@@ -0,0 +1,194 @@
+#include "pch.h"
+#include "ShaderLibrary.h"
+
+#include "ShaderCompiler.h"
+#include "platform/Log.h"
+#include "platform/MappedFile.h"
+
+#include <algorithm>
+
+namespace shrek::render::pipeline {
+
+namespace {
+
+#ifndef SRK_DIST
+constexpr bool enableHotReload = true;
+#else
+constexpr bool enableHotReload = false;
+#endif
+
+} // namespace
+
+ShaderLibrary::ShaderLibrary(VkDevice device, base::JobSystem& jobs, const std::string& directory) SRK_NOEXCEPT :
+    m_Device(device),
+    m_Jobs(jobs),
+    m_Directory(directory),
+    m_Watcher(enableHotReload ? std::make_unique<FileWatcher>(directory) : nullptr),
+    m_NextHandler(0)
+{
+}
+
+ShaderLibrary::~ShaderLibrary() SRK_NOEXCEPT
+{
+    // the jobs still reference this
+    m_Jobs.Wait(m_InFlight);
+}
+
+bool ShaderLibrary::CompileFile(const std::string& directory, const std::string& name, std::vector<uint32_t>& spirv) SRK_NOEXCEPT
+{
+    std::optional<VkShaderStageFlagBits> stage = StageFromPath(name);
+    if (!stage.has_value())
+    {
+        SRK_CORE_ERROR("Unknown shader stage for {}", name);
+        return false;
+    }
+
+    const std::string path = directory + "/" + name;
+    MappedFile        source(path);
+    if (!source.IsValid())
+        return false;
+
+    std::string log;
+    if (!CompileGlsl(source.AsString(), path, stage.value(), spirv, log))
+    {
+        SRK_CORE_ERROR("{} failed to compile:\n{}", name, log);
+        return false;
+    }
+    return true;
+}
+
+ShaderRef ShaderLibrary::Compile(const std::string& name) const SRK_NOEXCEPT
+{
+    std::vector<uint32_t> spirv;
+    if (!CompileFile(m_Directory, name, spirv))
+        return nullptr;
+
+    return CreateShader(name, std::move(spirv));
+}
+
+ShaderRef ShaderLibrary::CreateShader(const std::string& name, std::vector<uint32_t> spirv) const SRK_NOEXCEPT
+{
+    // CompileFile already checked the stage
+    auto shader = std::make_shared<const Shader>(m_Device, name, StageFromPath(name).value(), std::move(spirv));
+    return shader->IsValid() ? shader : nullptr;
+}
+
+ShaderRef ShaderLibrary::Load(const std::string& name) SRK_NOEXCEPT
+{
+    auto it = m_Shaders.find(name);
+    if (it != m_Shaders.end())
+        return it->second;
+
+    ShaderRef shader = Compile(name);
+    if (shader)
+        m_Shaders.emplace(name, shader);
+
+    return shader;
+}
+
+ShaderRef ShaderLibrary::Load(const std::string& name, std::vector<uint32_t> spirv) SRK_NOEXCEPT
+{
+    auto it = m_Shaders.find(name);
+    if (it != m_Shaders.end())
+        return it->second;
+
+    ShaderRef shader = CreateShader(name, std::move(spirv));
+    if (shader)
+        m_Shaders.emplace(name, shader);
+
+    return shader;
+}
+
+ShaderRef ShaderLibrary::Get(const std::string& name) const SRK_NOEXCEPT
+{
+    auto it = m_Shaders.find(name);
+    return it != m_Shaders.end() ? it->second : nullptr;
+}
+
+uint32_t ShaderLibrary::AddReloadHandler(ShaderReloadHandler handler) SRK_NOEXCEPT
+{
+    m_Jobs.Wait(m_InFlight);
+    m_Handlers.emplace_back(m_NextHandler, std::move(handler));
+    return m_NextHandler++;
+}
+
+void ShaderLibrary::RemoveReloadHandler(uint32_t id) SRK_NOEXCEPT
+{
+    m_Jobs.Wait(m_InFlight);
+    m_Handlers.erase(std::remove_if(m_Handlers.begin(), m_Handlers.end(), [id](const auto& handler) { return handler.first == id; }), m_Handlers.end());
+}
+
+void ShaderLibrary::StartReload(const std::string& name) SRK_NOEXCEPT
+{
+    if (!m_Compiling.insert(name).second)
+    {
+        // picked up again once the compile in flight is done, it may have read a half written file
+        m_Stale.insert(name);
+        return;
+    }
+
+    m_Jobs.Submit(
+        [this, name]() {
+            ShaderRef shader = Compile(name);
+            if (shader)
+            {
+                for (const auto& [id, handler] : m_Handlers)
+                {
+                    if (handler.Rebuild)
+                        handler.Rebuild(shader);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(m_ReloadMutex);
+            m_Finished.push_back(Reload{name, std::move(shader)});
+        },
+        &m_InFlight);
+}
+
+void ShaderLibrary::Update() SRK_NOEXCEPT
+{
+    if (!m_Watcher)
+        return;
+
+    m_Changed.clear();
+    m_Watcher->Poll(m_Changed);
+
+    for (const std::string& name : m_Changed)
+    {
+        // only shaders somebody loaded are worth compiling
+        if (m_Shaders.count(name) != 0)
+            StartReload(name);
+    }
+}
+
+void ShaderLibrary::ApplyReloads() SRK_NOEXCEPT
+{
+    std::vector<Reload> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_ReloadMutex);
+        finished.swap(m_Finished);
+    }
+
+    for (Reload& reload : finished)
+    {
+        m_Compiling.erase(reload.Name);
+
+        if (reload.Shader)
+        {
+            // anyone still holding the old shader keeps it alive until they let go
+            m_Shaders[reload.Name] = reload.Shader;
+            for (const auto& [id, handler] : m_Handlers)
+            {
+                if (handler.Commit)
+                    handler.Commit(reload.Shader);
+            }
+
+            SRK_CORE_INFO("Reloaded shader {}", reload.Name);
+        }
+
+        if (m_Stale.erase(reload.Name) != 0)
+            StartReload(reload.Name);
+    }
+}
+
+} // namespace shrek::render::pipeline
@@ -0,0 +1,88 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+#include "Shader.h"
+#include "base/JobSystem.h"
+#include "platform/FileWatcher.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace shrek::render::pipeline {
+
+struct ShaderReloadHandler
+{
+    std::function<void(const ShaderRef& shader)> Rebuild; // on the worker that compiled the shader, build anything that depends on it here
+    std::function<void(const ShaderRef& shader)> Commit;  // at the frame boundary, swap in what Rebuild built
+};
+
+/*
+ *  Owns the shaders loaded from one directory and hot reloads them when their source changes.
+ *  Changed files are recompiled on the job system and their dependents rebuilt on the same worker,
+ *  the results are only made visible by ApplyReloads so a frame never sees half of a reload.
+ *  Everything except the handlers is meant to be used from a single thread.
+ */
+class ShaderLibrary
+{
+public:
+    ShaderLibrary(VkDevice device, base::JobSystem& jobs, const std::string& directory) SRK_NOEXCEPT;
+    ~ShaderLibrary() SRK_NOEXCEPT;
+
+    ShaderLibrary(const ShaderLibrary& other) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary& other) = delete;
+
+    // compiles on the calling thread, for load time. null when the shader does not compile
+    ShaderRef Load(const std::string& name) SRK_NOEXCEPT;
+    // with the spirv CompileFile made for it ahead of time, only the module is created here
+    ShaderRef Load(const std::string& name, std::vector<uint32_t> spirv) SRK_NOEXCEPT;
+    ShaderRef Get(const std::string& name) const SRK_NOEXCEPT;
+
+    uint32_t AddReloadHandler(ShaderReloadHandler handler) SRK_NOEXCEPT;
+    // waits for the reloads in flight since they may still call the handler
+    void RemoveReloadHandler(uint32_t id) SRK_NOEXCEPT;
+
+    // glsl in directory to spirv, needs no device so it can run before there is one. safe from any thread
+    static bool CompileFile(const std::string& directory, const std::string& name, std::vector<uint32_t>& spirv) SRK_NOEXCEPT;
+
+    // polls for changed sources and starts compiling them, never waits on a compile
+    void Update() SRK_NOEXCEPT;
+
+    // call between frames, swaps in every shader that finished compiling since the last call
+    void ApplyReloads() SRK_NOEXCEPT;
+
+private:
+    struct Reload
+    {
+        std::string Name;
+        ShaderRef   Shader; // null when compiling failed, the old shader stays
+    };
+
+    ShaderRef Compile(const std::string& name) const SRK_NOEXCEPT;
+    ShaderRef CreateShader(const std::string& name, std::vector<uint32_t> spirv) const SRK_NOEXCEPT;
+    void      StartReload(const std::string& name) SRK_NOEXCEPT;
+
+private:
+    VkDevice                     m_Device;
+    base::JobSystem&             m_Jobs;
+    std::string                  m_Directory;
+    std::unique_ptr<FileWatcher> m_Watcher; // null when hot reloading is compiled out
+
+    std::unordered_map<std::string, ShaderRef> m_Shaders;
+    std::unordered_set<std::string>            m_Compiling;
+    std::unordered_set<std::string>            m_Stale; // changed again while compiling
+    std::vector<std::string>                   m_Changed;
+
+    std::vector<std::pair<uint32_t, ShaderReloadHandler>> m_Handlers;
+    uint32_t                                              m_NextHandler;
+
+    std::mutex          m_ReloadMutex;
+    std::vector<Reload> m_Finished;
+    base::JobCounter    m_InFlight;
+};
+
+} // namespace shrek::render::pipeline
@@ -0,0 +1,446 @@
+#include "pch.h"
+#include "ShaderReflection.h"
+
+#include "platform/Log.h"
+
+#include <algorithm>
+
+namespace shrek::render::pipeline {
+
+namespace {
+
+constexpr uint32_t spirvMagic  = 0x07230203;
+constexpr uint32_t headerWords = 5;
+constexpr uint32_t noValue     = ~0u;
+
+// only the parts of the SPIR-V spec that reflection looks at
+enum Op : uint32_t
+{
+    OpTypeBool          = 20,
+    OpTypeInt           = 21,
+    OpTypeFloat         = 22,
+    OpTypeVector        = 23,
+    OpTypeMatrix        = 24,
+    OpTypeImage         = 25,
+    OpTypeSampler       = 26,
+    OpTypeSampledImage  = 27,
+    OpTypeArray         = 28,
+    OpTypeRuntimeArray  = 29,
+    OpTypeStruct        = 30,
+    OpTypePointer       = 32,
+    OpConstant          = 43,
+    OpSpecConstantTrue  = 48,
+    OpSpecConstantFalse = 49,
+    OpSpecConstant      = 50,
+    OpVariable          = 59,
+    OpDecorate          = 71,
+    OpMemberDecorate    = 72,
+};
+
+enum Decoration : uint32_t
+{
+    Decoration_SpecId        = 1,
+    Decoration_Block         = 2,
+    Decoration_BufferBlock   = 3,
+    Decoration_ArrayStride   = 6,
+    Decoration_MatrixStride  = 7,
+    Decoration_BuiltIn       = 11,
+    Decoration_Location      = 30,
+    Decoration_Binding       = 33,
+    Decoration_DescriptorSet = 34,
+    Decoration_Offset        = 35,
+};
+
+enum StorageClass : uint32_t
+{
+    StorageClass_UniformConstant = 0,
+    StorageClass_Input           = 1,
+    StorageClass_Uniform         = 2,
+    StorageClass_PushConstant    = 9,
+    StorageClass_StorageBuffer   = 12,
+};
+
+constexpr uint32_t dimBuffer      = 5;
+constexpr uint32_t dimSubpassData = 6;
+
+struct Member
+{
+    uint32_t Offset{0};
+    uint32_t MatrixStride{0};
+};
+
+struct Id
+{
+    const uint32_t*     Instruction{nullptr}; // the one that defines the id
+    uint32_t            Op{0};
+    uint32_t            Set{noValue};
+    uint32_t            Binding{noValue};
+    uint32_t            Location{noValue};
+    uint32_t            SpecId{noValue};
+    uint32_t            ArrayStride{0};
+    bool                Block{false};
+    bool                BufferBlock{false};
+    bool                BuiltIn{false};
+    std::vector<Member> Members;
+};
+
+class Parser
+{
+public:
+    Parser(const std::vector<uint32_t>& spirv, std::string& log) SRK_NOEXCEPT : m_Spirv(spirv), m_Log(log) {}
+
+    bool Parse() SRK_NOEXCEPT
+    {
+        if (m_Spirv.size() < headerWords || m_Spirv[0] != spirvMagic)
+            return Fail("not SPIR-V");
+
+        m_Ids.resize(m_Spirv[3]); // the id bound
+
+        for (size_t offset = headerWords; offset < m_Spirv.size();)
+        {
+            const uint32_t* instruction = m_Spirv.data() + offset;
+            const uint32_t  wordCount   = instruction[0] >> 16;
+            const uint32_t  op          = instruction[0] & 0xFFFF;
+            if (wordCount == 0 || offset + wordCount > m_Spirv.size())
+                return Fail("truncated instruction");
+
+            if (!Record(op, instruction, wordCount))
+                return false;
+
+            offset += wordCount;
+        }
+
+        return true;
+    }
+
+    void Reflect(VkShaderStageFlagBits stage, ShaderReflection& reflection) const SRK_NOEXCEPT
+    {
+        for (const uint32_t variable : m_Variables)
+        {
+            const Id&      var          = m_Ids[variable];
+            const uint32_t storageClass = var.Instruction[3];
+            const Id*      pointer      = Get(var.Instruction[1]);
+            if (!pointer || pointer->Op != OpTypePointer)
+                continue;
+
+            const uint32_t pointee = pointer->Instruction[3];
+            const Id*      type    = Get(pointee);
+            if (!type)
+                continue;
+
+            switch (storageClass)
+            {
+                case StorageClass_UniformConstant:
+                case StorageClass_Uniform:
+                case StorageClass_StorageBuffer:
+                    ReflectBinding(var, storageClass, pointee, stage, reflection);
+                    break;
+                case StorageClass_PushConstant:
+                    ReflectPushConstants(pointee, reflection);
+                    break;
+                case StorageClass_Input:
+                    if (stage == VK_SHADER_STAGE_VERTEX_BIT && !var.BuiltIn && var.Location != noValue && !type->BuiltIn)
+                        reflection.Inputs.push_back(VertexInput{var.Location, InputFormat(pointee)});
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        for (const uint32_t constant : m_SpecConstants)
+        {
+            const Id& spec = m_Ids[constant];
+            if (spec.SpecId != noValue)
+                reflection.SpecializationConstants.push_back(SpecializationConstant{spec.SpecId, TypeSize(spec.Instruction[1], 0)});
+        }
+
+        std::sort(reflection.Bindings.begin(), reflection.Bindings.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+            return a.Set != b.Set ? a.Set < b.Set : a.Binding < b.Binding;
+        });
+        std::sort(reflection.Inputs.begin(), reflection.Inputs.end(), [](const VertexInput& a, const VertexInput& b) { return a.Location < b.Location; });
+        std::sort(reflection.SpecializationConstants.begin(), reflection.SpecializationConstants.end(), [](const auto& a, const auto& b) { return a.Id < b.Id; });
+    }
+
+private:
+    bool Fail(const char* message) SRK_NOEXCEPT
+    {
+        m_Log = message;
+        return false;
+    }
+
+    bool ValidId(uint32_t id) const SRK_NOEXCEPT { return id < m_Ids.size(); }
+
+    bool Record(uint32_t op, const uint32_t* instruction, uint32_t wordCount) SRK_NOEXCEPT
+    {
+        switch (op)
+        {
+            case OpDecorate:
+            {
+                if (wordCount < 3 || !ValidId(instruction[1]))
+                    return Fail("bad OpDecorate");
+
+                Id&            id      = m_Ids[instruction[1]];
+                const uint32_t literal = wordCount > 3 ? instruction[3] : 0;
+                switch (instruction[2])
+                {
+                    case Decoration_SpecId: id.SpecId = literal; break;
+                    case Decoration_Block: id.Block = true; break;
+                    case Decoration_BufferBlock: id.BufferBlock = true; break;
+                    case Decoration_ArrayStride: id.ArrayStride = literal; break;
+                    case Decoration_BuiltIn: id.BuiltIn = true; break;
+                    case Decoration_Location: id.Location = literal; break;
+                    case Decoration_Binding: id.Binding = literal; break;
+                    case Decoration_DescriptorSet: id.Set = literal; break;
+                    default: break;
+                }
+                return true;
+            }
+            case OpMemberDecorate:
+            {
+                if (wordCount < 4 || !ValidId(instruction[1]))
+                    return Fail("bad OpMemberDecorate");
+
+                Id& id = m_Ids[instruction[1]];
+                if (instruction[3] == Decoration_BuiltIn)
+                {
+                    // gl_PerVertex and friends
+                    id.BuiltIn = true;
+                    return true;
+                }
+
+                if (id.Members.size() <= instruction[2])
+                    id.Members.resize(instruction[2] + 1);
+
+                if (instruction[3] == Decoration_Offset && wordCount > 4)
+                    id.Members[instruction[2]].Offset = instruction[4];
+                else if (instruction[3] == Decoration_MatrixStride && wordCount > 4)
+                    id.Members[instruction[2]].MatrixStride = instruction[4];
+                return true;
+            }
+            case OpTypeBool:
+            case OpTypeInt:
+            case OpTypeFloat:
+            case OpTypeVector:
+            case OpTypeMatrix:
+            case OpTypeImage:
+            case OpTypeSampler:
+            case OpTypeSampledImage:
+            case OpTypeArray:
+            case OpTypeRuntimeArray:
+            case OpTypeStruct:
+            case OpTypePointer:
+                return Define(instruction[1], op, instruction, wordCount);
+            case OpConstant:
+            case OpSpecConstantTrue:
+            case OpSpecConstantFalse:
+            case OpSpecConstant:
+                if (wordCount < 3 || !Define(instruction[2], op, instruction, wordCount))
+                    return Fail("bad constant");
+                if (op != OpConstant)
+                    m_SpecConstants.push_back(instruction[2]);
+                return true;
+            case OpVariable:
+                if (wordCount < 4 || !Define(instruction[2], op, instruction, wordCount))
+                    return Fail("bad OpVariable");
+                m_Variables.push_back(instruction[2]);
+                return true;
+            default:
+                return true;
+        }
+    }
+
+    bool Define(uint32_t result, uint32_t op, const uint32_t* instruction, uint32_t wordCount) SRK_NOEXCEPT
+    {
+        // every type is given enough words here that the lookups below don't need to check again
+        static constexpr uint32_t minimumWords[] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            2, 4, 3, 4, 4, 9, 2, 3, 4, 3, 2, 0, 4};
+
+        if (!ValidId(result) || (op < std::size(minimumWords) && wordCount < minimumWords[op]))
+            return Fail("bad type declaration");
+
+        m_Ids[result].Instruction = instruction;
+        m_Ids[result].Op          = op;
+        return true;
+    }
+
+    // null for ids that are out of range or never defined
+    const Id* Get(uint32_t id) const SRK_NOEXCEPT
+    {
+        return ValidId(id) && m_Ids[id].Instruction ? &m_Ids[id] : nullptr;
+    }
+
+    uint32_t ConstantValue(uint32_t id) const SRK_NOEXCEPT
+    {
+        const Id* constant = Get(id);
+        return constant && constant->Op == OpConstant && (constant->Instruction[0] >> 16) > 3 ? constant->Instruction[3] : 1;
+    }
+
+    uint32_t TypeSize(uint32_t type, uint32_t matrixStride) const SRK_NOEXCEPT
+    {
+        const Id* id = Get(type);
+        if (!id)
+            return 0;
+
+        const uint32_t* instruction = id->Instruction;
+        switch (id->Op)
+        {
+            case OpTypeBool:
+                return 4;
+            case OpTypeInt:
+            case OpTypeFloat:
+                return instruction[2] / 8;
+            case OpTypeVector:
+                return instruction[3] * TypeSize(instruction[2], 0);
+            case OpTypeMatrix:
+                return instruction[3] * (matrixStride != 0 ? matrixStride : TypeSize(instruction[2], 0));
+            case OpTypeArray:
+                return ConstantValue(instruction[3]) * (id->ArrayStride != 0 ? id->ArrayStride : TypeSize(instruction[2], 0));
+            case OpTypeStruct:
+            {
+                const uint32_t memberCount = (instruction[0] >> 16) - 2;
+                uint32_t       size{0};
+                for (uint32_t member{}; member < memberCount; ++member)
+                {
+                    const Member layout = member < id->Members.size() ? id->Members[member] : Member{};
+                    size                = std::max(size, layout.Offset + TypeSize(instruction[2 + member], layout.MatrixStride));
+                }
+                return size;
+            }
+            default:
+                return 0; // runtime arrays have no size
+        }
+    }
+
+    VkFormat InputFormat(uint32_t type) const SRK_NOEXCEPT
+    {
+        static constexpr VkFormat floats[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+        static constexpr VkFormat sints[]  = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+        static constexpr VkFormat uints[]  = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+
+        const Id* id = Get(type);
+        if (!id)
+            return VK_FORMAT_UNDEFINED;
+
+        uint32_t components{1};
+        if (id->Op == OpTypeVector)
+        {
+            components = id->Instruction[3];
+            id         = Get(id->Instruction[2]);
+        }
+
+        // matrices span several locations and 64 bit inputs need their own formats, neither is used by the engine
+        if (!id || components < 1 || components > 4 || id->Instruction[2] != 32)
+            return VK_FORMAT_UNDEFINED;
+
+        if (id->Op == OpTypeFloat)
+            return floats[components - 1];
+        if (id->Op == OpTypeInt)
+            return id->Instruction[3] ? sints[components - 1] : uints[components - 1];
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    void ReflectBinding(const Id& var, uint32_t storageClass, uint32_t type, VkShaderStageFlagBits stage, ShaderReflection& reflection) const SRK_NOEXCEPT
+    {
+        if (var.Binding == noValue)
+            return;
+
+        DescriptorBinding binding;
+        binding.Set     = var.Set != noValue ? var.Set : 0;
+        binding.Binding = var.Binding;
+        binding.Stages  = stage;
+        binding.Count   = 1;
+
+        const Id* id = Get(type);
+        while (id && (id->Op == OpTypeArray || id->Op == OpTypeRuntimeArray))
+        {
+            if (id->Op == OpTypeArray)
+            {
+                binding.Count *= ConstantValue(id->Instruction[3]);
+            }
+            else
+            {
+                // needs descriptor indexing which the device isn't created with
+                SRK_CORE_WARN("Runtime sized descriptor array at set {} binding {} is bound as a single descriptor", binding.Set, binding.Binding);
+            }
+            id = Get(id->Instruction[2]);
+        }
+
+        if (!id)
+            return;
+
+        if (storageClass == StorageClass_StorageBuffer)
+        {
+            binding.Type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        }
+        else if (storageClass == StorageClass_Uniform)
+        {
+            binding.Type = id->BufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+        else if (id->Op == OpTypeSampledImage)
+        {
+            binding.Type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        }
+        else if (id->Op == OpTypeSampler)
+        {
+            binding.Type = VK_DESCRIPTOR_TYPE_SAMPLER;
+        }
+        else if (id->Op == OpTypeImage)
+        {
+            const uint32_t dim     = id->Instruction[3];
+            const bool     storage = id->Instruction[7] == 2;
+
+            if (dim == dimBuffer)
+                binding.Type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            else if (dim == dimSubpassData)
+                binding.Type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            else
+                binding.Type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        else
+        {
+            SRK_CORE_WARN("Unsupported descriptor at set {} binding {} is skipped", binding.Set, binding.Binding);
+            return;
+        }
+
+        reflection.Bindings.push_back(binding);
+    }
+
+    void ReflectPushConstants(uint32_t type, ShaderReflection& reflection) const SRK_NOEXCEPT
+    {
+        const Id* block = Get(type);
+        if (!block || block->Op != OpTypeStruct)
+            return;
+
+        // a stage only declares the members it uses so the range starts at the first offset
+        uint32_t offset = noValue;
+        for (const Member& member : block->Members)
+            offset = std::min(offset, member.Offset);
+
+        reflection.PushConstantOffset = offset != noValue ? offset : 0;
+        reflection.PushConstantSize   = TypeSize(type, 0) - reflection.PushConstantOffset;
+    }
+
+private:
+    const std::vector<uint32_t>& m_Spirv;
+    std::string&                 m_Log;
+    std::vector<Id>              m_Ids;
+    std::vector<uint32_t>        m_Variables;
+    std::vector<uint32_t>        m_SpecConstants;
+};
+
+} // namespace
+
+bool ReflectSpirv(const std::vector<uint32_t>& spirv, VkShaderStageFlagBits stage, ShaderReflection& reflection, std::string& log) SRK_NOEXCEPT
+{
+    reflection = ShaderReflection{};
+
+    Parser parser(spirv, log);
+    if (!parser.Parse())
+        return false;
+
+    parser.Reflect(stage, reflection);
+    return true;
+}
+
+} // namespace shrek::render::pipeline
@@ -0,0 +1,44 @@
+#pragma once
+#include "defs.h"
+#include "vulkan.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace shrek::render::pipeline {
+
+struct DescriptorBinding
+{
+    uint32_t           Set{0};
+    uint32_t           Binding{0};
+    VkDescriptorType   Type{VK_DESCRIPTOR_TYPE_MAX_ENUM};
+    uint32_t           Count{1};
+    VkShaderStageFlags Stages{0};
+};
+
+struct VertexInput
+{
+    uint32_t Location{0};
+    VkFormat Format{VK_FORMAT_UNDEFINED};
+};
+
+struct SpecializationConstant
+{
+    uint32_t Id{0};
+    uint32_t Size{0};
+};
+
+struct ShaderReflection
+{
+    std::vector<DescriptorBinding>      Bindings; // sorted by set, then binding
+    uint32_t                            PushConstantOffset{0};
+    uint32_t                            PushConstantSize{0}; // 0 without a push constant block
+    std::vector<VertexInput>            Inputs;              // sorted by location, vertex shaders only
+    std::vector<SpecializationConstant> SpecializationConstants;
+};
+
+// walks the SPIR-V once, false (with log filled in) when the module is malformed
+bool ReflectSpirv(const std::vector<uint32_t>& spirv, VkShaderStageFlagBits stage, ShaderReflection& reflection, std::string& log) SRK_NOEXCEPT;
+
+} // namespace shrek::render::pipeline
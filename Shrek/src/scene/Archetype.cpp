@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "Archetype.h"
+
+#include "platform/Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace shrek::scene {
+
+namespace details {
+
+void ChunkDeleter::operator()(std::byte* data) const SRK_NOEXCEPT
+{
+    ::operator delete[](data, std::align_val_t{ChunkAlignment});
+}
+
+} // namespace details
+
+namespace {
+
+constexpr uint32_t alignUp(uint32_t value, uint32_t alignment) SRK_NOEXCEPT
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// lays out every column in the chunk for the given capacity, returns the bytes needed
+uint32_t layoutColumns(ComponentMask mask, uint32_t capacity, std::array<uint32_t, MaxComponents>& offsets) SRK_NOEXCEPT
+{
+    // entity handles come first
+    uint32_t offset = capacity * static_cast<uint32_t>(sizeof(Entity));
+
+    for (ComponentId id{}; id < MaxComponents; ++id)
+    {
+        if ((mask & (ComponentMask{1} << id)) == 0)
+            continue;
+
+        const ComponentInfo& info = GetComponentInfo(id);
+        offset                    = alignUp(offset, info.Alignment);
+        offsets[id]               = offset;
+        offset += info.Size * capacity;
+    }
+
+    return offset;
+}
+
+} // namespace
+
+Archetype::Archetype(ComponentMask mask) SRK_NOEXCEPT :
+    m_Mask(mask),
+    m_Capacity(0),
+    m_Offsets(),
+    m_Chunks(),
+    m_FreeChunks(),
+    m_EntityCount(0)
+{
+    uint32_t rowSize = sizeof(Entity);
+    for (ComponentId id{}; id < MaxComponents; ++id)
+    {
+        if (Contains(id))
+            rowSize += GetComponentInfo(id).Size;
+    }
+
+    // start from the tight estimate and back off until alignment padding fits as well
+    m_Capacity = static_cast<uint32_t>(ChunkSize) / rowSize;
+    while (m_Capacity > 1 && layoutColumns(m_Mask, m_Capacity, m_Offsets) > ChunkSize)
+        --m_Capacity;
+
+    if (m_Capacity == 0 || layoutColumns(m_Mask, m_Capacity, m_Offsets) > ChunkSize)
+    {
+        SRK_CORE_CRITICAL("Archetype {:#x} does not fit a single entity in a {} byte chunk!", m_Mask, ChunkSize);
+        std::exit(-1);
+    }
+}
+
+EntityLocation Archetype::Allocate(Entity entity) SRK_NOEXCEPT
+{
+    if (m_FreeChunks.empty())
+    {
+        Chunk chunk;
+        chunk.Data.reset(static_cast<std::byte*>(::operator new[](ChunkSize, std::align_val_t{ChunkAlignment})));
+        m_FreeChunks.push_back(static_cast<uint32_t>(m_Chunks.size()));
+        m_Chunks.push_back(std::move(chunk));
+    }
+
+    uint32_t chunkIdx = m_FreeChunks.back();
+    Chunk&   chunk    = m_Chunks[chunkIdx];
+    uint32_t row      = chunk.Count++;
+
+    if (chunk.Count == m_Capacity)
+        m_FreeChunks.pop_back();
+
+    GetEntities(chunkIdx)[row] = entity;
+    ++m_EntityCount;
+
+    return EntityLocation{chunkIdx, row};
+}
+
+Entity Archetype::Remove(EntityLocation location) SRK_NOEXCEPT
+{
+    Chunk& chunk = m_Chunks[location.Chunk];
+    SRK_ASSERT(location.Row < chunk.Count, "removing a row that is not alive");
+
+    const bool wasFull = chunk.Count == m_Capacity;
+    uint32_t   last    = --chunk.Count;
+    Entity     moved   = NullEntity;
+
+    if (location.Row != last)
+    {
+        Entity* entities        = GetEntities(location.Chunk);
+        entities[location.Row] = entities[last];
+        moved                  = entities[last];
+
+        for (ComponentId id{}; id < MaxComponents; ++id)
+        {
+            if (!Contains(id))
+                continue;
+
+            const uint32_t size   = GetComponentInfo(id).Size;
+            std::byte*     column = chunk.Data.get() + m_Offsets[id];
+            std::memcpy(column + size * location.Row, column + size * last, size);
+        }
+    }
+
+    if (wasFull)
+        m_FreeChunks.push_back(location.Chunk);
+
+    --m_EntityCount;
+    return moved;
+}
+
+Entity* Archetype::GetEntities(uint32_t chunk) const SRK_NOEXCEPT
+{
+    return reinterpret_cast<Entity*>(m_Chunks[chunk].Data.get());
+}
+
+void* Archetype::GetColumn(uint32_t chunk, ComponentId id) const SRK_NOEXCEPT
+{
+    if (!Contains(id))
+        return nullptr;
+
+    return m_Chunks[chunk].Data.get() + m_Offsets[id];
+}
+
+void* Archetype::GetComponent(EntityLocation location, ComponentId id) const SRK_NOEXCEPT
+{
+    std::byte* column = static_cast<std::byte*>(GetColumn(location.Chunk, id));
+    return column ? column + GetComponentInfo(id).Size * location.Row : nullptr;
+}
+
+} // namespace shrek::scene
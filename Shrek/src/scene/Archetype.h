@@ -0,0 +1,84 @@
+#pragma once
+#include "defs.h"
+#include "Component.h"
+#include "Entity.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace shrek::scene {
+
+constexpr size_t ChunkSize      = 16 * 1024;
+constexpr size_t ChunkAlignment = 64; // cache line
+
+namespace details {
+
+struct ChunkDeleter
+{
+    void operator()(std::byte* data) const SRK_NOEXCEPT;
+};
+
+} // namespace details
+
+/*
+ *  Fixed size block holding `capacity` entities of one archetype.
+ *  Every component gets its own contiguous array (structure of arrays) so a query over a few
+ *  components only touches the memory it reads.
+ */
+struct Chunk
+{
+    std::unique_ptr<std::byte[], details::ChunkDeleter> Data;
+    uint32_t                                            Count{0};
+};
+
+struct EntityLocation
+{
+    uint32_t Chunk;
+    uint32_t Row;
+};
+
+class Archetype
+{
+public:
+    explicit Archetype(ComponentMask mask) SRK_NOEXCEPT;
+
+    Archetype(const Archetype& other) = delete;
+    Archetype& operator=(const Archetype& other) = delete;
+
+    ComponentMask GetMask() const SRK_NOEXCEPT { return m_Mask; }
+    uint32_t      GetCapacity() const SRK_NOEXCEPT { return m_Capacity; }
+    size_t        GetChunkCount() const SRK_NOEXCEPT { return m_Chunks.size(); }
+    size_t        GetEntityCount() const SRK_NOEXCEPT { return m_EntityCount; }
+    const Chunk&  GetChunk(size_t idx) const SRK_NOEXCEPT { return m_Chunks[idx]; }
+
+    bool Contains(ComponentId id) const SRK_NOEXCEPT { return (m_Mask & (ComponentMask{1} << id)) != 0; }
+
+    // new row at the end of the last chunk with space, component memory is left uninitialized
+    EntityLocation Allocate(Entity entity) SRK_NOEXCEPT;
+
+    // moves the last entity of the chunk into the hole, returns the entity that moved or NullEntity
+    Entity Remove(EntityLocation location) SRK_NOEXCEPT;
+
+    Entity* GetEntities(uint32_t chunk) const SRK_NOEXCEPT;
+    void*   GetColumn(uint32_t chunk, ComponentId id) const SRK_NOEXCEPT;
+    void*   GetComponent(EntityLocation location, ComponentId id) const SRK_NOEXCEPT;
+
+    template <typename Type>
+    Type* GetColumn(uint32_t chunk) const SRK_NOEXCEPT
+    {
+        return static_cast<Type*>(GetColumn(chunk, GetComponentId<Type>()));
+    }
+
+private:
+    ComponentMask                         m_Mask;
+    uint32_t                              m_Capacity;
+    std::array<uint32_t, MaxComponents>   m_Offsets; // offset of each component array inside a chunk
+    std::vector<Chunk>                    m_Chunks;
+    std::vector<uint32_t>                 m_FreeChunks; // chunks that are not full
+    size_t                                m_EntityCount;
+};
+
+} // namespace shrek::scene
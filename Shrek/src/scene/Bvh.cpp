@@ -0,0 +1,277 @@
+#include "pch.h"
+#include "Bvh.h"
+
+#include <algorithm>
+
+namespace shrek::scene {
+
+namespace {
+
+// absolute slack added around leaves, objects can move this far before the tree hears about it
+constexpr float fatMargin = 0.1f;
+
+} // namespace
+
+Bvh::Bvh() SRK_NOEXCEPT :
+    m_Nodes(),
+    m_Root(NullProxy),
+    m_FreeList(NullProxy),
+    m_LeafCount(0)
+{
+}
+
+ProxyId Bvh::AllocateNode() SRK_NOEXCEPT
+{
+    if (m_FreeList == NullProxy)
+    {
+        m_Nodes.emplace_back();
+        return static_cast<ProxyId>(m_Nodes.size() - 1);
+    }
+
+    ProxyId node  = m_FreeList;
+    m_FreeList    = m_Nodes[node].Parent;
+    m_Nodes[node] = Node{};
+    return node;
+}
+
+void Bvh::FreeNode(ProxyId node) SRK_NOEXCEPT
+{
+    m_Nodes[node].Parent = m_FreeList;
+    m_Nodes[node].Left   = NullProxy;
+    m_Nodes[node].Right  = NullProxy;
+    m_FreeList           = node;
+}
+
+ProxyId Bvh::Insert(const math::Aabb& box, Entity entity) SRK_NOEXCEPT
+{
+    ProxyId leaf        = AllocateNode();
+    m_Nodes[leaf].Box   = math::Expand(box, fatMargin);
+    m_Nodes[leaf].Owner = entity;
+
+    InsertLeaf(leaf);
+    ++m_LeafCount;
+    return leaf;
+}
+
+void Bvh::Remove(ProxyId proxy) SRK_NOEXCEPT
+{
+    SRK_ASSERT(proxy >= 0 && static_cast<size_t>(proxy) < m_Nodes.size() && m_Nodes[proxy].IsLeaf(), "removing an invalid proxy");
+
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --m_LeafCount;
+}
+
+bool Bvh::Move(ProxyId proxy, const math::Aabb& box) SRK_NOEXCEPT
+{
+    Node& leaf = m_Nodes[proxy];
+    if (math::Contains(leaf.Box, box))
+        return false;
+
+    const math::Aabb fat = math::Expand(box, fatMargin);
+
+    // refitting in place is cheap but stretches the ancestors, so only do it while the object is still near its old spot
+    if (math::Overlaps(leaf.Box, fat))
+    {
+        leaf.Box = fat;
+        Refit(leaf.Parent);
+    }
+    else
+    {
+        RemoveLeaf(proxy);
+        m_Nodes[proxy].Box = fat;
+        InsertLeaf(proxy);
+    }
+
+    return true;
+}
+
+// walks down picking the child that grows the least in surface area (box2d style descent)
+void Bvh::InsertLeaf(ProxyId leaf) SRK_NOEXCEPT
+{
+    if (m_Root == NullProxy)
+    {
+        m_Root               = leaf;
+        m_Nodes[leaf].Parent = NullProxy;
+        return;
+    }
+
+    const math::Aabb leafBox = m_Nodes[leaf].Box;
+
+    ProxyId sibling = m_Root;
+    while (!m_Nodes[sibling].IsLeaf())
+    {
+        const Node& node = m_Nodes[sibling];
+
+        const float area         = node.Box.SurfaceArea();
+        const float combinedArea = math::Merge(node.Box, leafBox).SurfaceArea();
+
+        // cost of making a new parent for this node and the leaf
+        const float cost = 2.f * combinedArea;
+        // cost of pushing the leaf further down
+        const float inheritance = 2.f * (combinedArea - area);
+
+        auto descendCost = [&](ProxyId child) SRK_NOEXCEPT {
+            const math::Aabb merged = math::Merge(m_Nodes[child].Box, leafBox);
+            if (m_Nodes[child].IsLeaf())
+                return merged.SurfaceArea() + inheritance;
+            return merged.SurfaceArea() - m_Nodes[child].Box.SurfaceArea() + inheritance;
+        };
+
+        const float leftCost  = descendCost(node.Left);
+        const float rightCost = descendCost(node.Right);
+
+        if (cost < leftCost && cost < rightCost)
+            break;
+
+        sibling = leftCost < rightCost ? node.Left : node.Right;
+    }
+
+    const ProxyId oldParent = m_Nodes[sibling].Parent;
+    const ProxyId newParent = AllocateNode();
+
+    m_Nodes[newParent].Parent = oldParent;
+    m_Nodes[newParent].Box    = math::Merge(leafBox, m_Nodes[sibling].Box);
+    m_Nodes[newParent].Left   = sibling;
+    m_Nodes[newParent].Right  = leaf;
+    m_Nodes[sibling].Parent   = newParent;
+    m_Nodes[leaf].Parent      = newParent;
+
+    if (oldParent == NullProxy)
+    {
+        m_Root = newParent;
+    }
+    else
+    {
+        if (m_Nodes[oldParent].Left == sibling)
+            m_Nodes[oldParent].Left = newParent;
+        else
+            m_Nodes[oldParent].Right = newParent;
+
+        Refit(oldParent);
+    }
+}
+
+void Bvh::RemoveLeaf(ProxyId leaf) SRK_NOEXCEPT
+{
+    if (leaf == m_Root)
+    {
+        m_Root = NullProxy;
+        return;
+    }
+
+    const ProxyId parent      = m_Nodes[leaf].Parent;
+    const ProxyId grandParent = m_Nodes[parent].Parent;
+    const ProxyId sibling     = m_Nodes[parent].Left == leaf ? m_Nodes[parent].Right : m_Nodes[parent].Left;
+
+    // the sibling takes over the parent's spot
+    if (grandParent == NullProxy)
+    {
+        m_Root                  = sibling;
+        m_Nodes[sibling].Parent = NullProxy;
+    }
+    else
+    {
+        if (m_Nodes[grandParent].Left == parent)
+            m_Nodes[grandParent].Left = sibling;
+        else
+            m_Nodes[grandParent].Right = sibling;
+
+        m_Nodes[sibling].Parent = grandParent;
+        Refit(grandParent);
+    }
+
+    FreeNode(parent);
+    m_Nodes[leaf].Parent = NullProxy;
+}
+
+void Bvh::Refit(ProxyId node) SRK_NOEXCEPT
+{
+    while (node != NullProxy)
+    {
+        Node&            current = m_Nodes[node];
+        const math::Aabb box     = math::Merge(m_Nodes[current.Left].Box, m_Nodes[current.Right].Box);
+
+        if (box.Min.x == current.Box.Min.x && box.Min.y == current.Box.Min.y && box.Min.z == current.Box.Min.z &&
+            box.Max.x == current.Box.Max.x && box.Max.y == current.Box.Max.y && box.Max.z == current.Box.Max.z)
+            break; // nothing above this can change either
+
+        current.Box = box;
+        node        = current.Parent;
+    }
+}
+
+void Bvh::EmitSubtree(ProxyId node, std::pmr::vector<Entity>& visible, std::vector<ProxyId>& stack) const SRK_NOEXCEPT
+{
+    const size_t base = stack.size();
+    stack.push_back(node);
+
+    while (stack.size() > base)
+    {
+        const Node& current = m_Nodes[stack.back()];
+        stack.pop_back();
+
+        if (current.IsLeaf())
+        {
+            visible.push_back(current.Owner);
+        }
+        else
+        {
+            stack.push_back(current.Left);
+            stack.push_back(current.Right);
+        }
+    }
+}
+
+// pops up to a simd batch of nodes at a time and tests them together
+void Bvh::Cull(const math::Frustum& frustum, std::pmr::vector<Entity>& visible) const SRK_NOEXCEPT
+{
+    if (m_Root == NullProxy)
+        return;
+
+    // thread local so that several views can cull at once without allocating every frame
+    thread_local std::vector<ProxyId> stack;
+    stack.clear();
+    stack.push_back(m_Root);
+
+    math::AabbBatch batch;
+    ProxyId         lanes[math::CullBatchWidth];
+
+    while (!stack.empty())
+    {
+        uint32_t count{};
+        while (count < math::CullBatchWidth && !stack.empty())
+        {
+            lanes[count] = stack.back();
+            stack.pop_back();
+            batch.Set(count, m_Nodes[lanes[count]].Box);
+            ++count;
+        }
+
+        const math::CullMask mask = math::TestAabbBatch(frustum, batch, count);
+
+        for (uint32_t lane{}; lane < count; ++lane)
+        {
+            const uint32_t bit = 1u << lane;
+            if ((mask.Visible & bit) == 0)
+                continue;
+
+            const Node& node = m_Nodes[lanes[lane]];
+            if (node.IsLeaf())
+            {
+                visible.push_back(node.Owner);
+            }
+            else if ((mask.Inside & bit) != 0)
+            {
+                EmitSubtree(lanes[lane], visible, stack);
+            }
+            else
+            {
+                stack.push_back(node.Left);
+                stack.push_back(node.Right);
+            }
+        }
+    }
+}
+
+} // namespace shrek::scene
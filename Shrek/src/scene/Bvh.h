@@ -0,0 +1,73 @@
+#pragma once
+#include "defs.h"
+#include "Entity.h"
+#include "base/math/Aabb.h"
+#include "base/math/Frustum.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace shrek::scene {
+
+using ProxyId = int32_t;
+
+constexpr ProxyId NullProxy = -1;
+
+/*
+ *  Dynamic aabb tree over the scene's renderables.
+ *  Leaves store a fattened box so small movements don't touch the tree at all, bigger ones refit the
+ *  ancestors in place and only objects that moved far away get reinserted.
+ *  Culling only descends into nodes that touch the frustum and does not test below nodes that are
+ *  completely inside, so the cost follows what is visible rather than the size of the scene.
+ *  Culling is const and can run for several views at once, changing the tree can not.
+ */
+class Bvh
+{
+public:
+    Bvh() SRK_NOEXCEPT;
+
+    ProxyId Insert(const math::Aabb& box, Entity entity) SRK_NOEXCEPT;
+    void    Remove(ProxyId proxy) SRK_NOEXCEPT;
+
+    // returns false when the box still fits the fat box and nothing changed
+    bool Move(ProxyId proxy, const math::Aabb& box) SRK_NOEXCEPT;
+
+    // appends the entity of every leaf touching the frustum
+    void Cull(const math::Frustum& frustum, std::pmr::vector<Entity>& visible) const SRK_NOEXCEPT;
+
+    Entity            GetEntity(ProxyId proxy) const SRK_NOEXCEPT { return m_Nodes[proxy].Owner; }
+    const math::Aabb& GetFatBox(ProxyId proxy) const SRK_NOEXCEPT { return m_Nodes[proxy].Box; }
+    size_t            GetProxyCount() const SRK_NOEXCEPT { return m_LeafCount; }
+
+private:
+    struct Node
+    {
+        math::Aabb Box;
+        Entity     Owner;
+        ProxyId    Parent{NullProxy}; // doubles as the free list link
+        ProxyId    Left{NullProxy};
+        ProxyId    Right{NullProxy};
+
+        bool IsLeaf() const SRK_NOEXCEPT { return Left == NullProxy; }
+    };
+
+    ProxyId AllocateNode() SRK_NOEXCEPT;
+    void    FreeNode(ProxyId node) SRK_NOEXCEPT;
+
+    void InsertLeaf(ProxyId leaf) SRK_NOEXCEPT;
+    void RemoveLeaf(ProxyId leaf) SRK_NOEXCEPT;
+
+    // recomputes boxes from `node` upwards, stopping early once a box does not change
+    void Refit(ProxyId node) SRK_NOEXCEPT;
+
+    void EmitSubtree(ProxyId node, std::pmr::vector<Entity>& visible, std::vector<ProxyId>& stack) const SRK_NOEXCEPT;
+
+private:
+    std::vector<Node> m_Nodes;
+    ProxyId           m_Root;
+    ProxyId           m_FreeList;
+    size_t            m_LeafCount;
+};
+
+} // namespace shrek::scene
@@ -0,0 +1,40 @@
+#include "pch.h"
+#include "Component.h"
+
+#include "platform/Log.h"
+
+#include <atomic>
+
+namespace shrek::scene {
+
+namespace {
+
+std::array<ComponentInfo, MaxComponents> componentInfos{};
+std::atomic<ComponentId>                 componentCount{0};
+
+} // namespace
+
+namespace details {
+
+ComponentId RegisterComponent(size_t size, size_t alignment) SRK_NOEXCEPT
+{
+    ComponentId id = componentCount.fetch_add(1, std::memory_order_relaxed);
+    if (id >= MaxComponents)
+    {
+        SRK_CORE_CRITICAL("Ran out of component ids, only {} component types are supported!", MaxComponents);
+        std::exit(-1);
+    }
+
+    componentInfos[id] = ComponentInfo{static_cast<uint32_t>(size), static_cast<uint32_t>(alignment)};
+    return id;
+}
+
+} // namespace details
+
+const ComponentInfo& GetComponentInfo(ComponentId id) SRK_NOEXCEPT
+{
+    SRK_ASSERT(id < componentCount.load(std::memory_order_relaxed), "component id was never registered");
+    return componentInfos[id];
+}
+
+} // namespace shrek::scene
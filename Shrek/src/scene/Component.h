@@ -0,0 +1,50 @@
+#pragma once
+#include "defs.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace shrek::scene {
+
+using ComponentId   = uint32_t;
+using ComponentMask = uint64_t;
+
+constexpr ComponentId MaxComponents = 64;
+
+struct ComponentInfo
+{
+    uint32_t Size;
+    uint32_t Alignment;
+};
+
+namespace details {
+
+ComponentId RegisterComponent(size_t size, size_t alignment) SRK_NOEXCEPT;
+
+} // namespace details
+
+const ComponentInfo& GetComponentInfo(ComponentId id) SRK_NOEXCEPT;
+
+/*
+ *  Components are plain data that get memcpy'd around when entities move between chunks,
+ *  anything that owns resources should store a handle instead.
+ */
+template <typename Type>
+ComponentId GetComponentId() SRK_NOEXCEPT
+{
+    static_assert(std::is_trivially_copyable_v<Type> && std::is_trivially_destructible_v<Type>,
+                  "Components have to be plain data as chunks move them with memcpy");
+
+    // function statics are initialized once even when called from multiple threads
+    static const ComponentId id = details::RegisterComponent(sizeof(Type), alignof(Type));
+    return id;
+}
+
+template <typename... Types>
+ComponentMask GetComponentMask() SRK_NOEXCEPT
+{
+    return (ComponentMask{0} | ... | (ComponentMask{1} << GetComponentId<Types>()));
+}
+
+} // namespace shrek::scene
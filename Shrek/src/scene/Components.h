@@ -0,0 +1,77 @@
+#pragma once
+#include "defs.h"
+#include "base/math/Aabb.h"
+#include "base/math/Mat.h"
+#include "base/math/Quat.h"
+#include "base/math/Vec.h"
+
+#include <array>
+#include <cstdint>
+
+// the components that the engine itself knows about
+namespace shrek::scene {
+
+struct Transform
+{
+    math::Vec3 Position{};
+    math::Quat Rotation{};
+    math::Vec3 Scale{1.f};
+};
+
+// written by UpdateTransforms from Transform
+struct WorldTransform
+{
+    math::Mat4 Matrix{};
+};
+
+// object space bounds of the mesh
+struct LocalBounds
+{
+    math::Aabb Box{};
+};
+
+// world space bounds, written by UpdateTransforms from LocalBounds and WorldTransform
+struct Bounds
+{
+    math::Aabb Box{};
+};
+
+// maps straight onto render::DrawKey
+struct Renderable
+{
+    uint32_t Mesh{0};
+    uint32_t Material{0};
+    uint32_t Pipeline{0};
+    uint32_t Pass{0};
+    bool     Transparent{false}; // sorted back to front at full depth precision, opaque draws only by coarse depth so they instance
+};
+
+constexpr uint32_t MaxMeshLods = 8;
+
+// the coarser versions of Renderable::Mesh, lod n is drawn as mesh Renderable::Mesh + n. an Error is the
+// simplification error relative to the mesh's extent like the optimizer reports it, lod 0's is always 0
+struct MeshLods
+{
+    std::array<float, MaxMeshLods> Errors{};
+    uint32_t                       Count{1};
+};
+
+// a light at the translation of the entity's WorldTransform, gathered into the frame packet for ClusteredLighting
+struct PointLight
+{
+    math::Vec3 Color{1.f};
+    float      Radius{1.f}; // nothing past it is lit
+    float      Intensity{1.f};
+};
+
+// leaf of the entity in the scene's Bvh, NullProxy until SyncBvh inserts it
+struct CullProxy
+{
+    int32_t Proxy{-1};
+};
+
+// the batched math kernels work on raw arrays, chunk columns of these are exactly that
+static_assert(sizeof(WorldTransform) == sizeof(math::Mat4) && alignof(WorldTransform) == alignof(math::Mat4));
+static_assert(sizeof(LocalBounds) == sizeof(math::Aabb) && sizeof(Bounds) == sizeof(math::Aabb));
+
+} // namespace shrek::scene
@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "Culling.h"
+#include "Components.h"
+
+#include "base/math/Batch.h"
+
+#include <algorithm>
+
+namespace shrek::scene {
+
+namespace {
+
+// the coarsest lod whose error, scaled by the entity's extent, still projects within what the view allows
+uint32_t selectLod(const MeshLods& lods, float extent, float distance, float lodScale) SRK_NOEXCEPT
+{
+    const float    scale = lodScale * extent / std::max(distance, 1e-3f);
+    const uint32_t count = std::min(lods.Count, MaxMeshLods);
+
+    uint32_t lod = 0;
+    while (lod + 1 < count && lods.Errors[lod + 1] * scale <= 1.f)
+        ++lod;
+    return lod;
+}
+
+void cullView(const World& world, const Bvh& bvh, View& view) SRK_NOEXCEPT
+{
+    // the last cull's results go with the arena, about as much as they took is reserved again
+    const size_t visible   = view.Visible.size();
+    const size_t instances = view.VisibleInstances.size();
+    base::Release(view.Visible);
+    base::Release(view.VisibleInstances);
+    view.Scratch.Reset();
+    view.Visible.reserve(visible);
+    view.VisibleInstances.reserve(instances);
+
+    bvh.Cull(view.Frustum, view.Visible);
+
+    render::RenderQueue& queue = *view.Queue;
+    queue.Clear();
+    queue.Reserve(view.Visible.size());
+
+    // the distances for the depth keys are worked out a simd batch of entities at a time
+    math::AabbBatch   boxes{};
+    float             distances[math::BatchWidth];
+    const Renderable* renderables[math::BatchWidth];
+    const MeshLods*   lods[math::BatchWidth];
+    uint32_t          indices[math::BatchWidth];
+    uint32_t          lanes{};
+
+    auto flush = [&]() {
+        math::CenterDistances(boxes, view.Eye, distances);
+
+        for (uint32_t lane{}; lane < lanes; ++lane)
+        {
+            // opaque draws of the same mesh at different distances have to stay adjacent to become one instanced draw,
+            // the hi-z cull rejects what's hidden anyway so a rough front to back order is all they need
+            const Renderable& renderable = *renderables[lane];
+            const uint32_t    depth      = renderable.Transparent ? render::DrawKey::QuantizeDepth(distances[lane], view.Near, view.Far, true)
+                                                                  : render::DrawKey::CoarsenDepth(render::DrawKey::QuantizeDepth(distances[lane], view.Near, view.Far));
+
+            // the lods of a mesh are meshes of their own, what is far enough away batches with the others of its lod
+            uint32_t mesh = renderable.Mesh;
+            if (lods[lane] && view.LodScale > 0.f)
+            {
+                const math::Aabb box = boxes.Get(lane);
+                mesh += selectLod(*lods[lane], math::Length(box.Max - box.Min), distances[lane], view.LodScale);
+            }
+
+            queue.Push(render::DrawKey::Pack(renderable.Pass, renderable.Pipeline, renderable.Material, depth), mesh, indices[lane]);
+        }
+        lanes = 0;
+    };
+
+    for (Entity entity : view.Visible)
+    {
+        const Renderable* renderable = world.Get<Renderable>(entity);
+        const Bounds*     bounds     = world.Get<Bounds>(entity);
+        if (!renderable || !bounds)
+            continue;
+
+        boxes.Set(lanes, bounds->Box);
+        renderables[lanes] = renderable;
+        lods[lanes]        = world.Get<MeshLods>(entity);
+        indices[lanes]     = entity.Index;
+
+        if (++lanes == math::BatchWidth)
+            flush();
+    }
+
+    if (lanes > 0)
+        flush();
+}
+
+} // namespace
+
+void SyncBvh(World& world, Bvh& bvh) SRK_NOEXCEPT
+{
+    world.Query<Bounds, CullProxy>().Each([&bvh](Entity entity, Bounds& bounds, CullProxy& proxy) {
+        if (proxy.Proxy == NullProxy)
+            proxy.Proxy = bvh.Insert(bounds.Box, entity);
+        else
+            bvh.Move(proxy.Proxy, bounds.Box);
+    });
+}
+
+void ReleaseProxy(World& world, Bvh& bvh, Entity entity) SRK_NOEXCEPT
+{
+    CullProxy* proxy = world.Get<CullProxy>(entity);
+    if (proxy && proxy->Proxy != NullProxy)
+    {
+        bvh.Remove(proxy->Proxy);
+        proxy->Proxy = NullProxy;
+    }
+}
+
+void CullViews(const World& world, const Bvh& bvh, std::vector<View>& views, base::JobSystem& jobs) SRK_NOEXCEPT
+{
+    jobs.ParallelFor(static_cast<uint32_t>(views.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t idx = begin; idx < end; ++idx)
+            cullView(world, bvh, views[idx]);
+    });
+}
+
+void GatherInstances(const World& world, View& view, std::pmr::vector<math::Aabb>& bounds, std::pmr::vector<math::Mat4>& transforms) SRK_NOEXCEPT
+{
+    // the queue only kept entity indices, the rest comes from what the cull saw sorted by index
+    view.VisibleInstances.clear();
+    for (Entity entity : view.Visible)
+    {
+        const Bounds*         box       = world.Get<Bounds>(entity);
+        const WorldTransform* transform = world.Get<WorldTransform>(entity);
+        if (box)
+            view.VisibleInstances.push_back(VisibleInstance{entity.Index, box->Box, transform ? transform->Matrix : math::Mat4::Identity()});
+    }
+    std::sort(view.VisibleInstances.begin(), view.VisibleInstances.end(), [](const VisibleInstance& lhs, const VisibleInstance& rhs) { return lhs.Index < rhs.Index; });
+
+    const std::pmr::vector<uint32_t>& instances = view.Queue->GetInstances();
+    bounds.resize(instances.size());
+    transforms.resize(instances.size());
+    for (size_t idx{}; idx < instances.size(); ++idx)
+    {
+        auto found = std::lower_bound(view.VisibleInstances.begin(), view.VisibleInstances.end(), instances[idx],
+                                      [](const VisibleInstance& entry, uint32_t index) { return entry.Index < index; });
+
+        // pushed by something other than the cull, a huge box always passes the occlusion test
+        if (found == view.VisibleInstances.end() || found->Index != instances[idx])
+        {
+            bounds[idx]     = math::Aabb{math::Vec3{-1e30f, -1e30f, -1e30f}, math::Vec3{1e30f, 1e30f, 1e30f}};
+            transforms[idx] = math::Mat4::Identity();
+        }
+        else
+        {
+            bounds[idx]     = found->Box;
+            transforms[idx] = found->Transform;
+        }
+    }
+}
+
+} // namespace shrek::scene
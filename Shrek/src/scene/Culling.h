@@ -0,0 +1,55 @@
+#pragma once
+#include "defs.h"
+#include "Bvh.h"
+#include "World.h"
+#include "base/Arena.h"
+#include "base/JobSystem.h"
+#include "base/math/Frustum.h"
+#include "base/math/Mat.h"
+#include "render/RenderQueue.h"
+
+#include <memory_resource>
+#include <vector>
+
+namespace shrek::scene {
+
+// what GatherInstances needs of a visible entity
+struct VisibleInstance
+{
+    uint32_t   Index{0}; // of the entity
+    math::Aabb Box;
+    math::Mat4 Transform;
+};
+
+struct View
+{
+    math::Frustum        Frustum;
+    math::Vec3           Eye;
+    float                Near{0.1f};
+    float                Far{1000.f};
+    render::RenderQueue* Queue{nullptr}; // every view records into its own queue
+    float                LodScale{0.f};  // of a world space error at distance 1 to the error allowed on screen, 0 only ever draws lod 0
+
+    // scratch for the cull results, good until the view is culled again which starts the arena over. every view
+    // has its own since views cull on different threads
+    base::Arena                       Scratch;
+    std::pmr::vector<Entity>          Visible{&Scratch};
+    std::pmr::vector<VisibleInstance> VisibleInstances{&Scratch}; // by entity index, for GatherInstances
+};
+
+// inserts/moves the Bvh leaves of every (Bounds, CullProxy) entity, has to run before culling and on one thread
+void SyncBvh(World& world, Bvh& bvh) SRK_NOEXCEPT;
+
+// takes the entity out of the tree, call before World::Destroy
+void ReleaseProxy(World& world, Bvh& bvh, Entity entity) SRK_NOEXCEPT;
+
+// culls every view against the tree in parallel and pushes the visible Renderables into the view's queue, with
+// the lod of their MeshLods that the view's LodScale allows. queues are cleared but not built, so more draws can
+// still be added before RenderQueue::Build.
+void CullViews(const World& world, const Bvh& bvh, std::vector<View>& views, base::JobSystem& jobs) SRK_NOEXCEPT;
+
+// the world space box and transform of every entry of the view's built queue, in RenderQueue::GetInstances()
+// order, for render::OcclusionCuller::Prepare and the draws. only valid until the entities move again
+void GatherInstances(const World& world, View& view, std::pmr::vector<math::Aabb>& bounds, std::pmr::vector<math::Mat4>& transforms) SRK_NOEXCEPT;
+
+} // namespace shrek::scene
@@ -0,0 +1,22 @@
+#pragma once
+#include "defs.h"
+
+#include <cstdint>
+
+namespace shrek::scene {
+
+// index into the world's entity records, generation catches handles to destroyed entities
+struct Entity
+{
+    uint32_t Index{~0u};
+    uint32_t Generation{0};
+
+    constexpr bool operator==(const Entity& other) const SRK_NOEXCEPT { return Index == other.Index && Generation == other.Generation; }
+    constexpr bool operator!=(const Entity& other) const SRK_NOEXCEPT { return !(*this == other); }
+
+    constexpr bool IsNull() const SRK_NOEXCEPT { return Index == ~0u; }
+};
+
+constexpr Entity NullEntity{};
+
+} // namespace shrek::scene
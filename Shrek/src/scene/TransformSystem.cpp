@@ -0,0 +1,70 @@
+#include "pch.h"
+#include "TransformSystem.h"
+#include "Components.h"
+
+#include "base/math/Batch.h"
+
+#include <algorithm>
+
+namespace shrek::scene {
+
+namespace {
+
+// the rows of a chunk go through the structure of arrays kernels BatchWidth at a time. unused lanes of a short
+// last batch still hold the previous batch and are never scattered back
+void composeChunk(const Transform* transforms, WorldTransform* matrices, uint32_t count) SRK_NOEXCEPT
+{
+    math::TransformBatch batch{};
+    math::Mat4Batch      composed;
+
+    for (uint32_t first{}; first < count; first += math::BatchWidth)
+    {
+        const uint32_t lanes = std::min(count - first, math::BatchWidth);
+        for (uint32_t lane{}; lane < lanes; ++lane)
+        {
+            const Transform& transform = transforms[first + lane];
+            batch.Set(lane, transform.Position, transform.Rotation, transform.Scale);
+        }
+
+        math::ComposeTransforms(batch, composed);
+
+        for (uint32_t lane{}; lane < lanes; ++lane)
+            matrices[first + lane].Matrix = composed.Get(lane);
+    }
+}
+
+void boundChunk(const WorldTransform* matrices, const LocalBounds* local, Bounds* bounds, uint32_t count) SRK_NOEXCEPT
+{
+    math::Mat4Batch matrixBatch{};
+    math::AabbBatch boxBatch{};
+
+    for (uint32_t first{}; first < count; first += math::BatchWidth)
+    {
+        const uint32_t lanes = std::min(count - first, math::BatchWidth);
+        for (uint32_t lane{}; lane < lanes; ++lane)
+        {
+            matrixBatch.Set(lane, matrices[first + lane].Matrix);
+            boxBatch.Set(lane, local[first + lane].Box);
+        }
+
+        math::TransformAabbs(matrixBatch, boxBatch, boxBatch);
+
+        for (uint32_t lane{}; lane < lanes; ++lane)
+            bounds[first + lane].Box = boxBatch.Get(lane);
+    }
+}
+
+} // namespace
+
+void UpdateTransforms(World& world, base::JobSystem& jobs) SRK_NOEXCEPT
+{
+    world.Query<Transform, WorldTransform>().ParallelEachChunk(jobs, [](const ChunkView<Transform, WorldTransform>& view) {
+        composeChunk(view.Get<Transform>(), view.Get<WorldTransform>(), view.Count);
+    });
+
+    world.Query<WorldTransform, LocalBounds, Bounds>().ParallelEachChunk(jobs, [](const ChunkView<WorldTransform, LocalBounds, Bounds>& view) {
+        boundChunk(view.Get<WorldTransform>(), view.Get<LocalBounds>(), view.Get<Bounds>(), view.Count);
+    });
+}
+
+} // namespace shrek::scene
@@ -0,0 +1,11 @@
+#pragma once
+#include "defs.h"
+#include "World.h"
+#include "base/JobSystem.h"
+
+namespace shrek::scene {
+
+// Transform -> WorldTransform, then (WorldTransform, LocalBounds) -> Bounds, chunk by chunk on the workers
+void UpdateTransforms(World& world, base::JobSystem& jobs) SRK_NOEXCEPT;
+
+} // namespace shrek::scene
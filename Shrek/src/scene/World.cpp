@@ -0,0 +1,135 @@
+#include "pch.h"
+#include "World.h"
+
+#include "platform/Log.h"
+
+namespace shrek::scene {
+
+World::World() SRK_NOEXCEPT :
+    m_Archetypes(),
+    m_ArchetypeLookup(),
+    m_Records(),
+    m_FreeRecords(),
+    m_AliveCount(0)
+{
+}
+
+World::~World() SRK_NOEXCEPT = default;
+
+Entity World::CreateEntity(ComponentMask mask) SRK_NOEXCEPT
+{
+    uint32_t index{};
+    if (!m_FreeRecords.empty())
+    {
+        index = m_FreeRecords.back();
+        m_FreeRecords.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_Records.size());
+        m_Records.emplace_back();
+    }
+
+    EntityRecord& record = m_Records[index];
+    Entity        entity{index, record.Generation};
+
+    record.Owner = &GetOrCreateArchetype(mask);
+    record.Location  = record.Owner->Allocate(entity);
+
+    ++m_AliveCount;
+    return entity;
+}
+
+void World::Destroy(Entity entity) SRK_NOEXCEPT
+{
+    if (!IsAlive(entity))
+    {
+        SRK_CORE_WARN("Trying to destroy an entity that is not alive ({}, {})", entity.Index, entity.Generation);
+        return;
+    }
+
+    EntityRecord& record = m_Records[entity.Index];
+    RemoveFromArchetype(record);
+
+    record.Owner = nullptr;
+    ++record.Generation; // any handles left around are now stale
+    m_FreeRecords.push_back(entity.Index);
+    --m_AliveCount;
+}
+
+bool World::IsAlive(Entity entity) const SRK_NOEXCEPT
+{
+    return entity.Index < m_Records.size() &&
+           m_Records[entity.Index].Generation == entity.Generation &&
+           m_Records[entity.Index].Owner != nullptr;
+}
+
+Archetype& World::GetOrCreateArchetype(ComponentMask mask) SRK_NOEXCEPT
+{
+    auto iter = m_ArchetypeLookup.find(mask);
+    if (iter != m_ArchetypeLookup.end())
+        return *m_Archetypes[iter->second];
+
+    m_ArchetypeLookup.emplace(mask, m_Archetypes.size());
+    m_Archetypes.push_back(std::make_unique<Archetype>(mask));
+    return *m_Archetypes.back();
+}
+
+ComponentMask World::GetMask(Entity entity) const SRK_NOEXCEPT
+{
+    return IsAlive(entity) ? m_Records[entity.Index].Owner->GetMask() : 0;
+}
+
+void World::ChangeArchetype(Entity entity, ComponentMask mask) SRK_NOEXCEPT
+{
+    if (!IsAlive(entity))
+    {
+        SRK_CORE_WARN("Trying to change the components of an entity that is not alive ({}, {})", entity.Index, entity.Generation);
+        return;
+    }
+
+    EntityRecord& record = m_Records[entity.Index];
+    Archetype*    from   = record.Owner;
+    if (from->GetMask() == mask)
+        return;
+
+    Archetype&     to       = GetOrCreateArchetype(mask);
+    EntityLocation location = to.Allocate(entity);
+
+    // carry over whatever both archetypes share
+    const ComponentMask shared = from->GetMask() & mask;
+    for (ComponentId id{}; id < MaxComponents; ++id)
+    {
+        if ((shared & (ComponentMask{1} << id)) != 0)
+            std::memcpy(to.GetComponent(location, id), from->GetComponent(record.Location, id), GetComponentInfo(id).Size);
+    }
+
+    RemoveFromArchetype(record);
+    record.Owner = &to;
+    record.Location  = location;
+}
+
+void* World::GetComponent(Entity entity, ComponentId id) const SRK_NOEXCEPT
+{
+    if (!IsAlive(entity))
+        return nullptr;
+
+    const EntityRecord& record = m_Records[entity.Index];
+    return record.Owner->GetComponent(record.Location, id);
+}
+
+void World::SetComponent(Entity entity, ComponentId id, const void* data) SRK_NOEXCEPT
+{
+    void* component = GetComponent(entity, id);
+    if (component)
+        std::memcpy(component, data, GetComponentInfo(id).Size);
+}
+
+void World::RemoveFromArchetype(EntityRecord& record) SRK_NOEXCEPT
+{
+    Entity moved = record.Owner->Remove(record.Location);
+    if (!moved.IsNull())
+        m_Records[moved.Index].Location = record.Location;
+}
+
+} // namespace shrek::scene
@@ -0,0 +1,251 @@
+#pragma once
+#include "defs.h"
+#include "Archetype.h"
+#include "Component.h"
+#include "Entity.h"
+#include "base/Arena.h"
+#include "base/JobSystem.h"
+
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace shrek::scene {
+
+class World;
+
+// contiguous view over one chunk, every pointer is an array of Count elements
+template <typename... Types>
+struct ChunkView
+{
+    const Entity*           Entities;
+    std::tuple<Types*...>   Columns;
+    uint32_t                Count;
+
+    template <typename Type>
+    Type* Get() const SRK_NOEXCEPT { return std::get<Type*>(Columns); }
+};
+
+/*
+ *  Matches every archetype that has at least the requested components.
+ *  Iteration walks chunk by chunk so the inner loops only see contiguous arrays.
+ *  Structural changes (create/destroy/add/remove) are not allowed while iterating.
+ */
+template <typename... Types>
+class Query
+{
+public:
+    explicit Query(World& world) SRK_NOEXCEPT;
+
+    // fn(const ChunkView<Types...>&)
+    template <typename Function>
+    void EachChunk(Function&& fn) const SRK_NOEXCEPT;
+
+    // fn(Entity, Types&...)
+    template <typename Function>
+    void Each(Function&& fn) const SRK_NOEXCEPT;
+
+    // chunks are handed out to the workers, fn has to be safe to call from multiple threads at once
+    template <typename Function>
+    void ParallelEachChunk(base::JobSystem& jobs, Function&& fn) const SRK_NOEXCEPT;
+
+    template <typename Function>
+    void ParallelEach(base::JobSystem& jobs, Function&& fn) const SRK_NOEXCEPT;
+
+    size_t Count() const SRK_NOEXCEPT;
+
+private:
+    ChunkView<Types...> MakeView(const Archetype& archetype, uint32_t chunk) const SRK_NOEXCEPT;
+
+    // (archetype, chunk) pairs that have entities in them
+    void CollectChunks(std::pmr::vector<std::pair<const Archetype*, uint32_t>>& chunks) const SRK_NOEXCEPT;
+
+private:
+    World&        m_World;
+    ComponentMask m_Mask;
+};
+
+class World
+{
+public:
+    World() SRK_NOEXCEPT;
+    ~World() SRK_NOEXCEPT;
+
+    World(const World& other) = delete;
+    World& operator=(const World& other) = delete;
+
+    template <typename... Types>
+    Entity Create(const Types&... components) SRK_NOEXCEPT
+    {
+        Entity entity = CreateEntity(GetComponentMask<Types...>());
+        (SetComponent(entity, GetComponentId<Types>(), &components), ...);
+        return entity;
+    }
+
+    void Destroy(Entity entity) SRK_NOEXCEPT;
+    bool IsAlive(Entity entity) const SRK_NOEXCEPT;
+
+    template <typename Type>
+    Type* Get(Entity entity) const SRK_NOEXCEPT
+    {
+        return static_cast<Type*>(GetComponent(entity, GetComponentId<Type>()));
+    }
+
+    template <typename Type>
+    bool Has(Entity entity) const SRK_NOEXCEPT
+    {
+        return GetComponent(entity, GetComponentId<Type>()) != nullptr;
+    }
+
+    // moves the entity into the archetype with the extra component
+    template <typename Type>
+    void Add(Entity entity, const Type& component) SRK_NOEXCEPT
+    {
+        ComponentId id = GetComponentId<Type>();
+        ChangeArchetype(entity, GetMask(entity) | (ComponentMask{1} << id));
+        SetComponent(entity, id, &component);
+    }
+
+    template <typename Type>
+    void Remove(Entity entity) SRK_NOEXCEPT
+    {
+        ChangeArchetype(entity, GetMask(entity) & ~(ComponentMask{1} << GetComponentId<Type>()));
+    }
+
+    template <typename... Types>
+    scene::Query<Types...> Query() SRK_NOEXCEPT
+    {
+        return scene::Query<Types...>(*this);
+    }
+
+    size_t GetEntityCount() const SRK_NOEXCEPT { return m_AliveCount; }
+
+    const std::vector<std::unique_ptr<Archetype>>& GetArchetypes() const SRK_NOEXCEPT { return m_Archetypes; }
+
+private:
+    struct EntityRecord
+    {
+        Archetype*     Owner{nullptr};
+        EntityLocation Location{};
+        uint32_t       Generation{0};
+    };
+
+    Entity        CreateEntity(ComponentMask mask) SRK_NOEXCEPT;
+    Archetype&    GetOrCreateArchetype(ComponentMask mask) SRK_NOEXCEPT;
+    ComponentMask GetMask(Entity entity) const SRK_NOEXCEPT;
+    void          ChangeArchetype(Entity entity, ComponentMask mask) SRK_NOEXCEPT;
+    void*         GetComponent(Entity entity, ComponentId id) const SRK_NOEXCEPT;
+    void          SetComponent(Entity entity, ComponentId id, const void* data) SRK_NOEXCEPT;
+
+    // fixes up the record of the entity that got swapped into a removed row
+    void RemoveFromArchetype(EntityRecord& record) SRK_NOEXCEPT;
+
+private:
+    std::vector<std::unique_ptr<Archetype>>    m_Archetypes;
+    std::unordered_map<ComponentMask, size_t>  m_ArchetypeLookup;
+    std::vector<EntityRecord>                  m_Records;
+    std::vector<uint32_t>                      m_FreeRecords;
+    size_t                                     m_AliveCount;
+};
+
+template <typename... Types>
+Query<Types...>::Query(World& world) SRK_NOEXCEPT :
+    m_World(world),
+    m_Mask(GetComponentMask<Types...>())
+{
+}
+
+template <typename... Types>
+ChunkView<Types...> Query<Types...>::MakeView(const Archetype& archetype, uint32_t chunk) const SRK_NOEXCEPT
+{
+    return ChunkView<Types...>{
+        archetype.GetEntities(chunk),
+        std::tuple<Types*...>(archetype.template GetColumn<Types>(chunk)...),
+        archetype.GetChunk(chunk).Count};
+}
+
+template <typename... Types>
+template <typename Function>
+void Query<Types...>::EachChunk(Function&& fn) const SRK_NOEXCEPT
+{
+    for (const auto& archetype : m_World.GetArchetypes())
+    {
+        if ((archetype->GetMask() & m_Mask) != m_Mask)
+            continue;
+
+        for (uint32_t chunk{}; chunk < archetype->GetChunkCount(); ++chunk)
+        {
+            if (archetype->GetChunk(chunk).Count != 0)
+                fn(MakeView(*archetype, chunk));
+        }
+    }
+}
+
+template <typename... Types>
+template <typename Function>
+void Query<Types...>::Each(Function&& fn) const SRK_NOEXCEPT
+{
+    EachChunk([&fn](const ChunkView<Types...>& view) {
+        for (uint32_t row{}; row < view.Count; ++row)
+            fn(view.Entities[row], std::get<Types*>(view.Columns)[row]...);
+    });
+}
+
+template <typename... Types>
+void Query<Types...>::CollectChunks(std::pmr::vector<std::pair<const Archetype*, uint32_t>>& chunks) const SRK_NOEXCEPT
+{
+    for (const auto& archetype : m_World.GetArchetypes())
+    {
+        if ((archetype->GetMask() & m_Mask) != m_Mask)
+            continue;
+
+        for (uint32_t chunk{}; chunk < archetype->GetChunkCount(); ++chunk)
+        {
+            if (archetype->GetChunk(chunk).Count != 0)
+                chunks.emplace_back(archetype.get(), chunk);
+        }
+    }
+}
+
+template <typename... Types>
+template <typename Function>
+void Query<Types...>::ParallelEachChunk(base::JobSystem& jobs, Function&& fn) const SRK_NOEXCEPT
+{
+    // called every frame, the list lives in scratch memory instead of the heap
+    base::ScratchScope                                      scratch;
+    std::pmr::vector<std::pair<const Archetype*, uint32_t>> chunks(scratch.Resource());
+    CollectChunks(chunks);
+
+    // a chunk is already a decent amount of work so a few chunks per job is enough
+    constexpr uint32_t chunksPerJob = 4;
+    jobs.ParallelFor(static_cast<uint32_t>(chunks.size()), chunksPerJob, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t idx = begin; idx < end; ++idx)
+            fn(MakeView(*chunks[idx].first, chunks[idx].second));
+    });
+}
+
+template <typename... Types>
+template <typename Function>
+void Query<Types...>::ParallelEach(base::JobSystem& jobs, Function&& fn) const SRK_NOEXCEPT
+{
+    ParallelEachChunk(jobs, [&fn](const ChunkView<Types...>& view) {
+        for (uint32_t row{}; row < view.Count; ++row)
+            fn(view.Entities[row], std::get<Types*>(view.Columns)[row]...);
+    });
+}
+
+template <typename... Types>
+size_t Query<Types...>::Count() const SRK_NOEXCEPT
+{
+    size_t count{};
+    for (const auto& archetype : m_World.GetArchetypes())
+    {
+        if ((archetype->GetMask() & m_Mask) == m_Mask)
+            count += archetype->GetEntityCount();
+    }
+    return count;
+}
+
+} // namespace shrek::scene
@@ -0,0 +1,158 @@
+#include "base/math/Batch.h"
+#include "base/math/Simd.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace shrek::math;
+
+namespace {
+
+constexpr size_t elementCount = 1 << 16;
+constexpr int    iterations   = 200;
+
+template <typename Function>
+double nanosecondsPerElement(Function&& fn)
+{
+    // warm up caches and clocks before timing
+    fn();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int iter{}; iter < iterations; ++iter)
+        fn();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(iterations) * elementCount);
+}
+
+Mat4 randomMatrix(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-10.f, 10.f);
+    Quat rotation = Normalize(Quat{dist(rng), dist(rng), dist(rng), dist(rng)});
+    return Mat4::FromTRS(Vec3{dist(rng), dist(rng), dist(rng)}, rotation, Vec3{std::fabs(dist(rng)) + 0.1f});
+}
+
+Aabb randomAabb(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-10.f, 10.f);
+    Vec3 a{dist(rng), dist(rng), dist(rng)};
+    Vec3 b{dist(rng), dist(rng), dist(rng)};
+    return Aabb{Min(a, b), Max(a, b)};
+}
+
+bool nearlyEqual(const float* a, const float* b, size_t count)
+{
+    for (size_t idx{}; idx < count; ++idx)
+    {
+        if (std::fabs(a[idx] - b[idx]) > 1e-3f * (1.f + std::fabs(a[idx])))
+            return false;
+    }
+    return true;
+}
+
+void report(const char* name, double scalarNs, double simdNs, bool matches)
+{
+    std::printf("%-24s scalar %7.2f ns  %-6s %7.2f ns  x%.2f %s\n",
+                name, scalarNs, SRK_SIMD_NAME, simdNs, scalarNs / simdNs, matches ? "" : "(MISMATCH)");
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 rng(1337);
+
+    std::vector<Mat4> lhs(elementCount), rhs(elementCount), scalarOut(elementCount), simdOut(elementCount);
+    std::vector<Aabb> boxes(elementCount), scalarBoxes(elementCount), simdBoxes(elementCount);
+
+    for (size_t idx{}; idx < elementCount; ++idx)
+    {
+        lhs[idx]   = randomMatrix(rng);
+        rhs[idx]   = randomMatrix(rng);
+        boxes[idx] = randomAabb(rng);
+    }
+
+    std::printf("%zu elements, %d iterations, simd path: %s\n", elementCount, iterations, SRK_SIMD_NAME);
+
+    {
+        double scalarNs = nanosecondsPerElement([&]() { scalar::MultiplyMatrices(lhs.data(), rhs.data(), scalarOut.data(), elementCount); });
+        double simdNs   = nanosecondsPerElement([&]() { MultiplyMatrices(lhs.data(), rhs.data(), simdOut.data(), elementCount); });
+        report("MultiplyMatrices", scalarNs, simdNs, nearlyEqual(&scalarOut[0][0].x, &simdOut[0][0].x, elementCount * 16));
+    }
+
+    {
+        const Mat4 parent = randomMatrix(rng);
+
+        double scalarNs = nanosecondsPerElement([&]() { scalar::MultiplyMatrices(parent, rhs.data(), scalarOut.data(), elementCount); });
+        double simdNs   = nanosecondsPerElement([&]() { MultiplyMatrices(parent, rhs.data(), simdOut.data(), elementCount); });
+        report("MultiplyMatrices(parent)", scalarNs, simdNs, nearlyEqual(&scalarOut[0][0].x, &simdOut[0][0].x, elementCount * 16));
+    }
+
+    {
+        double scalarNs = nanosecondsPerElement([&]() { scalar::TransformAabbs(lhs.data(), boxes.data(), scalarBoxes.data(), elementCount); });
+        double simdNs   = nanosecondsPerElement([&]() { TransformAabbs(lhs.data(), boxes.data(), simdBoxes.data(), elementCount); });
+        report("TransformAabbs", scalarNs, simdNs, nearlyEqual(&scalarBoxes[0].Min.x, &simdBoxes[0].Min.x, elementCount * 6));
+    }
+
+    // structure of arrays kernels, elementCount elements in BatchWidth wide batches
+    constexpr size_t batchCount = elementCount / BatchWidth;
+
+    std::vector<TransformBatch> trs(batchCount);
+    std::vector<Mat4Batch>      scalarMatrices(batchCount), simdMatrices(batchCount);
+    std::vector<AabbBatch>      boxBatches(batchCount), scalarBoxBatches(batchCount), simdBoxBatches(batchCount);
+
+    std::uniform_real_distribution<float> dist(-10.f, 10.f);
+    for (size_t idx{}; idx < batchCount; ++idx)
+    {
+        for (uint32_t lane{}; lane < BatchWidth; ++lane)
+        {
+            Quat rotation = Normalize(Quat{dist(rng), dist(rng), dist(rng), dist(rng)});
+            trs[idx].Set(lane, Vec3{dist(rng), dist(rng), dist(rng)}, rotation, Vec3{std::fabs(dist(rng)) + 0.1f});
+            boxBatches[idx].Set(lane, boxes[idx * BatchWidth + lane]);
+        }
+    }
+
+    {
+        double scalarNs = nanosecondsPerElement([&]() {
+            for (size_t idx{}; idx < batchCount; ++idx)
+                scalar::ComposeTransforms(trs[idx], scalarMatrices[idx]);
+        });
+        double simdNs = nanosecondsPerElement([&]() {
+            for (size_t idx{}; idx < batchCount; ++idx)
+                ComposeTransforms(trs[idx], simdMatrices[idx]);
+        });
+        report("ComposeTransforms(soa)", scalarNs, simdNs, nearlyEqual(&scalarMatrices[0].Elements[0][0], &simdMatrices[0].Elements[0][0], elementCount * 16));
+    }
+
+    {
+        double scalarNs = nanosecondsPerElement([&]() {
+            for (size_t idx{}; idx < batchCount; ++idx)
+                scalar::TransformAabbs(scalarMatrices[idx], boxBatches[idx], scalarBoxBatches[idx]);
+        });
+        double simdNs = nanosecondsPerElement([&]() {
+            for (size_t idx{}; idx < batchCount; ++idx)
+                TransformAabbs(scalarMatrices[idx], boxBatches[idx], simdBoxBatches[idx]);
+        });
+        report("TransformAabbs(soa)", scalarNs, simdNs, nearlyEqual(&scalarBoxBatches[0].CenterX[0], &simdBoxBatches[0].CenterX[0], elementCount * 6));
+    }
+
+    {
+        const Vec3         eye{dist(rng), dist(rng), dist(rng)};
+        std::vector<float> scalarDistances(elementCount), simdDistances(elementCount);
+
+        double scalarNs = nanosecondsPerElement([&]() {
+            for (size_t idx{}; idx < batchCount; ++idx)
+                scalar::CenterDistances(boxBatches[idx], eye, &scalarDistances[idx * BatchWidth]);
+        });
+        double simdNs = nanosecondsPerElement([&]() {
+            for (size_t idx{}; idx < batchCount; ++idx)
+                CenterDistances(boxBatches[idx], eye, &simdDistances[idx * BatchWidth]);
+        });
+        report("CenterDistances(soa)", scalarNs, simdNs, nearlyEqual(scalarDistances.data(), simdDistances.data(), elementCount));
+    }
+
+    return 0;
+}
@@ -1,5 +1,17 @@
 require "vendor/export-compile-commands"
 
+newoption {
+	trigger = "simd",
+	value = "ISA",
+	description = "Instruction set used by the base/math kernels",
+	allowed = {
+		{ "scalar", "No intrinsics" },
+		{ "sse", "SSE2" },
+		{ "avx2", "AVX2 (default)" }
+	},
+	default = "avx2"
+}
+
 workspace "Shrek"
 	architecture "x86_64"
 	startproject "Shrek"
@@ -14,6 +26,17 @@ workspace "Shrek"
 		"MultiProcessorCompile"
 	}
 
+	--compile time dispatch for base/math/Simd.h
+	filter "options:simd=sse"
+		defines { "SRK_SIMD_SSE" }
+		vectorextensions "SSE2"
+
+	filter "options:simd=avx2"
+		defines { "SRK_SIMD_AVX2" }
+		vectorextensions "AVX2"
+
+	filter {}
+
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
 -- Include directories relative to root folder (solution directory)
@@ -25,6 +48,9 @@ IncludeDir["glslang"] = "%{wks.location}/Shrek/vendor/vulkan/include/glslang"
 IncludeDir["GLFW"] = "%{wks.location}/Shrek/vendor/glfw/include"
 IncludeDir["spdlog"] = "%{wks.location}/Shrek/vendor/spdlog/include"
 
+--the vendored vulkan libraries are windows only, linux links the loader and glslang of the installed sdk
+VulkanSdk = os.getenv("VULKAN_SDK")
+
 --for grouping projects in the future
 group "Dependencies"
 	warnings "Off"
@@ -58,32 +84,94 @@ project "Shrek"
 		--"%{IncludeDir.ImGuizmo}",
         "%{IncludeDir.GLFW}",
 		"%{IncludeDir.spdlog}",
+		"%{IncludeDir.glslang}",
 		"%{prj.name}/src"
 	}
 
-	syslibdirs {
-		"%{wks.location}/Shrek/vendor/vulkan/lib"
-	}
-
 	 links {
-         "GLFW",
+         "GLFW"
 		--"ImGui",
-		"glslang.lib",
-		"vulkan-1.lib"
 	 }
 
 	warnings "Extra"
 
 	defines {
-        "VK_PROTOTYPES",
-        "VK_USE_PLATFORM_WIN32_KHR",
-		"NOMINMAX"
+        "VK_PROTOTYPES"
 	}
 
 	--defines for msvc compiler
 	filter "system:windows"
 		systemversion "latest"
-		defines { "WIN32", "_CRT_SECURE_NO_WARNINGS" }
+		defines { "WIN32", "_CRT_SECURE_NO_WARNINGS", "VK_USE_PLATFORM_WIN32_KHR", "NOMINMAX" }
+		syslibdirs { "%{wks.location}/Shrek/vendor/vulkan/lib" }
+		links {
+			"glslang.lib",
+			"SPIRV.lib",
+			"glslang-default-resource-limits.lib",
+			"vulkan-1.lib"
+		}
+
+	--x11 and wayland both go through glfw, which creates the surface so nothing needs VK_USE_PLATFORM_*_KHR
+	filter "system:linux"
+		links {
+			"glslang",
+			"SPIRV",
+			"glslang-default-resource-limits",
+			"vulkan",
+			"dl",
+			"pthread",
+			"rt"
+		}
+
+	--the sdk's libraries when VULKAN_SDK is set, the system ones otherwise
+	if VulkanSdk then
+		filter "system:linux"
+			syslibdirs { VulkanSdk .. "/lib" }
+	end
+
+	filter {}
+
+	--frame pointers so perf can walk the stacks without dwarf unwinding
+	filter { "system:linux", "configurations:not Dist" }
+		buildoptions { "-fno-omit-frame-pointer" }
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines { "SRK_DIST" }
+		runtime "Release"
+		optimize "on"
+
+--microbenchmarks for the base/math kernels against their scalar versions
+project "ShrekBench"
+	location "ShrekBench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files {
+		"%{prj.name}/src/**.cpp",
+		"Shrek/src/base/math/**.cpp",
+		"Shrek/src/base/math/**.h"
+	}
+
+	includedirs {
+		"Shrek/src"
+	}
+
+	warnings "Extra"
+
+	filter "system:windows"
+		systemversion "latest"
 
 	filter "configurations:Debug"
 		runtime "Debug"
@@ -0,0 +1,6 @@
+#!/bin/sh
+# links compile_commands.json to the debug, release or dist build
+set -e
+cd "$(dirname "$0")/.."
+echo "linking compile_commands.json to $1 build"
+ln -sf "compile_commands/$1.json" compile_commands.json
@@ -0,0 +1,7 @@
+#!/bin/sh
+# makefiles for the linux build, then build with e.g. make config=release -j$(nproc)
+# premake5 has to be on the PATH, vendor/premake only carries the windows binary
+set -e
+cd "$(dirname "$0")/.."
+premake5 gmake2
+premake5 export-compile-commands
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+# writes Shrek/assets/mesh/TestScene.glb and Shrek/assets/texture/Checker.png, what the engine builds its test
+# scene from. a uv sphere and a unit box with positions, normals and uvs with 16 bit indices, and a 1024x1024
+# checker with a tint that changes across it so the streamed mips are easy to tell apart. run from the repository root
+import json
+import math
+import os
+import struct
+import zlib
+
+
+def sphere(rings=16, segments=32, radius=0.5):
+    positions, normals, uvs, indices = [], [], [], []
+    for ring in range(rings + 1):
+        v = ring / rings
+        theta = v * math.pi
+        for segment in range(segments + 1):
+            u = segment / segments
+            phi = u * 2.0 * math.pi
+            n = (math.sin(theta) * math.cos(phi), math.cos(theta), math.sin(theta) * math.sin(phi))
+            normals.append(n)
+            positions.append(tuple(radius * c for c in n))
+            uvs.append((u, v))
+    for ring in range(rings):
+        for segment in range(segments):
+            a = ring * (segments + 1) + segment
+            b = a + segments + 1
+            indices += [a, a + 1, b, a + 1, b + 1, b]
+    return positions, normals, uvs, indices
+
+
+def box(half=0.5):
+    positions, normals, uvs, indices = [], [], [], []
+    for axis in range(3):
+        for sign in (-1.0, 1.0):
+            n = [0.0, 0.0, 0.0]
+            n[axis] = sign
+            u_axis, v_axis = (axis + 1) % 3, (axis + 2) % 3
+            if sign < 0:
+                u_axis, v_axis = v_axis, u_axis
+            base = len(positions)
+            for corner in ((0, 0), (1, 0), (1, 1), (0, 1)):
+                p = [0.0, 0.0, 0.0]
+                p[axis] = sign * half
+                p[u_axis] = (corner[0] * 2 - 1) * half
+                p[v_axis] = (corner[1] * 2 - 1) * half
+                positions.append(tuple(p))
+                normals.append(tuple(n))
+                uvs.append(corner)
+            indices += [base, base + 1, base + 2, base, base + 2, base + 3]
+    return positions, normals, uvs, indices
+
+
+def checker(size=1024, tiles=16):
+    rows = bytearray()
+    for y in range(size):
+        rows.append(0)  # no filter
+        for x in range(size):
+            light = ((x * tiles // size) + (y * tiles // size)) % 2 == 0
+            base = 230 if light else 60
+            rows += bytes((base, int(base * (0.6 + 0.4 * x / size)), int(base * (0.6 + 0.4 * y / size))))
+
+    def chunk(kind, data):
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data) & 0xFFFFFFFF)
+
+    header = struct.pack(">IIBBBBB", size, size, 8, 2, 0, 0, 0)
+    return b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", header) + chunk(b"IDAT", zlib.compress(bytes(rows), 9)) + chunk(b"IEND", b"")
+
+
+def main():
+    texture = os.path.join("Shrek", "assets", "texture", "Checker.png")
+    os.makedirs(os.path.dirname(texture), exist_ok=True)
+    with open(texture, "wb") as out:
+        out.write(checker())
+
+    meshes = [("Sphere", sphere()), ("Box", box())]
+
+    gltf = {"asset": {"version": "2.0", "generator": "scripts/make-test-scene.py"}, "buffers": [], "bufferViews": [], "accessors": [], "meshes": []}
+    bin_chunk = bytearray()
+
+    def add_accessor(data, component_type, type_name, count, target, minmax=None):
+        while len(bin_chunk) % 4:
+            bin_chunk.append(0)
+        view = {"buffer": 0, "byteOffset": len(bin_chunk), "byteLength": len(data), "target": target}
+        bin_chunk.extend(data)
+        gltf["bufferViews"].append(view)
+        accessor = {"bufferView": len(gltf["bufferViews"]) - 1, "componentType": component_type, "count": count, "type": type_name}
+        if minmax:
+            accessor["min"], accessor["max"] = minmax
+        gltf["accessors"].append(accessor)
+        return len(gltf["accessors"]) - 1
+
+    for name, (positions, normals, uvs, indices) in meshes:
+        bounds = ([min(p[i] for p in positions) for i in range(3)], [max(p[i] for p in positions) for i in range(3)])
+        attributes = {
+            "POSITION": add_accessor(b"".join(struct.pack("<3f", *p) for p in positions), 5126, "VEC3", len(positions), 34962, bounds),
+            "NORMAL": add_accessor(b"".join(struct.pack("<3f", *n) for n in normals), 5126, "VEC3", len(normals), 34962),
+            "TEXCOORD_0": add_accessor(b"".join(struct.pack("<2f", *uv) for uv in uvs), 5126, "VEC2", len(uvs), 34962),
+        }
+        index = add_accessor(struct.pack("<%dH" % len(indices), *indices), 5123, "SCALAR", len(indices), 34963)
+        gltf["meshes"].append({"name": name, "primitives": [{"attributes": attributes, "indices": index}]})
+
+    while len(bin_chunk) % 4:
+        bin_chunk.append(0)
+    gltf["buffers"].append({"byteLength": len(bin_chunk)})
+
+    json_chunk = json.dumps(gltf, separators=(",", ":")).encode()
+    json_chunk += b" " * (-len(json_chunk) % 4)
+
+    path = os.path.join("Shrek", "assets", "mesh", "TestScene.glb")
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "wb") as out:
+        out.write(struct.pack("<III", 0x46546C67, 2, 12 + 8 + len(json_chunk) + 8 + len(bin_chunk)))
+        out.write(struct.pack("<II", len(json_chunk), 0x4E4F534A) + json_chunk)
+        out.write(struct.pack("<II", len(bin_chunk), 0x004E4942) + bytes(bin_chunk))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,10 @@
+@echo off
+rem renders the regression scenes headless and exits with their result, e.g. regression.bat Release
+rem any further arguments go to the engine. scenes without a golden fail, --regression.update_goldens writes them
+set config=%1
+if "%config%"=="" set config=Release
+pushd %~dp0\..\Shrek
+call ..\bin\%config%-windows-x86_64\Shrek\Shrek.exe --regression.run %2 %3 %4 %5
+set result=%ERRORLEVEL%
+popd
+exit /b %result%
@@ -0,0 +1,9 @@
+#!/bin/sh
+# renders the regression scenes headless and exits with their result, e.g. ./regression.sh release
+# any further arguments go to the engine. scenes without a golden fail, --regression.update_goldens writes them
+set -e
+config=${1:-release}
+[ $# -gt 0 ] && shift
+config=$(echo "$config" | cut -c1 | tr '[:lower:]' '[:upper:]')$(echo "$config" | cut -c2-)
+cd "$(dirname "$0")/../Shrek"
+exec "../bin/$config-linux-x86_64/Shrek/Shrek" --regression.run "$@"
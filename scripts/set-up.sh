@@ -0,0 +1,5 @@
+#!/bin/sh
+set -e
+cd "$(dirname "$0")"
+./linux-gen-proj.sh
+./dev.sh release